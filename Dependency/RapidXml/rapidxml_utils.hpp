@@ -60,11 +60,14 @@ namespace rapidxml
             m_data.push_back(0);
         }
 
+        //! Copies the buffer into the memory and adds terminating 0.
+        //! \param buffer Data to load, it doesn't need to be null terminated.
+        //! \param size Size of the data, only this many characters are read from the buffer.
         file(const char* buffer, unsigned int size)
         {
           m_data.reserve(size + 1);
-          m_data = std::vector<char>(buffer, buffer + size + 1);
-          m_data[size] = 0;
+          m_data.assign(buffer, buffer + size);
+          m_data.push_back(0);
         }
         
         //! Gets file data.
@@ -922,6 +922,7 @@ namespace ToolKit
 
           cmd    += "\" -s " + std::to_string(UI::ImportData.Scale);
           cmd    += " -o " + std::to_string(UI::ImportData.optimize);
+          cmd    += UI::ImportData.binaryMesh ? " -b" : "";
 
           // Execute command
           result  = ExecSysCommand(cmd.c_str(), false, false);
@@ -1272,15 +1273,15 @@ namespace ToolKit
 
       for (ClassMeta* t : types)
       {
-        for (auto& resource : GetResourceManager(t)->m_storage)
+        for (ResourcePtr resource : GetResourceManager(t)->GetStoredResources())
         {
-          if (!resource.second->IsDynamic())
+          if (!resource->IsDynamic())
           {
-            String file = resource.second->GetFile();
+            String file = resource->GetFile();
             if (!IsDefaultResource(file))
             {
-              resource.second->m_dirty = true;
-              resource.second->Save(true);
+              resource->m_dirty = true;
+              resource->Save(true);
             }
           }
         }
@@ -0,0 +1,760 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#include "Benchmarks.h"
+
+#include "App.h"
+#include "EditorViewport.h"
+
+#include <AABBOverrideComponent.h>
+#include <BinPack2D.h>
+#include <DirectionComponent.h>
+#include <FileManager.h>
+#include <MathUtil.h>
+#include <Mesh.h>
+#include <RenderProxyStore.h>
+#include <Threads.h>
+
+namespace ToolKit
+{
+  namespace Editor
+  {
+
+    // Compares the work stealing job system against the fixed size frame pool on the current scene.
+    static void BenchmarkJobs(int iterations)
+    {
+      ScenePtr scene             = GetSceneManager()->GetCurrentScene();
+      EditorViewportPtr viewport = GetApp()->GetActiveViewport();
+      if (scene == nullptr || viewport == nullptr)
+      {
+        TK_WRN("Benchmark requires a scene and an active viewport.");
+        return;
+      }
+
+      Frustum frustum                = ExtractFrustum(viewport->GetCamera()->GetProjectViewMatrix(), false);
+      const EntityPtrArray& entities = scene->GetEntities();
+
+      WorkerManager* workerMan       = GetWorkerManager();
+      bool workStealing              = workerMan->m_workStealing;
+
+      auto measureFn                 = [&](bool useWorkStealing) -> void
+      {
+        workerMan->Flush();
+        workerMan->m_workStealing = useWorkStealing;
+
+        RenderJobArray jobs;
+        float beginTime = GetElapsedMilliSeconds();
+        for (int i = 0; i < iterations; i++)
+        {
+          EntityRawPtrArray rawNtties = ToEntityRawPtrArray(entities);
+          RenderJobProcessor::CreateRenderJobs(jobs, rawNtties);
+        }
+        float createJobsTime = (GetElapsedMilliSeconds() - beginTime) / iterations;
+
+        // Retained jobs are only copied, proxies are created by the first iteration if they are dirty.
+        beginTime            = GetElapsedMilliSeconds();
+        for (int i = 0; i < iterations; i++)
+        {
+          EntityRawPtrArray rawNtties = ToEntityRawPtrArray(entities);
+          scene->GetRenderProxyStore()->CollectRenderJobs(jobs, rawNtties);
+        }
+        float collectJobsTime = (GetElapsedMilliSeconds() - beginTime) / iterations;
+
+        size_t visibleCount   = 0;
+        beginTime             = GetElapsedMilliSeconds();
+        for (int i = 0; i < iterations; i++)
+        {
+          visibleCount = scene->m_aabbTree.VolumeQuery(frustum).size();
+        }
+        float volumeQueryTime = (GetElapsedMilliSeconds() - beginTime) / iterations;
+
+        TK_LOG("%s (%d threads): CreateRenderJobs %.3f ms (%zu jobs), CollectRenderJobs %.3f ms, VolumeQuery %.3f ms "
+               "(%zu entities)",
+               useWorkStealing ? "Job System" : "Frame Pool",
+               workerMan->GetThreadCount(WorkerManager::FramePool),
+               createJobsTime,
+               jobs.size(),
+               collectJobsTime,
+               volumeQueryTime,
+               visibleCount);
+      };
+
+      measureFn(false);
+      measureFn(true);
+
+      workerMan->Flush();
+      workerMan->m_workStealing = workStealing;
+    }
+
+    // Measures volume queries on synthetic trees with increasing leaf counts.
+    static void BenchmarkVolumeQuery(int iterations)
+    {
+      // All leafs share a dummy entity, only the traversal and the result collection is measured.
+      EntityPtr dummy = MakeNewPtr<Entity>();
+      std::mt19937 rng(7);
+
+      for (int leafCount : {10000, 100000, 1000000})
+      {
+        float extent = 4.0f * glm::pow((float) leafCount, 1.0f / 3.0f);
+        std::uniform_real_distribution<float> posDist(-extent, extent);
+        std::uniform_real_distribution<float> sizeDist(0.25f, 1.0f);
+
+        std::unique_ptr<AABBTree> tree = std::make_unique<AABBTree>();
+
+        float beginTime                = GetElapsedMilliSeconds();
+        for (int i = 0; i < leafCount; i++)
+        {
+          Vec3 pos(posDist(rng), posDist(rng), posDist(rng));
+          Vec3 halfSize(sizeDist(rng));
+          tree->CreateNode(dummy, BoundingBox(pos - halfSize, pos + halfSize));
+        }
+        float buildTime = GetElapsedMilliSeconds() - beginTime;
+
+        // Camera at the boundary of the cloud looking towards the center.
+        Mat4 project    = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, extent * 4.0f);
+        Mat4 view       = glm::lookAt(Vec3(0.0f, 0.0f, extent), ZERO, Y_AXIS);
+        Frustum frustum = ExtractFrustum(project * view, false);
+
+        EntityRawPtrArray result;
+        auto measureFn = [&](bool threaded, bool wide) -> float
+        {
+          // First query grows the buffers and flattens the wide tree, following ones must not allocate.
+          tree->m_wideTraversal = wide;
+          tree->VolumeQuery(frustum, result, threaded);
+
+          float queryBeginTime = GetElapsedMilliSeconds();
+          for (int i = 0; i < iterations; i++)
+          {
+            tree->VolumeQuery(frustum, result, threaded);
+          }
+
+          return (GetElapsedMilliSeconds() - queryBeginTime) / iterations;
+        };
+
+        // Rays are cast from the camera towards random points in the cloud.
+        RayArray rays(1000);
+        for (Ray& ray : rays)
+        {
+          ray.position  = Vec3(0.0f, 0.0f, extent);
+          ray.direction = glm::normalize(Vec3(posDist(rng), posDist(rng), posDist(rng)) - ray.position);
+        }
+
+        auto measureRayFn = [&](bool wide) -> float
+        {
+          tree->m_wideTraversal = wide;
+          tree->RayQuery(rays.front(), false);
+
+          float queryBeginTime = GetElapsedMilliSeconds();
+          for (const Ray& ray : rays)
+          {
+            tree->RayQuery(ray, false);
+          }
+
+          return (GetElapsedMilliSeconds() - queryBeginTime) * 1000.0f / (float) rays.size();
+        };
+
+        AABBTree::RayHitArray hits;
+        auto measureRayBatchFn = [&](bool threaded) -> float
+        {
+          tree->RayQueryBatch(rays, false, hits, {}, threaded);
+
+          float queryBeginTime = GetElapsedMilliSeconds();
+          for (int i = 0; i < iterations; i++)
+          {
+            tree->RayQueryBatch(rays, false, hits, {}, threaded);
+          }
+
+          return (GetElapsedMilliSeconds() - queryBeginTime) * 1000.0f / (float) (rays.size() * iterations);
+        };
+
+        int threadCount = GetWorkerManager()->GetThreadCount(WorkerManager::FramePool) + 1;
+        for (bool wide : {false, true})
+        {
+          float singleThreadTime = measureFn(false, wide);
+          float threadedTime     = measureFn(true, wide);
+          float rayTime          = measureRayFn(wide);
+
+          TK_LOG("VolumeQuery %s %d leafs (%zu in frustum): build %.1f ms, single thread %.3f ms, %d threads %.3f ms, "
+                 "RayQuery %.2f us",
+                 wide ? "wide" : "binary",
+                 leafCount,
+                 result.size(),
+                 buildTime,
+                 singleThreadTime,
+                 threadCount,
+                 threadedTime,
+                 rayTime);
+        }
+
+        float batchTime         = measureRayBatchFn(false);
+        float threadedBatchTime = measureRayBatchFn(true);
+        TK_LOG("RayQueryBatch %d leafs: single thread %.2f us, %d threads %.2f us per ray",
+               leafCount,
+               batchTime,
+               threadCount,
+               threadedBatchTime);
+      }
+    }
+
+    // Compares loading the meshes in the mesh manager from xml and binary mesh files.
+    static void BenchmarkMeshLoad(int iterations)
+    {
+      Path tempFolder = std::filesystem::temp_directory_path();
+      StringArray tempFiles;
+
+      for (ResourcePtr resource : GetMeshManager()->GetStoredResources())
+      {
+        MeshPtr mesh = std::static_pointer_cast<Mesh>(resource);
+        String file  = mesh->GetFile();
+        if (mesh->IsDynamic() || !mesh->m_loaded || !CheckSystemFile(file))
+        {
+          continue;
+        }
+
+        String name, ext;
+        DecomposePath(file, nullptr, &name, &ext);
+
+        // Same mesh is written in both formats, loads are done on new meshes to skip the manager's cache.
+        String xmlFile    = (tempFolder / ("MeshLoadBenchmarkXml" + ext)).string();
+        String binaryFile = (tempFolder / ("MeshLoadBenchmarkBinary" + ext)).string();
+        tempFiles.push_back(xmlFile);
+        tempFiles.push_back(binaryFile);
+
+        XmlDocument doc;
+        mesh->Serialize(&doc, nullptr);
+
+        String xml;
+        rapidxml::print(std::back_inserter(xml), doc, 0);
+        GetFileManager()->WriteAllText(xmlFile, xml);
+
+        if (!mesh->SerializeBinary(binaryFile))
+        {
+          continue;
+        }
+
+        auto measureFn = [&](const String& path) -> float
+        {
+          float beginTime = GetElapsedMilliSeconds();
+          for (int i = 0; i < iterations; i++)
+          {
+            MeshPtr copy;
+            if (mesh->IsSkinned())
+            {
+              copy = MakeNewPtr<SkinMesh>();
+            }
+            else
+            {
+              copy = MakeNewPtr<Mesh>();
+            }
+
+            copy->SetFile(path);
+            copy->Load();
+          }
+
+          return (GetElapsedMilliSeconds() - beginTime) / iterations;
+        };
+
+        float xmlTime    = measureFn(xmlFile);
+        float binaryTime = measureFn(binaryFile);
+
+        TK_LOG("MeshLoad %s: xml %.2f ms (%.1f KB), binary %.2f ms (%.1f KB)",
+               (name + ext).c_str(),
+               xmlTime,
+               std::filesystem::file_size(xmlFile) / 1024.0f,
+               binaryTime,
+               std::filesystem::file_size(binaryFile) / 1024.0f);
+      }
+
+      for (const String& file : tempFiles)
+      {
+        std::error_code err;
+        std::filesystem::remove(file, err);
+      }
+    }
+
+    // Moves the root of a synthetic hierarchy and reads back the world transforms, with and without transform system.
+    static void BenchmarkTransform(int iterations)
+    {
+      for (bool useSystem : {false, true})
+      {
+        ScenePtr scene = MakeNewPtr<Scene>();
+        scene->SetTransformSystemEnabled(useSystem);
+
+        // 64 groups of 128 props under a single root.
+        EntityPtr root = MakeNewPtr<Entity>();
+        scene->AddEntity(root);
+
+        EntityPtrArray props;
+        for (int i = 0; i < 64; i++)
+        {
+          EntityPtr group = MakeNewPtr<Entity>();
+          group->m_node->SetTranslation(Vec3((float) i, 0.0f, 0.0f));
+          root->m_node->AddChild(group->m_node);
+          scene->AddEntity(group);
+
+          for (int j = 0; j < 128; j++)
+          {
+            EntityPtr prop = MakeNewPtr<Entity>();
+            prop->m_node->SetTranslation(Vec3(0.0f, 0.0f, (float) j));
+            group->m_node->AddChild(prop->m_node);
+            scene->AddEntity(prop);
+            props.push_back(prop);
+          }
+        }
+        scene->Update(0.0f);
+
+        Vec3 sum;
+        float beginTime = GetElapsedMilliSeconds();
+        for (int i = 0; i < iterations; i++)
+        {
+          root->m_node->Rotate(glm::angleAxis(0.01f, Y_AXIS));
+          scene->Update(0.0f);
+
+          for (const EntityPtr& prop : props)
+          {
+            sum += prop->m_node->GetTranslation();
+          }
+        }
+        float frameTime = (GetElapsedMilliSeconds() - beginTime) / iterations;
+
+        TK_LOG("Transform %s %zu nodes: %.3f ms per frame (checksum %.1f)",
+               useSystem ? "system" : "lazy",
+               props.size() + 65,
+               frameTime,
+               sum.x + sum.y + sum.z);
+      }
+    }
+
+    // Samples all bones of a synthetic animation for many characters, by bone name and with the compiled clip.
+    static void BenchmarkAnimation(int iterations)
+    {
+      const int characterCount = 200;
+      const int boneCount      = 64;
+      const int keyCount       = 900;
+
+      AnimationPtr anim        = MakeNewPtr<Animation>();
+      anim->m_fps              = 30.0f;
+      anim->m_duration         = keyCount / anim->m_fps;
+
+      StringArray boneNames;
+      for (int bone = 0; bone < boneCount; bone++)
+      {
+        boneNames.push_back("Bone" + std::to_string(bone));
+
+        KeyArray keys(keyCount);
+        for (int i = 0; i < keyCount; i++)
+        {
+          keys[i].m_frame    = i;
+          keys[i].m_position = Vec3((float) bone, (float) i * 0.01f, 0.0f);
+          keys[i].m_rotation = glm::angleAxis((float) i * 0.01f, Y_AXIS);
+          keys[i].m_scale    = Vec3(1.0f);
+        }
+        anim->SetKeys(boneNames.back(), keys);
+      }
+      anim->Compile();
+
+      // Characters play the animation with different time offsets.
+      std::vector<Vec3> translations(characterCount);
+      auto characterTimeFn = [&](int character, int iteration) -> float
+      { return glm::mod(character * 0.37f + iteration * 0.016f, anim->m_duration); };
+
+      auto byNameFn = [&](int character, int iteration) -> void
+      {
+        float time = characterTimeFn(character, iteration);
+        Vec3 sum;
+        for (const String& boneName : boneNames)
+        {
+          const KeyArray& keys = anim->GetKeys().find(boneName)->second;
+
+          int key1, key2;
+          float ratio;
+          anim->GetNearestKeys(keys, key1, key2, ratio, time);
+
+          Quaternion rotation  = glm::slerp(keys[key1].m_rotation, keys[key2].m_rotation, ratio);
+          sum                 += Interpolate(keys[key1].m_position, keys[key2].m_position, ratio) + rotation * X_AXIS;
+        }
+        translations[character] = sum;
+      };
+
+      auto compiledFn = [&](int character, int iteration) -> void
+      {
+        float time = characterTimeFn(character, iteration);
+        Vec3 sum, translation, scale;
+        Quaternion rotation;
+        for (int track = 0; track < boneCount; track++)
+        {
+          anim->SampleTrack(track, time, translation, rotation, scale);
+          sum += translation + rotation * X_AXIS;
+        }
+        translations[character] = sum;
+      };
+
+      auto measureFn = [&](auto sampleFn, bool parallel) -> float
+      {
+        float beginTime = GetElapsedMilliSeconds();
+        for (int i = 0; i < iterations; i++)
+        {
+          if (parallel)
+          {
+            GetWorkerManager()->ParallelFor(characterCount,
+                                            8,
+                                            [&](size_t begin, size_t end) -> void
+                                            {
+                                              for (size_t character = begin; character < end; character++)
+                                              {
+                                                sampleFn((int) character, i);
+                                              }
+                                            });
+          }
+          else
+          {
+            for (int character = 0; character < characterCount; character++)
+            {
+              sampleFn(character, i);
+            }
+          }
+        }
+
+        return (GetElapsedMilliSeconds() - beginTime) / iterations;
+      };
+
+      float byNameTime           = measureFn(byNameFn, false);
+      float compiledTime         = measureFn(compiledFn, false);
+      float compiledParallelTime = measureFn(compiledFn, true);
+
+      Vec3 checksum;
+      for (const Vec3& translation : translations)
+      {
+        checksum += translation;
+      }
+
+      TK_LOG("Animation %d characters, %d bones, %d keys: by name %.3f ms, compiled %.3f ms, compiled parallel %.3f ms "
+             "(checksum %.1f)",
+             characterCount,
+             boneCount,
+             keyCount,
+             byNameTime,
+             compiledTime,
+             compiledParallelTime,
+             checksum.x + checksum.y + checksum.z);
+    }
+
+    static void BenchmarkShadowAtlas(int iterations)
+    {
+      // Random lights are added and removed, allocations of the remaining lights are kept like the shadow pass does.
+      const int atlasSize  = RHIConstants::ShadowAtlasTextureSize;
+      const int lightCount = 48;
+      std::mt19937 rng(7);
+      std::uniform_int_distribution<int> typeDist(0, 2);
+      std::uniform_int_distribution<int> resolutionDist(0, 2);
+
+      struct Group
+      {
+        int size  = 0;
+        int count = 0;
+        BinPack2D::PackedRect rect;
+      };
+
+      auto randomGroupFn = [&]() -> Group
+      {
+        const int mapCounts[] = {4, 6, 1}; // Directional with 4 cascades, point and spot.
+        Group group;
+        group.size  = 512 << resolutionDist(rng);
+        group.count = mapCounts[typeDist(rng)];
+        return group;
+      };
+
+      BinPack2D packer;
+      packer.Init(atlasSize);
+
+      std::vector<Group> groups;
+      int failures       = 0;
+      auto insertGroupFn = [&](Group group) -> void
+      {
+        group.rect = packer.Insert(group.size, group.count);
+        if (!group.rect.IsValid())
+        {
+          failures++;
+          return;
+        }
+        groups.push_back(group);
+      };
+
+      for (int i = 0; i < lightCount; i++)
+      {
+        insertGroupFn(randomGroupFn());
+      }
+
+      double occupancySum  = 0.0;
+      double layerSum      = 0.0;
+      double lowerBoundSum = 0.0;
+      double repackSum     = 0.0;
+      float churnTime      = 0.0f;
+
+      for (int i = 0; i < iterations; i++)
+      {
+        std::uniform_int_distribution<int> groupDist(0, (int) groups.size() - 1);
+        int removed     = groupDist(rng);
+
+        float beginTime = GetElapsedMilliSeconds();
+        packer.Remove(groups[removed].rect);
+        groups.erase(groups.begin() + removed);
+        insertGroupFn(randomGroupFn());
+        churnTime += GetElapsedMilliSeconds() - beginTime;
+
+        // Same lights packed from scratch, largest first, to see the cost of keeping the allocations.
+        std::vector<Group> sorted(groups);
+        std::sort(sorted.begin(),
+                  sorted.end(),
+                  [](const Group& g1, const Group& g2) -> bool
+                  { return g1.size * g1.size * g1.count > g2.size * g2.size * g2.count; });
+
+        BinPack2D repacker;
+        repacker.Init(atlasSize);
+
+        int64 area = 0;
+        for (const Group& group : sorted)
+        {
+          repacker.Insert(group.size, group.count);
+          area += (int64) group.size * group.size * group.count;
+        }
+
+        occupancySum  += packer.GetOccupancy();
+        layerSum      += packer.GetLayerCount();
+        repackSum     += repacker.GetLayerCount();
+        lowerBoundSum += glm::ceil((double) area / ((double) atlasSize * atlasSize));
+      }
+
+      TK_LOG("Shadow atlas %d lights, %d churns: occupancy %.1f%%, layers %.2f (from scratch %.2f, lower bound %.2f), "
+             "%.4f ms per churn, %d insert failures",
+             lightCount,
+             iterations,
+             occupancySum / iterations * 100.0,
+             layerSum / iterations,
+             repackSum / iterations,
+             lowerBoundSum / iterations,
+             churnTime / iterations,
+             failures);
+    }
+
+    // Parameters of the component except its id, which changes since the loaded ones collide with the source.
+    static String SerializedParams(const ComponentPtr& component)
+    {
+      XmlDocument doc;
+      XmlNode* root = CreateXmlNode(&doc, XmlParamBlockElement, nullptr);
+      for (const ParameterVariant& var : component->m_localData.m_variants)
+      {
+        if (var.m_name != "Id")
+        {
+          var.Serialize(&doc, root);
+        }
+      }
+
+      String params;
+      rapidxml::print(std::back_inserter(params), doc, 0);
+      return params;
+    }
+
+    // Components that are serialized must be loaded in order, with the same class and parameters.
+    static bool SameSerializedComponents(Entity* source, Entity* loaded)
+    {
+      ComponentPtrArray sourceComponents;
+      for (const ComponentPtr& component : source->GetComponentPtrArray())
+      {
+        if (component->IsSerializable())
+        {
+          sourceComponents.push_back(component);
+        }
+      }
+
+      const ComponentPtrArray& loadedComponents = loaded->GetComponentPtrArray();
+      if (sourceComponents.size() != loadedComponents.size())
+      {
+        return false;
+      }
+
+      for (size_t i = 0; i < sourceComponents.size(); i++)
+      {
+        const ComponentPtr& sourceComponent = sourceComponents[i];
+        const ComponentPtr& loadedComponent = loadedComponents[i];
+        if (sourceComponent->Class() != loadedComponent->Class() ||
+            SerializedParams(sourceComponent) != SerializedParams(loadedComponent))
+        {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    // Saves a synthetic scene, loads it from the xml and from the binary file and compares with the saved entities.
+    static void BenchmarkSceneSerialization(int iterations)
+    {
+      const int entityCount = 30000;
+      const int chainLength = 8;
+      std::mt19937 rng(7);
+      std::uniform_real_distribution<float> posDist(-100.0f, 100.0f);
+
+      Path tempFolder   = std::filesystem::temp_directory_path();
+      String file       = (tempFolder / ("SceneSerializationBenchmark" + SCENE)).string();
+      String binaryFile = file + SCENE_BINARY;
+      String hiddenFile = binaryFile + ".hidden";
+
+      // Entities are parented in chains and have components, so that all parts of the records are exercised. Every
+      // other entity starts with a component that isn't serialized, such as the gizmo of the editor camera.
+      ScenePtr source   = MakeNewPtr<Scene>();
+      source->SetFile(file);
+
+      // Values are in quarters, so that their text round trips exactly.
+      auto quarterFn = [&]() -> float { return glm::floor(posDist(rng)) * 0.25f; };
+
+      EntityPtr parent;
+      for (int i = 0; i < entityCount; i++)
+      {
+        EntityPtr ntt = MakeNewPtr<EntityNode>();
+        ntt->SetNameVal("Entity" + std::to_string(i));
+        ntt->m_node->SetTranslation(Vec3(posDist(rng), posDist(rng), posDist(rng)), TransformationSpace::TS_LOCAL);
+
+        if (i % 2 == 0)
+        {
+          ntt->AddComponent<MeshComponent>(false);
+        }
+
+        AABBOverrideComponentPtr aabbOverride = ntt->AddComponent<AABBOverrideComponent>();
+        aabbOverride->SetPositionOffsetVal(Vec3(quarterFn(), quarterFn(), quarterFn()));
+        aabbOverride->SetSizeVal(Vec3(quarterFn(), quarterFn(), quarterFn()));
+        ntt->AddComponent<DirectionComponent>();
+
+        if (i % chainLength != 0)
+        {
+          parent->m_node->AddChild(ntt->m_node);
+        }
+
+        source->AddEntity(ntt);
+        parent = ntt;
+      }
+
+      float beginTime = GetElapsedMilliSeconds();
+      source->Save(false);
+      float saveTime  = GetElapsedMilliSeconds() - beginTime;
+
+      // Loads are done on new scenes to skip the manager's cache. Ids of the source collide with all loaded entities.
+      ScenePtr loaded;
+      auto measureFn  = [&]() -> float
+      {
+        float beginTime = GetElapsedMilliSeconds();
+        for (int i = 0; i < iterations; i++)
+        {
+          loaded = MakeNewPtr<Scene>();
+          loaded->SetFile(file);
+          loaded->Load();
+        }
+
+        return (GetElapsedMilliSeconds() - beginTime) / iterations;
+      };
+
+      auto mismatchFn = [&]() -> int
+      {
+        const EntityPtrArray& expected = source->GetEntities();
+        const EntityPtrArray& actual   = loaded->GetEntities();
+        if (expected.size() != actual.size())
+        {
+          return (int) glm::max(expected.size(), actual.size());
+        }
+
+        int mismatches = 0;
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+          Entity* ntt1       = expected[i].get();
+          Entity* ntt2       = actual[i].get();
+          EntityPtr parent1  = ntt1->m_node->ParentEntity();
+          EntityPtr parent2  = ntt2->m_node->ParentEntity();
+          String parentName1 = parent1 ? parent1->GetNameVal() : "";
+          String parentName2 = parent2 ? parent2->GetNameVal() : "";
+          Vec3 pos1          = ntt1->m_node->GetTranslation(TransformationSpace::TS_LOCAL);
+          Vec3 pos2          = ntt2->m_node->GetTranslation(TransformationSpace::TS_LOCAL);
+          bool sameNtt       = ntt1->GetNameVal() == ntt2->GetNameVal() && ntt1->Class() == ntt2->Class();
+          bool sameParent    = parentName1 == parentName2;
+          bool sameComps     = SameSerializedComponents(ntt1, ntt2);
+          bool samePos       = glm::all(glm::epsilonEqual(pos1, pos2, 0.001f));
+          if (!sameNtt || !sameParent || !sameComps || !samePos)
+          {
+            mismatches++;
+          }
+        }
+
+        return mismatches;
+      };
+
+      float binaryTime     = measureFn();
+      int binaryMismatches = mismatchFn();
+
+      // Binary file is moved away, so that the xml is loaded.
+      std::error_code err;
+      std::filesystem::rename(binaryFile, hiddenFile, err);
+      float xmlTime     = measureFn();
+      int xmlMismatches = mismatchFn();
+
+      TK_LOG("SceneSerialization %d entities: save %.2f ms, xml load %.2f ms (%.1f KB, %d mismatches), binary load "
+             "%.2f ms (%.1f KB, %d mismatches)",
+             entityCount,
+             saveTime,
+             xmlTime,
+             std::filesystem::file_size(file, err) / 1024.0f,
+             xmlMismatches,
+             binaryTime,
+             std::filesystem::file_size(hiddenFile, err) / 1024.0f,
+             binaryMismatches);
+
+      loaded = nullptr;
+      source = nullptr;
+      for (const String& tempFile : {file, hiddenFile})
+      {
+        std::filesystem::remove(tempFile, err);
+      }
+    }
+
+    bool RunBenchmark(const String& name, int iterations)
+    {
+      if (name == "jobs")
+      {
+        BenchmarkJobs(iterations);
+      }
+      else if (name == "volumeQuery")
+      {
+        BenchmarkVolumeQuery(iterations);
+      }
+      else if (name == "meshLoad")
+      {
+        BenchmarkMeshLoad(iterations);
+      }
+      else if (name == "transform")
+      {
+        BenchmarkTransform(iterations);
+      }
+      else if (name == "animation")
+      {
+        BenchmarkAnimation(iterations);
+      }
+      else if (name == "shadowAtlas")
+      {
+        BenchmarkShadowAtlas(iterations);
+      }
+      else if (name == "scene")
+      {
+        BenchmarkSceneSerialization(iterations);
+      }
+      else
+      {
+        return false;
+      }
+
+      return true;
+    }
+
+  } // namespace Editor
+} // namespace ToolKit
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#pragma once
+
+#include <Types.h>
+
+namespace ToolKit
+{
+  namespace Editor
+  {
+
+    /**
+     * Runs the benchmark with the given name and logs its timings. Benchmarks measure the engine systems on the
+     * current scene or on synthetic data, they are run with the console's Benchmark command.
+     * @param name is one of jobs, volumeQuery, meshLoad, transform, animation, shadowAtlas or scene.
+     * @param iterations is the number of times each measured operation is repeated.
+     * @return False if there is no benchmark with the given name.
+     */
+    bool RunBenchmark(const String& name, int iterations);
+
+  } // namespace Editor
+} // namespace ToolKit
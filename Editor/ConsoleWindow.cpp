@@ -9,6 +9,7 @@
 
 #include "Action.h"
 #include "App.h"
+#include "Benchmarks.h"
 #include "EditorViewport.h"
 #include "TransformMod.h"
 
@@ -730,6 +731,35 @@ namespace ToolKit
       }
     }
 
+    void Benchmark(TagArgArray tagArgs)
+    {
+      auto showUsage = []()
+      {
+        TK_WRN("call command with arg: --jobs <iteration count>, --volumeQuery <iteration count>, --meshLoad "
+               "<iteration count>, --transform <iteration count>, --animation <iteration count>, --shadowAtlas "
+               "<iteration count> or --scene <iteration count>");
+      };
+      if (tagArgs.empty())
+      {
+        showUsage();
+        return;
+      }
+
+      for (const TagArg& arg : tagArgs)
+      {
+        int iterations = 100;
+        if (!arg.second.empty())
+        {
+          iterations = glm::max(1, std::atoi(arg.second.front().c_str()));
+        }
+
+        if (!RunBenchmark(arg.first, iterations))
+        {
+          showUsage();
+        }
+      }
+    }
+
     // ImGui ripoff. Portable helpers.
     static int Stricmp(const char* str1, const char* str2)
     {
@@ -795,6 +825,7 @@ namespace ToolKit
       CreateCommand(g_deleteSelection, DeleteSelection);
       CreateCommand(g_showProfileTimer, ShowProfileTimer);
       CreateCommand(g_selectSimilar, SelectSimilar);
+      CreateCommand(g_benchmark, Benchmark);
     }
 
     ConsoleWindow::~ConsoleWindow() {}
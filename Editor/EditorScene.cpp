@@ -386,6 +386,28 @@ namespace ToolKit
       return pdata;
     }
 
+    void EditorScene::PickObjects(const RayArray& rays,
+                                  PickDataArray& pickedObjects,
+                                  const IDArray& ignoreList,
+                                  const EntityPtrArray& extraList)
+    {
+      EntityPtrArray extraWithBillboards = extraList;
+      extraWithBillboards.insert(extraWithBillboards.end(), m_billboards.begin(), m_billboards.end());
+      UpdateBillboardsForPicking();
+
+      Scene::PickObjects(rays, pickedObjects, ignoreList, extraWithBillboards);
+
+      // If the billboards are picked, pick the entity.
+      for (PickData& pdata : pickedObjects)
+      {
+        if (pdata.entity != nullptr && pdata.entity->IsA<Billboard>() &&
+            static_cast<Billboard*>(pdata.entity.get())->m_entity != nullptr)
+        {
+          pdata.entity = static_cast<Billboard*>(pdata.entity.get())->m_entity;
+        }
+      }
+    }
+
     void EditorScene::PickObject(const Frustum& frustum,
                                  PickDataArray& pickedObjects,
                                  const IDArray& ignoreList,
@@ -80,6 +80,11 @@ namespace ToolKit
                           const IDArray& ignoreList       = {},
                           const EntityPtrArray& extraList = {}) override;
 
+      void PickObjects(const RayArray& rays,
+                       PickDataArray& pickedObjects,
+                       const IDArray& ignoreList       = {},
+                       const EntityPtrArray& extraList = {}) override;
+
       void PickObject(const Frustum& frustum,
                       PickDataArray& pickedObjects,
                       const IDArray& ignoreList       = {},
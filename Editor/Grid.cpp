@@ -220,7 +220,7 @@ namespace ToolKit
 
         shaderMaterial->SetFragmentShaderVal(frag);
         shaderMaterial->Init();
-        GetMaterialManager()->m_storage[g_gridMaterialName] = shaderMaterial;
+        GetMaterialManager()->Store(g_gridMaterialName, shaderMaterial);
       }
 
       m_material = GetMaterialManager()->Create<Material>(g_gridMaterialName);
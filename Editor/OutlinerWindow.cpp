@@ -358,10 +358,9 @@ namespace ToolKit
     // the idea behind is:
     // * detect if we can reorder or not. if so:
     //     orphan all movedEntities
-    //     remove all movedEntities from the scene (entities array)
     // * if all of the moved entities are root entities and the entity we
     // dropped below is also root
-    //   insert all entities below dropped entity (because we removed them)
+    //   move all entities below dropped entity in the scene (entities array)
     // * else if the entity we dropped bellow is not root
     //   this means we dropped in childs list. detect the child index
     //   insert all moved entities to parents children (between the index we
@@ -381,39 +380,18 @@ namespace ToolKit
 
       SortDraggedEntitiesByNodeIndex();
 
-      auto insertNttFn = [&](const EntityPtrArray& ntties, int startIndex) -> void
-      {
-        int insertLoc = 0;
-        for (int i = 0; i < (int) ntties.size(); i++)
-        {
-          EntityPtr ntt = ntties[i];
-
-          // RemoveEntity may recursively delete all children if exist, so we need to add back all removed.
-          TraverseNodeHierarchyBottomUp(ntt->m_node,
-                                        [&](Node* child) -> void
-                                        {
-                                          if (EntityPtr childNtt = child->OwnerEntity())
-                                          {
-                                            scene->AddEntity(childNtt, startIndex + insertLoc++);
-                                          }
-                                        });
-        }
-      };
-
       // is dropped to on top of the first entity?
       if (selectedIndex == DroppedOnTopOfEntities)
       {
         OrphanAll(movedEntities);
-        scene->RemoveEntity(movedEntities);
-        insertNttFn(movedEntities, 0);
+        scene->MoveEntities(movedEntities, 0);
         return true;
       }
 
       if (selectedIndex == DroppedBelowAllEntities)
       {
         OrphanAll(movedEntities);
-        scene->RemoveEntity(movedEntities);
-        insertNttFn(movedEntities, -1);
+        scene->MoveEntities(movedEntities, -1);
         return true;
       }
 
@@ -467,14 +445,22 @@ namespace ToolKit
       // the object that we dropped below is root ?
       if (isRootFn(droppedBelowNtt) && !droppedAboveFirstChild)
       {
-        // remove all dropped entites
-        scene->RemoveEntity(movedEntities);
+        // find index of dropped entity without the dropped entities and
+        // move all dropped entities below dropped entity
+        int index = 0;
+        for (const EntityPtr& ntt : entities)
+        {
+          if (ntt == droppedBelowNtt)
+          {
+            break;
+          }
 
-        // find index of dropped entity and
-        // insert all dropped entities below dropped entity
-        auto find = std::find(entities.cbegin(), entities.cend(), droppedBelowNtt);
-        int index = (int) std::distance(entities.cbegin(), find);
-        insertNttFn(movedEntities, index + 1);
+          if (!contains(movedEntities, ntt))
+          {
+            index++;
+          }
+        }
+        scene->MoveEntities(movedEntities, index + 1);
       }
       else if (droppedParent != nullptr) // did we drop in child list?
       {
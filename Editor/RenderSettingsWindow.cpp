@@ -198,6 +198,18 @@ namespace ToolKit
           GetApp()->ReInitViewports();
         }
 
+        bool clusteredLighting = graphics->GetClusteredLightingVal();
+        if (ImGui::Checkbox("Clustered Lighting##1", &clusteredLighting))
+        {
+          graphics->SetClusteredLightingVal(clusteredLighting);
+        }
+
+        bool gpuInstancing = graphics->GetGpuInstancingVal();
+        if (ImGui::Checkbox("Gpu Instancing##1", &gpuInstancing))
+        {
+          graphics->SetGpuInstancingVal(gpuInstancing);
+        }
+
         float renderScale = graphics->GetRenderResolutionScaleVal();
         if (ImGui::DragFloat("Resolution Multiplier", &renderScale, 0.05f, 0.25f, 1.0f))
         {
@@ -1001,6 +1001,9 @@ namespace ToolKit
         ImGui::Checkbox("Optimize", &ImportData.optimize);
         AddTooltipToLastItem("Optimize the object to be imported.\nSometimes import may fail due to this operation. "
                              "In that case try without optimizations enabled.");
+        ImGui::Checkbox("Binary Mesh", &ImportData.binaryMesh);
+        AddTooltipToLastItem("Write the meshes in the binary mesh format.\nBinary meshes are smaller and load faster "
+                             "but they can't be edited as text.");
         ImGui::PushItemWidth(100);
         ImGui::InputFloat("Scale", &ImportData.Scale);
         ImGui::PopItemWidth();
@@ -108,6 +108,7 @@ namespace ToolKit
         bool ShowImportWindow = false;
         bool Overwrite        = false;
         bool optimize         = false;
+        bool binaryMesh       = false;
         StringArray Files;
         String SubDir;
         float Scale                  = 1.0f;
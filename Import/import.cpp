@@ -226,6 +226,7 @@ namespace ToolKit
   const float g_desiredFps = 30.0f;
   const float g_animEps    = 0.001f;
   String g_currentExt;
+  bool g_binaryMesh = false; // Meshes are written in the binary mesh format instead of xml.
 
   // Interpolator functions Begin
   // Range checks added by OTSoftware.
@@ -443,7 +444,7 @@ namespace ToolKit
 
         cmax = GetMax(cr, ct, cs);
         cr = ct = cs = 0;
-        tAnim->m_keys.insert(std::make_pair(nodeAnim->mNodeName.C_Str(), keys));
+        tAnim->SetKeys(nodeAnim->mNodeName.C_Str(), keys);
       }
 
       // Recalculate duration. May be misleading due to shifted animations.
@@ -684,10 +685,11 @@ namespace ToolKit
       }
     }
 
-    tMesh->m_loaded      = true;
-    tMesh->m_vertexCount = (int) (tMesh->m_clientSideVertices.size());
-    tMesh->m_indexCount  = (int) (tMesh->m_clientSideIndices.size());
-    tMesh->m_material    = tMaterials[mesh->mMaterialIndex];
+    tMesh->m_loaded       = true;
+    tMesh->m_vertexCount  = (int) (tMesh->m_clientSideVertices.size());
+    tMesh->m_indexCount   = (int) (tMesh->m_clientSideIndices.size());
+    tMesh->m_material     = tMaterials[mesh->mMaterialIndex];
+    tMesh->m_binaryFormat = g_binaryMesh;
     for (ubyte i = 0; i < 3; i++)
     {
       tMesh->m_boundingBox.min[i] = mesh->mAABB.mMin[i];
@@ -1262,7 +1264,7 @@ namespace ToolKit
     {
       if (argc < 2)
       {
-        cout << "usage: Import 'fileToImport.format' <op> -t 'importTo' <op> -s 1.0 <op> -o 0";
+        cout << "usage: Import 'fileToImport.format' <op> -t 'importTo' <op> -s 1.0 <op> -o 0 <op> -b";
         throw(-1);
       }
 
@@ -1292,6 +1294,11 @@ namespace ToolKit
         {
           optimizationLevel = std::atoi(argv[i + 1]);
         }
+
+        if (arg == "-b")
+        {
+          g_binaryMesh = true;
+        }
       }
 
       dest = fs::path(dest).lexically_normal().u8string();
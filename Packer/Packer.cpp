@@ -7,6 +7,7 @@
 
 #include <Animation.h>
 #include <Common/Win32Utils.h>
+#include <EngineSettings.h>
 #include <FileManager.h>
 #include <Image.h>
 #include <Material.h>
@@ -117,7 +118,20 @@ namespace ToolKit
       return -1;
     }
 
-    int packResult = GetFileManager()->PackResources();
+    GraphicSettingsPtr graphics = GetEngineSettings().m_graphics;
+    int compression             = graphics->GetDesktopTextureCompressionVal().GetValue<int>();
+    if (m_platform == PublishPlatform::Web)
+    {
+      compression = graphics->GetWebTextureCompressionVal().GetValue<int>();
+    }
+    else if (m_platform == PublishPlatform::Android)
+    {
+      compression = graphics->GetAndroidTextureCompressionVal().GetValue<int>();
+    }
+
+    // Etc2 is core in Gles 3.0, so Android paks don't need the source images of the compressed textures.
+    bool dropSourceImages = m_platform == PublishPlatform::Android;
+    int packResult        = GetFileManager()->PackResources((TextureCompression) compression, true, dropSourceImages);
     if (packResult != 0)
     {
       return packResult;
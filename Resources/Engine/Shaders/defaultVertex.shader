@@ -1,5 +1,6 @@
 <shader>
 	<type name = "vertexShader" />
+    <include name = "instancingInc.shader" />
     <include name = "skinning.shader" />
 	<include name = "cameraDataInc.shader" />
     <uniform name = "model" />
@@ -28,13 +29,15 @@
 
   void main()
   {
+    mat4 modelMatrix = MODEL_MATRIX;
+
     gl_Position = vec4(vPosition, 1.0f);
     if(isSkinned > 0u)
     {
 	  if (normalMapInUse)
       {
-        vec3 B = normalize(vec3(model * vec4(vBiTan, 0.0)));
-        vec3 N = normalize(vec3(model * vec4(vNormal, 0.0)));
+        vec3 B = normalize(vec3(modelMatrix * vec4(vBiTan, 0.0)));
+        vec3 N = normalize(vec3(modelMatrix * vec4(vNormal, 0.0)));
 
         skin(gl_Position, N, B, gl_Position, N, B);
 
@@ -43,7 +46,7 @@
       }
       else
       {
-        v_normal = (inverseTransposeModel * vec4(vNormal, 1.0)).xyz;
+        v_normal = (INVERSE_TRANSPOSE_MODEL_MATRIX * vec4(vNormal, 1.0)).xyz;
         skin(gl_Position, v_normal, gl_Position, v_normal);
       }
     }
@@ -51,20 +54,20 @@
     {
 	  if (normalMapInUse)
       {
-        vec3 B = normalize(vec3(model * vec4(vBiTan, 0.0)));
-        vec3 N = normalize(vec3(model * vec4(vNormal, 0.0)));
+        vec3 B = normalize(vec3(modelMatrix * vec4(vBiTan, 0.0)));
+        vec3 N = normalize(vec3(modelMatrix * vec4(vNormal, 0.0)));
         vec3 T = normalize(cross(B,N));
         TBN = mat3(T,B,N);
       }
       else
       {
-        v_normal = (inverseTransposeModel * vec4(vNormal, 1.0)).xyz;
+        v_normal = (INVERSE_TRANSPOSE_MODEL_MATRIX * vec4(vNormal, 1.0)).xyz;
       }
     }
 
-    v_pos = (model * gl_Position).xyz;
-	v_viewPosDepth = (camera.view * model * gl_Position).z;
-    gl_Position = camera.projectionView * model * gl_Position;
+    v_pos = (modelMatrix * gl_Position).xyz;
+	v_viewPosDepth = (camera.view * modelMatrix * gl_Position).z;
+    gl_Position = camera.projectionView * modelMatrix * gl_Position;
     v_texture = vTexture;
   }
 	-->
@@ -55,6 +55,10 @@
 	#define MAX_POINT_LIGHT_PER_OBJECT 24
 	#define SPOT_LIGHT_CACHE_ITEM_COUNT 32
 	#define MAX_SPOT_LIGHT_PER_OBJECT 24
+	#define CLUSTER_COUNT_X 16
+	#define CLUSTER_COUNT_Y 9
+	#define CLUSTER_COUNT_Z 24
+	#define CLUSTER_INDEX_TEXTURE_WIDTH 1024
 
 	// Graphic Constants Data
 	//////////////////////////////////////////
@@ -1,5 +1,6 @@
 <shader>
   <type name = "vertexShader" />
+  <include name = "instancingInc.shader" />
   <include name = "skinning.shader" />
 	<include name = "cameraDataInc.shader" />
 	<include name = "drawDataInc.shader" />
@@ -28,6 +29,7 @@
   void main()
   {
     Material material = GetMaterial();
+    mat4 modelMatrix  = MODEL_MATRIX;
   
     gl_Position   = vec4(vPosition, 1.0f);
 
@@ -35,8 +37,8 @@
       {
         if (material.normalMapInUse == 1)
         {
-            vec3 B = normalize(vec3(model * vec4(vBiTan, 0.0)));
-            vec3 N = normalize(vec3(model * vec4(vNormal, 0.0)));
+            vec3 B = normalize(vec3(modelMatrix * vec4(vBiTan, 0.0)));
+            vec3 N = normalize(vec3(modelMatrix * vec4(vNormal, 0.0)));
 
             skin(gl_Position, N, B, gl_Position, N, B);
 
@@ -45,7 +47,7 @@
         }
         else
         {
-            v_normal = (inverseTransposeModel * vec4(vNormal, 1.0)).xyz;
+            v_normal = (INVERSE_TRANSPOSE_MODEL_MATRIX * vec4(vNormal, 1.0)).xyz;
             skin(gl_Position, v_normal, gl_Position, v_normal);
         }
       }
@@ -53,23 +55,23 @@
       {
 			  if (material.normalMapInUse == 1)
 			  {
-            vec3 B = normalize(vec3(model * vec4(vBiTan, 0.0)));
-            vec3 N = normalize(vec3(model * vec4(vNormal, 0.0)));
+            vec3 B = normalize(vec3(modelMatrix * vec4(vBiTan, 0.0)));
+            vec3 N = normalize(vec3(modelMatrix * vec4(vNormal, 0.0)));
             vec3 T = normalize(cross(B,N));
             TBN = mat3(T,B,N);
         }
         else
         {
-            v_normal = (inverseTransposeModel * vec4(vNormal, 1.0)).xyz;
+            v_normal = (INVERSE_TRANSPOSE_MODEL_MATRIX * vec4(vNormal, 1.0)).xyz;
         }
       }
 
-    vec3 v_pos    = (model * gl_Position).xyz;
+    vec3 v_pos    = (modelMatrix * gl_Position).xyz;
     v_viewDepth = (camera.view * vec4(v_pos, 1.0)).xyz;
         
     v_texture = vTexture;
 
-    gl_Position   = camera.projectionView * model * gl_Position;
+    gl_Position   = camera.projectionView * modelMatrix * gl_Position;
   }
 	-->
 	</source>
@@ -0,0 +1,29 @@
+<shader>
+	<type name = "includeShader" />
+	<define name = "Instanced" val = "0,1" />
+	<source>
+	<!--
+#ifndef INSTANCING_SHADER
+#define INSTANCING_SHADER
+
+// Instancing
+//////////////////////////////////////////
+
+#if Instanced
+// Per instance attributes. A matrix occupies four locations, 6 to 9.
+layout(location = 6) in mat4 vInstanceModel;
+layout(location = 10) in vec4 vInstanceKeyFrames;      // x: keyFrame1 y: keyFrame2 z: time w: blend factor
+layout(location = 11) in vec4 vInstanceBlendKeyFrames; // x: blendKeyFrame1 y: blendKeyFrame2 z: time w: unused
+
+#define MODEL_MATRIX vInstanceModel
+#define INVERSE_TRANSPOSE_MODEL_MATRIX transpose(inverse(vInstanceModel))
+#else
+// Expanded in the including shader, which declares the model uniforms.
+#define MODEL_MATRIX model
+#define INVERSE_TRANSPOSE_MODEL_MATRIX inverseTransposeModel
+#endif
+
+#endif
+	-->
+	</source>
+</shader>
@@ -4,7 +4,9 @@
 	<include name = "shadow.shader" />
 	<include name = "pbr.shader" />
 	<include name = "drawDataInc.shader" />
+	<include name = "cameraDataInc.shader" />
 	<define name = "highlightCascades" val = "0,1" />
+	<define name = "ClusteredLighting" val = "0,1" />
 	<define name = "ShadowSampleCount" val="1,9,25,49" />
 	<uniform name = "activePointLightIndexes" size = "32" />
 	<uniform name = "activeSpotLightIndexes" size = "32" />
@@ -16,11 +18,104 @@
 
 uniform sampler2DArray s_texture8; // Shadow atlas
 
-/// Deferred rendering uniforms
-uniform sampler2D s_texture13; // Light data
 uniform int activePointLightIndexes[MAX_POINT_LIGHT_PER_OBJECT];
 uniform int activeSpotLightIndexes[MAX_SPOT_LIGHT_PER_OBJECT];
 
+#if ClusteredLighting
+
+// Clustered Lighting
+//////////////////////////////////////////
+
+uniform highp sampler2D s_texture12; // Cluster grid, light index offset and count for each cluster.
+uniform highp sampler2D s_texture13; // Light data, a row for each light.
+uniform highp sampler2D s_texture14; // Light indexes of all clusters.
+
+struct ClusterDataLayout
+{
+	float sliceScale;
+	float sliceBias;
+	int lightCount;
+	int pad0;
+};
+
+layout(std140) uniform ClusterData
+{
+	ClusterDataLayout clusterData;
+};
+
+vec4 ClusterLightTexel(highp int lightIndex, int texel)
+{
+	return texelFetch(s_texture13, ivec2(texel, lightIndex), 0);
+}
+
+#define FETCH_COMMON_LIGHT_DATA(light, lightIndex)								\
+	vec4 t0 = ClusterLightTexel(lightIndex, 0);								\
+	vec4 t1 = ClusterLightTexel(lightIndex, 1);								\
+	vec4 t3 = ClusterLightTexel(lightIndex, 3);								\
+	vec4 t4 = ClusterLightTexel(lightIndex, 4);								\
+	vec4 t5 = ClusterLightTexel(lightIndex, 5);								\
+	light.color = t0.xyz;														\
+	light.intensity = t0.w;													\
+	light.position = t1.xyz;													\
+	light.castShadow = int(t3.z);												\
+	light.pcfSamples = int(t3.w);												\
+	light.shadowBias = t4.x;													\
+	light.bleedingReduction = t4.y;											\
+	light.pcfRadius = t4.z;													\
+	light.shadowResolution = t4.w;											\
+	light.shadowAtlasCoord = t5.xy;											\
+	light.shadowAtlasLayer = int(t5.z);
+
+PointLightData FetchClusterPointLight(highp int lightIndex)
+{
+	PointLightData light;
+	FETCH_COMMON_LIGHT_DATA(light, lightIndex)
+	light.radius = t1.w;
+
+	return light;
+}
+
+SpotLightData FetchClusterSpotLight(highp int lightIndex)
+{
+	SpotLightData light;
+	FETCH_COMMON_LIGHT_DATA(light, lightIndex)
+	light.radius = t1.w;
+	light.direction = ClusterLightTexel(lightIndex, 2).xyz;
+
+	// Angles are in the same order with the spot light cache.
+	light.innerAngle = t3.x;
+	light.outerAngle = t3.y;
+
+	light.projectionViewMatrix = mat4
+	(
+		ClusterLightTexel(lightIndex, 6),
+		ClusterLightTexel(lightIndex, 7),
+		ClusterLightTexel(lightIndex, 8),
+		ClusterLightTexel(lightIndex, 9)
+	);
+
+	return light;
+}
+
+// Returns the offset of the cluster's first light index and the light count of the cluster.
+highp ivec2 FindCluster(vec3 fragPos, float viewPosDepth)
+{
+	vec4 clipPos = camera.projectionView * vec4(fragPos, 1.0);
+	vec2 screenUv = clipPos.xy / clipPos.w * 0.5 + 0.5;
+
+	highp ivec2 tile = ivec2(screenUv * vec2(CLUSTER_COUNT_X, CLUSTER_COUNT_Y));
+	tile = clamp(tile, ivec2(0), ivec2(CLUSTER_COUNT_X - 1, CLUSTER_COUNT_Y - 1));
+
+	// Slices are distributed logarithmically between the near and far planes.
+	float depth = max(abs(viewPosDepth), 0.0001);
+	highp int slice = int(log(depth) * clusterData.sliceScale - clusterData.sliceBias);
+	slice = clamp(slice, 0, CLUSTER_COUNT_Z - 1);
+
+	return ivec2(texelFetch(s_texture12, ivec2(tile.x + tile.y * CLUSTER_COUNT_X, slice), 0).xy);
+}
+
+#endif
+
 const float shadowFadeOutDistanceNorm = 0.9;
 
 bool EpsilonEqual(float a, float b, float eps)
@@ -167,6 +262,99 @@ float Attenuation(float distance, float radius, float constant, float linear, fl
 	return attenuation;
 }
 
+vec3 PointLightIrradiance
+(
+	PointLightData light,
+	vec3 fragPos,
+	vec3 normal,
+	vec3 fragToEye,
+	vec3 albedo,
+	float metallic,
+	float roughness
+)
+{
+	float resRatio = light.shadowResolution / graphicConstants.shadowAtlasSize;
+
+	// radius check and attenuation
+	float lightDistance = length(light.position - fragPos);
+	float radiusCheck = RadiusCheck(light.radius, lightDistance);
+	float attenuation = Attenuation(lightDistance, light.radius, 1.0, 0.09, 0.032);
+
+	// lighting
+	vec3 lightDir = normalize(light.position - fragPos);
+	vec3 Lo = PBR(fragPos, normal, fragToEye, albedo, metallic, roughness, lightDir, light.color * light.intensity);
+
+	// shadow
+	float shadow = 1.0;
+	if (light.castShadow == 1)
+	{
+		shadow = CalculatePointShadow
+			(
+				fragPos,
+				light.position,
+				light.radius,
+				light.shadowAtlasCoord,
+				resRatio,
+				light.shadowAtlasLayer,
+				light.pcfRadius,
+				light.bleedingReduction,
+				light.shadowBias
+			);
+	}
+
+	return Lo * shadow * attenuation * radiusCheck;
+}
+
+vec3 SpotLightIrradiance
+(
+	SpotLightData light,
+	vec3 fragPos,
+	vec3 normal,
+	vec3 fragToEye,
+	vec3 albedo,
+	float metallic,
+	float roughness
+)
+{
+	float resRatio = light.shadowResolution / graphicConstants.shadowAtlasSize;
+
+	// radius check and attenuation
+	vec3 fragToLight = light.position - fragPos;
+	float lightDistance = length(fragToLight);
+	float radiusCheck = RadiusCheck(light.radius, lightDistance);
+	float attenuation = Attenuation(lightDistance, light.radius, 1.0, 0.09, 0.032);
+
+	// Lighting angle and falloff
+	float theta = dot(-normalize(fragToLight), light.direction);
+	float epsilon = light.outerAngle - light.innerAngle;
+	float intensity = clamp((theta - light.outerAngle) / epsilon, 0.0, 1.0);
+
+	// lighting
+	vec3 lightDir = normalize(-light.direction);
+	vec3 Lo = PBR(fragPos, normal, fragToEye, albedo, metallic, roughness, lightDir, light.color * light.intensity);
+
+	// shadow
+	float shadow = 1.0;
+	if (light.castShadow == 1)
+	{
+		shadow = CalculateSpotShadow
+			(
+				fragPos,
+				light.position,
+				light.projectionViewMatrix,
+				light.radius,
+				light.shadowAtlasCoord / graphicConstants.shadowAtlasSize, // Convert to uv
+				resRatio,
+				light.shadowAtlasLayer,
+				light.pcfRadius,
+				light.bleedingReduction,
+				light.shadowBias
+			);
+	}
+
+	return Lo * shadow * intensity * radiusCheck * attenuation;
+}
+
 // Adhoc filter shrink. Each cascade further away from the camera should
 // reduce the filter size because each pixel coverage enlarges in distant cascades.
 // MJP has a more matematically found way in his shadow sample.
@@ -262,86 +450,33 @@ vec3 PBRLighting
 		irradiance += Lo * shadow * cascadeMultiplier;
 	}
 	
-	for (int i = 0; i < GetActivePointLightCount(); i++)
+#if ClusteredLighting
+	highp ivec2 cluster = FindCluster(fragPos, viewPosDepth);
+	for (highp int i = cluster.x; i < cluster.x + cluster.y; i++)
 	{
-		int ii = activePointLightIndexes[i];
-		PointLightData light = pointLightArray[ii];
-		
-		float resRatio = light.shadowResolution / graphicConstants.shadowAtlasSize;
-		
-		// radius check and attenuation
-		float lightDistance = length(light.position - fragPos);
-		float radiusCheck = RadiusCheck(light.radius, lightDistance);
-		float attenuation = Attenuation(lightDistance, light.radius, 1.0, 0.09, 0.032);
-
-			// lighting
-		vec3 lightDir = normalize(light.position - fragPos);
-		vec3 Lo = PBR(fragPos, normal, fragToEye, albedo, metallic, roughness, lightDir, light.color * light.intensity);
-
-			// shadow
-		float shadow = 1.0;
-		if (light.castShadow == 1)
+		highp int index = int(texelFetch(s_texture14, ivec2(i % CLUSTER_INDEX_TEXTURE_WIDTH, i / CLUSTER_INDEX_TEXTURE_WIDTH), 0).x);
+		if (ClusterLightTexel(index, 2).w < 1.5)
 		{
-			shadow = CalculatePointShadow
-				(
-					fragPos,
-					light.position,
-					light.radius,
-					light.shadowAtlasCoord,
-					resRatio,
-					light.shadowAtlasLayer,
-					light.pcfRadius,
-					light.bleedingReduction,
-					light.shadowBias
-				);
+			irradiance += PointLightIrradiance(FetchClusterPointLight(index), fragPos, normal, fragToEye, albedo, metallic, roughness);
 		}
-
-		irradiance += Lo * shadow * attenuation * radiusCheck;
-	}
-	
-	for (int i = 0; i < GetActiveSpotLightCount(); i++)
-	{
-		int ii = activeSpotLightIndexes[i];
-		SpotLightData light = spotLightArray[ii];
-		
-		float resRatio = light.shadowResolution / graphicConstants.shadowAtlasSize;
-		
-		// radius check and attenuation
-		vec3 fragToLight = light.position - fragPos;
-		float lightDistance = length(fragToLight);
-		float radiusCheck = RadiusCheck(light.radius, lightDistance);
-		float attenuation = Attenuation(lightDistance, light.radius, 1.0, 0.09, 0.032);
-
-		// Lighting angle and falloff
-		float theta = dot(-normalize(fragToLight), light.direction);
-		float epsilon = light.outerAngle - light.innerAngle;
-		float intensity = clamp((theta - light.outerAngle) / epsilon, 0.0, 1.0);
-
-		// lighting
-		vec3 lightDir = normalize(-light.direction);
-		vec3 Lo = PBR(fragPos, normal, fragToEye, albedo, metallic, roughness, lightDir, light.color * light.intensity);
-
-		// shadow
-		float shadow = 1.0;
-		if (light.castShadow == 1)
+		else
 		{
-			shadow = CalculateSpotShadow
-				(
-					fragPos,
-					light.position,
-					light.projectionViewMatrix,
-					light.radius,
-					light.shadowAtlasCoord / graphicConstants.shadowAtlasSize, // Convert to uv
-					resRatio,
-					light.shadowAtlasLayer,
-					light.pcfRadius,
-					light.bleedingReduction,
-					light.shadowBias
-				);
+			irradiance += SpotLightIrradiance(FetchClusterSpotLight(index), fragPos, normal, fragToEye, albedo, metallic, roughness);
 		}
+	}
+#else
+	for (int i = 0; i < GetActivePointLightCount(); i++)
+	{
+		PointLightData light = pointLightArray[activePointLightIndexes[i]];
+		irradiance += PointLightIrradiance(light, fragPos, normal, fragToEye, albedo, metallic, roughness);
+	}
 
-		irradiance += Lo * shadow * intensity * radiusCheck * attenuation;
+	for (int i = 0; i < GetActiveSpotLightCount(); i++)
+	{
+		SpotLightData light = spotLightArray[activeSpotLightIndexes[i]];
+		irradiance += SpotLightIrradiance(light, fragPos, normal, fragToEye, albedo, metallic, roughness);
 	}
+#endif
 	
 	return irradiance;
 }
@@ -1,5 +1,6 @@
 <shader>
 	<type name = "vertexShader" />
+	<include name = "instancingInc.shader" />
 	<include name = "skinning.shader" />
 	<include name = "cameraDataInc.shader" />
 	<include name = "drawDataInc.shader" />
@@ -30,7 +31,7 @@
 				skin(skinnedVPos, skinnedVPos);
 			}
 
-			gl_Position = camera.projectionView * model * skinnedVPos;
+			gl_Position = camera.projectionView * MODEL_MATRIX * skinnedVPos;
 			z = gl_Position.z / gl_Position.w;
 			z = (gl_DepthRange.diff * z + gl_DepthRange.near + gl_DepthRange.far) * 0.5;
 
@@ -1,5 +1,6 @@
 <shader>
 	<type name = "vertexShader" />
+	<include name = "instancingInc.shader" />
 	<include name = "skinning.shader" />
 	<include name = "cameraDataInc.shader" />
 	<include name = "drawDataInc.shader" />
@@ -33,8 +34,9 @@
 			skin(skinnedVPos, skinnedVPos);
 		}
 	
-		v_pos = (camera.view * model * skinnedVPos) / camera.farPlane;
-		gl_Position = camera.projectionView * model * skinnedVPos;
+		mat4 modelMatrix = MODEL_MATRIX;
+		v_pos = (camera.view * modelMatrix * skinnedVPos) / camera.farPlane;
+		gl_Position = camera.projectionView * modelMatrix * skinnedVPos;
 	
 		v_normal = vNormal;
 		v_bitan = vBiTan;
@@ -1,5 +1,6 @@
 <shader>
 	<type name = "includeShader" />
+  <include name = "instancingInc.shader" />
   <uniform name = "isSkinned" />
   <uniform name = "numBones" />
   <uniform name = "keyFrame1" />
@@ -38,16 +39,52 @@ uniform float blendKeyFrameCount;
 uniform sampler2D s_texture2; // Blend animation data texture
 uniform sampler2D s_texture3; // Animation data texture
 
+// Instanced draws read the key frames of each instance from the instance attributes.
+vec4 getKeyFramesData()
+{
+#if Instanced
+  return vec4(vInstanceKeyFrames.xyz, keyFrameCount);
+#else
+  return vec4(keyFrame1, keyFrame2, keyFrameIntepolationTime, keyFrameCount);
+#endif
+}
+
+vec4 getBlendKeyFramesData()
+{
+#if Instanced
+  return vec4(vInstanceBlendKeyFrames.xyz, blendKeyFrameCount);
+#else
+  return vec4(blendKeyFrame1, blendKeyFrame2, blendKeyFrameIntepolationTime, blendKeyFrameCount);
+#endif
+}
+
+float getBlendFactor()
+{
+#if Instanced
+  return vInstanceKeyFrames.w;
+#else
+  return blendFactor;
+#endif
+}
+
+// Bone matrices are stored as 3 texels, the first three rows of the matrix. Key frames that exceed the height of the
+// texture wrap to the next block of bone columns. Bind pose textures have a single row and a single block.
 mat4 getMatrixFromTexture(sampler2D animDataTexture, float boneIndx, float keyframe, float numberOfKeyFrames)
 {
-  float matrixPos   = boneIndx / numBones;
-  float stepX       = 1.0 / (numBones * 4.0);
-  vec2 moveToCenter = vec2(stepX / 2.0, 1.0 / (numberOfKeyFrames * 2.0));
+  ivec2 size      = textureSize(animDataTexture, 0);
+  int blockWidth  = int(numBones + 0.5) * 3;
+  int key         = int(keyframe * numberOfKeyFrames + 0.5);
+  int block       = min(key / size.y, size.x / blockWidth - 1);
+  ivec2 texel     = ivec2(block * blockWidth + int(boneIndx + 0.5) * 3, key % size.y);
+
+  vec4 row0       = texelFetch(animDataTexture, texel, 0);
+  vec4 row1       = texelFetch(animDataTexture, texel + ivec2(1, 0), 0);
+  vec4 row2       = texelFetch(animDataTexture, texel + ivec2(2, 0), 0);
 
-  return mat4(texture(animDataTexture, vec2(matrixPos, keyframe) + moveToCenter),
-              texture(animDataTexture, vec2(matrixPos + stepX, keyframe) + moveToCenter),
-              texture(animDataTexture, vec2(matrixPos + (stepX * 2.0), keyframe) + moveToCenter),
-              texture(animDataTexture, vec2(matrixPos + (stepX * 3.0), keyframe) + moveToCenter));
+  return mat4(vec4(row0.x, row1.x, row2.x, 0.0),
+              vec4(row0.y, row1.y, row2.y, 0.0),
+              vec4(row0.z, row1.z, row2.z, 0.0),
+              vec4(row0.w, row1.w, row2.w, 1.0));
 }
 
 // keyFramesData-> x: keyFrame1 y: keyFrame2 z: time w: key frame count
@@ -61,7 +98,7 @@ void skinCalc(in sampler2D animDataTexture, vec4 keyFramesData, in vec4 vertexPo
 
     if (isAnimated == 0u)
     {
-      mat4 bindPoseMatrix = getMatrixFromTexture(animDataTexture, vBones[i], 0.5, keyFramesData.w);
+      mat4 bindPoseMatrix = getMatrixFromTexture(animDataTexture, vBones[i], 0.0, 1.0);
       skinnedPos += bindPoseMatrix * vertexPos * vWeights[i];
     }
     else
@@ -98,7 +135,7 @@ void skinCalc
 
     if (isAnimated == 0u)
     {
-      mat4 bindPoseMatrix = getMatrixFromTexture(animDataTexture, vBones[i], 0.5, keyFramesData.w);
+      mat4 bindPoseMatrix = getMatrixFromTexture(animDataTexture, vBones[i], 0.0, 1.0);
       skinnedPos += bindPoseMatrix * vertexPos * vWeights[i];
       skinnedNormal += mat3(bindPoseMatrix) * vertexNormal * vWeights[i];
     }
@@ -145,7 +182,7 @@ void skinCalc
 
     if (isAnimated == 0u)
     {
-      mat4 bindPoseMatrix = getMatrixFromTexture(animDataTexture, vBones[i], 0.5, keyFramesData.w);
+      mat4 bindPoseMatrix = getMatrixFromTexture(animDataTexture, vBones[i], 0.0, 1.0);
       mat3 bindPoseMatrix3x3 = mat3(bindPoseMatrix);
       skinnedPos += bindPoseMatrix * vertexPos * vWeights[i];
       skinnedNormal += bindPoseMatrix3x3 * vertexNormal * vWeights[i];
@@ -177,7 +214,7 @@ void skinCalc
 
 void skin(in vec4 vertexPos, out vec4 skinnedPos)
 {
-  skinCalc(s_texture3, vec4(keyFrame1, keyFrame2, keyFrameIntepolationTime, keyFrameCount), vertexPos, skinnedPos);
+  skinCalc(s_texture3, getKeyFramesData(), vertexPos, skinnedPos);
 
   if (blendAnimation != 0)
   {
@@ -185,11 +222,11 @@ void skin(in vec4 vertexPos, out vec4 skinnedPos)
     skinCalc
     (
       s_texture2,
-      vec4(blendKeyFrame1, blendKeyFrame2, blendKeyFrameIntepolationTime, blendKeyFrameCount),
+      getBlendKeyFramesData(),
       vertexPos,
       blendingAnimSkinnedPos
     );
-    skinnedPos = mix(skinnedPos, blendingAnimSkinnedPos, blendFactor);
+    skinnedPos = mix(skinnedPos, blendingAnimSkinnedPos, getBlendFactor());
   }
 }
 
@@ -198,7 +235,7 @@ void skin(in vec4 vertexPos, in vec3 vertexNormal, out vec4 skinnedPos, out vec3
   skinCalc
   (
     s_texture3,
-    vec4(keyFrame1, keyFrame2, keyFrameIntepolationTime, keyFrameCount),
+    getKeyFramesData(),
     vertexPos,
     vertexNormal,
     skinnedPos,
@@ -212,14 +249,14 @@ void skin(in vec4 vertexPos, in vec3 vertexNormal, out vec4 skinnedPos, out vec3
     skinCalc
     (
       s_texture2,
-      vec4(blendKeyFrame1, blendKeyFrame2, blendKeyFrameIntepolationTime, blendKeyFrameCount),
+      getBlendKeyFramesData(),
       vertexPos,
       vertexNormal,
       blendingAnimSkinnedPos,
       blendingAnimNormal
     );
-    skinnedPos = mix(skinnedPos, blendingAnimSkinnedPos, blendFactor);
-    skinnedNormal = normalize(mix(skinnedNormal, blendingAnimNormal, blendFactor));
+    skinnedPos = mix(skinnedPos, blendingAnimSkinnedPos, getBlendFactor());
+    skinnedNormal = normalize(mix(skinnedNormal, blendingAnimNormal, getBlendFactor()));
   }
 }
 
@@ -236,7 +273,7 @@ void skin
   skinCalc
   (
     s_texture3,
-    vec4(keyFrame1, keyFrame2, keyFrameIntepolationTime, keyFrameCount),
+    getKeyFramesData(),
     vertexPos,
     vertexNormal,
     vertexBiTangent,
@@ -250,11 +287,11 @@ void skin
     vec4 blendingAnimSkinnedPos;
     vec3 blendingAnimNormal;
     vec3 blendingBiTangent;
-    skinCalc(s_texture2, vec4(blendKeyFrame1, blendKeyFrame2, blendKeyFrameIntepolationTime, blendKeyFrameCount),
+    skinCalc(s_texture2, getBlendKeyFramesData(),
       vertexPos, vertexNormal, vertexBiTangent, blendingAnimSkinnedPos, blendingAnimNormal, blendingBiTangent);
-    skinnedPos = mix(skinnedPos, blendingAnimSkinnedPos, blendFactor);
-    skinnedNormal = normalize(mix(skinnedNormal, blendingAnimNormal, blendFactor));
-    skinnedBiTangent = normalize(mix(skinnedBiTangent, blendingBiTangent, blendFactor));
+    skinnedPos = mix(skinnedPos, blendingAnimSkinnedPos, getBlendFactor());
+    skinnedNormal = normalize(mix(skinnedNormal, blendingAnimNormal, getBlendFactor()));
+    skinnedBiTangent = normalize(mix(skinnedBiTangent, blendingBiTangent, getBlendFactor()));
   }
 }
 
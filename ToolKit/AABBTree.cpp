@@ -10,14 +10,24 @@
 #include "Entity.h"
 #include "MathUtil.h"
 #include "Primative.h"
+#include "SimdMath.h"
+#include "SkeletonComponent.h"
+#include "Stats.h"
 #include "Threads.h"
+#include "ToolKit.h"
+#include "TransformSystem.h"
 
 #include "DebugNew.h"
 
 namespace ToolKit
 {
 
-  AABBTree::AABBTree() : m_root {nullNode}, m_nodeCapacity {32}, m_nodeCount {0}, m_threadTreshold(1000) { Reset(); }
+  AABBTree::AABBTree()
+      : m_root {nullNode}, m_nodeCapacity {32}, m_nodeCount {0}, m_threadTreshold(1000), m_wideTreeDirty(true),
+        m_deferInsertion(false), m_insertionsSinceBuild(0), m_builtSAHCost(0.0f)
+  {
+    Reset();
+  }
 
   AABBTree::~AABBTree()
   {
@@ -44,13 +54,14 @@ namespace ToolKit
       m_nodes[i].entity = EntityWeakPtr();
       m_nodes[i].next   = i + 1;
       m_nodes[i].parent = i;
-      m_nodes[i].leafs.clear();
     }
     m_nodes[m_nodeCapacity - 1].next   = nullNode;
     m_nodes[m_nodeCapacity - 1].parent = m_nodeCapacity - 1;
 
     m_freeList                         = 0;
     m_invalidNodes.clear();
+    m_wideTreeDirty   = true;
+    m_backgroundBuild = nullptr;
   }
 
   AABBNodeProxy AABBTree::CreateNode(EntityWeakPtr entity, const BoundingBox& aabb)
@@ -68,10 +79,11 @@ namespace ToolKit
     m_nodes[newNode].entity   = entity;
     m_nodes[newNode].parent   = nullNode;
 
-    // Insert a reference to self to create leafs struct properly in the tree.
-    m_nodes[newNode].leafs.insert(newNode);
-
-    InsertLeaf(newNode);
+    // Deferred nodes are inserted all at once by Rebuild.
+    if (!m_deferInsertion)
+    {
+      InsertLeaf(newNode);
+    }
 
     return newNode;
   }
@@ -80,6 +92,16 @@ namespace ToolKit
 
   void AABBTree::UpdateTree()
   {
+    assert(!m_deferInsertion && "Tree can't be updated while insertion is deferred.");
+
+    // Moved entities are invalidated by the transform system update.
+    if (m_transformSystem != nullptr)
+    {
+      m_transformSystem->Update();
+    }
+
+    CheckTreeQuality();
+
     if (m_invalidNodes.empty())
     {
       return;
@@ -87,10 +109,15 @@ namespace ToolKit
 
     // Update node will invalidate m_invalidNodes set, so this copy is needed.
     AABBNodeSet invalidNodes = m_invalidNodes;
+
+    // A few moved leafs are refit in place, which keeps the wide tree. Reinserting them keeps the tree tighter but the
+    // wide tree needs to be flattened again, which only pays off if many leafs are moved. Quality of the refit tree is
+    // watched by CheckTreeQuality.
+    int leafCount            = (m_nodeCount + 1) / 2;
+    bool refit               = !m_wideTreeDirty && (int) invalidNodes.size() <= glm::max(leafCount / 8, 1);
+
     for (AABBNodeProxy node : invalidNodes)
     {
-      RemoveLeaf(node);
-
       BoundingBox aabb = m_nodes[node].aabb;
       if (!m_nodes[node].entity.expired())
       {
@@ -98,18 +125,61 @@ namespace ToolKit
         aabb          = ntt->GetBoundingBox(true);
       }
 
-      m_nodes[node].aabb = aabb;
+      if (refit)
+      {
+        RefitLeaf(node, aabb);
+        continue;
+      }
 
+      RemoveLeaf(node);
+      m_nodes[node].aabb = aabb;
       InsertLeaf(node);
     }
   }
 
+  void AABBTree::SetTransformSystem(TransformSystem* transformSystem) { m_transformSystem = transformSystem; }
+
+  void AABBTree::RefitLeaf(AABBNodeProxy leaf, const BoundingBox& aabb)
+  {
+    m_invalidNodes.erase(leaf);
+    m_insertionsSinceBuild++;
+
+    m_nodes[leaf].aabb = aabb;
+    for (AABBNodeProxy node = m_nodes[leaf].parent; node != nullNode; node = m_nodes[node].parent)
+    {
+      m_nodes[node].aabb = BoundingBox::Union(m_nodes[m_nodes[node].child1].aabb, m_nodes[m_nodes[node].child2].aabb);
+    }
+
+    if (m_wideTreeDirty || m_wideNodes.empty())
+    {
+      return;
+    }
+
+    // Slots hold the bounds of the dynamic tree nodes, which are up to date now.
+    for (int32 wide = m_leafWideNodes[leaf]; wide != nullNode; wide = m_wideParents[wide])
+    {
+      WideNode& wideNode = m_wideNodes[wide];
+      for (int32 i = 0; i < wideNode.childCount; i++)
+      {
+        wideNode.bounds.Set(i, m_nodes[m_wideSlotNodes[wide * 4 + i]].aabb);
+      }
+    }
+  }
+
   void AABBTree::RemoveNode(AABBNodeProxy node)
   {
     assert(0 <= node && node < m_nodeCapacity);
     assert(m_nodes[node].IsLeaf());
 
-    RemoveLeaf(node);
+    // Deferred nodes are not in the tree. Rebuild collects the remaining leafs, tree links are not needed.
+    if (m_deferInsertion)
+    {
+      m_invalidNodes.erase(node);
+    }
+    else
+    {
+      RemoveLeaf(node);
+    }
     FreeNode(node);
   }
 
@@ -143,14 +213,15 @@ namespace ToolKit
 
   void AABBTree::Rebuild()
   {
-    m_invalidNodes.clear();
+    float beginTime   = GetElapsedMilliSeconds();
 
-    // Rebuild tree with bottom up approach.
-    std::vector<AABBNodeProxy> leaves;
-    leaves.resize(m_nodeCount);
-    int32 count = 0;
+    // Any background build is outdated by this one.
+    m_backgroundBuild = nullptr;
+
+    // Collect all leafs with their up to date bounding boxes and free the internal nodes.
+    std::vector<BuildLeaf> leafs;
+    leafs.reserve(m_nodeCount);
 
-    // Collect all leaves
     for (int32 i = 0; i < m_nodeCapacity; ++i)
     {
       // Already in the free list
@@ -159,74 +230,497 @@ namespace ToolKit
         continue;
       }
 
-      // Clean the leaf
       if (m_nodes[i].IsLeaf())
       {
+        if (m_invalidNodes.count(i) != 0)
+        {
+          if (EntityPtr ntt = m_nodes[i].entity.lock())
+          {
+            m_nodes[i].aabb = ntt->GetBoundingBox(true);
+          }
+        }
+
         m_nodes[i].parent = nullNode;
 
-        leaves[count++]   = i;
+        BuildLeaf& leaf   = leafs.emplace_back();
+        leaf.aabb         = m_nodes[i].aabb;
+        leaf.center       = m_nodes[i].aabb.GetCenter();
+        leaf.node         = i;
       }
       else
       {
-        // Free the internal node
         FreeNode(i);
       }
     }
 
-    while (count > 1)
+    m_invalidNodes.clear();
+    m_wideTreeDirty        = true;
+    m_insertionsSinceBuild = 0;
+    m_root                 = nullNode;
+
+    if (!leafs.empty())
     {
-      float minCost = TK_FLT_MAX;
-      int32 minI    = -1;
-      int32 minJ    = -1;
+      // A tree with n leafs has n - 1 internal nodes. Allocating them up front lets sub trees be built in parallel.
+      const int leafCount = (int) leafs.size();
+      NodeProxyArray internals(leafCount - 1);
+      for (AABBNodeProxy& node : internals)
+      {
+        node = AllocateNode();
+      }
+
+      WorkerManager* workerMan = GetWorkerManager();
+      JobSystem* jobSystem     = nullptr;
+      if (workerMan->m_workStealing && workerMan->GetThreadCount(WorkerManager::FramePool) > 0)
+      {
+        jobSystem = workerMan->GetJobSystem();
+      }
+
+      BuildRange rootRange = {0, leafCount, 0};
+      CalculateRangeBounds(leafs.data(), rootRange);
+      m_root = BuildSubTree(m_nodes, leafs.data(), internals.data(), rootRange, jobSystem);
+    }
+
+    m_builtSAHCost = CalculateSAHCost();
+
+    if (TKStats* stats = GetTKStats())
+    {
+      stats->m_aabbTreeBuildTime = GetElapsedMilliSeconds() - beginTime;
+      stats->m_aabbTreeSAHCost   = m_builtSAHCost;
+    }
+  }
+
+  void AABBTree::SetDeferredInsertion(bool defer)
+  {
+    if (m_deferInsertion == defer)
+    {
+      return;
+    }
+
+    m_deferInsertion = defer;
+    if (defer)
+    {
+      // Nodes that are created while deferred are not in the tree, they would be lost by the swap.
+      m_backgroundBuild = nullptr;
+    }
+    else
+    {
+      Rebuild();
+    }
+  }
+
+  float AABBTree::CalculateSAHCost() const
+  {
+    if (m_root == nullNode || m_nodes[m_root].IsLeaf())
+    {
+      return 0.0f;
+    }
+
+    float internalArea = 0.0f;
+    for (int32 i = 0; i < m_nodeCapacity; ++i)
+    {
+      // Skip the free nodes and the leafs.
+      if (m_nodes[i].parent != i && !m_nodes[i].IsLeaf())
+      {
+        internalArea += m_nodes[i].aabb.HalfSurfaceArea();
+      }
+    }
+
+    // Internal node count grows with the leafs, cost per leaf is compared with the cost at the last build.
+    float rootArea = m_nodes[m_root].aabb.HalfSurfaceArea();
+    int leafCount  = (m_nodeCount + 1) / 2;
+    return rootArea > 0.0f ? internalArea / (rootArea * (float) leafCount) : 0.0f;
+  }
+
+  void AABBTree::CheckTreeQuality()
+  {
+    SwapBackgroundBuild();
+    if (m_backgroundBuild != nullptr)
+    {
+      return;
+    }
+
+    // Cost is only checked after a fair amount of insertions, so that its calculation is amortized.
+    int leafCount = (m_nodeCount + 1) / 2;
+    if (m_insertionsSinceBuild < glm::max(leafCount / 8, 256))
+    {
+      return;
+    }
+
+    m_insertionsSinceBuild = 0;
+
+    // A tree that is only built incrementally has no build cost to compare with, it is rebuilt once.
+    float cost             = CalculateSAHCost();
+    if (m_builtSAHCost > 0.0f && cost <= m_builtSAHCost * m_rebuildRatio)
+    {
+      return;
+    }
+
+    if (Main::GetInstance()->m_threaded)
+    {
+      StartBackgroundBuild();
+    }
+    else
+    {
+      Rebuild();
+    }
+  }
+
+  void AABBTree::StartBackgroundBuild()
+  {
+    BackgroundBuildPtr build = std::make_shared<BackgroundBuild>();
+    build->leafs.reserve((m_nodeCount + 1) / 2);
+
+    for (int32 i = 0; i < m_nodeCapacity; ++i)
+    {
+      // Skip the free nodes and the internal nodes.
+      if (m_nodes[i].parent == i || !m_nodes[i].IsLeaf())
+      {
+        continue;
+      }
+
+      BuildLeaf& leaf = build->leafs.emplace_back();
+      leaf.aabb       = m_nodes[i].aabb;
+      leaf.center     = m_nodes[i].aabb.GetCenter();
+      leaf.node       = (AABBNodeProxy) build->leafNodes.size();
+
+      build->leafNodes.push_back(i);
+      build->entities.push_back(m_nodes[i].entity);
+    }
+
+    if (build->leafs.size() < 2)
+    {
+      return;
+    }
+
+    m_backgroundBuild = build;
+    TKAsyncTask(WorkerManager::BackgroundPool, [build]() -> void { BuildBackgroundTree(*build); });
+  }
+
+  void AABBTree::BuildBackgroundTree(BackgroundBuild& build)
+  {
+    float beginTime     = GetElapsedMilliSeconds();
+
+    // Snapshot leafs are the first nodes, internal nodes follow them.
+    const int leafCount = (int) build.leafs.size();
+    build.nodes.resize(2 * leafCount - 1);
+    for (int i = 0; i < leafCount; i++)
+    {
+      build.nodes[i].child1 = nullNode;
+      build.nodes[i].child2 = nullNode;
+    }
+
+    NodeProxyArray internals(leafCount - 1);
+    for (int i = 0; i < leafCount - 1; i++)
+    {
+      internals[i] = leafCount + i;
+    }
+
+    // Job system is not used, waiting on the frame jobs would stall the background pool.
+    BuildRange rootRange = {0, leafCount, 0};
+    BuildLeaf* leafs     = build.leafs.data();
+    CalculateRangeBounds(leafs, rootRange);
+    build.root                     = BuildSubTree(build.nodes, leafs, internals.data(), rootRange, nullptr);
+    build.nodes[build.root].parent = nullNode;
+
+    build.buildTime                = GetElapsedMilliSeconds() - beginTime;
+    build.finished.store(true, std::memory_order_release);
+  }
+
+  void AABBTree::SwapBackgroundBuild()
+  {
+    if (m_backgroundBuild == nullptr || !m_backgroundBuild->finished.load(std::memory_order_acquire))
+    {
+      return;
+    }
+
+    BackgroundBuildPtr build = std::move(m_backgroundBuild);
+    m_backgroundBuild        = nullptr;
+
+    // Only the leafs of the current tree are kept.
+    for (int32 i = 0; i < m_nodeCapacity; ++i)
+    {
+      if (m_nodes[i].parent != i && !m_nodes[i].IsLeaf())
+      {
+        FreeNode(i);
+      }
+    }
+
+    // Snapshot leafs that are freed or reused by another entity during the build are removed from the built tree, their
+    // siblings take the place of their parents.
+    AABBNodeArray& nodes = build->nodes;
+    const int leafCount  = (int) build->leafNodes.size();
+    std::vector<uint8> removed(nodes.size(), 0);
+    std::vector<uint8> inTree(m_nodeCapacity, 0);
+    AABBNodeProxy root = build->root;
+
+    for (int i = 0; i < leafCount; i++)
+    {
+      AABBNodeProxy leaf         = build->leafNodes[i];
+      const EntityWeakPtr& owner = build->entities[i];
+      const EntityWeakPtr& ntt   = m_nodes[leaf].entity;
+      if (m_nodes[leaf].parent != leaf && !ntt.owner_before(owner) && !owner.owner_before(ntt))
+      {
+        inTree[leaf] = 1;
+        continue;
+      }
+
+      removed[i]           = 1;
+      AABBNodeProxy parent = nodes[i].parent;
+      if (parent == nullNode)
+      {
+        root = nullNode;
+        continue;
+      }
+
+      AABBNodeProxy sibling     = nodes[parent].child1 == i ? nodes[parent].child2 : nodes[parent].child1;
+      AABBNodeProxy grandParent = nodes[parent].parent;
+      removed[parent]           = 1;
+      nodes[sibling].parent     = grandParent;
+
+      if (grandParent == nullNode)
+      {
+        root = sibling;
+      }
+      else if (nodes[grandParent].child1 == parent)
+      {
+        nodes[grandParent].child1 = sibling;
+      }
+      else
+      {
+        nodes[grandParent].child2 = sibling;
+      }
+    }
+
+    // Remaining leafs are created during the build.
+    NodeProxyArray createdLeafs;
+    for (int32 i = 0; i < m_nodeCapacity; ++i)
+    {
+      if (m_nodes[i].parent != i && inTree[i] == 0)
+      {
+        createdLeafs.push_back(i);
+      }
+    }
+
+    NodeProxyArray proxies(nodes.size(), nullNode);
+    for (int i = 0; i < leafCount; i++)
+    {
+      proxies[i] = build->leafNodes[i];
+    }
+
+    for (int i = leafCount; i < (int) nodes.size(); i++)
+    {
+      if (removed[i] == 0)
+      {
+        proxies[i] = AllocateNode();
+      }
+    }
+
+    // Children are always after their parents, linking in reverse order refits the bounds with the current leaf bounds.
+    for (int i = (int) nodes.size() - 1; i >= leafCount; i--)
+    {
+      if (removed[i] != 0)
+      {
+        continue;
+      }
+
+      AABBNodeProxy node     = proxies[i];
+      AABBNodeProxy child1   = proxies[nodes[i].child1];
+      AABBNodeProxy child2   = proxies[nodes[i].child2];
+
+      m_nodes[node].child1   = child1;
+      m_nodes[node].child2   = child2;
+      m_nodes[node].aabb     = BoundingBox::Union(m_nodes[child1].aabb, m_nodes[child2].aabb);
+      m_nodes[child1].parent = node;
+      m_nodes[child2].parent = node;
+    }
+
+    m_root = root != nullNode ? proxies[root] : nullNode;
+    if (m_root != nullNode)
+    {
+      m_nodes[m_root].parent = nullNode;
+    }
+
+    for (AABBNodeProxy leaf : createdLeafs)
+    {
+      m_nodes[leaf].parent = nullNode;
+      InsertLeaf(leaf);
+    }
+
+    m_wideTreeDirty        = true;
+    m_insertionsSinceBuild = 0;
+    m_builtSAHCost         = CalculateSAHCost();
+
+    if (TKStats* stats = GetTKStats())
+    {
+      stats->m_aabbTreeBuildTime = build->buildTime;
+      stats->m_aabbTreeSAHCost   = m_builtSAHCost;
+    }
+  }
+
+  AABBNodeProxy AABBTree::BuildSubTree(AABBNodeArray& nodes,
+                                       BuildLeaf* leafs,
+                                       const AABBNodeProxy* internals,
+                                       const BuildRange& range,
+                                       JobSystem* jobSystem)
+  {
+    const int begin = range.begin;
+    const int end   = range.end;
+    if (end - begin == 1)
+    {
+      return leafs[begin].node;
+    }
+
+    // Root takes the first internal node, rest is shared by the children in the order of their leafs.
+    BuildRange range1;
+    BuildRange range2;
+    range1.begin         = begin;
+    range1.internalBegin = range.internalBegin + 1;
+    range2.end           = end;
+
+    // Split along the longest axis of the centers.
+    Vec3 extent          = range.centerBounds.max - range.centerBounds.min;
+    int axis             = 0;
+    if (extent.y > extent[axis])
+    {
+      axis = 1;
+    }
+
+    if (extent.z > extent[axis])
+    {
+      axis = 2;
+    }
+
+    int bestSplit = -1;
+    if (extent[axis] > 0.0f)
+    {
+      // Bin the centers and find the split plane with the lowest surface area heuristic cost.
+      constexpr int binCount = 16;
+      BoundingBox binBounds[binCount];
+      BoundingBox binCenterBounds[binCount];
+      int binLeafCounts[binCount] = {0};
+
+      const float binScale        = binCount * 0.9999f / extent[axis];
+      const float axisMin         = range.centerBounds.min[axis];
+      auto binIndexFn             = [=](const BuildLeaf& leaf) -> int
+      { return (int) ((leaf.center[axis] - axisMin) * binScale); };
+
+      for (int i = begin; i < end; i++)
+      {
+        int bin = binIndexFn(leafs[i]);
+        binBounds[bin].UpdateBoundary(leafs[i].aabb);
+        binCenterBounds[bin].UpdateBoundary(leafs[i].center);
+        binLeafCounts[bin]++;
+      }
+
+      // Sweep from right to left to accumulate the right side costs. Union is used for merging since empty bins are
+      // inverted boxes.
+      float rightCosts[binCount];
+      BoundingBox rightBounds;
+      int rightCount = 0;
+      for (int i = binCount - 1; i > 0; i--)
+      {
+        rightBounds    = BoundingBox::Union(rightBounds, binBounds[i]);
+        rightCount    += binLeafCounts[i];
+        rightCosts[i]  = rightCount > 0 ? rightBounds.HalfSurfaceArea() * rightCount : 0.0f;
+      }
 
-      // Find the best aabb pair
-      for (int32 i = 0; i < count; ++i)
+      float bestCost = TK_FLT_MAX;
+      BoundingBox leftBounds;
+      int leftCount = 0;
+      for (int i = 0; i < binCount - 1; i++)
       {
-        BoundingBox aabbI = m_nodes[leaves[i]].aabb;
+        leftBounds  = BoundingBox::Union(leftBounds, binBounds[i]);
+        leftCount  += binLeafCounts[i];
 
-        for (int32 j = i + 1; j < count; ++j)
+        // Both sides must contain leafs.
+        if (leftCount == 0 || leftCount == end - begin)
         {
-          BoundingBox aabbJ    = m_nodes[leaves[j]].aabb;
+          continue;
+        }
 
-          BoundingBox combined = BoundingBox::Union(aabbI, aabbJ);
-          float cost           = combined.SurfaceArea();
+        float cost = leftBounds.HalfSurfaceArea() * leftCount + rightCosts[i + 1];
+        if (cost < bestCost)
+        {
+          bestCost  = cost;
+          bestSplit = i;
+        }
+      }
 
-          if (cost < minCost)
-          {
-            minCost = cost;
-            minI    = i;
-            minJ    = j;
-          }
+      if (bestSplit != -1)
+      {
+        BuildLeaf* midLeaf = std::partition(leafs + begin,
+                                            leafs + end,
+                                            [=](const BuildLeaf& leaf) -> bool
+                                            { return binIndexFn(leaf) <= bestSplit; });
+        range1.end         = (int) (midLeaf - leafs);
+
+        // Bounds of the children are known from the bins, no need to iterate over the leafs again.
+        for (int i = 0; i < binCount; i++)
+        {
+          BuildRange& side  = i <= bestSplit ? range1 : range2;
+          side.bounds       = BoundingBox::Union(side.bounds, binBounds[i]);
+          side.centerBounds = BoundingBox::Union(side.centerBounds, binCenterBounds[i]);
         }
       }
+    }
 
-      AABBNodeProxy index1      = leaves[minI];
-      AABBNodeProxy index2      = leaves[minJ];
-      AABBNode* child1          = &m_nodes[index1];
-      AABBNode* child2          = &m_nodes[index2];
+    // If all centers are at the same point, any split is as good as the others.
+    if (bestSplit == -1)
+    {
+      range1.end = (begin + end) / 2;
+    }
 
-      // Create a parent(internal) node
-      AABBNodeProxy parentIndex = AllocateNode();
-      AABBNode* parent          = &m_nodes[parentIndex];
+    range2.begin         = range1.end;
+    range2.internalBegin = range.internalBegin + range1.end - begin;
 
-      parent->child1            = index1;
-      parent->child2            = index2;
-      parent->aabb              = BoundingBox::Union(child1->aabb, child2->aabb);
-      parent->parent            = nullNode;
+    if (bestSplit == -1)
+    {
+      CalculateRangeBounds(leafs, range1);
+      CalculateRangeBounds(leafs, range2);
+    }
 
-      child1->parent            = parentIndex;
-      child2->parent            = parentIndex;
+    // Children write to distinct leafs and internal nodes, so they can be built concurrently. Large first child is
+    // built on a job while this thread builds the second one. Waiting thread executes the pending jobs.
+    constexpr int parallelLeafCount = 2048;
 
-      leaves[minI]              = parentIndex;
+    AABBNodeProxy child1            = nullNode;
+    JobPtr child1Job;
+    if (jobSystem != nullptr && range1.end - range1.begin >= parallelLeafCount)
+    {
+      child1Job = jobSystem->Schedule([&]() -> void
+                                      { child1 = BuildSubTree(nodes, leafs, internals, range1, jobSystem); });
+    }
+    else
+    {
+      child1 = BuildSubTree(nodes, leafs, internals, range1, jobSystem);
+    }
 
-      leaves[minJ]              = leaves[count - 1];
-      --count;
+    AABBNodeProxy child2 = BuildSubTree(nodes, leafs, internals, range2, jobSystem);
+    if (child1Job != nullptr)
+    {
+      jobSystem->Wait(child1Job);
     }
 
-    if (!leaves.empty())
+    AABBNodeProxy node   = internals[range.internalBegin];
+    AABBNode& internal   = nodes[node];
+    internal.aabb        = range.bounds;
+    internal.child1      = child1;
+    internal.child2      = child2;
+
+    nodes[child1].parent = node;
+    nodes[child2].parent = node;
+
+    return node;
+  }
+
+  void AABBTree::CalculateRangeBounds(const BuildLeaf* leafs, BuildRange& range)
+  {
+    range.bounds       = BoundingBox();
+    range.centerBounds = BoundingBox();
+    for (int i = range.begin; i < range.end; i++)
     {
-      m_root = leaves[0];
-      leaves.clear();
+      range.bounds.UpdateBoundary(leafs[i].aabb);
+      range.centerBounds.UpdateBoundary(leafs[i].center);
     }
   }
 
@@ -234,179 +728,660 @@ namespace ToolKit
   {
     UpdateTree();
 
-    if (m_root != nullNode)
+    if (m_root != nullNode)
+    {
+      return m_nodes[m_root].aabb;
+    }
+
+    return infinitesimalBox;
+  }
+
+  AABBNodeProxy AABBTree::AllocateNode()
+  {
+    if (m_freeList == nullNode)
+    {
+      assert(m_nodeCount == m_nodeCapacity);
+
+      // Grow the node pool
+      m_nodeCapacity += m_nodeCapacity / 2;
+      m_nodes.resize(m_nodeCapacity);
+
+      // Build a linked list for the free list.
+      for (int32 i = m_nodeCount; i < m_nodeCapacity - 1; ++i)
+      {
+        m_nodes[i].next   = i + 1;
+        m_nodes[i].parent = i;
+      }
+      m_nodes[m_nodeCapacity - 1].parent = m_nodeCapacity - 1;
+      m_nodes[m_nodeCapacity - 1].next   = nullNode;
+
+      m_freeList                         = m_nodeCount;
+    }
+
+    AABBNodeProxy node   = m_freeList;
+    m_freeList           = m_nodes[node].next;
+    m_nodes[node].parent = nullNode;
+    m_nodes[node].child1 = nullNode;
+    m_nodes[node].child2 = nullNode;
+    m_nodes[node].entity.reset();
+    ++m_nodeCount;
+
+    return node;
+  }
+
+  /** Traversal stack of the calling thread for volume queries. Grows to the tree depth once and gets reused. */
+  static thread_local NodeProxyArray g_volumeQueryStack;
+
+  /**
+   * Scratch buffers of the calling thread for threaded volume queries and batched ray queries. Queries move them out
+   * while running and back when done, so a query that starts on the same thread while the other one waits for its
+   * workers gets its own buffers.
+   */
+  static thread_local NodeProxyArray g_queryRoots;
+  static thread_local std::vector<EntityRawPtrArray> g_queryResults;
+  static thread_local std::vector<uint64> g_rayOrder;
+
+  /** Tests the volume against the box. */
+  template <typename VolumeType>
+  static IntersectResult VolumeBoxIntersection(const VolumeType& vol, const BoundingBox& box)
+  {
+    if constexpr (std::is_same_v<VolumeType, Frustum>)
+    {
+      return FrustumBoxIntersection(vol, box);
+    }
+    else if constexpr (std::is_same_v<VolumeType, BoundingBox>)
+    {
+      return BoxBoxIntersection(vol, box);
+    }
+    else
+    {
+      static_assert(std::is_same_v<VolumeType, Frustum> || std::is_same_v<VolumeType, BoundingBox>,
+                    "Volume query is not implemented.");
+    }
+  }
+
+  /** Tests the volume against 4 boxes at once. */
+  template <typename VolumeType>
+  static void VolumeBoxIntersection(const VolumeType& vol, const BoundingBox4& boxes, int& outsideMask, int& insideMask)
+  {
+    if constexpr (std::is_same_v<VolumeType, Frustum>)
+    {
+      FrustumBoxIntersection(vol, boxes, outsideMask, insideMask);
+    }
+    else if constexpr (std::is_same_v<VolumeType, BoundingBox>)
+    {
+      BoxBoxIntersection(vol, boxes, outsideMask, insideMask);
+    }
+    else
+    {
+      static_assert(std::is_same_v<VolumeType, Frustum> || std::is_same_v<VolumeType, BoundingBox>,
+                    "Volume query is not implemented.");
+    }
+  }
+
+  /** Test tree against a frustum. */
+  template TK_API EntityRawPtrArray AABBTree::VolumeQuery(const Frustum& frustum, bool threaded);
+
+  /** Test tree against a box. */
+  template TK_API EntityRawPtrArray AABBTree::VolumeQuery(const BoundingBox& box, bool threaded);
+
+  /** Test tree against a frustum. */
+  template TK_API void AABBTree::VolumeQuery(const Frustum& frustum, EntityRawPtrArray& result, bool threaded);
+
+  /** Test tree against a box. */
+  template TK_API void AABBTree::VolumeQuery(const BoundingBox& box, EntityRawPtrArray& result, bool threaded);
+
+  template <typename VolumeType>
+  EntityRawPtrArray AABBTree::VolumeQuery(const VolumeType& vol, bool threaded)
+  {
+    EntityRawPtrArray entities;
+    VolumeQuery(vol, entities, threaded);
+
+    return entities;
+  }
+
+  template <typename VolumeType>
+  void AABBTree::VolumeQuery(const VolumeType& vol, EntityRawPtrArray& result, bool threaded)
+  {
+    UpdateTree();
+
+    result.clear();
+    if (m_root == nullNode)
+    {
+      return;
+    }
+
+    if (m_wideTraversal)
+    {
+      UpdateWideTree();
+    }
+
+    const bool wide = m_wideTraversal && !m_wideNodes.empty();
+    int threadCount =
+        m_nodeCount > m_threadTreshold && threaded ? GetWorkerManager()->GetThreadCount(WorkerManager::FramePool) : 0;
+
+    if (threadCount == 0)
+    {
+      if (wide)
+      {
+        WideVolumeQuery(vol, 0, g_volumeQueryStack, result);
+      }
+      else
+      {
+        VolumeQuery(vol, m_root, g_volumeQueryStack, result);
+      }
+      return;
+    }
+
+    NodeProxyArray queryRoots                   = std::move(g_queryRoots);
+    std::vector<EntityRawPtrArray> queryResults = std::move(g_queryResults);
+    queryRoots.clear();
+
+    // Split the tree in to sub trees level by level, until there are enough of them to balance the load across threads.
+    const size_t targetRootCount = (size_t) (threadCount + 1) * 4;
+    queryRoots.push_back(wide ? 0 : m_root);
+
+    bool expanded = true;
+    while (expanded && queryRoots.size() < targetRootCount)
+    {
+      expanded               = false;
+      const size_t rootCount = queryRoots.size();
+      for (size_t i = 0; i < rootCount && queryRoots.size() < targetRootCount; i++)
+      {
+        if (wide)
+        {
+          // Negative roots are wide leafs, they can't be split further.
+          if (queryRoots[i] >= 0)
+          {
+            const WideNode& node = m_wideNodes[queryRoots[i]];
+            queryRoots[i]        = node.children[0];
+            queryRoots.insert(queryRoots.end(), node.children + 1, node.children + node.childCount);
+            expanded = true;
+          }
+          continue;
+        }
+
+        const AABBNode& node = m_nodes[queryRoots[i]];
+        if (!node.IsLeaf())
+        {
+          queryRoots[i] = node.child1;
+          queryRoots.push_back(node.child2);
+          expanded = true;
+        }
+      }
+    }
+
+    // Result buffers only grow, their memory is reused in the consecutive queries.
+    if (queryResults.size() < queryRoots.size())
+    {
+      queryResults.resize(queryRoots.size());
+    }
+
+    auto queryRootsFn = [this, &vol, &queryRoots, &queryResults, wide](size_t beginIndex, size_t endIndex) -> void
+    {
+      for (size_t i = beginIndex; i < endIndex; i++)
+      {
+        queryResults[i].clear();
+        if (wide)
+        {
+          WideVolumeQuery(vol, queryRoots[i], g_volumeQueryStack, queryResults[i]);
+        }
+        else
+        {
+          VolumeQuery(vol, queryRoots[i], g_volumeQueryStack, queryResults[i]);
+        }
+      }
+    };
+
+    GetWorkerManager()->ParallelFor(queryRoots.size(), 1, queryRootsFn);
+
+    // Merge the results of each sub tree.
+    size_t totalCount = 0;
+    for (size_t i = 0; i < queryRoots.size(); i++)
+    {
+      totalCount += queryResults[i].size();
+    }
+
+    result.reserve(totalCount);
+    for (size_t i = 0; i < queryRoots.size(); i++)
+    {
+      result.insert(result.end(), queryResults[i].begin(), queryResults[i].end());
+    }
+
+    g_queryRoots   = std::move(queryRoots);
+    g_queryResults = std::move(queryResults);
+  }
+
+  EntityPtr AABBTree::RayQuery(const Ray& ray, bool deep, float* t, const IDArray& ignoreList)
+  {
+    if (m_root == nullNode)
+    {
+      return nullptr;
+    }
+
+    UpdateTree();
+
+    if (m_wideTraversal)
+    {
+      UpdateWideTree();
+    }
+
+    RayHit hit;
+
+    if (m_wideTraversal && !m_wideNodes.empty())
+    {
+      NodeProxyArray& stack = g_volumeQueryStack;
+      stack.clear();
+      stack.push_back(0);
+
+      while (!stack.empty())
+      {
+        const WideNode& node = m_wideNodes[stack.back()];
+        stack.pop_back();
+
+        float dists[4];
+        int hitMask = RayBoxIntersection(ray, node.bounds, dists);
+
+        // Sort the hit children by distance. Boxes that start behind the closest hit can't contain a closer hit.
+        int order[4];
+        int hitCount = 0;
+        for (int i = 0; i < node.childCount; i++)
+        {
+          if ((hitMask & (1 << i)) && dists[i] < hit.t)
+          {
+            int j = hitCount++;
+            for (; j > 0 && dists[order[j - 1]] > dists[i]; j--)
+            {
+              order[j] = order[j - 1];
+            }
+            order[j] = i;
+          }
+        }
+
+        // Test the leafs from near to far, so that the hit distance shrinks as early as possible.
+        for (int i = 0; i < hitCount; i++)
+        {
+          int32 child = node.children[order[i]];
+          if (child < 0 && dists[order[i]] < hit.t)
+          {
+            TestRayLeaf(ray, m_wideLeafs[~child], dists[order[i]], deep, ignoreList, hit);
+          }
+        }
+
+        // Push the internal nodes from far to near, so that the nearest one is visited first.
+        for (int i = hitCount - 1; i >= 0; i--)
+        {
+          int32 child = node.children[order[i]];
+          if (child >= 0 && dists[order[i]] < hit.t)
+          {
+            stack.push_back(child);
+          }
+        }
+      }
+    }
+    else
+    {
+      std::deque<AABBNodeProxy> stack;
+      stack.emplace_back(m_root);
+
+      while (stack.size() != 0)
+      {
+        AABBNodeProxy current = stack.back();
+        stack.pop_back();
+
+        float intersecLen;
+        if (RayBoxIntersection(ray, m_nodes[current].aabb, intersecLen))
+        {
+          if (m_nodes[current].IsLeaf())
+          {
+            TestRayLeaf(ray, current, intersecLen, deep, ignoreList, hit);
+          }
+          else
+          {
+            stack.emplace_back(m_nodes[current].child1);
+            stack.emplace_back(m_nodes[current].child2);
+          }
+        }
+      }
+    }
+
+    if (t != nullptr)
     {
-      return m_nodes[m_root].aabb;
+      *t = hit.t;
     }
 
-    return infinitesimalBox;
+    return hit.entity;
   }
 
-  AABBNodeProxy AABBTree::AllocateNode()
+  /** Spreads the lower 10 bits of the value to every third bit, used for interleaving the bits of morton codes. */
+  static uint32 SpreadBits3(uint32 val)
   {
-    if (m_freeList == nullNode)
+    val = (val * 0x00010001u) & 0xFF0000FFu;
+    val = (val * 0x00000101u) & 0x0F00F00Fu;
+    val = (val * 0x00000011u) & 0xC30C30C3u;
+    val = (val * 0x00000005u) & 0x49249249u;
+    return val;
+  }
+
+  void AABBTree::RayQueryBatch(const RayArray& rays,
+                               bool deep,
+                               RayHitArray& results,
+                               const IDArray& ignoreList,
+                               bool threaded)
+  {
+    results.assign(rays.size(), RayHit());
+    if (m_root == nullNode || rays.empty())
     {
-      assert(m_nodeCount == m_nodeCapacity);
+      return;
+    }
 
-      // Grow the node pool
-      m_nodeCapacity += m_nodeCapacity / 2;
-      m_nodes.resize(m_nodeCapacity);
+    // Tree is updated once for the whole batch. Packets always traverse the wide tree.
+    UpdateTree();
+    UpdateWideTree();
 
-      // Build a linked list for the free list.
-      for (int32 i = m_nodeCount; i < m_nodeCapacity - 1; ++i)
+    if (m_wideNodes.empty())
+    {
+      // Tree consists of a single leaf.
+      for (size_t i = 0; i < rays.size(); i++)
       {
-        m_nodes[i].next   = i + 1;
-        m_nodes[i].parent = i;
+        float boxDist;
+        if (RayBoxIntersection(rays[i], m_nodes[m_root].aabb, boxDist))
+        {
+          TestRayLeaf(rays[i], m_root, boxDist, deep, ignoreList, results[i]);
+        }
       }
-      m_nodes[m_nodeCapacity - 1].parent = m_nodeCapacity - 1;
-      m_nodes[m_nodeCapacity - 1].next   = nullNode;
-
-      m_freeList                         = m_nodeCount;
+      return;
     }
 
-    AABBNodeProxy node   = m_freeList;
-    m_freeList           = m_nodes[node].next;
-    m_nodes[node].parent = nullNode;
-    m_nodes[node].child1 = nullNode;
-    m_nodes[node].child2 = nullNode;
-    m_nodes[node].entity.reset();
-    m_nodes[node].leafs.clear();
-    ++m_nodeCount;
+    std::vector<uint64> rayOrder = std::move(g_rayOrder);
+    rayOrder.resize(rays.size());
 
-    return node;
-  }
+    // Sort the rays by their direction octant, origin and direction. Rays that are packed together start close to each
+    // other and travel in similar directions, so they visit mostly the same nodes.
+    const BoundingBox& rootBox = m_nodes[m_root].aabb;
+    const Vec3 originScale     = 63.0f / glm::max(rootBox.max - rootBox.min, Vec3(TK_FLT_MIN));
 
-  /** Test tree against a frustum. */
-  template TK_API EntityRawPtrArray AABBTree::VolumeQuery(const Frustum& frustum, bool threaded);
+    for (size_t i = 0; i < rays.size(); i++)
+    {
+      const Ray& ray    = rays[i];
+      Vec3 originCell   = glm::clamp((ray.position - rootBox.min) * originScale, Vec3(0.0f), Vec3(63.0f));
+      Vec3 dirCell      = glm::clamp((glm::normalize(ray.direction) + 1.0f) * 3.5f, Vec3(0.0f), Vec3(7.0f));
+
+      uint32 octant     = (ray.direction.x < 0.0f) | (ray.direction.y < 0.0f) << 1 | (ray.direction.z < 0.0f) << 2;
+      uint32 originCode = SpreadBits3((uint32) originCell.x) | SpreadBits3((uint32) originCell.y) << 1 |
+                          SpreadBits3((uint32) originCell.z) << 2;
+      uint32 dirCode    = SpreadBits3((uint32) dirCell.x) | SpreadBits3((uint32) dirCell.y) << 1 |
+                          SpreadBits3((uint32) dirCell.z) << 2;
+
+      uint32 key        = octant << 27 | originCode << 9 | dirCode;
+      rayOrder[i]       = (uint64) key << 32 | (uint64) i;
+    }
+    std::sort(rayOrder.begin(), rayOrder.end());
 
-  /** Test tree against a box. */
-  template TK_API EntityRawPtrArray AABBTree::VolumeQuery(const BoundingBox& box, bool threaded);
+    // Posing a skinned entity writes to its skeleton, threaded packets leave their deep tests to this thread. Buffers
+    // are reused like the ray order, chunk buffer collects the tests of a chunk before they are merged under the lock.
+    static thread_local DeferredRayTestArray deferredTestsBuffer;
+    static thread_local DeferredRayTestArray chunkTestsBuffer;
 
-  template <typename VolumeType>
-  EntityRawPtrArray AABBTree::VolumeQuery(const VolumeType& vol, bool threaded)
-  {
-    UpdateTree();
+    DeferredRayTestArray deferredTests = std::move(deferredTestsBuffer);
+    deferredTests.clear();
+    Spinlock deferredTestsLock;
+    const bool deferPosed    = threaded && deep;
 
-    EntityRawPtrArray entities;
-    if (m_root == nullNode)
+    const size_t packetCount = (rays.size() + 3) / 4;
+    auto queryPacketsFn      = [&](size_t beginIndex, size_t endIndex) -> void
     {
-      return entities;
-    }
+      DeferredRayTestArray& chunkTests = chunkTestsBuffer;
+      chunkTests.clear();
 
-    EntityRawPtrArray entitiesInVolume;
-    entitiesInVolume.resize(m_nodeCapacity);
-    std::fill(entitiesInVolume.begin(), entitiesInVolume.end(), nullptr);
-
-    m_maxThreadCount =
-        m_nodeCount > m_threadTreshold && threaded ? GetWorkerManager()->GetThreadCount(WorkerManager::FramePool) : 0;
+      for (size_t i = beginIndex; i < endIndex; i++)
+      {
+        size_t first = i * 4;
+        int rayCount = (int) glm::min(rays.size() - first, (size_t) 4);
+        RayQueryPacket(rays.data(),
+                       rayOrder.data() + first,
+                       rayCount,
+                       deep,
+                       ignoreList,
+                       results.data(),
+                       deferPosed ? &chunkTests : nullptr);
+      }
 
-    std::atomic_int availableThreadCount(glm::max(0, m_maxThreadCount - 1));
+      if (!chunkTests.empty())
+      {
+        SpinlockGuard guard(deferredTestsLock);
+        deferredTests.insert(deferredTests.end(), chunkTests.begin(), chunkTests.end());
+      }
+    };
 
-    if constexpr (std::is_same_v<VolumeType, Frustum>)
-    {
-      VolumeQuery(entitiesInVolume,
-                  availableThreadCount,
-                  m_root,
-                  [this, &vol](AABBNodeProxy root) -> IntersectResult
-                  { return FrustumBoxIntersection(vol, m_nodes[root].aabb); });
-    }
-    else if constexpr (std::is_same_v<VolumeType, BoundingBox>)
+    if (threaded)
     {
-      VolumeQuery(entitiesInVolume,
-                  availableThreadCount,
-                  m_root,
-                  [this, &vol](AABBNodeProxy root) -> IntersectResult
-                  { return BoxBoxIntersection(vol, m_nodes[root].aabb); });
+      // Mesh level tests are much more expensive than the traversal, deep queries are distributed in smaller chunks.
+      GetWorkerManager()->ParallelFor(packetCount, deep ? 2 : 16, queryPacketsFn);
     }
     else
     {
-      assert(0 && "Volume query is not implemented.");
-      return entities;
+      queryPacketsFn(0, packetCount);
     }
 
-    // If there are threads in work, wait for them.
-    SpinWaitBarrier([&]() -> bool { return availableThreadCount.load() < m_maxThreadCount; });
-
-    entities.reserve(m_nodeCapacity);
+    // Nearer leafs are tested first, farther ones are skipped once a ray hits something before them.
+    std::sort(deferredTests.begin(),
+              deferredTests.end(),
+              [](const DeferredRayTest& a, const DeferredRayTest& b) -> bool { return a.boxDist < b.boxDist; });
 
-    for (int i = 0; i < (int) entitiesInVolume.size(); i++)
+    for (const DeferredRayTest& test : deferredTests)
     {
-      if (entitiesInVolume[i] != nullptr)
+      RayHit& hit = results[test.rayIndex];
+      if (test.boxDist < hit.t)
       {
-        entities.push_back(entitiesInVolume[i]);
+        TestRayLeaf(rays[test.rayIndex], test.leaf, test.boxDist, deep, ignoreList, hit);
       }
     }
 
-    return entities;
+    g_rayOrder          = std::move(rayOrder);
+    deferredTestsBuffer = std::move(deferredTests);
   }
 
-  EntityPtr AABBTree::RayQuery(const Ray& ray, bool deep, float* t, const IDArray& ignoreList)
+  /** Ray of a packet whose origin and reciprocal direction are broadcasted once to be tested against many nodes. */
+  struct PacketRay
   {
-    if (m_root == nullNode)
-    {
-      return nullptr;
-    }
+    Float4 posX;
+    Float4 posY;
+    Float4 posZ;
+    Float4 invDirX;
+    Float4 invDirY;
+    Float4 invDirZ;
+  };
+
+  /** Same as the RayBoxIntersection for 4 boxes, without preparing the ray for each test. */
+  static inline int PacketRayBoxIntersection(const PacketRay& ray, const BoundingBox4& boxes, float t[4])
+  {
+    Float4 minX  = Load4(boxes.minX);
+    Float4 maxX  = Load4(boxes.maxX);
+    Float4 vminX = (minX - ray.posX) * ray.invDirX;
+    Float4 vmaxX = (maxX - ray.posX) * ray.invDirX;
 
-    UpdateTree();
+    Float4 vminY = (Load4(boxes.minY) - ray.posY) * ray.invDirY;
+    Float4 vmaxY = (Load4(boxes.maxY) - ray.posY) * ray.invDirY;
 
-    std::deque<AABBNodeProxy> stack;
-    stack.emplace_back(m_root);
+    Float4 vminZ = (Load4(boxes.minZ) - ray.posZ) * ray.invDirZ;
+    Float4 vmaxZ = (Load4(boxes.maxZ) - ray.posZ) * ray.invDirZ;
 
-    float hitDist = TK_FLT_MAX;
-    EntityPtr hitEntity;
+    Float4 tmin  = Max4(Max4(Min4(vminX, vmaxX), Min4(vminY, vmaxY)), Min4(vminZ, vmaxZ));
+    Float4 tmax  = Min4(Min4(Max4(vminX, vmaxX), Max4(vminY, vmaxY)), Max4(vminZ, vmaxZ));
 
-    while (stack.size() != 0)
+    Mask4 hit    = (tmax >= Splat4(0.0f)) & (tmin <= tmax) & (minX <= maxX);
+    Store4(t, tmin);
+
+    return MoveMask4(hit);
+  }
+
+  /** Wide node to visit and the mask of the packet rays that hit its bounds. */
+  struct RayPacketEntry
+  {
+    int32 node;
+    int rayMask;
+  };
+
+  /** Traversal stack of the calling thread for ray packets. */
+  static thread_local std::vector<RayPacketEntry> g_rayPacketStack;
+
+  void AABBTree::RayQueryPacket(const Ray* rays,
+                                const uint64* rayOrder,
+                                int rayCount,
+                                bool deep,
+                                const IDArray& ignoreList,
+                                RayHit* results,
+                                DeferredRayTestArray* deferredTests) const
+  {
+    uint rayIndices[4];
+    float hitDists[4];
+    PacketRay packetRays[4];
+    for (int r = 0; r < rayCount; r++)
     {
-      AABBNodeProxy current = stack.back();
+      rayIndices[r]         = (uint) (rayOrder[r] & 0xFFFFFFFFu);
+
+      const Ray& ray        = rays[rayIndices[r]];
+      Vec3 invDir           = 1.0f / ray.direction;
+      packetRays[r].posX    = Splat4(ray.position.x);
+      packetRays[r].posY    = Splat4(ray.position.y);
+      packetRays[r].posZ    = Splat4(ray.position.z);
+      packetRays[r].invDirX = Splat4(invDir.x);
+      packetRays[r].invDirY = Splat4(invDir.y);
+      packetRays[r].invDirZ = Splat4(invDir.z);
+      hitDists[r]           = TK_FLT_MAX;
+    }
+
+    std::vector<RayPacketEntry>& stack = g_rayPacketStack;
+    stack.clear();
+    stack.push_back({0, (1 << rayCount) - 1});
+
+    while (!stack.empty())
+    {
+      RayPacketEntry entry = stack.back();
       stack.pop_back();
 
-      float intersecLen;
-      if (RayBoxIntersection(ray, m_nodes[current].aabb, intersecLen))
+      const WideNode& node = m_wideNodes[entry.node];
+
+      // Test each ray against the children. A child is kept with the rays that hit it before their closest hits.
+      float dists[4][4];
+      int childRayMasks[4] = {0, 0, 0, 0};
+      float childDists[4]  = {TK_FLT_MAX, TK_FLT_MAX, TK_FLT_MAX, TK_FLT_MAX};
+      for (int r = 0; r < rayCount; r++)
       {
-        if (m_nodes[current].IsLeaf())
+        if ((entry.rayMask & (1 << r)) == 0)
         {
-          EntityPtr candidate = m_nodes[current].entity.lock();
-          if (!ignoreList.empty())
+          continue;
+        }
+
+        int hitMask  = PacketRayBoxIntersection(packetRays[r], node.bounds, dists[r]);
+        hitMask     &= MoveMask4(Load4(dists[r]) < Splat4(hitDists[r]));
+        for (int i = 0; hitMask != 0; i++, hitMask >>= 1)
+        {
+          if (hitMask & 1)
           {
-            if (contains(ignoreList, candidate->GetIdVal()))
-            {
-              continue;
-            }
+            childRayMasks[i] |= 1 << r;
+            childDists[i]     = glm::min(childDists[i], dists[r][i]);
           }
+        }
+      }
 
-          if (deep)
+      // Sort the hit children by the nearest entry distance of the packet.
+      int order[4];
+      int hitCount = 0;
+      for (int i = 0; i < node.childCount; i++)
+      {
+        if (childRayMasks[i] != 0)
+        {
+          int j = hitCount++;
+          for (; j > 0 && childDists[order[j - 1]] > childDists[i]; j--)
           {
-            float meshDist;
-            if (RayEntityIntersection(ray, candidate, meshDist))
-            {
-              intersecLen = meshDist;
-            }
-            else
-            {
-              intersecLen = TK_FLT_MAX;
-            }
+            order[j] = order[j - 1];
           }
+          order[j] = i;
+        }
+      }
+
+      // Test the leafs from near to far, so that the hit distances shrink as early as possible.
+      for (int i = 0; i < hitCount; i++)
+      {
+        const int c = order[i];
+        int32 child = node.children[c];
+        if (child >= 0)
+        {
+          continue;
+        }
 
-          if (intersecLen < hitDist)
+        for (int r = 0; r < rayCount; r++)
+        {
+          if ((childRayMasks[c] & (1 << r)) && dists[r][c] < hitDists[r])
           {
-            hitDist   = intersecLen;
-            hitEntity = candidate;
+            RayHit& hit        = results[rayIndices[r]];
+            AABBNodeProxy leaf = m_wideLeafs[~child];
+            bool skipPosed     = deferredTests != nullptr;
+            if (!TestRayLeaf(rays[rayIndices[r]], leaf, dists[r][c], deep, ignoreList, hit, skipPosed))
+            {
+              deferredTests->push_back({rayIndices[r], leaf, dists[r][c]});
+            }
+            hitDists[r] = hit.t;
           }
         }
-        else
+      }
+
+      // Push the internal nodes from far to near, so that the nearest one is visited first.
+      for (int i = hitCount - 1; i >= 0; i--)
+      {
+        int32 child = node.children[order[i]];
+        if (child >= 0)
         {
-          stack.emplace_back(m_nodes[current].child1);
-          stack.emplace_back(m_nodes[current].child2);
+          stack.push_back({child, childRayMasks[order[i]]});
         }
       }
     }
+  }
 
-    if (t != nullptr)
+  bool AABBTree::TestRayLeaf(const Ray& ray,
+                             AABBNodeProxy leaf,
+                             float boxDist,
+                             bool deep,
+                             const IDArray& ignoreList,
+                             RayHit& hit,
+                             bool skipPosed) const
+  {
+    EntityPtr candidate = m_nodes[leaf].entity.lock();
+    if (candidate == nullptr)
+    {
+      return true;
+    }
+
+    if (!ignoreList.empty())
+    {
+      if (contains(ignoreList, candidate->GetIdVal()))
+      {
+        return true;
+      }
+    }
+
+    if (deep && skipPosed && candidate->GetComponentFast<SkeletonComponent>() != nullptr)
+    {
+      return false;
+    }
+
+    float dist        = boxDist;
+    uint submeshIndex = TK_UINT_MAX;
+    if (deep && !RayEntityIntersection(ray, candidate, dist, &submeshIndex))
     {
-      *t = hitDist;
+      return true;
     }
 
-    return hitEntity;
+    if (dist < hit.t)
+    {
+      hit.entity       = candidate;
+      hit.t            = dist;
+      hit.submeshIndex = submeshIndex;
+    }
+
+    return true;
   }
 
   void AABBTree::GetDebugBoundingBoxes(EntityPtrArray& boundingBoxes)
@@ -432,7 +1407,6 @@ namespace ToolKit
     m_nodes[node].parent = node;
     m_nodes[node].next   = m_freeList;
     m_nodes[node].entity.reset();
-    m_nodes[node].leafs.clear();
     m_freeList = node;
 
     --m_nodeCount;
@@ -483,32 +1457,12 @@ namespace ToolKit
       return;
     }
 
-    // n0 does not invalidate its parent leaf cache, n1 does due to depth difference.
-    // n0 is at a lower depth, moving it a higher depth does not alter n's leafs.
-    auto leafCacheUpdate = [&](AABBNodeProxy n0, AABBNodeProxy n1) -> void
-    {
-      AABBNodeProxy n0sibling = m_nodes[n1].parent;
-      assert(n0sibling != nullNode);
-
-      for (AABBNodeProxy leaf : m_nodes[n1].leafs)
-      {
-        m_nodes[n0sibling].leafs.erase(leaf);
-      }
-
-      for (AABBNodeProxy leaf : m_nodes[n0].leafs)
-      {
-        m_nodes[n0sibling].leafs.insert(leaf);
-      }
-    };
-
     // printf("Tree rotation occurred: %d\n", bestDiffIndex);
     switch (bestDiffIndex)
     {
     case 0:
     {
       // Swap(child2, nodes[child1].child2);
-      leafCacheUpdate(child2, m_nodes[child1].child2);
-
       m_nodes[m_nodes[child1].child2].parent = node;
       m_nodes[node].child2                   = m_nodes[child1].child2;
 
@@ -522,8 +1476,6 @@ namespace ToolKit
     case 1:
     {
       // Swap(child2, nodes[child1].child1);
-      leafCacheUpdate(child2, m_nodes[child1].child1);
-
       m_nodes[m_nodes[child1].child1].parent = node;
       m_nodes[node].child2                   = m_nodes[child1].child1;
 
@@ -537,8 +1489,6 @@ namespace ToolKit
     case 2:
     {
       // Swap(child1, nodes[child2].child2);
-      leafCacheUpdate(child1, m_nodes[child2].child2);
-
       m_nodes[m_nodes[child2].child2].parent = node;
       m_nodes[node].child1                   = m_nodes[child2].child2;
 
@@ -551,8 +1501,6 @@ namespace ToolKit
     case 3:
     {
       // Swap(child1, nodes[child2].child1);
-      leafCacheUpdate(child1, m_nodes[child2].child1);
-
       m_nodes[m_nodes[child2].child1].parent = node;
       m_nodes[node].child1                   = m_nodes[child2].child1;
 
@@ -566,73 +1514,241 @@ namespace ToolKit
     }
   }
 
-  void AABBTree::VolumeQuery(EntityRawPtrArray& result,
-                             std::atomic_int& threadCount,
+  template <typename VolumeType>
+  void AABBTree::VolumeQuery(const VolumeType& vol,
                              AABBNodeProxy root,
-                             std::function<IntersectResult(AABBNodeProxy)> queryFn) const
+                             NodeProxyArray& stack,
+                             EntityRawPtrArray& result) const
   {
-    std::deque<AABBNodeProxy> stack;
-    stack.emplace_back(root);
+    stack.clear();
+    stack.push_back(root);
 
-    while (stack.size() != 0)
+    while (!stack.empty())
     {
       AABBNodeProxy current = stack.back();
       stack.pop_back();
 
-      IntersectResult intResult = queryFn(current);
+      const AABBNode& node      = m_nodes[current];
+      IntersectResult intResult = VolumeBoxIntersection(vol, node.aabb);
 
       if (intResult == IntersectResult::Intersect)
       {
         // Volume is partially inside, check all internal volumes.
-        if (m_nodes[current].IsLeaf())
+        if (node.IsLeaf())
         {
-          if (!m_nodes[current].entity.expired())
+          if (Entity* ntt = node.entity.lock().get())
           {
-            result[current] = m_nodes[current].entity.lock().get();
+            result.push_back(ntt);
           }
         }
         else
         {
-          auto parallelProcessFn = [&](AABBNodeProxy node) -> void
-          {
-            if (node == nullNode)
-            {
-              return;
-            }
+          stack.push_back(node.child1);
+          stack.push_back(node.child2);
+        }
+      }
+      else if (intResult == IntersectResult::Inside)
+      {
+        // Volume is fully inside, get all entities without testing.
+        CollectLeafs(current, stack, result);
+      }
+    }
+  }
 
-            int currentCount = threadCount.load();
-            if (currentCount > 0)
-            {
-              if (threadCount.compare_exchange_strong(currentCount, currentCount - 1))
-              {
-                TKAsyncTask(WorkerManager::FramePool,
-                            [this, &result, &threadCount, node, queryFn]() -> void
-                            { VolumeQuery(result, threadCount, node, queryFn); });
-                return;
-              }
-            }
+  void AABBTree::CollectLeafs(AABBNodeProxy root, NodeProxyArray& stack, EntityRawPtrArray& result) const
+  {
+    // Work on top of the given stack, items below the base belong to the caller.
+    const size_t stackBase = stack.size();
+    stack.push_back(root);
 
-            stack.emplace_back(node);
-          };
+    while (stack.size() > stackBase)
+    {
+      const AABBNode& node = m_nodes[stack.back()];
+      stack.pop_back();
 
-          parallelProcessFn(m_nodes[current].child1);
-          parallelProcessFn(m_nodes[current].child2);
+      if (node.IsLeaf())
+      {
+        if (Entity* ntt = node.entity.lock().get())
+        {
+          result.push_back(ntt);
         }
       }
-      else if (intResult == IntersectResult::Inside)
+      else
+      {
+        stack.push_back(node.child1);
+        stack.push_back(node.child2);
+      }
+    }
+  }
+
+  void AABBTree::UpdateWideTree()
+  {
+    if (!m_wideTreeDirty)
+    {
+      return;
+    }
+
+    m_wideTreeDirty = false;
+    m_wideNodes.clear();
+    m_wideLeafs.clear();
+    m_wideParents.clear();
+    m_wideSlotNodes.clear();
+    m_leafWideNodes.assign(m_nodeCapacity, nullNode);
+
+    // A single leaf can't form a wide node, it is handled by the binary traversal.
+    if (m_root == nullNode || m_nodes[m_root].IsLeaf())
+    {
+      return;
+    }
+
+    // Each wide node holds at least 2 leafs, leaf count is roughly the half of the node count.
+    m_wideNodes.reserve(m_nodeCount / 4 + 1);
+    m_wideLeafs.reserve(m_nodeCount / 2 + 1);
+    m_wideParents.reserve(m_nodeCount / 4 + 1);
+    m_wideSlotNodes.reserve(m_nodeCount + 4);
+
+    BuildWideNode(m_root, nullNode);
+  }
+
+  int32 AABBTree::BuildWideNode(AABBNodeProxy node, int32 parent)
+  {
+    AABBNodeProxy children[4] = {m_nodes[node].child1, m_nodes[node].child2, nullNode, nullNode};
+    int32 childCount          = 2;
+
+    // Collapse the binary levels by opening the largest internal child until there are 4 children.
+    while (childCount < 4)
+    {
+      int32 largest     = -1;
+      float largestArea = -1.0f;
+      for (int32 i = 0; i < childCount; i++)
       {
-        // Volume is fully inside, get all entities from cache.
-        for (AABBNodeProxy leaf : m_nodes[current].leafs)
+        const AABBNode& child = m_nodes[children[i]];
+        if (!child.IsLeaf() && child.aabb.HalfSurfaceArea() > largestArea)
         {
-          if (!m_nodes[leaf].entity.expired())
-          {
-            result[leaf] = m_nodes[leaf].entity.lock().get();
-          }
+          largest     = i;
+          largestArea = child.aabb.HalfSurfaceArea();
+        }
+      }
+
+      if (largest == -1)
+      {
+        break;
+      }
+
+      const AABBNode& opened = m_nodes[children[largest]];
+      children[largest]      = opened.child1;
+      children[childCount++] = opened.child2;
+    }
+
+    const int32 wideIndex = (int32) m_wideNodes.size();
+    m_wideNodes.emplace_back();
+    m_wideParents.push_back(parent);
+    m_wideSlotNodes.insert(m_wideSlotNodes.end(), children, children + 4);
+
+    WideNode& wideNode  = m_wideNodes.back();
+    wideNode.childCount = childCount;
+    for (int32 i = 0; i < childCount; i++)
+    {
+      wideNode.bounds.Set(i, m_nodes[children[i]].aabb);
+    }
+
+    for (int32 i = 0; i < childCount; i++)
+    {
+      int32 wideChild;
+      if (m_nodes[children[i]].IsLeaf())
+      {
+        wideChild                    = ~(int32) m_wideLeafs.size();
+        m_leafWideNodes[children[i]] = wideIndex;
+        m_wideLeafs.push_back(children[i]);
+      }
+      else
+      {
+        wideChild = BuildWideNode(children[i], wideIndex);
+      }
+
+      // Recursion may grow the array, so the node is accessed by index.
+      m_wideNodes[wideIndex].children[i] = wideChild;
+    }
+
+    return wideIndex;
+  }
+
+  template <typename VolumeType>
+  void AABBTree::WideVolumeQuery(const VolumeType& vol,
+                                 int32 root,
+                                 NodeProxyArray& stack,
+                                 EntityRawPtrArray& result) const
+  {
+    stack.clear();
+
+    // Query root is a single leaf.
+    if (root < 0)
+    {
+      const AABBNode& leaf = m_nodes[m_wideLeafs[~root]];
+      if (VolumeBoxIntersection(vol, leaf.aabb) != IntersectResult::Outside)
+      {
+        if (Entity* ntt = leaf.entity.lock().get())
+        {
+          result.push_back(ntt);
+        }
+      }
+      return;
+    }
+
+    stack.push_back(root);
+    while (!stack.empty())
+    {
+      const WideNode& node = m_wideNodes[stack.back()];
+      stack.pop_back();
+
+      int outsideMask, insideMask;
+      VolumeBoxIntersection(vol, node.bounds, outsideMask, insideMask);
+
+      for (int32 i = 0; i < node.childCount; i++)
+      {
+        if (outsideMask & (1 << i))
+        {
+          continue;
+        }
+
+        int32 child = node.children[i];
+        if (child < 0 || (insideMask & (1 << i)))
+        {
+          // Leafs don't need further testing, fully inside nodes get all entities without testing.
+          CollectWideLeafs(child, stack, result);
+        }
+        else
+        {
+          stack.push_back(child);
         }
       }
     }
+  }
 
-    threadCount.fetch_add(1);
+  void AABBTree::CollectWideLeafs(int32 root, NodeProxyArray& stack, EntityRawPtrArray& result) const
+  {
+    // Work on top of the given stack, items below the base belong to the caller.
+    const size_t stackBase = stack.size();
+    stack.push_back(root);
+
+    while (stack.size() > stackBase)
+    {
+      int32 current = stack.back();
+      stack.pop_back();
+
+      if (current < 0)
+      {
+        if (Entity* ntt = m_nodes[m_wideLeafs[~current]].entity.lock().get())
+        {
+          result.push_back(ntt);
+        }
+      }
+      else
+      {
+        const WideNode& node = m_wideNodes[current];
+        stack.insert(stack.end(), node.children, node.children + node.childCount);
+      }
+    }
   }
 
   AABBNodeProxy AABBTree::InsertLeaf(AABBNodeProxy leaf)
@@ -640,6 +1756,9 @@ namespace ToolKit
     assert(0 <= leaf && leaf < m_nodeCapacity);
     assert(m_nodes[leaf].IsLeaf());
 
+    m_wideTreeDirty = true;
+    m_insertionsSinceBuild++;
+
     if (m_root == nullNode)
     {
       m_root = leaf;
@@ -722,25 +1841,10 @@ namespace ToolKit
       m_root = newParent;
     }
 
-    // Construct new parent's leaf cache.
-    if (m_nodes[bestSibling].IsLeaf())
-    {
-      m_nodes[newParent].leafs.insert(bestSibling);
-    }
-    else
-    {
-      for (AABBNodeProxy sibLeaf : m_nodes[bestSibling].leafs)
-      {
-        m_nodes[newParent].leafs.insert(sibLeaf);
-      }
-    }
-
     // Walk back up the tree refitting ancestors' AABB and applying rotations
     AABBNodeProxy ancestor = newParent;
     while (ancestor != nullNode)
     {
-      m_nodes[ancestor].leafs.insert(leaf); // Insert to all ancestors.
-
       AABBNodeProxy child1   = m_nodes[ancestor].child1;
       AABBNodeProxy child2   = m_nodes[ancestor].child2;
 
@@ -761,6 +1865,7 @@ namespace ToolKit
 
     // Remove the leaf if its in invalid nodes.
     m_invalidNodes.erase(leaf);
+    m_wideTreeDirty      = true;
 
     AABBNodeProxy parent = m_nodes[leaf].parent;
     if (parent == nullNode) // node is root
@@ -799,8 +1904,6 @@ namespace ToolKit
       AABBNodeProxy ancestor = grandParent;
       while (ancestor != nullNode)
       {
-        m_nodes[ancestor].leafs.erase(leaf); // Remove from all ancestors.
-
         AABBNodeProxy child1   = m_nodes[ancestor].child1;
         AABBNodeProxy child2   = m_nodes[ancestor].child2;
 
@@ -19,8 +19,10 @@
 namespace ToolKit
 {
 
+  class JobSystem;
+  class TransformSystem;
+
   typedef int AABBNodeProxy;
-  typedef std::unordered_set<AABBNodeProxy> AABBNodeProxySet;
   typedef std::vector<AABBNodeProxy> NodeProxyArray;
 
   class TK_API AABBTree
@@ -39,12 +41,30 @@ namespace ToolKit
       AABBNodeProxy child1;
       AABBNodeProxy child2;
       AABBNodeProxy next;
+    };
 
-      AABBNodeProxySet leafs;
+    /**
+     * Node of the flattened 4 wide tree. Bounds of the children are kept in SoA layout to test all of them at once.
+     */
+    struct WideNode
+    {
+      BoundingBox4 bounds; //!< Bounds of the children.
+      int32 children[4];   //!< Wide node index for positive values, ~index to wide leafs for negative values.
+      int32 childCount;    //!< Number of the valid children.
+    };
+
+    /** Result of a ray in a batched ray query. */
+    struct RayHit
+    {
+      EntityPtr entity;                //!< Nearest entity that is hit, null if the ray hits nothing.
+      float t           = TK_FLT_MAX;  //!< Distance to the hit along the ray.
+      uint submeshIndex = TK_UINT_MAX; //!< Index of the hit sub mesh. Only set by the deep queries.
     };
 
     typedef std::vector<AABBNode> AABBNodeArray;
     typedef std::set<AABBNodeProxy> AABBNodeSet;
+    typedef std::vector<WideNode> WideNodeArray;
+    typedef std::vector<RayHit> RayHitArray;
 
    public:
     AABBTree();
@@ -59,6 +79,12 @@ namespace ToolKit
     /** Updates the aabb tree for every invalid node, if any. */
     void UpdateTree();
 
+    /**
+     * Sets the transform system that moves the entities in the tree. Its pending changes are applied before the tree
+     * is updated, which invalidates the moved entities.
+     */
+    void SetTransformSystem(TransformSystem* transformSystem);
+
     /** Invalidates the given node. */
     void Invalidate(AABBNodeProxy node);
 
@@ -68,9 +94,24 @@ namespace ToolKit
     /** Calls the callback function for each node in a depth first manner. */
     void Traverse(std::function<void(const AABBNode*)> callback);
 
-    /** Creates an optimum aabb tree in bottom up fashion but its very slow to use even at scene loading.  */
+    /**
+     * Rebuilds the whole tree top down with binned surface area heuristic. Sub trees are built in parallel on the job
+     * system. Leaf nodes are kept, node proxies of the entities stay valid.
+     */
     void Rebuild();
 
+    /**
+     * While enabled, created nodes are not inserted in to the tree and the tree can't be queried. Disabling it builds
+     * the tree at once with Rebuild, which is much faster than inserting the nodes one by one. Used at scene loading.
+     */
+    void SetDeferredInsertion(bool defer);
+
+    /**
+     * Returns the surface area heuristic cost of the tree, sum of the internal node areas relative to the root area per
+     * leaf. Lower is better, incremental updates increase the cost over time. Trees of different sizes are comparable.
+     */
+    float CalculateSAHCost() const;
+
     /** Return debug boxes for each node in the tree. */
     void GetDebugBoundingBoxes(EntityPtrArray& boundingBoxes);
 
@@ -81,12 +122,90 @@ namespace ToolKit
     template <typename VolumeType>
     EntityRawPtrArray VolumeQuery(const VolumeType& vol, bool threaded = true);
 
+    /**
+     * Template for volume queries that fills the given result array. Capacity of the array is reused, querying with the
+     * same array each frame does not allocate memory. VolumeTypes: {Frustum, BoundingBox}
+     */
+    template <typename VolumeType>
+    void VolumeQuery(const VolumeType& vol, EntityRawPtrArray& result, bool threaded = true);
+
     /**
      * Test ray against the tree and returns the nearest entity that hits the ray and the hit distance t.
      * If the deep parameter passed as true, it checks mesh level intersection.
      */
     EntityPtr RayQuery(const Ray& ray, bool deep, float* t = nullptr, const IDArray& ignoreList = {});
 
+    /**
+     * Tests all the rays against the tree and writes the nearest hit of rays[i] to results[i]. Rays are sorted by their
+     * origin and direction, coherent rays are traversed in packets of 4 that share the node visits. Packets are
+     * distributed across the frame workers if threaded. If deep is true, mesh level intersection is checked. Entities
+     * that are posed by a skeleton are tested on the calling thread after the packets, posing them is not thread safe.
+     */
+    void RayQueryBatch(const RayArray& rays,
+                       bool deep,
+                       RayHitArray& results,
+                       const IDArray& ignoreList = {},
+                       bool threaded             = true);
+
+   public:
+    /**
+     * Volume and ray queries traverse a 4 wide tree that is flattened from the dynamic tree. Wide tree is rebuilt
+     * lazily before a query, if leafs are added or removed. Moved leafs refit the bounds of both trees in place.
+     */
+    bool m_wideTraversal = true;
+
+    /**
+     * Tree is rebuilt in the background when its SAH cost exceeds the cost at the last rebuild by this ratio. Queries
+     * keep using the current tree until the rebuilt one is swapped in.
+     */
+    float m_rebuildRatio = 1.3f;
+
+   private:
+    /** Leaf and its centroid used while building the tree. */
+    struct BuildLeaf
+    {
+      BoundingBox aabb;
+      Vec3 center;
+      AABBNodeProxy node;
+    };
+
+    /** Leafs in [begin, end) and the internal nodes starting from the internalBegin form a sub tree. */
+    struct BuildRange
+    {
+      int begin;
+      int end;
+      int internalBegin;
+      BoundingBox bounds;       //!< Bounds of the leafs in the range.
+      BoundingBox centerBounds; //!< Bounds of the leaf centers in the range.
+    };
+
+    /**
+     * Tree that is built on a background thread from a snapshot of the leafs. Leafs are the first nodes followed by
+     * the internal nodes, it is linked to the node proxies of the tree when swapped in.
+     */
+    struct BackgroundBuild
+    {
+      std::vector<BuildLeaf> leafs;        //!< Snapshot of the leafs, node is the index of the leaf in the snapshot.
+      NodeProxyArray leafNodes;            //!< Node proxy of each snapshot leaf.
+      std::vector<EntityWeakPtr> entities; //!< Entity of each snapshot leaf, detects the reused node proxies.
+      AABBNodeArray nodes;                 //!< Nodes of the built tree.
+      AABBNodeProxy root = nullNode;       //!< Root of the built tree.
+      float buildTime    = 0.0f;           //!< Duration of the build in milliseconds.
+      std::atomic_bool finished {false};   //!< Set after the tree is built.
+    };
+
+    typedef std::shared_ptr<BackgroundBuild> BackgroundBuildPtr;
+
+    /** Deep ray test that is left to the calling thread by a threaded batch query. */
+    struct DeferredRayTest
+    {
+      uint rayIndex;      //!< Index of the ray and its result.
+      AABBNodeProxy leaf; //!< Leaf whose entity is tested.
+      float boxDist;      //!< Distance to the bounds of the leaf.
+    };
+
+    typedef std::vector<DeferredRayTest> DeferredRayTestArray;
+
    private:
     AABBNodeProxy AllocateNode();
     void FreeNode(AABBNodeProxy node);
@@ -94,10 +213,87 @@ namespace ToolKit
     void RemoveLeaf(AABBNodeProxy leaf);
     void Rotate(AABBNodeProxy node);
 
-    void VolumeQuery(EntityRawPtrArray& result,
-                     std::atomic_int& threadCount,
+    /**
+     * Sets the bounds of the leaf without changing the structure of the trees. Bounds of the ancestors in the dynamic
+     * tree and in the wide tree are updated.
+     */
+    void RefitLeaf(AABBNodeProxy leaf, const BoundingBox& aabb);
+
+    /**
+     * Builds the sub tree for the range in to the nodes and returns its root. A range of n leafs uses n - 1 internal
+     * nodes. If the job system is given, large sub trees are built in parallel.
+     */
+    static AABBNodeProxy BuildSubTree(AABBNodeArray& nodes,
+                                      BuildLeaf* leafs,
+                                      const AABBNodeProxy* internals,
+                                      const BuildRange& range,
+                                      JobSystem* jobSystem);
+
+    /** Calculates the bounds of the leafs in the range by iterating over them. */
+    static void CalculateRangeBounds(const BuildLeaf* leafs, BuildRange& range);
+
+    /** Starts a background rebuild if incremental updates made the tree worse than the rebuild ratio. */
+    void CheckTreeQuality();
+
+    /** Takes a snapshot of the leafs and builds a new tree from them on the background pool. */
+    void StartBackgroundBuild();
+
+    /** Builds the tree of the snapshot. Runs on a background thread, only accesses the build. */
+    static void BuildBackgroundTree(BackgroundBuild& build);
+
+    /**
+     * Replaces the internal nodes with the ones of the finished background build. Leafs that are removed during the
+     * build are taken out of the new tree and the ones that are created are inserted in to it.
+     */
+    void SwapBackgroundBuild();
+
+    /** Appends the entities in the volume under the root to result. Stack is used for traversal. */
+    template <typename VolumeType>
+    void VolumeQuery(const VolumeType& vol,
                      AABBNodeProxy root,
-                     std::function<IntersectResult(AABBNodeProxy)> queryFn) const;
+                     NodeProxyArray& stack,
+                     EntityRawPtrArray& result) const;
+
+    /** Appends all the entities under the root to result without testing. */
+    void CollectLeafs(AABBNodeProxy root, NodeProxyArray& stack, EntityRawPtrArray& result) const;
+
+    /** Flattens the dynamic tree in to the wide tree if the dynamic tree has changed since the last flattening. */
+    void UpdateWideTree();
+
+    /** Creates the wide node for the given internal node and its sub tree. Returns the index of the wide node. */
+    int32 BuildWideNode(AABBNodeProxy node, int32 parent);
+
+    /** Same as VolumeQuery, but traverses the wide tree starting from the given wide node or wide leaf. */
+    template <typename VolumeType>
+    void WideVolumeQuery(const VolumeType& vol, int32 root, NodeProxyArray& stack, EntityRawPtrArray& result) const;
+
+    /** Appends all the entities under the given wide node or wide leaf to result without testing. */
+    void CollectWideLeafs(int32 root, NodeProxyArray& stack, EntityRawPtrArray& result) const;
+
+    /**
+     * Traverses the wide tree with up to 4 rays at once. Lower 32 bits of the rayOrder are the indices of the rays and
+     * their results. A child is visited if any of the rays hits it and only with the rays that hit it. If deferredTests
+     * is given, deep tests of the posed entities are appended to it instead of being performed.
+     */
+    void RayQueryPacket(const Ray* rays,
+                        const uint64* rayOrder,
+                        int rayCount,
+                        bool deep,
+                        const IDArray& ignoreList,
+                        RayHit* results,
+                        DeferredRayTestArray* deferredTests) const;
+
+    /**
+     * Tests the ray against the entity of the leaf whose bounds is hit at boxDist and updates the hit if closer. If
+     * skipPosed is true, deep test of an entity that is posed by a skeleton is skipped and false is returned.
+     */
+    bool TestRayLeaf(const Ray& ray,
+                     AABBNodeProxy leaf,
+                     float boxDist,
+                     bool deep,
+                     const IDArray& ignoreList,
+                     RayHit& hit,
+                     bool skipPosed = false) const;
 
    private:
     AABBNodeProxy m_root;
@@ -112,8 +308,38 @@ namespace ToolKit
     /** Threshold node count to do threaded traverse for volume queries. */
     const int m_threadTreshold;
 
-    /** Internally used to get max available thread count. */
-    mutable int m_maxThreadCount;
+    /** Flattened 4 wide tree. Root is at index 0, empty if the dynamic tree has less than 2 leafs. */
+    WideNodeArray m_wideNodes;
+
+    /** Leaf nodes of the dynamic tree that are referenced by the wide nodes. */
+    NodeProxyArray m_wideLeafs;
+
+    /** Parent of each wide node, nullNode for the root. */
+    NodeProxyArray m_wideParents;
+
+    /** Dynamic tree nodes whose bounds are in the slots of the wide nodes, 4 slots for each wide node. */
+    NodeProxyArray m_wideSlotNodes;
+
+    /** Wide node that holds the leaf, indexed by the leaf. Used for refitting the wide tree. */
+    NodeProxyArray m_leafWideNodes;
+
+    /** Set when the dynamic tree changes, wide tree needs to be flattened again. */
+    bool m_wideTreeDirty;
+
+    /** Nodes are only allocated without inserting while set. */
+    bool m_deferInsertion;
+
+    /** Number of leaf insertions since the last rebuild. */
+    int m_insertionsSinceBuild;
+
+    /** SAH cost of the tree right after the last rebuild. */
+    float m_builtSAHCost;
+
+    /** Rebuild that is in progress on the background pool, null if there is none. */
+    BackgroundBuildPtr m_backgroundBuild;
+
+    /** Transform system that is updated before the tree, null if the entities update their transforms by themselves. */
+    TransformSystem* m_transformSystem = nullptr;
   };
 
 } // namespace ToolKit
@@ -14,7 +14,9 @@
 #include "MathUtil.h"
 #include "Mesh.h"
 #include "Node.h"
+#include "RHI.h"
 #include "Skeleton.h"
+#include "Threads.h"
 #include "ToolKit.h"
 #include "Util.h"
 
@@ -25,6 +27,12 @@ static constexpr bool SERIALIZE_ANIMATION_AS_BINARY = true;
 namespace ToolKit
 {
 
+  /** Players with up to this many records are updated on the calling thread, larger ones in chunks of this size. */
+  constexpr size_t g_animationPlayerParallelThreshold = 32;
+
+  /** Last version given to a compiled animation clip. */
+  static std::atomic<uint64> g_animationClipVersion {0};
+
   TKDefineClass(Animation, Resource);
 
   Animation::Animation() {}
@@ -40,28 +48,32 @@ namespace ToolKit
       return;
     }
 
-    float ratio;
-    int key1, key2;
-    std::vector<Key>& keys = m_keys.begin()->second;
-    GetNearestKeys(keys, key1, key2, ratio, time);
+    if (!IsCompiled())
+    {
+      Compile();
+    }
 
-    int keySize = static_cast<int>(keys.size());
-    if (keys.size() <= key1 || key1 == -1)
+    // Nodes of the entities are animated by the track of the entity, otherwise by the first track of the keys.
+    int track = -1;
+    if (EntityPtr owner = node->OwnerEntity())
     {
-      return;
+      track = FindTrack(owner->GetNameVal());
     }
 
-    if (keys.size() <= key2 || key2 == -1)
+    if (track == -1)
     {
-      return;
+      track = FindTrack(m_keys.begin()->first);
     }
 
-    Key k1              = keys[key1];
-    Key k2              = keys[key2];
+    if (m_clip.tracks[track].keyCount == 0)
+    {
+      return;
+    }
 
-    Vec3 positon        = Interpolate(k1.m_position, k2.m_position, ratio);
-    Quaternion rotation = glm::slerp(k1.m_rotation, k2.m_rotation, ratio);
-    Vec3 scale          = Interpolate(k1.m_scale, k2.m_scale, ratio);
+    Vec3 positon;
+    Quaternion rotation;
+    Vec3 scale;
+    SampleTrack(track, time, positon, rotation, scale);
 
     node->SetLocalTransforms(positon, rotation, scale);
   }
@@ -73,46 +85,43 @@ namespace ToolKit
       return;
     }
 
-    float ratio;
-    int key1, key2;
+    SkeletonPtr skeletonResource = skeleton->GetSkeletonResourceVal();
+    if (skeletonResource == nullptr || skeleton->m_map == nullptr)
+    {
+      return;
+    }
+
+    if (!IsCompiled())
+    {
+      Compile();
+    }
+
     Vec3 translation;
     Quaternion orientation;
     Vec3 scale;
 
-    EntityPtr owner = skeleton->OwnerEntity();
-    for (auto& dBoneIter : skeleton->m_map->m_boneMap)
+    // Tracks are bound to the bones once, bone nodes are accessed by index.
+    BindBones(skeletonResource.get(), skeleton->m_boneBinding);
+    const IntArray& binding          = skeleton->m_boneBinding.trackBones;
+    const NodeRawPtrArray& boneNodes = skeleton->m_map->m_boneNodes;
+    for (int track = 0; track < (int) m_clip.tracks.size(); track++)
     {
-      auto entry = m_keys.find(dBoneIter.first);
-      if (entry == m_keys.end())
+      int boneIndex = binding[track];
+      if (boneIndex == -1 || boneIndex >= (int) boneNodes.size() || boneNodes[boneIndex] == nullptr)
       {
         continue;
       }
 
-      GetNearestKeys(entry->second, key1, key2, ratio, time);
-
-      // Sanity checks
-      int keySize = static_cast<int>(entry->second.size());
-      if (keySize <= key1 || keySize <= key2)
+      if (m_clip.tracks[track].keyCount == 0)
       {
         continue;
       }
 
-      if (key1 == -1 || key2 == -1)
-      {
-        continue;
-      }
-
-      Key k1                             = entry->second[key1];
-      Key k2                             = entry->second[key2];
-      DynamicBoneMap::DynamicBone& dBone = dBoneIter.second;
-
-      translation                        = Interpolate(k1.m_position, k2.m_position, ratio);
-      orientation                        = glm::slerp(k1.m_rotation, k2.m_rotation, ratio);
-      scale                              = Interpolate(k1.m_scale, k2.m_scale, ratio);
+      SampleTrack(track, time, translation, orientation, scale);
 
       // TODO CPU skinning for blended animations
 
-      dBone.node->SetLocalTransforms(translation, orientation, scale);
+      boneNodes[boneIndex]->SetLocalTransforms(translation, orientation, scale);
     }
     skeleton->isDirty = true;
   }
@@ -225,6 +234,8 @@ namespace ToolKit
       }
     }
 
+    Compile();
+
     return nullptr;
   }
 
@@ -234,6 +245,7 @@ namespace ToolKit
   {
     m_initiated = false;
     m_keys.clear();
+    Compile();
   }
 
   void Animation::CopyTo(Resource* other)
@@ -243,20 +255,32 @@ namespace ToolKit
     cpy->m_keys     = m_keys;
     cpy->m_fps      = m_fps;
     cpy->m_duration = m_duration;
+    cpy->Compile();
   }
 
-  void Animation::GetNearestKeys(const KeyArray& keys, int& key1, int& key2, float& ratio, float t)
+  /**
+   * Finds the keys around the time. Frames of the keys are read with the given function, they must be ascending.
+   * Uniform keys are on consecutive frames, their index is calculated directly.
+   */
+  template <typename FrameFn>
+  static void FindNearestKeys(int keyCount,
+                              bool uniform,
+                              float fps,
+                              const FrameFn& frameFn,
+                              int& key1,
+                              int& key2,
+                              float& ratio,
+                              float t)
   {
     // Find nearset keys.
     key1  = -1;
     key2  = -1;
     ratio = 0.0f;
 
-    assert(keys.empty() != true && "Animation can't be empty !");
+    assert(keyCount > 0 && "Animation can't be empty !");
 
     // Check boundary cases.
-    int keySize = static_cast<int>(keys.size());
-    if (keySize == 1)
+    if (keyCount == 1)
     {
       key1 = 0;
       key2 = 0;
@@ -264,8 +288,8 @@ namespace ToolKit
     }
 
     // Current time is earliear than earliest time in the animation.
-    float boundaryTime = keys.front().m_frame * 1.0f / m_fps;
-    if (boundaryTime > t)
+    float frame = t * fps;
+    if ((float) frameFn(0) > frame)
     {
       key1 = 0;
       key2 = 1;
@@ -273,29 +297,231 @@ namespace ToolKit
     }
 
     // Current time is later than the latest time in the animation.
-    boundaryTime = keys.back().m_frame * 1.0f / m_fps;
-    if (t > boundaryTime)
+    if (frame > (float) frameFn(keyCount - 1))
     {
-      key2  = keySize - 1;
+      key2  = keyCount - 1;
       key1  = key2 - 1;
       ratio = 1.0f;
       return;
     }
 
     // Current time is in between keyframes.
-    // Rote interpolation ratio and nearest keys.
-    for (int i = 1; i < keySize; i++)
+    if (uniform)
+    {
+      key1 = glm::min((int) (frame - (float) frameFn(0)), keyCount - 2);
+    }
+    else
+    {
+      // Last key that is not later than the current time.
+      int low  = 0;
+      int high = keyCount - 1;
+      while (high - low > 1)
+      {
+        int mid = (low + high) / 2;
+        if ((float) frameFn(mid) <= frame)
+        {
+          low = mid;
+        }
+        else
+        {
+          high = mid;
+        }
+      }
+
+      key1 = low;
+    }
+
+    key2         = key1 + 1;
+
+    float frame1 = (float) frameFn(key1);
+    float frame2 = (float) frameFn(key2);
+    ratio        = (frame - frame1) / (frame2 - frame1);
+  }
+
+  static Quaternion Dequantize(const QuantizedQuaternion& rotation)
+  {
+    // Components are assigned by name, constructor argument order depends on the quaternion data layout.
+    Quaternion q;
+    q.x = rotation.x / 32767.0f;
+    q.y = rotation.y / 32767.0f;
+    q.z = rotation.z / 32767.0f;
+    q.w = rotation.w / 32767.0f;
+
+    return glm::normalize(q);
+  }
+
+  static QuantizedQuaternion Quantize(const Quaternion& rotation)
+  {
+    Quaternion q = glm::normalize(rotation);
+
+    QuantizedQuaternion quantized;
+    quantized.x = (int16_t) glm::round(glm::clamp(q.x, -1.0f, 1.0f) * 32767.0f);
+    quantized.y = (int16_t) glm::round(glm::clamp(q.y, -1.0f, 1.0f) * 32767.0f);
+    quantized.z = (int16_t) glm::round(glm::clamp(q.z, -1.0f, 1.0f) * 32767.0f);
+    quantized.w = (int16_t) glm::round(glm::clamp(q.w, -1.0f, 1.0f) * 32767.0f);
+
+    return quantized;
+  }
+
+  void Animation::GetNearestKeys(const KeyArray& keys, int& key1, int& key2, float& ratio, float t)
+  {
+    int keyCount = (int) keys.size();
+    bool uniform = keyCount > 0 && keys.back().m_frame - keys.front().m_frame == keyCount - 1;
+
+    FindNearestKeys(keyCount,
+                    uniform,
+                    m_fps,
+                    [&keys](int key) -> int { return keys[key].m_frame; },
+                    key1,
+                    key2,
+                    ratio,
+                    t);
+  }
+
+  void Animation::Compile()
+  {
+    m_clip         = AnimationClip();
+    m_clip.version = ++g_animationClipVersion;
+    m_keysDirty    = false;
+
+    if (m_keys.empty())
+    {
+      return;
+    }
+
+    size_t totalKeyCount = 0;
+    for (const auto& [boneName, keys] : m_keys)
     {
-      float keyTime2 = keys[i].m_frame / m_fps;
-      float keyTime1 = keys[i - 1].m_frame / m_fps;
+      m_clip.trackNames.push_back(boneName);
+      totalKeyCount += keys.size();
+    }
+    std::sort(m_clip.trackNames.begin(), m_clip.trackNames.end());
+
+    m_clip.frames.reserve(totalKeyCount);
+    m_clip.positions.reserve(totalKeyCount);
+    m_clip.rotations.reserve(totalKeyCount);
+    m_clip.scales.reserve(totalKeyCount);
 
-      if (t >= keyTime1 && keyTime2 >= t)
+    for (const String& boneName : m_clip.trackNames)
+    {
+      const KeyArray& keys = m_keys[boneName];
+
+      AnimationClip::Track track;
+      track.firstKey = (int) m_clip.frames.size();
+      track.keyCount = (int) keys.size();
+      track.uniform  = !keys.empty() && keys.back().m_frame - keys.front().m_frame == track.keyCount - 1;
+
+      for (const Key& key : keys)
       {
-        ratio = (t - keyTime1) / (keyTime2 - keyTime1);
-        key1  = i - 1;
-        key2  = i;
-        return;
+        m_clip.frames.push_back(key.m_frame);
+        m_clip.positions.push_back(key.m_position);
+        m_clip.rotations.push_back(Quantize(key.m_rotation));
+        m_clip.scales.push_back(key.m_scale);
+      }
+
+      if (m_clip.referenceTrack == -1 || track.keyCount > m_clip.tracks[m_clip.referenceTrack].keyCount)
+      {
+        m_clip.referenceTrack = (int) m_clip.tracks.size();
       }
+
+      m_clip.tracks.push_back(track);
+    }
+  }
+
+  bool Animation::IsCompiled() const { return !m_keysDirty; }
+
+  const BoneKeyArrayMap& Animation::GetKeys() const { return m_keys; }
+
+  void Animation::SetKeys(const String& boneName, const KeyArray& keys)
+  {
+    m_keys[boneName] = keys;
+    m_keysDirty      = true;
+  }
+
+  int Animation::FindTrack(const String& boneName) const
+  {
+    auto trackItr = std::lower_bound(m_clip.trackNames.begin(), m_clip.trackNames.end(), boneName);
+    if (trackItr == m_clip.trackNames.end() || *trackItr != boneName)
+    {
+      return -1;
+    }
+
+    return (int) (trackItr - m_clip.trackNames.begin());
+  }
+
+  const AnimationClip& Animation::GetClip() const { return m_clip; }
+
+  /**
+   * Finds the nearest keys of the track of the clip and the interpolation ratio for the time. Returned keys are
+   * relative to the first key of the track.
+   */
+  static void FindNearestTrackKeys(const AnimationClip& clip,
+                                   float fps,
+                                   int track,
+                                   int& key1,
+                                   int& key2,
+                                   float& ratio,
+                                   float t)
+  {
+    const AnimationClip::Track& clipTrack = clip.tracks[track];
+    const int* frames                     = clip.frames.data() + clipTrack.firstKey;
+
+    FindNearestKeys(clipTrack.keyCount,
+                    clipTrack.uniform,
+                    fps,
+                    [frames](int key) -> int { return frames[key]; },
+                    key1,
+                    key2,
+                    ratio,
+                    t);
+  }
+
+  /** Samples the interpolated transform of the track of the clip at the given time. */
+  static void SampleClipTrack(const AnimationClip& clip,
+                              float fps,
+                              int track,
+                              float t,
+                              Vec3& translation,
+                              Quaternion& orientation,
+                              Vec3& scale)
+  {
+    float ratio;
+    int key1, key2;
+    FindNearestTrackKeys(clip, fps, track, key1, key2, ratio, t);
+
+    int firstKey  = clip.tracks[track].firstKey;
+    key1         += firstKey;
+    key2         += firstKey;
+
+    translation   = Interpolate(clip.positions[key1], clip.positions[key2], ratio);
+    orientation   = glm::slerp(Dequantize(clip.rotations[key1]), Dequantize(clip.rotations[key2]), ratio);
+    scale         = Interpolate(clip.scales[key1], clip.scales[key2], ratio);
+  }
+
+  void Animation::GetNearestTrackKeys(int track, int& key1, int& key2, float& ratio, float t) const
+  {
+    FindNearestTrackKeys(m_clip, m_fps, track, key1, key2, ratio, t);
+  }
+
+  void Animation::SampleTrack(int track, float t, Vec3& translation, Quaternion& orientation, Vec3& scale) const
+  {
+    SampleClipTrack(m_clip, m_fps, track, t, translation, orientation, scale);
+  }
+
+  void Animation::BindBones(Skeleton* skeleton, AnimationBoneBinding& binding) const
+  {
+    ObjectId skeletonId = skeleton->GetIdVal();
+    if (binding.clipVersion == m_clip.version && binding.skeleton == skeletonId)
+    {
+      return;
+    }
+
+    binding.clipVersion = m_clip.version;
+    binding.skeleton    = skeletonId;
+    binding.trackBones.assign(m_clip.tracks.size(), -1);
+    for (size_t track = 0; track < m_clip.tracks.size(); track++)
+    {
+      binding.trackBones[track] = skeleton->GetBoneIndex(m_clip.trackNames[track]);
     }
   }
 
@@ -357,6 +583,12 @@ namespace ToolKit
       }
     }
 
+    // Animations that are created in code are compiled before they are played.
+    if (!rec->m_animation->IsCompiled())
+    {
+      rec->m_animation->Compile();
+    }
+
     // Generate animation frame data
     AddAnimationData(rec->m_entity, rec->m_animation);
 
@@ -383,7 +615,7 @@ namespace ToolKit
   void AnimationPlayer::Update(float deltaTimeSec)
   {
     // Updates all the records in the player and returns true if record needs to be removed.
-    auto updateRecordsFn = [&](AnimRecordPtr record) -> bool
+    auto updateRecordsFn = [&](const AnimRecordPtr& record) -> bool
     {
       if (record->m_state == AnimRecord::State::Pause)
       {
@@ -436,87 +668,133 @@ namespace ToolKit
       return state == AnimRecord::State::Stop;
     };
 
+    // Records only modify themselves while they are advanced, they are removed afterwards.
+    std::vector<uint8> removedRecords(m_records.size());
+    GetWorkerManager()->ParallelFor(m_records.size(),
+                                    g_animationPlayerParallelThreshold,
+                                    [&](size_t begin, size_t end) -> void
+                                    {
+                                      for (size_t i = begin; i < end; i++)
+                                      {
+                                        removedRecords[i] = updateRecordsFn(m_records[i]);
+                                      }
+                                    });
+
     // Update all active animation records
     bool anyAnimRecordDeleted = false;
-    for (AnimRecordPtrArray::iterator it = m_records.begin(); it != m_records.end();)
+    for (size_t i = 0; i < m_records.size(); i++)
     {
-      if (updateRecordsFn(*it))
+      if (!removedRecords[i])
       {
-        // remove record from both blending map and records array
+        continue;
+      }
 
-        anyAnimRecordDeleted = true;
+      // remove record from both blending map and records array
 
-        if (EntityPtr ntt = (*it)->m_entity.lock())
-        {
-          if (SkeletonComponentPtr skComp = ntt->GetComponent<SkeletonComponent>())
-          {
-            skComp->m_animData.currentAnimation = nullptr;
-            skComp->m_animData.blendAnimation   = nullptr;
-          }
-        }
+      anyAnimRecordDeleted = true;
+      AnimRecordPtr& rec   = m_records[i];
 
-        // Remove blending record from record to be blended
-        if ((*it)->m_blendingData.recordToBeBlended != nullptr)
+      if (EntityPtr ntt = rec->m_entity.lock())
+      {
+        if (SkeletonComponentPtr skComp = ntt->GetComponent<SkeletonComponent>())
         {
-          (*it)->m_blendingData.recordToBeBlended->m_blendingData.recordToBlend = nullptr;
+          skComp->m_animData.currentAnimation = nullptr;
+          skComp->m_animData.blendAnimation   = nullptr;
         }
-
-        it = m_records.erase(it);
       }
-      else
+
+      // Remove blending record from record to be blended
+      if (rec->m_blendingData.recordToBeBlended != nullptr)
       {
-        ++it;
+        rec->m_blendingData.recordToBeBlended->m_blendingData.recordToBlend = nullptr;
       }
+
+      rec = nullptr;
     }
 
     // remove unused animation data textures
     if (anyAnimRecordDeleted)
     {
+      erase_if(m_records, [](const AnimRecordPtr& rec) -> bool { return rec == nullptr; });
       UpdateAnimationData();
     }
 
-    // Fill skeleton components with anim data
-    for (auto it = m_records.begin(); it != m_records.end(); it++)
+    // Key frames are found in parallel. Several records may play on the same skeleton, so the results are written to
+    // the skeleton components in the order of the records.
+    std::vector<SkeletonComponent*> skeletons(m_records.size(), nullptr);
+    std::vector<AnimData> animDataArray(m_records.size());
+
+    auto fillAnimDataFn = [&](AnimRecordPtr& record) -> void
     {
-      AnimRecordPtr record = *it;
+      size_t index  = &record - m_records.data();
+      EntityPtr ntt = record->m_entity.lock();
+      if (ntt == nullptr)
+      {
+        return;
+      }
 
-      if (EntityPtr ntt = record->m_entity.lock())
+      MeshComponent* meshComp   = ntt->GetComponentFast<MeshComponent>();
+      SkeletonComponent* skComp = ntt->GetComponentFast<SkeletonComponent>();
+      if (meshComp == nullptr || skComp == nullptr || !meshComp->GetMeshVal()->IsSkinned())
       {
-        MeshComponentPtr meshComp   = ntt->GetMeshComponent();
-        SkeletonComponentPtr skComp = ntt->GetComponent<SkeletonComponent>();
-        if (meshComp->GetMeshVal()->IsSkinned() && skComp != nullptr)
-        {
-          assert(record->m_animation->m_keys.size() > 0);
-          KeyArray& keys = (*(record->m_animation->m_keys.begin())).second;
-          int key1, key2;
-          float ratio;
-          record->m_animation->GetNearestKeys(keys, key1, key2, ratio, record->m_currentTime);
-
-          skComp->m_animData.keyFrameCount             = (float) keys.size();
-          skComp->m_animData.firstKeyFrame             = (float) key1 / skComp->m_animData.keyFrameCount;
-          skComp->m_animData.secondKeyFrame            = (float) key2 / skComp->m_animData.keyFrameCount;
-          skComp->m_animData.keyFrameInterpolationTime = ratio;
-          skComp->m_animData.currentAnimation          = record->m_animation;
-
-          AnimRecordPtr recordToBlend                  = record->m_blendingData.recordToBlend;
-          if (recordToBlend != nullptr)
-          {
-            KeyArray& blendAnimKeys = (*(recordToBlend->m_animation->m_keys.begin())).second;
-            recordToBlend->m_animation->GetNearestKeys(blendAnimKeys, key1, key2, ratio, recordToBlend->m_currentTime);
-
-            skComp->m_animData.blendKeyFrameCount   = (float) blendAnimKeys.size();
-            skComp->m_animData.animationBlendFactor = recordToBlend->m_blendingData.blendCurrentDurationInSec /
-                                                      recordToBlend->m_blendingData.blendTotalDurationInSec;
-            skComp->m_animData.blendFirstKeyFrame             = (float) key1 / skComp->m_animData.blendKeyFrameCount;
-            skComp->m_animData.blendSecondKeyFrame            = (float) key2 / skComp->m_animData.blendKeyFrameCount;
-            skComp->m_animData.blendKeyFrameInterpolationTime = ratio;
-            skComp->m_animData.blendAnimation                 = recordToBlend->m_animation;
-          }
-          else
-          {
-            skComp->m_animData.blendAnimation = nullptr;
-          }
-        }
+        return;
+      }
+
+      const Animation* anim     = record->m_animation.get();
+      const AnimationClip& clip = anim->GetClip();
+      assert(clip.referenceTrack != -1);
+
+      int key1, key2;
+      float ratio;
+      anim->GetNearestTrackKeys(clip.referenceTrack, key1, key2, ratio, record->m_currentTime);
+
+      AnimData animData                  = skComp->m_animData;
+      animData.keyFrameCount             = (float) clip.tracks[clip.referenceTrack].keyCount;
+      animData.firstKeyFrame             = (float) key1 / animData.keyFrameCount;
+      animData.secondKeyFrame            = (float) key2 / animData.keyFrameCount;
+      animData.keyFrameInterpolationTime = ratio;
+      animData.currentAnimation          = record->m_animation;
+
+      AnimRecordPtr recordToBlend        = record->m_blendingData.recordToBlend;
+      if (recordToBlend != nullptr)
+      {
+        const Animation* blendAnim     = recordToBlend->m_animation.get();
+        const AnimationClip& blendClip = blendAnim->GetClip();
+        blendAnim->GetNearestTrackKeys(blendClip.referenceTrack, key1, key2, ratio, recordToBlend->m_currentTime);
+
+        animData.blendKeyFrameCount   = (float) blendClip.tracks[blendClip.referenceTrack].keyCount;
+        animData.animationBlendFactor = recordToBlend->m_blendingData.blendCurrentDurationInSec /
+                                        recordToBlend->m_blendingData.blendTotalDurationInSec;
+        animData.blendFirstKeyFrame             = (float) key1 / animData.blendKeyFrameCount;
+        animData.blendSecondKeyFrame            = (float) key2 / animData.blendKeyFrameCount;
+        animData.blendKeyFrameInterpolationTime = ratio;
+        animData.blendAnimation                 = recordToBlend->m_animation;
+      }
+      else
+      {
+        animData.blendAnimation = nullptr;
+      }
+
+      skeletons[index]     = skComp;
+      animDataArray[index] = animData;
+    };
+
+    GetWorkerManager()->ParallelFor(m_records.size(),
+                                    g_animationPlayerParallelThreshold,
+                                    [&](size_t begin, size_t end) -> void
+                                    {
+                                      for (size_t i = begin; i < end; i++)
+                                      {
+                                        fillAnimDataFn(m_records[i]);
+                                      }
+                                    });
+
+    // Fill skeleton components with anim data
+    for (size_t i = 0; i < m_records.size(); i++)
+    {
+      if (skeletons[i] != nullptr)
+      {
+        skeletons[i]->m_animData = std::move(animDataArray[i]);
       }
     }
   }
@@ -536,10 +814,10 @@ namespace ToolKit
 
   DataTexturePtr AnimationPlayer::GetAnimationDataTexture(ObjectId skelID, ObjectId animID)
   {
-    const std::pair<ObjectId, ObjectId> p = std::make_pair(skelID, animID);
-    if (m_animTextures.find(p) != m_animTextures.end())
+    auto bakeItr = m_animTextures.find(AnimationDataKey(skelID, animID));
+    if (bakeItr != m_animTextures.end() && bakeItr->second != nullptr)
     {
-      return m_animTextures[p];
+      return bakeItr->second->texture;
     }
 
     return nullptr;
@@ -549,18 +827,18 @@ namespace ToolKit
   {
     if (EntityPtr entity = ntt.lock())
     {
-      if (SkeletonComponentPtr skelComp = entity->GetComponent<SkeletonComponent>())
+      if (SkeletonComponent* skelComp = entity->GetComponentFast<SkeletonComponent>())
       {
         if (SkeletonPtr skeleton = skelComp->GetSkeletonResourceVal())
         {
-          if (m_animTextures.find(std::make_pair(skeleton->GetIdVal(), anim->GetIdVal())) != m_animTextures.end())
+          AnimationDataKey key(skeleton->GetIdVal(), anim->GetIdVal());
+          if (m_animTextures.find(key) != m_animTextures.end())
           {
-            // this animation data already exists
+            // this animation data already exists or is being baked
             return;
           }
 
-          DataTexturePtr texture = CreateAnimationDataTexture(skeleton, anim);
-          m_animTextures[std::make_pair(skeleton->GetIdVal(), anim->GetIdVal())] = texture;
+          m_animTextures[key] = CreateAnimationDataBake(skeleton, anim);
         }
       }
     }
@@ -568,139 +846,256 @@ namespace ToolKit
 
   void AnimationPlayer::UpdateAnimationData()
   {
-    std::map<std::pair<ObjectId, ObjectId>, DataTexturePtr>::iterator it;
-    for (it = m_animTextures.begin(); it != m_animTextures.end();)
+    std::unordered_set<AnimationDataKey, AnimationDataKeyHash> usedKeys;
+    for (const AnimRecordPtr& animRecord : m_records)
     {
-      bool found = false;
-      for (AnimRecordPtr animRecord : m_records)
+      if (EntityPtr entity = animRecord->m_entity.lock())
       {
-        if (EntityPtr entity = animRecord->m_entity.lock())
+        if (SkeletonComponent* skelComp = entity->GetComponentFast<SkeletonComponent>())
         {
-          if (SkeletonComponentPtr skelComp = entity->GetComponent<SkeletonComponent>())
+          if (SkeletonPtr skeleton = skelComp->GetSkeletonResourceVal())
           {
-            if (SkeletonPtr skeleton = skelComp->GetSkeletonResourceVal())
-            {
-              const ObjectId skeletonID = skeleton->GetIdVal();
-              const ObjectId animID     = animRecord->m_animation->GetIdVal();
-
-              if (it->first.first == skeletonID && it->first.second == animID)
-              {
-                found = true;
-                break;
-              }
-            }
+            usedKeys.insert(AnimationDataKey(skeleton->GetIdVal(), animRecord->m_animation->GetIdVal()));
           }
         }
       }
+    }
 
-      if (found)
+    for (auto bakeItr = m_animTextures.begin(); bakeItr != m_animTextures.end();)
+    {
+      if (usedKeys.find(bakeItr->first) != usedKeys.end())
       {
-        ++it;
+        ++bakeItr;
+        continue;
       }
-      else
+
+      // Bakes in progress are abandoned.
+      if (bakeItr->second != nullptr)
       {
-        it = m_animTextures.erase(it);
+        bakeItr->second->cancelled = true;
       }
+      bakeItr = m_animTextures.erase(bakeItr);
     }
   }
 
-  void AnimationPlayer::ClearAnimationData() { m_animTextures.clear(); }
+  void AnimationPlayer::ClearAnimationData()
+  {
+    for (auto& [key, bake] : m_animTextures)
+    {
+      if (bake != nullptr)
+      {
+        bake->cancelled = true;
+      }
+    }
+    m_animTextures.clear();
+  }
 
-  DataTexturePtr AnimationPlayer::CreateAnimationDataTexture(SkeletonPtr skeleton, AnimationPtr anim)
+  AnimationPlayer::AnimationDataBakePtr AnimationPlayer::CreateAnimationDataBake(SkeletonPtr skeleton,
+                                                                                 AnimationPtr anim)
   {
-    if (anim->m_keys.empty())
+    const AnimationClip& clip = anim->GetClip();
+    const int boneCount       = (int) skeleton->m_bones.size();
+    if (clip.referenceTrack == -1 || boneCount == 0)
     {
       return nullptr;
     }
 
-    uint height        = 1024;                               // max number of key frames
-    uint width         = (int) skeleton->m_bones.size() * 4; // number of bones * 4 (each element holds a row of matrix)
-    uint sizeOfElement = 16 * 4;                             // size of an element in bytes
+    AnimationDataBakePtr bake = std::make_shared<AnimationDataBake>();
+    bake->clip                = clip;
+    bake->fps                 = anim->m_fps;
+    bake->keyFrameCount       = clip.tracks[clip.referenceTrack].keyCount;
+    bake->rowCount            = glm::min(bake->keyFrameCount, (int) RHIConstants::AnimationDataTextureSize);
+    bake->blockCount          = (bake->keyFrameCount + bake->rowCount - 1) / bake->rowCount;
 
-    char* buffer       = new char[height * width * sizeOfElement];
+    if (bake->blockCount * boneCount * 3 > (int) RHIConstants::AnimationDataTextureSize)
+    {
+      TK_ERR("Animation \"%s\" has too many key frames for the skeleton \"%s\".",
+             anim->GetFile().c_str(),
+             skeleton->GetFile().c_str());
+      return nullptr;
+    }
 
-    uint maxKeyCount   = 0;
-    uint keyframeIndex = 0;
-    while (true)
+    // Bones without keys stay in their identity transform.
+    AnimationBoneBinding binding;
+    anim->BindBones(skeleton.get(), binding);
+    bake->boneTracks.assign(boneCount, -1);
+    for (int track = 0; track < (int) binding.trackBones.size(); track++)
     {
-      if (keyframeIndex >= height)
+      int boneIndx = binding.trackBones[track];
+      if (boneIndx != -1 && clip.tracks[track].keyCount > 0)
       {
-        TK_ERR("The maximum number of key frames for animations is 1024!");
-        TK_ERR("Animation \"%s\" has more than 1024 key frames.", anim->GetFile().c_str());
-        SafeDelArray(buffer);
-        return nullptr;
+        bake->boneTracks[boneIndx] = track;
       }
+    }
 
-      bool keysframesLeft = false;
-      std::vector<std::pair<Node*, uint>> boneNodes;
+    // Bone hierarchy is flattened from the nodes of the T-pose.
+    const NodeRawPtrArray& boneNodes = skeleton->m_Tpose.m_boneNodes;
+    std::unordered_map<Node*, int> boneIndices;
+    for (int boneIndx = 0; boneIndx < (int) boneNodes.size(); boneIndx++)
+    {
+      boneIndices[boneNodes[boneIndx]] = boneIndx;
+    }
 
-      // Iterate all bones for the key frame and get node transformations
-      for (auto& dBoneIter : skeleton->m_Tpose.m_boneMap)
-      {
-        const String& name                 = dBoneIter.first;
-        DynamicBoneMap::DynamicBone& dBone = dBoneIter.second;
+    bake->boneParents.assign(boneCount, -1);
+    bake->inheritScale.assign(boneCount, 0);
+    bake->inverseBindMatrices.resize(boneCount);
+    bake->rootParentTransforms.assign(boneCount, Mat4(1.0f));
+    bake->boneTransforms.resize(boneCount);
 
-        if (anim->m_keys.find(name) == anim->m_keys.end())
-        {
-          dBone.node->SetLocalTransforms(Vec3(), Quaternion(), Vec3(1.0f));
-          boneNodes.push_back(std::make_pair(dBone.node, dBone.boneIndx));
-          continue;
-        }
+    bake->boneOrder.resize(boneCount);
 
-        std::vector<Key>& keys = anim->m_keys[name];
-        if (keys.size() <= keyframeIndex)
-        {
-          continue;
-        }
-        else
-        {
-          if (maxKeyCount < keys.size())
-          {
-            maxKeyCount = (uint) keys.size();
-          }
+    IntArray boneDepths(boneCount, 0);
+    for (int boneIndx = 0; boneIndx < boneCount; boneIndx++)
+    {
+      bake->boneOrder[boneIndx]           = boneIndx;
+      bake->inverseBindMatrices[boneIndx] = skeleton->m_bones[boneIndx]->m_inverseWorldMatrix;
 
-          keysframesLeft = true;
+      Node* node                          = boneIndx < (int) boneNodes.size() ? boneNodes[boneIndx] : nullptr;
+      if (node == nullptr)
+      {
+        continue;
+      }
 
-          Key& key       = keys[keyframeIndex];
-          dBone.node->SetLocalTransforms(key.m_position, key.m_rotation, key.m_scale);
-          boneNodes.push_back(std::make_pair(dBone.node, dBone.boneIndx));
-        }
+      bake->inheritScale[boneIndx] = node->m_inheritScale;
+      auto parentItr               = boneIndices.find(node->m_parent);
+      if (parentItr != boneIndices.end())
+      {
+        bake->boneParents[boneIndx] = parentItr->second;
+      }
+      else if (node->m_parent != nullptr)
+      {
+        // Root bones keep the transforms of the nodes above the skeleton.
+        bake->rootParentTransforms[boneIndx] = node->m_parent->GetTransform(TransformationSpace::TS_WORLD);
       }
 
-      if (!keysframesLeft)
+      for (Node* parent = node->m_parent; parent != nullptr; parent = parent->m_parent)
       {
-        break;
+        boneDepths[boneIndx]++;
       }
+    }
+
+    std::stable_sort(bake->boneOrder.begin(),
+                     bake->boneOrder.end(),
+                     [&boneDepths](int bone1, int bone2) -> bool { return boneDepths[bone1] < boneDepths[bone2]; });
+
+    // Each bone occupies 3 texels of a row, 4 floats each.
+    bake->data.resize((size_t) bake->rowCount * bake->blockCount * boneCount * 12);
+
+    TextureSettings& settings = bake->settings;
+    settings.Target           = GraphicTypes::Target2D;
+    settings.WarpS            = GraphicTypes::UVClampToEdge;
+    settings.WarpT            = GraphicTypes::UVClampToEdge;
+    settings.WarpR            = GraphicTypes::UVClampToEdge;
+    settings.MinFilter        = GraphicTypes::SampleNearest;
+    settings.MagFilter        = GraphicTypes::SampleNearest;
+    settings.InternalFormat   = GraphicTypes::FormatRGBA32F;
+    settings.Format           = GraphicTypes::FormatRGBA;
+    settings.Type             = GraphicTypes::TypeFloat;
+
+    // Float data is converted by the driver, half precision textures are uploaded from the same data.
+    if (m_halfPrecisionAnimationData)
+    {
+      settings.InternalFormat = GraphicTypes::FormatRGBA16F;
+    }
+
+    if (!Main::GetInstance()->m_threaded)
+    {
+      BakeAnimationData(*bake);
+      UploadAnimationData(*bake);
+      return bake;
+    }
+
+    // Texture is created on the main thread once the key frames are baked.
+    TKAsyncTask(WorkerManager::BackgroundPool,
+                [bake]() -> void
+                {
+                  BakeAnimationData(*bake);
+                  TKAsyncTask(WorkerManager::MainThread, [bake]() -> void { UploadAnimationData(*bake); });
+                });
+
+    return bake;
+  }
+
+  static void RemoveScale(Mat4& transform)
+  {
+    for (int i = 0; i < 3; i++)
+    {
+      transform[i] = Vec4(glm::normalize(Vec3(transform[i])), transform[i].w);
+    }
+  }
 
-      // After getting all node transformations re-calculate dirty nodes transformations
-      for (auto& node : boneNodes)
+  void AnimationPlayer::BakeAnimationData(AnimationDataBake& bake)
+  {
+    if (bake.cancelled)
+    {
+      return;
+    }
+
+    const AnimationClip& clip                  = bake.clip;
+    const AnimationClip::Track& referenceTrack = clip.tracks[clip.referenceTrack];
+    const int boneCount                        = (int) bake.boneTracks.size();
+    const size_t rowStride                     = (size_t) bake.blockCount * boneCount * 12;
+
+    Vec3 translation;
+    Quaternion orientation;
+    Vec3 scale;
+
+    for (int keyframeIndex = 0; keyframeIndex < bake.keyFrameCount; keyframeIndex++)
+    {
+      const int block  = keyframeIndex / bake.rowCount;
+      const int row    = keyframeIndex % bake.rowCount;
+      float* rowData   = bake.data.data() + row * rowStride + (size_t) block * boneCount * 12;
+
+      // All tracks are sampled at the time of the key frame of the reference track.
+      const float time = clip.frames[referenceTrack.firstKey + keyframeIndex] / bake.fps;
+
+      for (int boneIndx : bake.boneOrder)
       {
-        StaticBone* sBone         = skeleton->m_bones[node.second];
+        Mat4 local(1.0f);
+        if (int track = bake.boneTracks[boneIndx]; track != -1)
+        {
+          SampleClipTrack(clip, bake.fps, track, time, translation, orientation, scale);
+          local = glm::translate(translation) * glm::toMat4(orientation) * glm::scale(scale);
+        }
 
-        const Mat4 boneTransform  = node.first->GetTransform(TransformationSpace::TS_WORLD);
-        const Mat4 totalTransform = boneTransform * sBone->m_inverseWorldMatrix;
+        int parent           = bake.boneParents[boneIndx];
+        Mat4 parentTransform = parent != -1 ? bake.boneTransforms[parent] : bake.rootParentTransforms[boneIndx];
+        if (!bake.inheritScale[boneIndx])
+        {
+          RemoveScale(parentTransform);
+        }
 
-        uint loc                  = ((keyframeIndex * (uint) skeleton->m_bones.size() + node.second) * sizeOfElement);
-        memcpy(buffer + loc, &totalTransform, sizeOfElement);
-      }
+        Mat4& world              = bake.boneTransforms[boneIndx];
+        world                    = parentTransform * local;
 
-      ++keyframeIndex;
+        // First three rows of the skinning matrix, the last row is always (0, 0, 0, 1).
+        const Mat4 skinTransform = world * bake.inverseBindMatrices[boneIndx];
+        float* texels            = rowData + boneIndx * 12;
+        for (int i = 0; i < 3; i++)
+        {
+          for (int j = 0; j < 4; j++)
+          {
+            texels[i * 4 + j] = skinTransform[j][i];
+          }
+        }
+      }
     }
 
-    TextureSettings dataTextureSettings;
-    dataTextureSettings.Target         = GraphicTypes::Target2D;
-    dataTextureSettings.WarpS          = GraphicTypes::UVClampToEdge;
-    dataTextureSettings.WarpT          = GraphicTypes::UVClampToEdge;
-    dataTextureSettings.WarpR          = GraphicTypes::UVClampToEdge;
-    dataTextureSettings.InternalFormat = GraphicTypes::FormatRGBA32F;
-    dataTextureSettings.Format         = GraphicTypes::FormatRGBA;
-    dataTextureSettings.Type           = GraphicTypes::TypeFloat;
-    DataTexturePtr animDataTexture     = MakeNewPtr<DataTexture>(width, maxKeyCount, dataTextureSettings);
-    animDataTexture->Init((void*) buffer);
+    bake.clip = AnimationClip();
+  }
+
+  void AnimationPlayer::UploadAnimationData(AnimationDataBake& bake)
+  {
+    if (bake.cancelled || !Main::GetInstance()->m_initiated)
+    {
+      return;
+    }
 
-    SafeDelArray(buffer);
+    int width    = bake.blockCount * (int) bake.boneTracks.size() * 3;
+    bake.texture = MakeNewPtr<DataTexture>(width, bake.rowCount, bake.settings);
+    bake.texture->Init(bake.data.data());
 
-    return animDataTexture;
+    std::vector<float>().swap(bake.data);
   }
 
   AnimationManager::AnimationManager() { m_baseType = Animation::StaticClass(); }
@@ -35,6 +35,44 @@ namespace ToolKit
   typedef std::vector<Key> KeyArray;
   typedef std::unordered_map<String, KeyArray> BoneKeyArrayMap;
 
+  /** Rotation quantized to 16 bit signed normalized components. */
+  struct QuantizedQuaternion
+  {
+    int16_t x = 0;
+    int16_t y = 0;
+    int16_t z = 0;
+    int16_t w = 0;
+  };
+
+  /**
+   * Keys of an Animation compiled in to flat arrays for sampling. Each track holds the keys of a bone and keys of a
+   * track are consecutive in the key arrays. Keys of the tracks whose keys are on consecutive frames are found in
+   * constant time, the others are found with a binary search.
+   */
+  struct AnimationClip
+  {
+    /** Range of the keys of a bone. */
+    struct Track
+    {
+      int firstKey = 0;     //!< Index of the first key of the track in the key arrays.
+      int keyCount = 0;     //!< Number of the keys of the track.
+      bool uniform = false; //!< States if the keys are on consecutive frames.
+    };
+
+    StringArray trackNames;                     //!< Bone name of each track.
+    std::vector<Track> tracks;                  //!< Tracks sorted by the bone names.
+    IntArray frames;                            //!< Frame of each key.
+    Vec3Array positions;                        //!< Position of each key.
+    std::vector<QuantizedQuaternion> rotations; //!< Quantized rotation of each key.
+    Vec3Array scales;                           //!< Scale of each key.
+
+    /** Track with the most keys. Its keys are the rows of the animation data textures. */
+    int referenceTrack = -1;
+
+    /** Unique id of the compilation. Each compile of any animation gets a new version. */
+    uint64 version     = 0;
+  };
+
   /**
    * The class that represents animations which can be played with
    * AnimationPlayer. Alter's Entity Node transforms or Skeleton / Bone
@@ -94,7 +132,8 @@ namespace ToolKit
     void UnInit() override;
 
     /**
-     * Finds nearest keys and interpolation ratio for current time.
+     * Finds nearest keys and interpolation ratio for current time. Keys on consecutive frames are found in constant
+     * time, others with a binary search.
      * @param keys animation key array.
      * @param key1 output key 1.
      * @param key2 output key 2.
@@ -103,6 +142,43 @@ namespace ToolKit
      */
     void GetNearestKeys(const KeyArray& keys, int& key1, int& key2, float& ratio, float t);
 
+    /**
+     * Compiles the keys in to the clip that is used for sampling. Animation is compiled when it is deserialized and
+     * before it is sampled if the keys are modified afterwards.
+     */
+    void Compile();
+
+    /** Returns true if the keys are not modified since the last compile. */
+    bool IsCompiled() const;
+
+    /** Returns the keys of each bone. */
+    const BoneKeyArrayMap& GetKeys() const;
+
+    /** Replaces the keys of the bone. Animation is compiled again before it is sampled. */
+    void SetKeys(const String& boneName, const KeyArray& keys);
+
+    /** Returns the index of the track for the bone, -1 if the animation has no keys for the bone. */
+    int FindTrack(const String& boneName) const;
+
+    /** Returns the compiled clip. */
+    const AnimationClip& GetClip() const;
+
+    /**
+     * Finds the nearest keys of the track and the interpolation ratio for the time. Returned keys are relative to the
+     * first key of the track.
+     * @see GetNearestKeys
+     */
+    void GetNearestTrackKeys(int track, int& key1, int& key2, float& ratio, float t) const;
+
+    /** Samples the interpolated transform of the track at the given time. */
+    void SampleTrack(int track, float t, Vec3& translation, Quaternion& orientation, Vec3& scale) const;
+
+    /**
+     * Binds the tracks to the bones of the skeleton. Binding is only resolved again when the animation is compiled
+     * again or it is used with another skeleton.
+     */
+    void BindBones(Skeleton* skeleton, AnimationBoneBinding& binding) const;
+
    protected:
     void CopyTo(Resource* other) override;
 
@@ -110,13 +186,17 @@ namespace ToolKit
     XmlNode* DeSerializeImp(const SerializationFileInfo& info, XmlNode* parent) override;
 
    public:
+    float m_fps      = 30.0f; //!< Frames to display per second.
+    float m_duration = 0.0f;  //!< Duration of the animation.
+
+   private:
     /**
      * A map that holds bone names and their corresponding keys
      * for this animation.
      */
     BoneKeyArrayMap m_keys;
-    float m_fps      = 30.0f; //!< Frames to display per second.
-    float m_duration = 0.0f;  //!< Duration of the animation.
+    AnimationClip m_clip;     //!< Compiled keys.
+    bool m_keysDirty = false; //!< States if the keys are modified after the last compile.
   };
 
   /**
@@ -244,18 +324,57 @@ namespace ToolKit
      * Data is hold as skeleton - animation pair.
      * @param skelID is the skeleton to look for.
      * @param animID is the animation to look for.
-     * @return Found data texture for the pair or nullptr.
+     * @return Found data texture for the pair or nullptr. Textures that are being baked are nullptr.
      */
     DataTexturePtr GetAnimationDataTexture(ObjectId skelID, ObjectId animID);
 
    private:
+    /** Skeleton id - animation id pair. */
+    typedef std::pair<ObjectId, ObjectId> AnimationDataKey;
+
+    struct AnimationDataKeyHash
+    {
+      std::size_t operator()(const AnimationDataKey& key) const
+      {
+        std::size_t hashValue  = std::hash<ObjectId>()(key.first);
+        hashValue             ^= std::hash<ObjectId>()(key.second) + 0x9e3779b9 + (hashValue << 6) + (hashValue >> 2);
+        return hashValue;
+      }
+    };
+
+    /**
+     * Inputs and outputs of baking the data texture of a skeleton - animation pair. Skeleton is flattened in to arrays
+     * on the main thread, key frames are baked on a background worker without touching the nodes of the skeleton.
+     */
+    struct AnimationDataBake
+    {
+      AnimationClip clip;                     //!< Copy of the compiled clip, released after the bake.
+      float fps = 30.0f;                      //!< Frames per second of the animation.
+      IntArray boneTracks;                    //!< Track of each bone, -1 for the bones without keys.
+      IntArray boneParents;                   //!< Parent of each bone, -1 for the root bones.
+      IntArray boneOrder;                     //!< Bone indexes ordered such that parents precede their children.
+      std::vector<char> inheritScale;         //!< States if each bone inherits the scale of its parent.
+      std::vector<Mat4> inverseBindMatrices;  //!< Inverse world matrix of each bone in the bind pose.
+      std::vector<Mat4> rootParentTransforms; //!< World transform of the parent node of each root bone.
+      std::vector<Mat4> boneTransforms;       //!< Scratch for the world transforms of the bones of a key frame.
+      int keyFrameCount = 0;                  //!< Number of the key frames of the reference track.
+      int rowCount      = 0;                  //!< Height of the texture.
+      int blockCount    = 0;                  //!< Number of bone column blocks, key frames beyond the height wrap.
+      std::vector<float> data;                //!< Baked texels, released after the upload.
+      TextureSettings settings;               //!< Settings of the data texture.
+      std::atomic_bool cancelled {false};     //!< Set when the pair is no longer played, skips the bake and upload.
+      DataTexturePtr texture;                 //!< Created on the main thread when the bake is complete.
+    };
+
+    typedef std::shared_ptr<AnimationDataBake> AnimationDataBakePtr;
+
     /**
      * Clears all animation records.
      */
     void ClearAnimRecords();
 
     /**
-     * Add data texture of animation for skeleton
+     * Add data texture of animation for skeleton. Texture is baked in the background when threading is enabled.
      */
     void AddAnimationData(EntityWeakPtr ntt, AnimationPtr anim);
 
@@ -270,20 +389,36 @@ namespace ToolKit
     void ClearAnimationData();
 
     /**
-     * Creates and returns animation data texture for given skeleton and animation
+     * Prepares the bake of the animation data texture for given skeleton and animation and starts it.
+     * @return The bake whose texture is assigned once it is complete, nullptr if the pair can't be baked.
+     */
+    AnimationDataBakePtr CreateAnimationDataBake(SkeletonPtr skeleton, AnimationPtr anim);
+
+    /**
+     * Bakes the key frames of the animation in to the data of the bake. Pure math, doesn't allocate.
+     * Each bone is stored as 3 texels holding the first three rows of its skinning matrix.
      */
-    DataTexturePtr CreateAnimationDataTexture(SkeletonPtr skeleton, AnimationPtr anim);
+    static void BakeAnimationData(AnimationDataBake& bake);
+
+    /** Creates the texture of a completed bake. Must be called on the main thread. */
+    static void UploadAnimationData(AnimationDataBake& bake);
 
    public:
     /** Global time multiplier for all track in the player. */
-    float m_timeMultiplier = 1.0f;
+    float m_timeMultiplier            = 1.0f;
+
+    /**
+     * Stores the animation data textures in half precision floats, which uses half the vram of the full precision
+     * textures. Affects the textures that are baked after it is changed.
+     */
+    bool m_halfPrecisionAnimationData = true;
 
    private:
     // Storage for the AnimRecord objects.
     AnimRecordPtrArray m_records;
 
     // Storage for animation data (skeleton id - animation id pair)
-    std::map<std::pair<ObjectId, ObjectId>, DataTexturePtr> m_animTextures;
+    std::unordered_map<AnimationDataKey, AnimationDataBakePtr, AnimationDataKeyHash> m_animTextures;
   };
 
 } // namespace ToolKit
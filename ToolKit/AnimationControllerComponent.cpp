@@ -105,7 +105,7 @@ namespace ToolKit
       // set blending data
 
       // check if they have same bones
-      assert(HaveSameKeys(activeRecord->m_animation->m_keys, lastActiveRecord->m_animation->m_keys) &&
+      assert(HaveSameKeys(activeRecord->m_animation->GetKeys(), lastActiveRecord->m_animation->GetKeys()) &&
              "Blend animation is for different skeleton than the animation to blend with!");
 
       activeRecord->m_blendingData.recordToBlend                 = lastActiveRecord;
@@ -8,83 +8,340 @@
 #include "BinPack2D.h"
 
 #include "ToolKit.h"
+#include "Util.h"
 
 #include "DebugNew.h"
 
 namespace ToolKit
 {
 
-  BinPack2D::PackedRectArray BinPack2D::Pack(const IntArray& squares, int atlasSize, int* layerCount)
+  void BinPack2D::Init(int atlasSize, int maxLayers)
   {
-    PackedRectArray packed;
-    packed.reserve(squares.size());
+    m_layers.clear();
+    m_atlasSize = atlasSize;
+    m_maxLayers = maxLayers;
+  }
 
-    if (squares.empty())
+  BinPack2D::PackedRect BinPack2D::Insert(int squareSize, int squareCount)
+  {
+    PackedRect packed;
+    if (squareSize <= 0 || squareSize > m_atlasSize || squareCount <= 0)
     {
       return packed;
     }
 
-    PackedRect lastRect;
-    lastRect.coordinate = Vec2(0.0);
-    lastRect.layer      = 0;
+    // Squares that don't fit in a row are wrapped to the next row from the left edge of the atlas.
+    int squaresPerRow = m_atlasSize / squareSize;
+    int rowCount      = (squareCount + squaresPerRow - 1) / squaresPerRow;
+    packed.width      = glm::min(squareCount, squaresPerRow) * squareSize;
+    packed.height     = rowCount * squareSize;
+    packed.squareSize = squareSize;
 
-    // Place the first at the beginning.
-    int mapSize         = squares[0];
-
-    auto sizeFailureFn  = [&packed, atlasSize](int mapSize) -> PackedRectArray
+    if (packed.height > m_atlasSize)
     {
-      TK_LOG("Map can't fit into atlas. Atlas size %d < Map size %d", atlasSize, mapSize);
+      // Group spans consecutive whole layers, search for enough empty layers.
+      int layerCount = (packed.height + m_atlasSize - 1) / m_atlasSize;
+      packed.height  = layerCount * m_atlasSize;
+
+      int firstLayer = 0;
+      for (int i = 0; i < firstLayer + layerCount; i++)
+      {
+        if (i == (int) m_layers.size() && !AddLayer())
+        {
+          return PackedRect();
+        }
+
+        if (m_layers[i].allocatedArea > 0)
+        {
+          firstLayer = i + 1;
+        }
+      }
+
+      for (int i = firstLayer; i < firstLayer + layerCount; i++)
+      {
+        Allocate(m_layers[i], {0, 0, m_atlasSize, m_atlasSize});
+      }
+
+      packed.coordinate = Vec2(0.0f);
+      packed.layer      = firstLayer;
       return packed;
-    };
+    }
 
-    if (mapSize <= atlasSize)
+    // Lowest layer that the group fits is used, to keep the layer count low.
+    Rect found;
+    int layerIndex = -1;
+    for (int i = 0; i < (int) m_layers.size(); i++)
     {
-      packed.push_back(lastRect);
+      if (FindPosition(m_layers[i], packed.width, packed.height, found))
+      {
+        layerIndex = i;
+        break;
+      }
     }
-    else
+
+    if (layerIndex == -1)
     {
-      return sizeFailureFn(mapSize);
+      if (!AddLayer())
+      {
+        return PackedRect();
+      }
+
+      layerIndex = (int) m_layers.size() - 1;
+      FindPosition(m_layers[layerIndex], packed.width, packed.height, found);
     }
 
-    for (size_t i = 1; i < squares.size(); i++)
+    Allocate(m_layers[layerIndex], found);
+
+    packed.coordinate = Vec2((float) found.x, (float) found.y);
+    packed.layer      = layerIndex;
+    return packed;
+  }
+
+  void BinPack2D::Remove(const PackedRect& rect)
+  {
+    if (!rect.IsValid() || rect.layer >= (int) m_layers.size())
     {
-      mapSize = squares[i];
-      if (mapSize <= atlasSize)
+      return;
+    }
+
+    if (rect.height > m_atlasSize)
+    {
+      int layerCount = rect.height / m_atlasSize;
+      for (int i = rect.layer; i < rect.layer + layerCount && i < (int) m_layers.size(); i++)
       {
-        int x = (int) lastRect.coordinate.x + mapSize;
-        if (x < atlasSize)
-        {
-          lastRect.coordinate.x = (float) x;
-          packed.push_back(lastRect);
-        }
-        else
+        ClearLayer(m_layers[i]);
+      }
+
+      return;
+    }
+
+    Layer& layer = m_layers[rect.layer];
+    int x        = (int) rect.coordinate.x;
+    int y        = (int) rect.coordinate.y;
+    erase_if(layer.allocations,
+             [&](const Rect& allocation) -> bool
+             {
+               return allocation.x == x && allocation.y == y && allocation.width == rect.width &&
+                      allocation.height == rect.height;
+             });
+
+    // Free rectangles are rebuilt from the remaining allocations, so that they are maximal again.
+    RectArray allocations = std::move(layer.allocations);
+    ClearLayer(layer);
+    for (const Rect& allocation : allocations)
+    {
+      Allocate(layer, allocation);
+    }
+  }
+
+  BinPack2D::PackedRect BinPack2D::GetSquare(const PackedRect& rect, int index) const
+  {
+    PackedRect square = rect;
+    square.width      = rect.squareSize;
+    square.height     = rect.squareSize;
+
+    for (int i = 1; i <= index; i++)
+    {
+      square.coordinate.x += (float) rect.squareSize;
+      if (square.coordinate.x >= (float) m_atlasSize)
+      {
+        square.coordinate.x  = 0.0f;
+        square.coordinate.y += (float) rect.squareSize;
+        if (square.coordinate.y >= (float) m_atlasSize)
         {
-          int y = (int) lastRect.coordinate.y + mapSize;
-          if (y < atlasSize)
-          {
-            lastRect.coordinate = Vec2(0.0f, y);
-            packed.push_back(lastRect);
-          }
-          else
-          {
-            lastRect.coordinate  = Vec2(0.0);
-            lastRect.layer      += 1;
-            packed.push_back(lastRect);
-          }
+          square.coordinate  = Vec2(0.0f);
+          square.layer      += 1;
         }
       }
-      else
+    }
+
+    return square;
+  }
+
+  int BinPack2D::GetLayerCount() const
+  {
+    for (int i = (int) m_layers.size() - 1; i >= 0; i--)
+    {
+      if (m_layers[i].allocatedArea > 0)
       {
-        return sizeFailureFn(mapSize);
+        return i + 1;
       }
     }
 
+    return 0;
+  }
+
+  float BinPack2D::GetOccupancy() const
+  {
+    int layerCount = GetLayerCount();
+    if (layerCount == 0)
+    {
+      return 0.0f;
+    }
+
+    int64 allocatedArea = 0;
+    for (int i = 0; i < layerCount; i++)
+    {
+      allocatedArea += m_layers[i].allocatedArea;
+    }
+
+    return (float) ((double) allocatedArea / ((double) layerCount * m_atlasSize * m_atlasSize));
+  }
+
+  BinPack2D::PackedRectArray BinPack2D::Pack(const IntArray& squares, int atlasSize, int* layerCount)
+  {
+    Init(atlasSize);
+
+    PackedRectArray packed;
+    packed.reserve(squares.size());
+
+    for (int mapSize : squares)
+    {
+      PackedRect rect = Insert(mapSize, 1);
+      if (!rect.IsValid())
+      {
+        TK_LOG("Map can't fit into atlas. Atlas size %d < Map size %d", atlasSize, mapSize);
+        return packed;
+      }
+
+      packed.push_back(rect);
+    }
+
     if (layerCount != nullptr)
     {
-      *layerCount = lastRect.layer + 1;
+      *layerCount = GetLayerCount();
     }
 
     return packed;
   }
 
+  bool BinPack2D::FindPosition(const Layer& layer, int width, int height, Rect& found) const
+  {
+    int bestShortSide = TK_INT_MAX;
+    int bestLongSide  = TK_INT_MAX;
+
+    for (const Rect& freeRect : layer.freeRects)
+    {
+      if (freeRect.width < width || freeRect.height < height)
+      {
+        continue;
+      }
+
+      int leftoverX = freeRect.width - width;
+      int leftoverY = freeRect.height - height;
+      int shortSide = glm::min(leftoverX, leftoverY);
+      int longSide  = glm::max(leftoverX, leftoverY);
+
+      if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+      {
+        found         = {freeRect.x, freeRect.y, width, height};
+        bestShortSide = shortSide;
+        bestLongSide  = longSide;
+      }
+    }
+
+    return bestShortSide != TK_INT_MAX;
+  }
+
+  void BinPack2D::Allocate(Layer& layer, const Rect& rect)
+  {
+    RectArray freeRects;
+    freeRects.reserve(layer.freeRects.size() + 4);
+
+    for (const Rect& freeRect : layer.freeRects)
+    {
+      bool overlapX = rect.x < freeRect.x + freeRect.width && rect.x + rect.width > freeRect.x;
+      bool overlapY = rect.y < freeRect.y + freeRect.height && rect.y + rect.height > freeRect.y;
+      if (!overlapX || !overlapY)
+      {
+        freeRects.push_back(freeRect);
+        continue;
+      }
+
+      // Remaining parts of the free rectangle on each side of the allocation.
+      if (rect.y > freeRect.y)
+      {
+        Rect below   = freeRect;
+        below.height = rect.y - freeRect.y;
+        freeRects.push_back(below);
+      }
+
+      if (rect.y + rect.height < freeRect.y + freeRect.height)
+      {
+        Rect above   = freeRect;
+        above.y      = rect.y + rect.height;
+        above.height = freeRect.y + freeRect.height - above.y;
+        freeRects.push_back(above);
+      }
+
+      if (rect.x > freeRect.x)
+      {
+        Rect left  = freeRect;
+        left.width = rect.x - freeRect.x;
+        freeRects.push_back(left);
+      }
+
+      if (rect.x + rect.width < freeRect.x + freeRect.width)
+      {
+        Rect right  = freeRect;
+        right.x     = rect.x + rect.width;
+        right.width = freeRect.x + freeRect.width - right.x;
+        freeRects.push_back(right);
+      }
+    }
+
+    layer.freeRects      = std::move(freeRects);
+    layer.allocatedArea += (int64) rect.width * rect.height;
+    layer.allocations.push_back(rect);
+
+    PruneFreeRects(layer);
+  }
+
+  void BinPack2D::PruneFreeRects(Layer& layer)
+  {
+    auto containsFn = [](const Rect& outer, const Rect& inner) -> bool
+    {
+      return inner.x >= outer.x && inner.y >= outer.y && inner.x + inner.width <= outer.x + outer.width &&
+             inner.y + inner.height <= outer.y + outer.height;
+    };
+
+    RectArray& freeRects = layer.freeRects;
+    for (size_t i = 0; i < freeRects.size(); i++)
+    {
+      for (size_t j = i + 1; j < freeRects.size(); j++)
+      {
+        if (containsFn(freeRects[j], freeRects[i]))
+        {
+          freeRects.erase(freeRects.begin() + i);
+          i--;
+          break;
+        }
+
+        if (containsFn(freeRects[i], freeRects[j]))
+        {
+          freeRects.erase(freeRects.begin() + j);
+          j--;
+        }
+      }
+    }
+  }
+
+  void BinPack2D::ClearLayer(Layer& layer)
+  {
+    layer.freeRects     = {{0, 0, m_atlasSize, m_atlasSize}};
+    layer.allocations.clear();
+    layer.allocatedArea = 0;
+  }
+
+  bool BinPack2D::AddLayer()
+  {
+    if (m_maxLayers > 0 && (int) m_layers.size() >= m_maxLayers)
+    {
+      return false;
+    }
+
+    ClearLayer(m_layers.emplace_back());
+    return true;
+  }
+
 } // namespace ToolKit
@@ -13,24 +13,106 @@ namespace ToolKit
 {
 
   /**
-   * Packs 2D squares into an atlas (array of squares)
-   * Squares must be sorted from smallest to largest to properly placed.
-   * Algorithm is not optimal, meaning that it may not fit all the squares tightly
-   * Algorithm fallows a sequence from left to right, goes one up and left to right
-   * than next layer. This sequence is expected in the shader to find the map's layer and coordinate.
+   * Packs groups of 2D squares into an atlas (array of square layers) with the MaxRects algorithm. Allocations can be
+   * inserted and removed one by one, existing allocations never move.
+   * Squares of a group fallow a sequence from left to right, goes one up and left to right than next layer. This
+   * sequence is expected in the shader to find the map's layer and coordinate, so a group is placed as a rectangle
+   * that starts at the left edge of the atlas if its squares don't fit in a single row. Groups that don't fit in a
+   * layer occupy consecutive whole layers.
    */
-  class BinPack2D
+  class TK_API BinPack2D
   {
    public:
+    /** Placement of a group of squares in the atlas. */
     struct PackedRect
     {
-      Vec2 coordinate = Vec2(-1.0f);
-      int layer       = -1;
+      Vec2 coordinate = Vec2(-1.0f); //!< Bottom left corner of the rectangle in the layer.
+      int layer       = -1;          //!< Layer of the rectangle, first layer if it spans multiple layers.
+      int width       = 0;           //!< Width of the rectangle.
+      int height      = 0;           //!< Height of the rectangle, multiple of the atlas size if it spans layers.
+      int squareSize  = 0;           //!< Size of the squares in the rectangle.
+
+      /** Returns true if the rectangle is placed in the atlas. */
+      bool IsValid() const { return layer != -1; }
     };
 
     typedef std::vector<PackedRect> PackedRectArray;
 
+    /**
+     * Removes all allocations and sets the size of the atlas.
+     * @param atlasSize is the width and height of a layer.
+     * @param maxLayers is the maximum number of layers that can be used, zero for no limit.
+     */
+    void Init(int atlasSize, int maxLayers = 0);
+
+    /**
+     * Places a group of squares to the atlas.
+     * @param squareSize is the width and height of the squares. Must be a power of two, not larger than the atlas.
+     * @param squareCount is the number of squares in the group.
+     * @return Placement of the group, invalid if the group doesn't fit in the atlas.
+     */
+    PackedRect Insert(int squareSize, int squareCount);
+
+    /** Frees the area of a group that is placed by Insert. */
+    void Remove(const PackedRect& rect);
+
+    /** Returns the placement of a square of a group, following the sequence that the shader expects. */
+    PackedRect GetSquare(const PackedRect& rect, int index) const;
+
+    /** Returns the number of layers up to the last layer that has an allocation. */
+    int GetLayerCount() const;
+
+    /** Returns the ratio of the allocated area to the area of the used layers. */
+    float GetOccupancy() const;
+
+    /**
+     * Packs the squares from scratch. Each square is placed as a separate group.
+     * @param squares are the sizes of the squares.
+     * @param atlasSize is the width and height of a layer.
+     * @param layerCount is the number of layers needed.
+     * @return Placements of the squares, in the same order.
+     */
     PackedRectArray Pack(const IntArray& squares, int atlasSize, int* layerCount = nullptr);
+
+   private:
+    /** A free or allocated area in a layer. */
+    struct Rect
+    {
+      int x      = 0;
+      int y      = 0;
+      int width  = 0;
+      int height = 0;
+    };
+
+    typedef std::vector<Rect> RectArray;
+
+    /** Free area of a layer, kept as maximal, possibly overlapping rectangles. */
+    struct Layer
+    {
+      RectArray freeRects;     //!< Free rectangles of the layer.
+      RectArray allocations;   //!< Allocated rectangles of the layer.
+      int64 allocatedArea = 0; //!< Total area of the allocations in the layer.
+    };
+
+    /** Finds the free rectangle with the best short side fit in the layer. Returns false if nothing fits. */
+    bool FindPosition(const Layer& layer, int width, int height, Rect& found) const;
+
+    /** Allocates the rectangle in the layer by splitting the free rectangles that overlap it. */
+    void Allocate(Layer& layer, const Rect& rect);
+
+    /** Removes the free rectangles that are contained by another one. */
+    void PruneFreeRects(Layer& layer);
+
+    /** Resets the layer to a single free rectangle. */
+    void ClearLayer(Layer& layer);
+
+    /** Adds a new empty layer. Returns false if the layer limit is reached. */
+    bool AddLayer();
+
+   private:
+    std::vector<Layer> m_layers; //!< Layers of the atlas.
+    int m_atlasSize = 0;         //!< Width and height of the layers.
+    int m_maxLayers = 0;         //!< Maximum number of layers, zero for no limit.
   };
 
 } // namespace ToolKit
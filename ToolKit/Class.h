@@ -32,6 +32,12 @@ namespace ToolKit
      */
     std::vector<std::pair<StringView, ObjectId>> SuperClassLookUp;
 
+    /**
+     * Dense index of the component classes, assigned when the class is registered. Used to access the components of
+     * the entities in constant time. -1 for the other classes.
+     */
+    int ComponentIndex = -1;
+
     bool operator==(const ClassMeta& other) const
     {
       assert(HashId != NullHandle && "Class is not registered.");
@@ -0,0 +1,320 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#include "ClusteredLighting.h"
+
+#include "Camera.h"
+#include "Light.h"
+#include "MathUtil.h"
+#include "Stats.h"
+#include "Texture.h"
+#include "Threads.h"
+#include "ToolKit.h"
+
+#include "DebugNew.h"
+
+namespace ToolKit
+{
+
+  /** Number of vec4 texels that each light occupies in the light data texture. */
+  constexpr int g_clusterLightTexelCount = 10;
+
+  constexpr int g_clusterSliceCount      = RHIConstants::ClusterCountZ;
+  constexpr int g_clusterTileCount       = RHIConstants::ClusterCountX * RHIConstants::ClusterCountY;
+  constexpr int g_clusterCount           = g_clusterTileCount * g_clusterSliceCount;
+  constexpr int g_maxClusteredLights     = RHIConstants::MaxClusteredLights;
+  constexpr int g_indexTextureWidth      = RHIConstants::ClusterIndexTextureWidth;
+  constexpr int g_indexTextureHeight     = RHIConstants::MaxClusterLightIndices / g_indexTextureWidth;
+
+  ClusteredLighting::ClusteredLighting()
+  {
+    m_sliceDepths.resize(g_clusterSliceCount + 1);
+    m_sliceIndices.resize(g_clusterSliceCount);
+    m_clusterGrid.resize(g_clusterCount * 2);
+  }
+
+  ClusteredLighting::~ClusteredLighting() { UnInit(); }
+
+  void ClusteredLighting::Init()
+  {
+    if (m_clusterGridTexture != nullptr)
+    {
+      return;
+    }
+
+    TextureSettings settings;
+    settings.Target         = GraphicTypes::Target2D;
+    settings.WarpS          = GraphicTypes::UVClampToEdge;
+    settings.WarpT          = GraphicTypes::UVClampToEdge;
+    settings.WarpR          = GraphicTypes::UVClampToEdge;
+    settings.Type           = GraphicTypes::TypeFloat;
+
+    // Each row of the grid is a depth slice.
+    settings.InternalFormat = GraphicTypes::FormatRG32F;
+    settings.Format         = GraphicTypes::FormatRG;
+    m_clusterGridTexture    = MakeNewPtr<DataTexture>(g_clusterTileCount, g_clusterSliceCount, settings);
+    m_clusterGridTexture->Init(nullptr);
+
+    settings.InternalFormat = GraphicTypes::FormatRGBA32F;
+    settings.Format         = GraphicTypes::FormatRGBA;
+    m_lightDataTexture      = MakeNewPtr<DataTexture>(g_clusterLightTexelCount, g_maxClusteredLights, settings);
+    m_lightDataTexture->Init(nullptr);
+
+    settings.InternalFormat = GraphicTypes::FormatR32F;
+    settings.Format         = GraphicTypes::FormatRed;
+    m_lightIndexTexture     = MakeNewPtr<DataTexture>(g_indexTextureWidth, g_indexTextureHeight, settings);
+    m_lightIndexTexture->Init(nullptr);
+  }
+
+  void ClusteredLighting::UnInit()
+  {
+    m_clusterGridTexture = nullptr;
+    m_lightDataTexture   = nullptr;
+    m_lightIndexTexture  = nullptr;
+  }
+
+  bool ClusteredLighting::IsSupported(const CameraPtr& camera)
+  {
+    return camera != nullptr && !camera->IsOrtographic() && camera->Near() > 0.0f && camera->Far() > camera->Near();
+  }
+
+  void ClusteredLighting::Update(const CameraPtr& camera, const LightRawPtrArray& lights)
+  {
+    float beginTime = GetElapsedMilliSeconds();
+
+    Init();
+
+    // Slices are distributed logarithmically, so that their depth grows with their distance to the camera.
+    const float nearPlane    = camera->Near();
+    const float farPlane     = camera->Far();
+    const float sliceCount   = (float) g_clusterSliceCount;
+    const float logDepth     = glm::log(farPlane / nearPlane);
+
+    m_clusterData.sliceScale = sliceCount / logDepth;
+    m_clusterData.sliceBias  = sliceCount * glm::log(nearPlane) / logDepth;
+    for (int i = 0; i <= g_clusterSliceCount; i++)
+    {
+      m_sliceDepths[i] = nearPlane * glm::pow(farPlane / nearPlane, (float) i / sliceCount);
+    }
+
+    m_projection = camera->GetProjectionMatrix();
+    Mat4 view    = camera->GetViewMatrix();
+
+    // Cache items are lazily updated, they are read before the parallel assignment.
+    m_lightData.clear();
+    m_lightBounds.clear();
+    for (Light* light : lights)
+    {
+      if (m_lightBounds.size() >= RHIConstants::MaxClusteredLights)
+      {
+        break;
+      }
+
+      if (light->GetLightType() != Light::LightType::Directional)
+      {
+        PackLight(light, view);
+      }
+    }
+    m_clusterData.lightCount = (int) m_lightBounds.size();
+
+    // Each slice writes its own clusters and index list.
+    GetWorkerManager()->ParallelFor(g_clusterSliceCount,
+                                    1,
+                                    [this](size_t begin, size_t end) -> void
+                                    {
+                                      for (size_t slice = begin; slice < end; slice++)
+                                      {
+                                        AssignLights((int) slice);
+                                      }
+                                    });
+
+    MergeSlices();
+
+    int indexRows = (int) (m_lightIndices.size() / RHIConstants::ClusterIndexTextureWidth);
+    m_clusterGridTexture->MapRows(m_clusterGrid.data(), g_clusterSliceCount);
+    m_lightDataTexture->MapRows(m_lightData.data(), m_clusterData.lightCount);
+    m_lightIndexTexture->MapRows(m_lightIndices.data(), indexRows);
+
+    if (TKStats* stats = GetTKStats())
+    {
+      uint occupiedClusters = 0;
+      uint maxClusterLights = 0;
+      for (int i = 0; i < g_clusterCount; i++)
+      {
+        uint count        = (uint) m_clusterGrid[i * 2 + 1];
+        occupiedClusters += count > 0;
+        maxClusterLights  = glm::max(maxClusterLights, count);
+      }
+
+      stats->m_clusteredLightCount     = (uint) m_clusterData.lightCount;
+      stats->m_clusterCount            = (uint) g_clusterCount;
+      stats->m_occupiedClusterCount    = occupiedClusters;
+      stats->m_maxLightsPerCluster     = maxClusterLights;
+      stats->m_clusterLightIndexCount  = m_lightIndexCount;
+      stats->m_clusteredLightBuildTime = GetElapsedMilliSeconds() - beginTime;
+    }
+  }
+
+  void ClusteredLighting::PackLight(Light* light, const Mat4& view)
+  {
+    Vec4 texels[g_clusterLightTexelCount]  = {};
+    const LightCacheItem::CommonData* data = nullptr;
+
+    BoundingSphere sphere;
+    if (light->GetLightType() == Light::LightType::Spot)
+    {
+      SpotLight* spot                          = static_cast<SpotLight*>(light);
+      const SpotLightCacheItem::Data& spotData = spot->GetCacheItem().data;
+      data                                     = &spotData;
+
+      texels[1].w                              = spotData.radius;
+      texels[2]                                = Vec4(spotData.direction, (float) Light::LightType::Spot);
+      texels[3].x                              = spotData.outerAngle;
+      texels[3].y                              = spotData.innerAngle;
+      for (int i = 0; i < 4; i++)
+      {
+        texels[6 + i] = spotData.projectionViewMatrix[i];
+      }
+
+      // Smallest sphere that encloses the cone, depends on whether the cone is wider than 90 degrees.
+      float halfAngle = glm::radians(spot->GetOuterAngleVal() * 0.5f);
+      float cosAngle  = glm::cos(halfAngle);
+      if (halfAngle > glm::quarter_pi<float>())
+      {
+        sphere.pos    = spotData.position + spotData.direction * spotData.radius * cosAngle;
+        sphere.radius = spotData.radius * glm::sin(halfAngle);
+      }
+      else
+      {
+        sphere.radius = spotData.radius / (2.0f * cosAngle);
+        sphere.pos    = spotData.position + spotData.direction * sphere.radius;
+      }
+    }
+    else
+    {
+      PointLight* point                          = static_cast<PointLight*>(light);
+      const PointLightCacheItem::Data& pointData = point->GetCacheItem().data;
+      data                                       = &pointData;
+
+      texels[1].w                                = pointData.radius;
+      texels[2].w                                = (float) Light::LightType::Point;
+
+      sphere.pos                                 = pointData.position;
+      sphere.radius                              = pointData.radius;
+    }
+
+    texels[0]   = Vec4(data->color, data->intensity);
+    texels[1]   = Vec4(data->position, texels[1].w);
+    texels[3].z = (float) data->castShadow;
+    texels[3].w = (float) data->pcfSamples;
+    texels[4]   = Vec4(data->shadowBias, data->bleedingReduction, data->pcfRadius, data->shadowResolution);
+    texels[5]   = Vec4(data->shadowAtlasCoord, (float) data->shadowAtlasLayer, 0.0f);
+
+    m_lightData.insert(m_lightData.end(), texels, texels + g_clusterLightTexelCount);
+
+    // Slices are found from the view depth range of the sphere.
+    sphere.pos    = Vec3(view * Vec4(sphere.pos, 1.0f));
+    float minZ    = -sphere.pos.z - sphere.radius;
+    float maxZ    = -sphere.pos.z + sphere.radius;
+
+    auto sliceItr = std::upper_bound(m_sliceDepths.begin(), m_sliceDepths.end(), minZ);
+    int first     = glm::max((int) std::distance(m_sliceDepths.begin(), sliceItr) - 1, 0);
+
+    sliceItr      = std::lower_bound(m_sliceDepths.begin(), m_sliceDepths.end(), maxZ);
+    int last      = glm::min((int) std::distance(m_sliceDepths.begin(), sliceItr) - 1, g_clusterSliceCount - 1);
+
+    m_lightBounds.push_back({sphere, first, last});
+  }
+
+  void ClusteredLighting::AssignLights(int slice)
+  {
+    std::vector<float>& indices = m_sliceIndices[slice];
+    indices.clear();
+
+    // Lights that intersect the slice.
+    IntArray sliceLights;
+    for (int i = 0; i < (int) m_lightBounds.size(); i++)
+    {
+      if (m_lightBounds[i].firstSlice <= slice && m_lightBounds[i].lastSlice >= slice)
+      {
+        sliceLights.push_back(i);
+      }
+    }
+
+    // Normalized device coordinates are converted to view space by the inverse of the projection's x and y terms.
+    const Vec2 ndcScale   = Vec2(1.0f / m_projection[0][0], 1.0f / m_projection[1][1]);
+    const Vec2 ndcOffset  = Vec2(m_projection[2][0], m_projection[2][1]);
+    const Vec2 tileSize   = Vec2(2.0f / RHIConstants::ClusterCountX, 2.0f / RHIConstants::ClusterCountY);
+    const float nearDepth = m_sliceDepths[slice];
+    const float farDepth  = m_sliceDepths[slice + 1];
+
+    for (int tile = 0; tile < g_clusterTileCount; tile++)
+    {
+      int cluster = slice * g_clusterTileCount + tile;
+      float* grid = &m_clusterGrid[cluster * 2];
+      grid[0]     = (float) indices.size();
+
+      if (sliceLights.empty())
+      {
+        grid[1] = 0.0f;
+        continue;
+      }
+
+      Vec2 ndcMin  = Vec2(tile % RHIConstants::ClusterCountX, tile / RHIConstants::ClusterCountX) * tileSize - 1.0f;
+      Vec2 ndcMax  = ndcMin + tileSize;
+
+      // Tile's view space extent grows with the depth, box encloses it on both ends of the slice.
+      Vec2 nearMin = (ndcMin + ndcOffset) * ndcScale * nearDepth;
+      Vec2 nearMax = (ndcMax + ndcOffset) * ndcScale * nearDepth;
+      Vec2 farMin  = (ndcMin + ndcOffset) * ndcScale * farDepth;
+      Vec2 farMax  = (ndcMax + ndcOffset) * ndcScale * farDepth;
+
+      BoundingBox box(Vec3(glm::min(nearMin, farMin), -farDepth), Vec3(glm::max(nearMax, farMax), -nearDepth));
+
+      for (int light : sliceLights)
+      {
+        if (SphereBoxIntersection(m_lightBounds[light].sphere, box))
+        {
+          indices.push_back((float) light);
+        }
+      }
+
+      grid[1] = (float) indices.size() - grid[0];
+    }
+  }
+
+  void ClusteredLighting::MergeSlices()
+  {
+    m_lightIndices.clear();
+
+    // Offsets of each slice are shifted by the index count of the previous slices.
+    for (int slice = 0; slice < g_clusterSliceCount; slice++)
+    {
+      const std::vector<float>& indices = m_sliceIndices[slice];
+      const float sliceOffset           = (float) m_lightIndices.size();
+      const int freeSpace               = (int) (RHIConstants::MaxClusterLightIndices - m_lightIndices.size());
+      const int copyCount               = glm::min((int) indices.size(), freeSpace);
+
+      for (int tile = 0; tile < g_clusterTileCount; tile++)
+      {
+        float* grid  = &m_clusterGrid[(slice * g_clusterTileCount + tile) * 2];
+
+        // Clusters that don't fit the index texture lose their lights.
+        grid[1]      = glm::clamp((float) copyCount - grid[0], 0.0f, grid[1]);
+        grid[0]     += sliceOffset;
+      }
+
+      m_lightIndices.insert(m_lightIndices.end(), indices.begin(), indices.begin() + copyCount);
+    }
+
+    // Index texture is mapped by complete rows.
+    m_lightIndexCount = (uint) m_lightIndices.size();
+    uint rowWidth     = RHIConstants::ClusterIndexTextureWidth;
+    m_lightIndices.resize((m_lightIndexCount + rowWidth - 1) / rowWidth * rowWidth, 0.0f);
+  }
+
+} // namespace ToolKit
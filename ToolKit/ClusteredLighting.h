@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#pragma once
+
+/**
+ * @file Clustered forward lighting. Point and spot lights are assigned to the clusters of the view frustum once per
+ * frame, instead of assigning them to each render job.
+ */
+
+#include "GeometryTypes.h"
+#include "UniformBuffer.h"
+
+namespace ToolKit
+{
+
+  // ClusterGpuBuffer
+  //////////////////////////////////////////
+
+  struct ClusterDataLayout
+  {
+    float sliceScale; //!< Multiplier of the logarithm of the view depth to find the slice of a fragment.
+    float sliceBias;  //!< Subtracted from the scaled logarithm of the view depth to find the slice of a fragment.
+    int lightCount;   //!< Number of lights in the light data texture.
+    int pad0;
+  };
+
+  typedef GpuBufferBase<ClusterDataLayout, 11> ClusterGpuBuffer;
+
+  // ClusteredLighting
+  //////////////////////////////////////////
+
+  /**
+   * Divides the view frustum in to a grid of clusters, screen space tiles along x and y and logarithmic slices along
+   * the depth. Each frame, point and spot lights are assigned to the clusters they intersect, one depth slice per
+   * worker task. Fragments find their cluster and iterate its lights, so there is no light limit per object.
+   * Gles 3.0 has no storage buffers, light data, cluster grid and light index lists are uploaded as data textures.
+   */
+  class TK_API ClusteredLighting
+  {
+   public:
+    ClusteredLighting();
+    ~ClusteredLighting(); //!< Releases the gpu resources.
+
+    ClusteredLighting(const ClusteredLighting&)            = delete;
+    ClusteredLighting& operator=(const ClusteredLighting&) = delete;
+
+    /** Creates the data textures. Called by the first update. */
+    void Init();
+
+    /** Releases the data textures. */
+    void UnInit();
+
+    /**
+     * Assigns the point and spot lights to the clusters of the camera and uploads the results. Directional lights are
+     * skipped, they affect all fragments. Lights beyond RHIConstants::MaxClusteredLights are ignored.
+     */
+    void Update(const CameraPtr& camera, const LightRawPtrArray& lights);
+
+    /** Returns true if the camera can be clustered. Orthographic cameras use the per object light assignment. */
+    static bool IsSupported(const CameraPtr& camera);
+
+   public:
+    /** Light index offset and light count for each cluster. */
+    DataTexturePtr m_clusterGridTexture = nullptr;
+
+    /** Packed data of the point and spot lights, a row for each light. */
+    DataTexturePtr m_lightDataTexture   = nullptr;
+
+    /** Light indexes of all clusters, each cluster's indexes are consecutive. */
+    DataTexturePtr m_lightIndexTexture  = nullptr;
+
+    /** Slice parameters and the light count that is mapped to the cluster gpu buffer. */
+    ClusterDataLayout m_clusterData     = {};
+
+   private:
+    void PackLight(Light* light, const Mat4& view);
+    void AssignLights(int slice);
+    void MergeSlices();
+
+   private:
+    /** View space bounding sphere of a light and the depth slices that it intersects. */
+    struct LightBounds
+    {
+      BoundingSphere sphere;
+      int firstSlice;
+      int lastSlice;
+    };
+
+    Mat4 m_projection;                              //!< Projection of the clustered camera.
+    std::vector<float> m_sliceDepths;               //!< View depth of the boundaries of the slices.
+    std::vector<LightBounds> m_lightBounds;         //!< Bounds of each packed light.
+    std::vector<Vec4> m_lightData;                  //!< Packed light data that is uploaded to the light data texture.
+    std::vector<std::vector<float>> m_sliceIndices; //!< Light indexes of the clusters of each slice.
+    std::vector<float> m_clusterGrid;               //!< Light index offset and count for each cluster.
+    std::vector<float> m_lightIndices;              //!< Merged light indexes of all slices.
+    uint m_lightIndexCount = 0;                     //!< Number of merged light indexes without the row padding.
+  };
+
+  typedef std::shared_ptr<ClusteredLighting> ClusteredLightingPtr;
+
+} // namespace ToolKit
@@ -47,6 +47,16 @@ namespace ToolKit
     }
   }
 
+  void Component::InvalidateRenderProxy()
+  {
+    if (EntityPtr ntt = m_entity.lock())
+    {
+      ntt->InvalidateRenderProxy();
+    }
+  }
+
+  bool Component::IsSerializable() const { return m_serializableComponent; }
+
   void Component::ParameterConstructor()
   {
     Super::ParameterConstructor();
@@ -14,12 +14,20 @@
 
 #include "Object.h"
 
+#include <bitset>
+
 namespace ToolKit
 {
 
   typedef std::shared_ptr<class Component> ComponentPtr;
   typedef std::vector<ComponentPtr> ComponentPtrArray;
 
+  /** Maximum number of the registered component classes. */
+  constexpr int TKMaxComponentClasses = 128;
+
+  /** A bit for each component class, indexed by the ClassMeta::ComponentIndex of the class. */
+  typedef std::bitset<TKMaxComponentClasses> ComponentMask;
+
   /**
    * Base component class that represent data which can be added and queried
    * by entities. Components are responsible bringing in related functionality
@@ -71,6 +79,12 @@ namespace ToolKit
     /** Owner entity gets invalidated. */
     virtual void InvalidateSpatialCaches();
 
+    /** Retained render jobs of the owner entity are created again. */
+    void InvalidateRenderProxy();
+
+    /** States if the component is written to the scene file. */
+    bool IsSerializable() const;
+
    protected:
     void ParameterConstructor() override;
 
@@ -8,6 +8,7 @@
 #include "DirectionComponent.h"
 
 #include "Entity.h"
+#include "TransformSystem.h"
 
 #include <DebugNew.h>
 
@@ -109,9 +110,16 @@ namespace ToolKit
 
   Mat4& DirectionComponent::GetOwnerWorldTransform() const
   {
+    // Pending transforms of the owner reset the cache flag.
+    Node* ownerNode = OwnerEntity()->m_node;
+    if (TransformSystem* transformSystem = ownerNode->GetTransformSystem())
+    {
+      transformSystem->Update();
+    }
+
     if (m_spatialCachesInvalidated)
     {
-      m_ownerWorldTransformCache = OwnerEntity()->m_node->GetTransform(TransformationSpace::TS_WORLD);
+      m_ownerWorldTransformCache = ownerNode->GetTransform(TransformationSpace::TS_WORLD);
       m_spatialCachesInvalidated = false;
     }
 
@@ -12,6 +12,7 @@
 #include "MathUtil.h"
 #include "PluginManager.h"
 #include "RenderSystem.h"
+#include "TextureCompression.h"
 #include "ToolKit.h"
 
 #include "DebugNew.h"
@@ -61,6 +62,8 @@ namespace ToolKit
     StableShadowMap_Define(false, "ShadowSettings", 0, 0, 0);
     UseEVSM4_Define(false, "ShadowSettings", 0, 0, 0);
     Use32BitShadowMap_Define(false, "ShadowSettings", 0, 0, 0);
+    CacheShadowMaps_Define(true, "ShadowSettings", 0, 0, 0);
+    MaxShadowAtlasLayers_Define(0, "ShadowSettings", 0, 0, 0);
   }
 
   void ShadowSettings::ParameterEventConstructor()
@@ -137,6 +140,22 @@ namespace ToolKit
     EnableGpuTimer_Define(false, "GraphicSettings", 0, 0, 0);
     HDRPipeline_Define(true, "GraphicSettings", 0, 0, 0);
     RenderResolutionScale_Define(1.0f, "GraphicSettings", 0, 0, 0);
+    ClusteredLighting_Define(false, "GraphicSettings", 0, 0, 0);
+    GpuInstancing_Define(true, "GraphicSettings", 0, 0, 0);
+
+    MultiChoiceVariant textureCompressionMcv = {
+        {CreateMultiChoiceParameter("None", (int) TextureCompression::None),
+         CreateMultiChoiceParameter("ETC2", (int) TextureCompression::ETC2),
+         CreateMultiChoiceParameter("BC", (int) TextureCompression::BC)},
+        0
+    };
+    DesktopTextureCompression_Define(textureCompressionMcv, "GraphicSettings", 0, true, true);
+
+    textureCompressionMcv.CurrentVal.Index = 0;
+    WebTextureCompression_Define(textureCompressionMcv, "GraphicSettings", 0, true, true);
+
+    textureCompressionMcv.CurrentVal.Index = 1;
+    AndroidTextureCompression_Define(textureCompressionMcv, "GraphicSettings", 0, true, true);
   }
 
   // PostProcessingSettings
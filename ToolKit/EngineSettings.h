@@ -105,6 +105,18 @@ namespace ToolKit
     /** Uses 32 bit shadow maps. */
     TKDeclareParam(bool, Use32BitShadowMap);
 
+    /**
+     * Reuses the shadow maps of the previous frames. A shadow map is only rendered again when its shadow camera, its
+     * place in the shadow atlas or any of the casters in it changes.
+     */
+    TKDeclareParam(bool, CacheShadowMaps);
+
+    /**
+     * Maximum number of layers that the shadow atlas can have, zero for the gpu limit. When the atlas is full, shadow
+     * maps of the newly added lights are placed with lower resolutions.
+     */
+    TKDeclareParam(int, MaxShadowAtlasLayers);
+
     /**
      * Shadow sample taken from shadow map. Higher is smoother but more expensive.
      * Indexes and sample counts {0: 1, 2: 9, 3: 25, 4: 49}
@@ -162,6 +174,30 @@ namespace ToolKit
     /** Anisotropic texture filtering value. It can be 0, 2 ,4, 8, 16. Clamped with gpu max anisotropy. */
     TKDeclareParam(MultiChoiceVariant, AnisotropicTextureFiltering);
 
+    /**
+     * Assigns point and spot lights to the clusters of the view frustum once per frame instead of each object. Removes
+     * the light limits per object, suitable for scenes with many small lights.
+     */
+    TKDeclareParam(bool, ClusteredLighting);
+
+    /**
+     * Draws the render jobs that share the mesh, material and lights with a single instanced draw call. Reduces the cpu
+     * cost of the scenes with many copies of the same mesh.
+     */
+    TKDeclareParam(bool, GpuInstancing);
+
+    /**
+     * Block compression of the textures packed for desktop platforms. None, Etc2 or Bc. Compressed textures are stored
+     * with their mip levels and uploaded without decoding, which reduces the load times and the vram usage.
+     */
+    TKDeclareParam(MultiChoiceVariant, DesktopTextureCompression);
+
+    /** Block compression of the textures packed for web. None, Etc2 or Bc. */
+    TKDeclareParam(MultiChoiceVariant, WebTextureCompression);
+
+    /** Block compression of the textures packed for android. None, Etc2 or Bc. */
+    TKDeclareParam(MultiChoiceVariant, AndroidTextureCompression);
+
     /** Global shadow settings. */
     ShadowSettingsPtr m_shadows;
   };
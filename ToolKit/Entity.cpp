@@ -20,11 +20,13 @@
 #include "Node.h"
 #include "Prefab.h"
 #include "Primative.h"
+#include "RenderProxyStore.h"
 #include "Scene.h"
 #include "Skeleton.h"
 #include "Sky.h"
 #include "Surface.h"
 #include "ToolKit.h"
+#include "TransformSystem.h"
 #include "Util.h"
 
 #include <DebugNew.h>
@@ -99,6 +101,12 @@ namespace ToolKit
 
   const BoundingBox& Entity::GetBoundingBox(bool inWorld)
   {
+    // A registered node that is moved invalidates the caches with the transform system update.
+    if (TransformSystem* transformSystem = m_node->GetTransformSystem())
+    {
+      transformSystem->Update();
+    }
+
     if (!m_spatialCachesInvalidated)
     {
       return inWorld ? m_worldBoundingBoxCache : m_localBoundingBoxCache;
@@ -117,7 +125,11 @@ namespace ToolKit
     return cpy;
   }
 
-  void Entity::ClearComponents() { m_components.clear(); }
+  void Entity::ClearComponents()
+  {
+    m_components.clear();
+    UpdateComponentSlots();
+  }
 
   Entity* Entity::GetPrefabRoot() const { return _prefabRootEntity; }
 
@@ -142,6 +154,18 @@ namespace ToolKit
     }
 
     m_spatialCachesInvalidated = true;
+    InvalidateRenderProxy();
+  }
+
+  void Entity::InvalidateRenderProxy()
+  {
+    if (m_renderProxyIndex != -1)
+    {
+      if (ScenePtr scene = m_scene.lock())
+      {
+        scene->GetRenderProxyStore()->Invalidate(this);
+      }
+    }
   }
 
   Entity* Entity::CopyTo(Entity* other) const
@@ -153,6 +177,7 @@ namespace ToolKit
       ComponentPtr copy = m_components[i]->Copy(other->Self<Entity>());
       other->m_components.push_back(copy);
     }
+    other->UpdateComponentSlots();
 
     return other;
   }
@@ -167,7 +192,38 @@ namespace ToolKit
     TransformLock_Define(false, EntityCategory.Name, EntityCategory.Priority, true, true);
   }
 
-  void Entity::ParameterEventConstructor() { Super::ParameterEventConstructor(); }
+  void Entity::ParameterEventConstructor()
+  {
+    Super::ParameterEventConstructor();
+
+    // Keep the lookup indices of the scene up to date.
+    ParamId().m_onValueChangedFn.push_back(
+        [this](Value& oldVal, Value& newVal) -> void
+        {
+          if (ScenePtr scene = m_scene.lock())
+          {
+            scene->OnEntityIdChanged(this, std::get<ObjectId>(oldVal));
+          }
+        });
+
+    ParamName().m_onValueChangedFn.push_back(
+        [this](Value& oldVal, Value& newVal) -> void
+        {
+          if (ScenePtr scene = m_scene.lock())
+          {
+            scene->OnEntityNameChanged(this, std::get<String>(oldVal));
+          }
+        });
+
+    ParamTag().m_onValueChangedFn.push_back(
+        [this](Value& oldVal, Value& newVal) -> void
+        {
+          if (ScenePtr scene = m_scene.lock())
+          {
+            scene->OnEntityTagChanged(this, std::get<String>(oldVal));
+          }
+        });
+  }
 
   void Entity::WeakCopy(Entity* other, bool copyComponents) const
   {
@@ -184,6 +240,7 @@ namespace ToolKit
     if (copyComponents)
     {
       other->m_components = m_components;
+      other->UpdateComponentSlots();
     }
   }
 
@@ -192,6 +249,7 @@ namespace ToolKit
     assert(GetComponent(component->Class()) == nullptr && "Component has already been added.");
     component->OwnerEntity(Self<Entity>());
     m_components.push_back(component);
+    UpdateComponentSlots();
   }
 
   MeshComponentPtr Entity::GetMeshComponent() const { return GetComponent<MeshComponent>(); }
@@ -206,6 +264,7 @@ namespace ToolKit
       {
         ComponentPtr cmp = m_components[i];
         m_components.erase(m_components.begin() + i);
+        UpdateComponentSlots();
         return cmp;
       }
     }
@@ -215,6 +274,42 @@ namespace ToolKit
 
   ComponentPtrArray& Entity::GetComponentPtrArray() { return m_components; }
 
+  const ComponentMask& Entity::GetComponentMask() const { return m_componentMask; }
+
+  void Entity::UpdateComponentSlots()
+  {
+    m_componentSlots.clear();
+    m_componentMask.reset();
+
+    // Each component fills the slots of its class and its base classes, first component of a class takes the slot.
+    for (int i = 0; i < (int) m_components.size(); i++)
+    {
+      for (ClassMeta* Class = m_components[i]->Class(); Class != nullptr; Class = Class->Super)
+      {
+        int componentIndex = Class->ComponentIndex;
+        if (componentIndex == -1 || m_componentMask.test(componentIndex))
+        {
+          continue;
+        }
+
+        if (componentIndex >= (int) m_componentSlots.size())
+        {
+          m_componentSlots.resize(componentIndex + 1, -1);
+        }
+
+        m_componentSlots[componentIndex] = (int8_t) i;
+        m_componentMask.set(componentIndex);
+      }
+    }
+
+    if (ScenePtr scene = m_scene.lock())
+    {
+      scene->OnEntityComponentsChanged(this);
+    }
+
+    InvalidateRenderProxy();
+  }
+
   const ComponentPtrArray& Entity::GetComponentPtrArray() const { return m_components; }
 
   ComponentPtr Entity::GetComponent(ClassMeta* Class) const
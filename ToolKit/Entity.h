@@ -65,8 +65,7 @@ namespace ToolKit
       assert(GetComponent(T::StaticClass()) == nullptr && "Component has already been added.");
 
       std::shared_ptr<T> component = MakeNewPtr<T>(componentSerializable);
-      component->OwnerEntity(Self<Entity>());
-      m_components.push_back(component);
+      AddComponent(component);
       return component;
     }
 
@@ -92,17 +91,17 @@ namespace ToolKit
     template <typename T>
     ComponentPtr RemoveComponent()
     {
-      for (int i = 0; i < (int) m_components.size(); i++)
+      int slot = GetComponentSlot(T::StaticClass());
+      if (slot == -1)
       {
-        if (m_components[i]->IsA<T>())
-        {
-          ComponentPtr cmp = m_components[i];
-          m_components.erase(m_components.begin() + i);
-          return cmp;
-        }
+        return nullptr;
       }
 
-      return nullptr;
+      ComponentPtr cmp = m_components[slot];
+      m_components.erase(m_components.begin() + slot);
+      UpdateComponentSlots();
+
+      return cmp;
     }
 
     /**
@@ -113,7 +112,8 @@ namespace ToolKit
     ComponentPtr RemoveComponent(ClassMeta* Class);
 
     /**
-     * Mutable component array accessors.
+     * Mutable component array accessors. Components must be added and removed with the Add / Remove functions, which
+     * keep the component slots up to date.
      * @return ComponentPtrArray for this Entity.
      */
     ComponentPtrArray& GetComponentPtrArray();
@@ -125,38 +125,49 @@ namespace ToolKit
     const ComponentPtrArray& GetComponentPtrArray() const;
 
     /**
-     * Used to return component of type T.
+     * Used to return component of type T. Constant time for the registered component classes.
      * @return Component of type T if exist, otherwise nullptr.
      */
     template <typename T>
     std::shared_ptr<T> GetComponent() const
     {
-      for (int i = 0; i < (int) m_components.size(); i++)
-      {
-        if (m_components[i]->IsA<T>())
-        {
-          return Cast<T>(m_components[i]);
-        }
-      }
-
-      return nullptr;
+      int slot = GetComponentSlot(T::StaticClass());
+      return slot == -1 ? nullptr : Cast<T>(m_components[slot]);
     }
 
     /** Faster version of the get component, if raw pointer is applicable. */
     template <typename T>
     T* GetComponentFast() const
     {
+      int slot = GetComponentSlot(T::StaticClass());
+      return slot == -1 ? nullptr : static_cast<T*>(m_components[slot].get());
+    }
+
+    /**
+     * Returns the index of the first component that is of the given class or derived from it, -1 if there is none.
+     * Registered component classes are looked up from the component slots, others are searched.
+     */
+    int GetComponentSlot(ClassMeta* Class) const
+    {
+      if (Class->ComponentIndex != -1)
+      {
+        return Class->ComponentIndex < (int) m_componentSlots.size() ? m_componentSlots[Class->ComponentIndex] : -1;
+      }
+
       for (int i = 0; i < (int) m_components.size(); i++)
       {
-        if (m_components[i]->IsA<T>())
+        if (m_components[i]->Class()->IsSublcassOf(Class))
         {
-          return static_cast<T*>(m_components[i].get());
+          return i;
         }
       }
 
-      return nullptr;
+      return -1;
     }
 
+    /** Returns the mask of the classes that the entity has components of, including their base classes. */
+    const ComponentMask& GetComponentMask() const;
+
     /**
      * Returns the component with the given class.
      * @return Component of type T if exist, otherwise empty pointer.
@@ -180,6 +191,9 @@ namespace ToolKit
     /** Updates spatial caches related to entity. AABB tree is updated upon access. */
     virtual void UpdateSpatialCaches();
 
+    /** Render jobs that are retained by the scene are created again with the next frame. */
+    void InvalidateRenderProxy();
+
    protected:
     virtual Entity* CopyTo(Entity* other) const;
     void ParameterConstructor() override;
@@ -223,6 +237,15 @@ namespace ToolKit
     /** Entity causes AABBTree to be updated when added removed to the scene. */
     bool m_partOfAABBTree             = true;
 
+    /** Index of the proxy that retains the render jobs of this entity in the scene's RenderProxyStore. */
+    int m_renderProxyIndex            = -1;
+
+    /** Index of the scene's archetype that holds the entities with the same component mask. */
+    int m_archetypeIndex              = -1;
+
+    /** Index of this entity in the entities of its archetype. */
+    int m_archetypeSlot               = -1;
+
     /** The Scene that entity belongs to. */
     SceneWeakPtr m_scene;
 
@@ -233,12 +256,22 @@ namespace ToolKit
     BoundingBox m_localBoundingBoxCache;
     BoundingBox m_worldBoundingBoxCache;
 
+   private:
+    /** Rebuilds the component slots and mask after the components change, notifies the scene. */
+    void UpdateComponentSlots();
+
    private:
     /**
      * Component map that may contains only one component per type.
      * It holds Class HashId - ComponentPtr
      */
     ComponentPtrArray m_components;
+
+    /** Index in to the components for each component class index, -1 if there is no component of the class. */
+    std::vector<int8_t> m_componentSlots;
+
+    /** Classes that the entity has components of. */
+    ComponentMask m_componentMask;
   };
 
   // Entity Container functions.
@@ -7,15 +7,19 @@
 
 #include "FileManager.h"
 
+#include "Animation.h"
 #include "Audio.h"
 #include "Image.h"
 #include "Logger.h"
+#include "MappedFile.h"
 #include "Material.h"
 #include "Mesh.h"
-#include "RenderSystem.h"
-#include "Scene.h"
 #include "Shader.h"
+#include "Skeleton.h"
+#include "Texture.h"
+#include "Threads.h"
 #include "ToolKit.h"
+#include "Util.h"
 
 #include <mz.h>
 #include <unzip.h>
@@ -25,24 +29,17 @@
 
 namespace ToolKit
 {
+  /** Returns the absolute and normalized path, so that a file referenced through different paths is packed once. */
+  static String GetPackPath(const String& path) { return std::filesystem::absolute(path).lexically_normal().string(); }
+
   FileManager::FileManager() {}
 
-  FileManager::~FileManager()
-  {
-    if (m_zfile)
-    {
-      unzClose(m_zfile);
-      m_zfile = nullptr;
-    }
-  }
+  FileManager::~FileManager() { CloseZipFile(); }
 
   void FileManager::CloseZipFile()
   {
-    if (m_zfile)
-    {
-      unzClose(m_zfile);
-      m_zfile = nullptr;
-    }
+    LockGuard lock(m_pakMutex);
+    m_pak.Close();
   }
 
   XmlFilePtr FileManager::GetXmlFile(const String& filePath)
@@ -71,47 +68,38 @@ namespace ToolKit
 
   FileManager::FileDataType FileManager::GetFile(FileType fileType, ImageFileInfo& fileInfo)
   {
-    String pakPath      = ConcatPaths({ResourcePath(), "..", "MinResources.pak"});
-
-    // Get relative path from Resources directory
-    String relativePath = fileInfo.filePath;
-    GetRelativeResourcesPath(relativePath);
-
-    if (!m_zfile)
+    if (MappedFilePtr content = ReadFileFromPak(fileInfo.filePath))
     {
-      m_zfile = unzOpen(pakPath.c_str());
-    }
-
-    if (m_zfile && !m_ignorePakFile)
-    {
-      GenerateOffsetTableForPakFiles();
+      const ubyte* buffer = content->Data();
+      int bufferSize      = (int) content->Size();
 
       if (fileType == FileType::Xml)
       {
-        return ReadXmlFileFromZip(m_zfile, relativePath, fileInfo.filePath.c_str());
+        // Mapped entries end at the next entry or the page end, xml file copies exactly the content and terminates it.
+        return MakeNewPtr<XmlFile>((const char*) buffer, (uint) bufferSize);
       }
       else if (fileType == FileType::ImageUint8)
       {
-        return ReadImageFileFromZip(m_zfile, relativePath, fileInfo);
+        return ImageLoadFromMemory(buffer, bufferSize, fileInfo.x, fileInfo.y, fileInfo.comp, fileInfo.reqComp);
       }
       else if (fileType == FileType::ImageFloat)
       {
         ImageSetVerticalOnLoad(true);
-        float* img = ReadHdriFileFromZip(m_zfile, relativePath, fileInfo);
+        float* img = ImageLoadFromMemoryF(buffer, bufferSize, fileInfo.x, fileInfo.y, fileInfo.comp, fileInfo.reqComp);
         ImageSetVerticalOnLoad(false);
         return img;
       }
       else if (fileType == FileType::Audio)
       {
-        uint bufferSize   = 0;
-        ubyte* fileBuffer = (ubyte*) ReadFileBufferFromZip(m_zfile, relativePath, bufferSize);
-        if (bufferSize > 0)
+        if (AudioManager* audioMan = GetAudioManager())
         {
-          if (AudioManager* audioMan = GetAudioManager())
-          {
-            return audioMan->DecodeFromMemory(fileBuffer, bufferSize);
-          }
+          // Audio manager keeps referencing the encoded data.
+          ubyte* fileBuffer = new ubyte[bufferSize];
+          memcpy(fileBuffer, buffer, bufferSize);
+          return audioMan->DecodeFromMemory(fileBuffer, (uint) bufferSize);
         }
+
+        return SoundBuffer();
       }
       else
       {
@@ -120,7 +108,7 @@ namespace ToolKit
     }
     else
     {
-      // Zip pak not found, read from file at default path
+      // File is not in the pak, read from file at default path
       if (fileType == FileType::Xml)
       {
         return MakeNewPtr<XmlFile>(fileInfo.filePath.c_str());
@@ -142,6 +130,8 @@ namespace ToolKit
         {
           return audioMan->DecodeFromFile(fileInfo.filePath);
         }
+
+        return SoundBuffer();
       }
       else
       {
@@ -162,48 +152,85 @@ namespace ToolKit
     return std::get<SoundBuffer>(data);
   }
 
-  int FileManager::PackResources()
+  MappedFilePtr FileManager::GetMappedFile(const String& filePath)
+  {
+    if (MappedFilePtr pakFile = ReadFileFromPak(filePath))
+    {
+      return pakFile;
+    }
+
+    // Not in the pak, read from file at default path
+    MappedFilePtr file = MakeNewPtr<MappedFile>();
+    if (file->Open(filePath))
+    {
+      return file;
+    }
+
+    return nullptr;
+  }
+
+  int FileManager::PackResources(TextureCompression compression, bool incremental, bool dropSourceImages)
   {
-    String zipFile = ConcatPaths({ResourcePath(), "..", "MinResources.pak"});
+    String zipFile         = ConcatPaths({ResourcePath(), "..", "MinResources.pak"});
+    String previousZipFile = zipFile + ".previous";
+    m_textureCompression   = compression;
+    m_dropSourceImages     = dropSourceImages;
+    m_allPaths.clear();
+    m_texturePaths.clear();
 
     if (CheckSystemFile(zipFile.c_str()))
     {
-      if (m_zfile)
+      CloseZipFile();
+
+      // Previous pak is kept until the new one is written, its unchanged entries are copied to the new one.
+      std::error_code err;
+      if (incremental)
       {
-        unzClose(m_zfile);
-        m_zfile = nullptr;
+        std::filesystem::rename(zipFile, previousZipFile, err);
+      }
+      else
+      {
+        std::filesystem::remove(zipFile, err);
       }
 
-      std::error_code err;
-      if (!std::filesystem::remove(zipFile, err))
+      if (err)
       {
         TK_LOG("cannot remove MinResources.pak! message: %s\n", err.message().c_str());
         return -1;
       }
     }
 
-    // Load all scenes once in order to fill resource managers
+    // Scan all scenes for the resources that they reference
     TK_LOG("Packing Scenes\n");
-    LoadAllScenes(ScenePath(""));
+    ScanAllScenes(ScenePath(""));
 
     TK_LOG("Packing Layers\n");
-    LoadAllScenes(LayerPath(""));
+    ScanAllScenes(LayerPath(""));
 
     // Get all paths of resources
     TK_LOG("Getting all used paths\n");
     GetAllUsedResourcePaths();
 
     // Zip used resources
-    if (!ZipPack(zipFile))
+    bool packed = ZipPack(zipFile, incremental ? previousZipFile : "");
+
+    std::error_code err;
+    if (!packed)
     {
+      // Last good pak is restored in place of the failed one.
+      if (CheckSystemFile(previousZipFile))
+      {
+        std::filesystem::remove(zipFile, err);
+        std::filesystem::rename(previousZipFile, zipFile, err);
+      }
+
       // Error
       TK_ERR("Error zipping.");
       return -1;
     }
-    else
-    {
-      TK_LOG("Resources packed.\n");
-    }
+
+    std::filesystem::remove(previousZipFile, err);
+    TK_LOG("Resources packed.\n");
 
     // Copy assets under android assets if exists
     String androidAssetFolder = ConcatPaths({ResourcePath(), "..", "Android", "app", "src", "main", "assets"});
@@ -222,30 +249,24 @@ namespace ToolKit
 
   bool FileManager::CheckFileFromResources(const String& path)
   {
-    if (!Main::GetInstance()->m_resourceRoot.empty())
-    {
-      GenerateOffsetTableForPakFiles();
-    }
-
-    String relativePath = path;
-    UnixifyPath(relativePath);
-    GetRelativeResourcesPath(relativePath);
-
     if (CheckSystemFile(path))
     {
       return true;
     }
 
-    bool inPak = false;
-    if (!m_ignorePakFile)
+    if (m_ignorePakFile || !OpenPakFile())
     {
-      inPak = IsFileInPak(relativePath);
+      return false;
     }
 
-    return inPak;
+    String relativePath = path;
+    UnixifyPath(relativePath);
+    GetRelativeResourcesPath(relativePath);
+
+    return m_pak.Contains(relativePath);
   }
 
-  void FileManager::LoadAllScenes(const String& path)
+  void FileManager::ScanAllScenes(const String& path)
   {
     // Resources in the scene files
     for (const auto& entry : std::filesystem::directory_iterator(path))
@@ -253,11 +274,11 @@ namespace ToolKit
       if (entry.is_directory())
       {
         // Go scenes in directories
-        LoadAllScenes(entry.path().string());
+        ScanAllScenes(entry.path().string());
         continue;
       }
 
-      // Load all scenes
+      // Scan all scenes
       String pt = entry.path().string();
       String name, ext;
       DecomposePath(pt, nullptr, &name, &ext);
@@ -265,145 +286,151 @@ namespace ToolKit
       if (ext == SCENE || ext == LAYER)
       {
         TK_LOG("Packing Scene: %s\n", name.c_str());
-
-        ScenePtr scene = GetSceneManager()->Create<Scene>(pt);
-        scene->Load();
-        scene->Init();
-
-        GetRenderSystem()->FlushRenderTasks(); // Finalize loading baked files.
+        ScanDependencies(pt);
       }
     }
   }
 
-  void FileManager::GetAllUsedResourcePaths()
+  void FileManager::ScanDependencies(const String& file)
   {
-    std::unordered_map<String, ResourcePtr> mp;
+    // Each file is scanned once. Missing files are reported while zipping.
+    String path = GetPackPath(file);
+    if (!m_allPaths.insert(path).second || !CheckSystemFile(path))
+    {
+      return;
+    }
 
-    // Get all engine resources
-    GetAllPaths(DefaultPath());
+    String ext;
+    DecomposePath(path, nullptr, nullptr, &ext);
 
-    // Material
-    mp = GetMaterialManager()->m_storage;
-    for (auto it = mp.begin(); it != mp.end(); it++)
+    if (ext == MESH || ext == SKINMESH)
     {
-      String absolutePath = it->first;
-
-      // Skip default.material
-      if (!it->second->m_loaded)
+      // Meshes are either binary or xml.
+      MappedFile mappedFile;
+      StringArray references;
+      if (mappedFile.Open(path) && Mesh::ReadBinaryReferences(mappedFile, references))
       {
-        continue;
-      }
+        for (const String& reference : references)
+        {
+          ScanDependencies(reference);
+        }
 
-      // If the path is relative, make it absolute
-      if (absolutePath[0] == '.')
-      {
-        size_t index = absolutePath.find("Materials");
-        absolutePath = absolutePath.substr(index);
-        absolutePath = ConcatPaths({DefaultAbsolutePath(), absolutePath});
+        return;
       }
-
-      m_allPaths.insert(absolutePath);
     }
-
-    // Meshes
-    mp = GetMeshManager()->m_storage;
-    for (auto it = mp.begin(); it != mp.end(); it++)
+    else if (ext == SCENE || ext == LAYER)
     {
-      String absolutePath = it->first;
-      // If the path is relative, make it absolute
-      if (absolutePath[0] == '.')
+      // Binary form of the scene is loaded instead of the xml, if it is produced.
+      String binaryPath = path + SCENE_BINARY;
+      if (CheckSystemFile(binaryPath))
       {
-        size_t index = absolutePath.find("Meshes");
-        absolutePath = absolutePath.substr(index);
-        absolutePath = ConcatPaths({DefaultAbsolutePath(), absolutePath});
+        m_allPaths.insert(binaryPath);
       }
-
-      m_allPaths.insert(absolutePath);
     }
-
-    // Animations
-    mp = GetAnimationManager()->m_storage;
-    for (auto it = mp.begin(); it != mp.end(); it++)
+    else if (ext != MATERIAL && ext != SHADER)
     {
-      String absolutePath = it->first;
-      // If the path is relative, make it absolute
-      if (absolutePath[0] == '.')
-      {
-        size_t index = absolutePath.find("Meshes");
-        absolutePath = absolutePath.substr(index);
-        absolutePath = ConcatPaths({DefaultAbsolutePath(), absolutePath});
-      }
-
-      m_allPaths.insert(absolutePath);
+      return;
     }
 
-    // Skeletons
-    mp = GetSkeletonManager()->m_storage;
-    for (auto it = mp.begin(); it != mp.end(); it++)
-    {
-      String absolutePath = it->first;
-      // If the path is relative, make it absolute
-      if (absolutePath[0] == '.')
-      {
-        size_t index = absolutePath.find("Meshes");
-        absolutePath = absolutePath.substr(index);
-        absolutePath = ConcatPaths({DefaultAbsolutePath(), absolutePath});
-      }
+    XmlFile xmlFile(path.c_str());
+    XmlDocument doc;
+    doc.parse<rapidxml::parse_default>(xmlFile.data());
 
-      m_allPaths.insert(absolutePath);
-    }
+    ScanXmlNode(&doc);
+  }
 
-    // Prefabs
-    mp = GetSceneManager()->m_storage;
-    for (auto it = mp.begin(); it != mp.end(); it++)
+  void FileManager::ScanXmlNode(XmlNode* node)
+  {
+    for (XmlNode* child = node->first_node(); child != nullptr; child = child->next_sibling())
     {
-      String absolutePath = it->first;
-      // If the path is relative, make it absolute
-      if (absolutePath[0] == '.')
+      String reference;
+      if (XmlResRefElement == child->name())
       {
-        size_t index = absolutePath.find("Prefabs");
-        if (index == String::npos)
+        String resourceClass, file;
+        ReadAttr(child, "Class", resourceClass);
+        ReadAttr(child, "File", file);
+        NormalizePathInplace(file);
+
+        if (file.empty())
         {
           continue;
         }
-        absolutePath = absolutePath.substr(index);
-        absolutePath = ConcatPaths({DefaultAbsolutePath(), absolutePath});
-      }
 
-      m_allPaths.insert(absolutePath);
-    }
+        if (resourceClass == Texture::StaticClass()->Name)
+        {
+          // Normal and metallic roughness textures are linear, see Material::Init.
+          String slot;
+          ReadAttr(node, "name", slot);
 
-    // Shaders
-    mp = GetShaderManager()->m_storage;
-    for (auto it = mp.begin(); it != mp.end(); it++)
-    {
-      String absolutePath = it->first;
-      // If the path is relative, make it absolute
-      if (absolutePath[0] == '.')
+          reference = TexturePath(file);
+          bool srgb = slot != "NormalTexture" && slot != "MetallicRoughnessTexture";
+          m_texturePaths.emplace(GetPackPath(reference), srgb);
+        }
+        else if (resourceClass == Hdri::StaticClass()->Name)
+        {
+          reference = TexturePath(file);
+        }
+        else if (resourceClass == Mesh::StaticClass()->Name || resourceClass == SkinMesh::StaticClass()->Name)
+        {
+          reference = MeshPath(file);
+        }
+        else if (resourceClass == Material::StaticClass()->Name)
+        {
+          reference = MaterialPath(file);
+        }
+        else if (resourceClass == Shader::StaticClass()->Name)
+        {
+          reference = ShaderPath(file);
+        }
+        else if (resourceClass == Animation::StaticClass()->Name)
+        {
+          reference = AnimationPath(file);
+        }
+        else if (resourceClass == Skeleton::StaticClass()->Name)
+        {
+          reference = SkeletonPath(file);
+        }
+      }
+      else if (strcmp(child->name(), "material") == 0)
       {
-        size_t index = absolutePath.find("Shaders");
-        absolutePath = absolutePath.substr(index);
-        absolutePath = ConcatPaths({DefaultAbsolutePath(), absolutePath});
+        // Material of the xml meshes.
+        String file;
+        ReadAttr(child, "name", file);
+        NormalizePathInplace(file);
+        reference = file.empty() ? file : MaterialPath(file);
+      }
+      else if (strcmp(child->name(), "include") == 0)
+      {
+        // Shader includes are always in the engine's shaders.
+        String file;
+        ReadAttr(child, "name", file);
+        reference = file.empty() ? file : ShaderPath(file, true);
+      }
+      else if (XmlParamterElement == child->name())
+      {
+        String name, file;
+        ReadAttr(child, "name", name);
+        if (name == "PrefabPath")
+        {
+          ReadAttr(child, XmlParamterValAttr, file);
+          NormalizePathInplace(file);
+          reference = file.empty() ? file : PrefabPath(file);
+        }
       }
 
-      m_allPaths.insert(absolutePath);
-    }
-
-    // Textures
-    mp = GetTextureManager()->m_storage;
-    for (auto it = mp.begin(); it != mp.end(); it++)
-    {
-      String absolutePath = it->first;
-      // If the path is relative, make it absolute
-      if (absolutePath[0] == '.')
+      if (!reference.empty())
       {
-        size_t index = absolutePath.find("Textures");
-        absolutePath = absolutePath.substr(index);
-        absolutePath = ConcatPaths({DefaultAbsolutePath(), absolutePath});
+        ScanDependencies(reference);
       }
 
-      m_allPaths.insert(absolutePath);
+      ScanXmlNode(child);
     }
+  }
+
+  void FileManager::GetAllUsedResourcePaths()
+  {
+    // Get all engine resources
+    GetAllPaths(DefaultPath());
 
     // Scenes
     GetAllPaths(ScenePath(""));
@@ -415,101 +442,335 @@ namespace ToolKit
     GetExtraFilePaths();
   }
 
-  bool FileManager::CheckPakFile() { return m_zfile != nullptr; }
+  bool FileManager::CheckPakFile() { return OpenPakFile(); }
 
-  bool FileManager::ZipPack(const String& zipName)
+  bool FileManager::ZipPack(const String& zipName, const String& previousZipName)
   {
-    zipFile zFile = zipOpen64(zipName.c_str(), 0);
+    // Entries of the previous pak and their hashes.
+    std::unordered_map<String, PakEntry> previousEntries;
+    ZipFile previousZip = nullptr;
+    if (!previousZipName.empty() && CheckSystemFile(previousZipName))
+    {
+      previousZip = unzOpen64(previousZipName.c_str());
+    }
 
-    if (zFile == NULL)
+    if (previousZip != nullptr)
     {
-      printf("Error opening zip.\n");
-      zipClose(zFile, NULL);
-      return false;
+      for (int status = unzGoToFirstFile(previousZip); status == UNZ_OK; status = unzGoToNextFile(previousZip))
+      {
+        unz_file_info64 info;
+        char name[1024]  = {};
+        char comment[32] = {};
+        int ret          = unzGetCurrentFileInfo64(previousZip, &info, name, 1024, NULL, 0, comment, 32);
+        if (ret == UNZ_OK)
+        {
+          PakEntry entry;
+          entry.name   = name;
+          entry.hash   = std::strtoull(comment, nullptr, 16);
+          entry.part   = -1;
+          entry.offset = unzGetOffset64(previousZip);
+
+          // Entries without a hash are packed by older versions, they are always compressed again.
+          if (entry.hash != 0)
+          {
+            previousEntries[entry.name] = entry;
+          }
+        }
+      }
     }
 
-    // Add files to zip
-    for (const String& path : m_allPaths)
+    // Files are compressed in parallel, each chunk of files is written to its own part zip.
+    const size_t grainSize = 8;
+    StringArray paths(m_allPaths.begin(), m_allPaths.end());
+    std::vector<PakEntryArray> fileEntries(paths.size());
+    std::atomic_bool partFailed(false);
+
+    auto partNameFn = [&zipName](size_t part) -> String { return zipName + ".part" + std::to_string(part); };
+
+    GetWorkerManager()->ParallelFor(paths.size(),
+                                    grainSize,
+                                    [&](size_t beginIndex, size_t endIndex) -> void
+                                    {
+                                      int part        = (int) (beginIndex / grainSize);
+                                      ZipFile partZip = zipOpen64(partNameFn(part).c_str(), 0);
+                                      if (partZip == NULL)
+                                      {
+                                        partFailed = true;
+                                        return;
+                                      }
+
+                                      for (size_t i = beginIndex; i < endIndex; i++)
+                                      {
+                                        PackFile(paths[i], previousEntries, partZip, part, fileEntries[i]);
+                                      }
+
+                                      zipClose(partZip, NULL);
+                                    });
+
+    // Entries are copied to the pak in the order of the files. Entries of a part are in the order they are written.
+    PakEntryArray entries;
+    int reusedCount = 0;
+    for (const PakEntryArray& fileEntry : fileEntries)
+    {
+      for (const PakEntry& entry : fileEntry)
+      {
+        entries.push_back(entry);
+        reusedCount += entry.part == -1 ? 1 : 0;
+      }
+    }
+
+    // Entries of a part are read in the order they are written, entries that failed while writing are skipped.
+    auto locateFn = [](ZipFile unzipFile, const String& name, bool first) -> bool
     {
-      if (!AddFileToZip(zFile, path.c_str()))
+      char currentName[1024];
+      int ret = first ? unzGoToFirstFile(unzipFile) : unzGoToNextFile(unzipFile);
+      for (; ret == UNZ_OK; ret = unzGoToNextFile(unzipFile))
       {
-        TK_WRN("Failed to add this file to zip: %s\n", path.c_str());
+        ret = unzGetCurrentFileInfo64(unzipFile, NULL, currentName, sizeof(currentName), NULL, 0, NULL, 0);
+        if (ret == UNZ_OK && name == currentName)
+        {
+          return true;
+        }
       }
+
+      return false;
+    };
+
+    zipFile zFile     = zipOpen64(zipName.c_str(), 0);
+    bool copied       = zFile != NULL && !partFailed;
+    ZipFile partUnzip = nullptr;
+    int currentPart   = -1;
+
+    for (size_t i = 0; i < entries.size() && copied; i++)
+    {
+      const PakEntry& entry = entries[i];
+      if (entry.part == -1)
+      {
+        copied = unzSetOffset64(previousZip, entry.offset) == UNZ_OK && CopyZipEntry(previousZip, zFile);
+        continue;
+      }
+
+      bool first = entry.part != currentPart;
+      if (first)
+      {
+        if (partUnzip != nullptr)
+        {
+          unzClose(partUnzip);
+        }
+
+        currentPart = entry.part;
+        partUnzip   = unzOpen64(partNameFn(currentPart).c_str());
+      }
+
+      copied = partUnzip != nullptr && locateFn(partUnzip, entry.name, first) && CopyZipEntry(partUnzip, zFile);
+    }
+
+    if (partUnzip != nullptr)
+    {
+      unzClose(partUnzip);
+    }
+
+    if (previousZip != nullptr)
+    {
+      unzClose(previousZip);
     }
 
-    zipClose(zFile, NULL);
+    if (zFile != NULL)
+    {
+      zipClose(zFile, NULL);
+    }
+
+    std::error_code err;
+    for (size_t part = 0; part * grainSize < paths.size(); part++)
+    {
+      std::filesystem::remove(partNameFn(part), err);
+    }
 
+    if (!copied)
+    {
+      TK_ERR("Error writing zip: %s", zipName.c_str());
+      return false;
+    }
+
+    TK_LOG("%d entries are packed, %d of them are reused from the previous pak.\n", (int) entries.size(), reusedCount);
     return true;
   }
 
-  bool FileManager::AddFileToZip(ZipFile zfile, const char* filename)
+  void FileManager::PackFile(const String& path,
+                             const std::unordered_map<String, PakEntry>& previousEntries,
+                             ZipFile partZip,
+                             int part,
+                             PakEntryArray& entries)
   {
-    FILE* f;
-    int ret;
-    size_t red;
-    size_t flen;
+    size_t index = path.find("Resources");
+    if (index == String::npos)
+    {
+      TK_ERR("Resource is not under resources path: %s", path.c_str());
+      return;
+    }
+
+    constexpr int length = sizeof("Resources");
+    String name          = path.substr(index + length);
 
-    if (zfile == NULL || filename == NULL)
+    // File is read once for hashing, compressing and zipping. Empty files can't be mapped.
+    MappedFile file;
+    std::error_code err;
+    if (!file.Open(path) && (std::filesystem::file_size(path, err) != 0 || err))
     {
-      return false;
+      TK_WRN("Failed to add this file to zip: %s\n", path.c_str());
+      return;
     }
 
-    f = fopen(filename, "rb");
-    if (f == NULL)
+    const uint8* data = file.Data();
+    uint64 size       = file.Size();
+    uint64 hash       = StringHash(StringView((const char*) data, size));
+
+    // Entries whose hashes are the same in the previous pak are copied from it.
+    auto reuseFn      = [&](const String& entryName, uint64 entryHash) -> bool
     {
+      auto entryItr = previousEntries.find(entryName);
+      if (entryItr != previousEntries.end() && entryItr->second.hash == entryHash)
+      {
+        entries.push_back(entryItr->second);
+        return true;
+      }
+
       return false;
+    };
+
+    auto textureItr = m_texturePaths.find(path);
+    if (m_textureCompression != TextureCompression::None && textureItr != m_texturePaths.end())
+    {
+      bool srgb       = textureItr->second;
+      String ktx2Name = name + KTX2;
+      uint64 ktx2Hash = MurmurHash(hash ^ (((uint64) m_textureCompression << 1) | (uint64) srgb));
+
+      bool compressed = reuseFn(ktx2Name, ktx2Hash);
+      if (!compressed)
+      {
+        int width    = 0;
+        int height   = 0;
+        int comp     = 0;
+        uint8* image = ImageLoadFromMemory(data, (int) size, &width, &height, &comp, 4);
+        if (image != nullptr)
+        {
+          TK_LOG("Compressing texture: %s\n", path.c_str());
+          std::vector<uint8> ktx2 = CompressToKtx2(image, width, height, m_textureCompression, srgb);
+          ImageFree(image);
+
+          if (!ktx2.empty() && AddBufferToZip(partZip, ktx2Name, ktx2.data(), ktx2.size(), ktx2Hash))
+          {
+            entries.push_back({ktx2Name, ktx2Hash, part, 0});
+            compressed = true;
+          }
+        }
+      }
+
+      // Source image is the fallback for the gpus without support, it is only dropped when the target guarantees etc2.
+      if (compressed && m_dropSourceImages && m_textureCompression == TextureCompression::ETC2)
+      {
+        return;
+      }
     }
 
-    // Get length of the file
-    std::basic_ifstream<char> stream(filename, std::ios::binary);
-    if (!stream)
+    if (reuseFn(name, hash))
     {
-      return false;
+      return;
     }
-    stream.unsetf(std::ios::skipws);
-    stream.seekg(0, std::ios::end); // Determine stream size
-    flen               = stream.tellg();
 
-    String filenameStr = String(filename);
-    size_t index       = filenameStr.find("Resources");
-    if (index != String::npos)
+    if (AddBufferToZip(partZip, name, data, size, hash))
     {
-      constexpr int length = sizeof("Resources");
-      filenameStr          = filenameStr.substr(index + length);
+      entries.push_back({name, hash, part, 0});
     }
     else
     {
-      TK_ERR("Resource is not under resources path: %s", filename);
+      TK_WRN("Failed to add this file to zip: %s\n", path.c_str());
+    }
+  }
+
+  bool FileManager::AddBufferToZip(ZipFile zfile, const String& name, const void* data, uint64 size, uint64 hash)
+  {
+    if (zfile == NULL)
+    {
       return false;
     }
 
-    // Compression level is -1 which is default, use 0 for no compression, 1 for best speed.
-    ret =
-        zipOpenNewFileInZip64(zfile, filenameStr.c_str(), NULL, NULL, 0, NULL, 0, NULL, MZ_COMPRESS_METHOD_ZSTD, -1, 0);
+    // Hash is compared with the source by the next incremental pack.
+    char comment[17];
+    snprintf(comment, sizeof(comment), "%016llx", (unsigned long long) hash);
 
+    // Compression level is -1 which is default, use 0 for no compression, 1 for best speed.
+    int ret = zipOpenNewFileInZip64(zfile,
+                                    name.c_str(),
+                                    NULL,
+                                    NULL,
+                                    0,
+                                    NULL,
+                                    0,
+                                    comment,
+                                    MZ_COMPRESS_METHOD_ZSTD,
+                                    -1,
+                                    0);
     if (ret != ZIP_OK)
     {
-      fclose(f);
       zipCloseFileInZip(zfile);
       return false;
     }
 
-    char* fileData = reinterpret_cast<char*>(malloc((flen + 1) * static_cast<uint>(sizeof(char))));
-    red            = fread(fileData, 1, flen, f);
-    ret            = zipWriteInFileInZip(zfile, fileData, static_cast<uint>(flen));
+    if (size > 0)
+    {
+      ret = zipWriteInFileInZip(zfile, data, static_cast<uint>(size));
+    }
+    zipCloseFileInZip(zfile);
 
-    if (ret != ZIP_OK)
+    return ret == ZIP_OK;
+  }
+
+  bool FileManager::CopyZipEntry(ZipFile unzipFile, ZipFile zfile)
+  {
+    unz_file_info64 info;
+    char name[1024]  = {};
+    char comment[32] = {};
+    if (unzGetCurrentFileInfo64(unzipFile, &info, name, sizeof(name), NULL, 0, comment, sizeof(comment)) != UNZ_OK)
     {
-      fclose(f);
-      zipCloseFileInZip(zfile);
       return false;
     }
 
-    free(fileData);
-    fclose(f);
-    zipCloseFileInZip(zfile);
+    // Entry is opened raw, compressed data is copied as it is.
+    int method = 0;
+    int level  = 0;
+    if (unzOpenCurrentFile2(unzipFile, &method, &level, 1) != UNZ_OK)
+    {
+      return false;
+    }
 
-    return true;
+    int zip64 = info.uncompressed_size >= 0xFFFFFFFF ? 1 : 0;
+    int ret   = zipOpenNewFileInZip2_64(zfile, name, NULL, NULL, 0, NULL, 0, comment, method, level, 1, zip64);
+
+    std::vector<uint8> buffer(64 * 1024);
+    while (ret == ZIP_OK)
+    {
+      int readBytes = unzReadCurrentFile(unzipFile, buffer.data(), (uint) buffer.size());
+      if (readBytes <= 0)
+      {
+        ret = readBytes;
+        break;
+      }
+
+      ret = zipWriteInFileInZip(zfile, buffer.data(), (uint) readBytes);
+    }
+
+    if (ret == ZIP_OK)
+    {
+      ret = zipCloseFileInZipRaw64(zfile, info.uncompressed_size, info.crc);
+    }
+    else
+    {
+      zipCloseFileInZip(zfile);
+    }
+
+    unzCloseCurrentFile(unzipFile);
+    return ret == ZIP_OK;
   }
 
   void FileManager::GetAllPaths(const String& path)
@@ -523,7 +784,7 @@ namespace ToolKit
         continue;
       }
 
-      m_allPaths.insert(std::filesystem::absolute(entry.path()).string());
+      m_allPaths.insert(GetPackPath(entry.path().string()));
     }
   }
 
@@ -549,7 +810,7 @@ namespace ToolKit
         continue;
       }
 
-      m_allPaths.insert(ConcatPaths({ResourcePath(), line}));
+      ScanDependencies(ConcatPaths({ResourcePath(), line}));
     }
     file.close();
   }
@@ -617,245 +878,30 @@ namespace ToolKit
     }
   }
 
-  XmlFilePtr FileManager::ReadXmlFileFromZip(ZipFile zfile, const String& relativePath, const char* path)
-  {
-    // Check offset map of file
-    String unixifiedPath = relativePath;
-    UnixifyPath(unixifiedPath);
-    ZPOS64_T offset = m_zipFilesOffsetTable[unixifiedPath].first;
-    if (offset != 0)
-    {
-      if (unzSetOffset64(zfile, offset) == UNZ_OK)
-      {
-        if (unzOpenCurrentFile(zfile) == UNZ_OK)
-        {
-          unz_file_info fileInfo;
-          memset(&fileInfo, 0, sizeof(unz_file_info));
-
-          if (unzGetCurrentFileInfo(zfile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) == UNZ_OK)
-          {
-            XmlFilePtr file = CreateXmlFileFromZip(zfile, relativePath, static_cast<uint>(fileInfo.uncompressed_size));
-            return file;
-          }
-        }
-      }
-    }
-
-    // If the file is not found return the file from path
-    return MakeNewPtr<XmlFile>(path);
-  }
-
-  uint8* FileManager::ReadImageFileFromZip(ZipFile zfile, const String& relativePath, ImageFileInfo& fileInfo)
-  {
-    // Check offset map of file
-    String unixifiedPath = relativePath;
-    UnixifyPath(unixifiedPath);
-    ZPOS64_T offset = m_zipFilesOffsetTable[unixifiedPath].first;
-    if (offset != 0)
-    {
-      if (unzSetOffset64(zfile, offset) == UNZ_OK)
-      {
-        if (unzOpenCurrentFile(zfile) == UNZ_OK)
-        {
-          unz_file_info unzFileInfo;
-          memset(&unzFileInfo, 0, sizeof(unz_file_info));
-
-          if (unzGetCurrentFileInfo(zfile, &unzFileInfo, NULL, 0, NULL, 0, NULL, 0) == UNZ_OK)
-          {
-            fileInfo.filePath = relativePath;
-            uint8* img = CreateImageFileFromZip(zfile, static_cast<uint>(unzFileInfo.uncompressed_size), fileInfo);
-            return img;
-          }
-        }
-      }
-    }
-
-    // If the file is not found return the file from path
-    return ImageLoad(fileInfo.filePath.c_str(), fileInfo.x, fileInfo.y, fileInfo.comp, fileInfo.reqComp);
-  }
-
-  float* FileManager::ReadHdriFileFromZip(ZipFile zfile, const String& relativePath, ImageFileInfo& fileInfo)
-  {
-    // Check offset map of file
-    String unixifiedPath = relativePath;
-    UnixifyPath(unixifiedPath);
-    ZPOS64_T offset = m_zipFilesOffsetTable[unixifiedPath].first;
-    if (offset != 0)
-    {
-      if (unzSetOffset64(zfile, offset) == UNZ_OK)
-      {
-        if (unzOpenCurrentFile(zfile) == UNZ_OK)
-        {
-          unz_file_info unzFileInfo;
-          memset(&unzFileInfo, 0, sizeof(unz_file_info));
-
-          if (unzGetCurrentFileInfo(zfile, &unzFileInfo, NULL, 0, NULL, 0, NULL, 0) == UNZ_OK)
-          {
-            fileInfo.filePath = relativePath;
-            float* img = CreateHdriFileFromZip(zfile, static_cast<uint>(unzFileInfo.uncompressed_size), fileInfo);
-            return img;
-          }
-        }
-      }
-    }
-
-    // If the file is not found return the file from path
-    return ImageLoadF(fileInfo.filePath.c_str(), fileInfo.x, fileInfo.y, fileInfo.comp, fileInfo.reqComp);
-  }
-
-  ubyte* FileManager::ReadFileBufferFromZip(ZipFile zfile, const String& relativePath, uint& bufferSize)
-  {
-    // Check offset map of file
-    String unixifiedPath = relativePath;
-    UnixifyPath(unixifiedPath);
-    ZPOS64_T offset = m_zipFilesOffsetTable[unixifiedPath].first;
-
-    if (offset != 0)
-    {
-      if (unzSetOffset64(zfile, offset) == UNZ_OK)
-      {
-        if (unzOpenCurrentFile(zfile) == UNZ_OK)
-        {
-          unz_file_info unzFileInfo;
-          memset(&unzFileInfo, 0, sizeof(unz_file_info));
-
-          if (unzGetCurrentFileInfo(zfile, &unzFileInfo, NULL, 0, NULL, 0, NULL, 0) == UNZ_OK)
-          {
-            // Read file
-            bufferSize        = (uint) unzFileInfo.uncompressed_size;
-            ubyte* fileBuffer = new ubyte[bufferSize]();
-            uint readBytes    = unzReadCurrentFile(zfile, fileBuffer, bufferSize);
-
-            if (readBytes < 0)
-            {
-              GetLogger()->Log("Error reading compressed file: " + relativePath);
-              SafeDelArray(fileBuffer);
-
-              return nullptr;
-            }
-            else
-            {
-              return fileBuffer;
-            }
-          }
-        }
-      }
-    }
-
-    return nullptr;
-  }
-
-  XmlFilePtr FileManager::CreateXmlFileFromZip(ZipFile zfile, const String& filename, uint filesize)
-  {
-    // Read file
-    char* fileBuffer = new char[filesize]();
-    uint readBytes   = unzReadCurrentFile(zfile, fileBuffer, filesize);
-    if (readBytes < 0)
-    {
-      GetLogger()->Log("Error reading compressed file: " + filename);
-      TK_ERR("Error reading compressed file: %s", filename.c_str());
-    }
-
-    // Create XmlFile object
-    XmlFilePtr file = MakeNewPtr<XmlFile>(fileBuffer, readBytes);
-
-    SafeDelArray(fileBuffer);
-
-    return file;
-  }
-
-  uint8* FileManager::CreateImageFileFromZip(ZipFile zfile, uint filesize, ImageFileInfo& fileInfo)
+  bool FileManager::OpenPakFile()
   {
-    ubyte* fileBuffer = new ubyte[filesize]();
-    uint readBytes    = unzReadCurrentFile(zfile, fileBuffer, filesize);
-    if (readBytes < 0)
+    LockGuard lock(m_pakMutex);
+    if (!m_pak.IsOpen())
     {
-      GetLogger()->Log("Error reading compressed file: " + fileInfo.filePath);
-      TK_ERR("Error reading compressed file: %s", fileInfo.filePath.c_str());
+      String pakPath = ConcatPaths({ResourcePath(), "..", "MinResources.pak"});
+      m_pak.Open(pakPath);
     }
 
-    // Load image
-    uint8* img = ImageLoadFromMemory(fileBuffer, filesize, fileInfo.x, fileInfo.y, fileInfo.comp, fileInfo.reqComp);
-
-    SafeDelArray(fileBuffer);
-
-    return img;
+    return m_pak.IsOpen();
   }
 
-  float* FileManager::CreateHdriFileFromZip(ZipFile zfile, uint filesize, ImageFileInfo& fileInfo)
+  MappedFilePtr FileManager::ReadFileFromPak(const String& filePath)
   {
-    ubyte* fileBuffer = new ubyte[filesize]();
-    uint readBytes    = unzReadCurrentFile(zfile, fileBuffer, filesize);
-    if (readBytes < 0)
+    if (m_ignorePakFile || !OpenPakFile())
     {
-      GetLogger()->Log("Error reading compressed file: " + fileInfo.filePath);
-      TK_ERR("Error reading compressed file: %s", fileInfo.filePath.c_str());
+      return nullptr;
     }
 
-    // Load image
-    float* img = ImageLoadFromMemoryF(fileBuffer, filesize, fileInfo.x, fileInfo.y, fileInfo.comp, fileInfo.reqComp);
-
-    SafeDelArray(fileBuffer);
-
-    return img;
-  }
-
-  void FileManager::GenerateOffsetTableForPakFiles()
-  {
-    if (m_offsetTableCreated)
-    {
-      return;
-    }
-
-    String pakPath = ConcatPaths({ResourcePath(), "..", "MinResources.pak"});
-
-    if (!m_zfile)
-    {
-      m_zfile = unzOpen(pakPath.c_str());
-    }
-
-    if (unzGoToFirstFile(m_zfile) == UNZ_OK)
-    {
-      do
-      {
-        if (unzOpenCurrentFile(m_zfile) == UNZ_OK)
-        {
-          unz_file_info fileInfo;
-          memset(&fileInfo, 0, sizeof(unz_file_info));
-
-          if (unzGetCurrentFileInfo(m_zfile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) == UNZ_OK)
-          {
-            // Get file name
-            char* filename = new char[fileInfo.size_filename + 1]();
-            unzGetCurrentFileInfo(m_zfile, &fileInfo, filename, fileInfo.size_filename + 1, NULL, 0, NULL, 0);
-            filename[fileInfo.size_filename] = '\0';
-
-            std::pair<ZPOS64_T, uint> element;
-            element.first  = unzGetOffset64(m_zfile);
-            element.second = (uint) fileInfo.uncompressed_size;
-
-            // Unixfy the path
-            String filenameStr(filename);
-            UnixifyPath(filenameStr);
-
-            m_zipFilesOffsetTable[filenameStr.c_str()] = element;
-
-            SafeDelArray(filename);
-          }
-        }
-      } while (unzGoToNextFile(m_zfile) == UNZ_OK);
-    }
-
-    m_offsetTableCreated = true;
-  }
-
-  bool FileManager::IsFileInPak(const String& filename)
-  {
-    if (m_zipFilesOffsetTable.find(filename.c_str()) == m_zipFilesOffsetTable.end())
-    {
-      return false;
-    }
+    // Get relative path from Resources directory
+    String relativePath = filePath;
+    GetRelativeResourcesPath(relativePath);
+    UnixifyPath(relativePath);
 
-    return true;
+    return m_pak.Read(relativePath);
   }
 } // namespace ToolKit
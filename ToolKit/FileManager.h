@@ -7,7 +7,8 @@
 
 #pragma once
 
-#include "Types.h"
+#include "PakFile.h"
+#include "TextureCompression.h"
 
 namespace ToolKit
 {
@@ -35,16 +36,29 @@ namespace ToolKit
     /** Returns a decoded audio file or null if no decoder found. Used in Audio::Load to create resource. */
     SoundBuffer GetAudioFile(const String& filePath);
 
+    /**
+     * Returns the raw content of a file or null if the file can't be read. Files on disk and stored files in the pak
+     * are memory mapped, compressed files in the pak are decompressed to a buffer. Used for loading binary resources
+     * without copying them.
+     */
+    MappedFilePtr GetMappedFile(const String& filePath);
+
     /**
      * Pack all the resources for the project.
-     * Does this by opening all scene and layer files in resource folder.
-     * Than accumulate all resources in all managers. Finally creates a zip file from the collected resources.
+     * Does this by scanning all scene and layer files in resource folder for the resources that they reference,
+     * without loading them. Referenced materials, meshes and prefabs are scanned recursively. Finally creates a zip
+     * file from the collected resources. Files are compressed in parallel.
      * Produced zip file is called "MinResources.pak"
      * If extra files other than automatically collected ones are needed, the function looks for a text file
      * "ExtraFiles.txt" each line in this file is added to the pack as well.
      * All files must be in the Resources folder of the project.
+     * @param compression is the block compression that the textures are packed with. Compressed textures are stored as
+     * "<texture file>.ktx2" with their mip levels. Source images are kept as a fallback for the gpus without support.
+     * @param incremental reuses the compressed entries of the previous pak whose source content is not changed.
+     * @param dropSourceImages leaves the source images of the etc2 compressed textures out of the pak. Only for the
+     * targets whose gpus all support etc2, such as Android.
      */
-    int PackResources();
+    int PackResources(TextureCompression compression, bool incremental = true, bool dropSourceImages = false);
 
     bool CheckFileFromResources(const String& path); //!< Checks the given file in first resource path than in pak file.
     void GetRelativeResourcesPath(String& path);     //!< Converts the path, relative to the Resources folder.
@@ -78,35 +92,72 @@ namespace ToolKit
       int reqComp;
     };
 
+    /** An entry of the pak that is being packed. */
+    struct PakEntry
+    {
+      String name;       //!< Name of the entry, relative to the Resources folder.
+      uint64 hash   = 0; //!< Hash of the source content and the options that the entry is created with.
+      int part      = 0; //!< Index of the part zip that has the entry, -1 for the previous pak.
+      uint64 offset = 0; //!< Position of the entry in the previous pak.
+    };
+
+    typedef std::vector<PakEntry> PakEntryArray;
+
     FileDataType GetFile(FileType fileType, ImageFileInfo& fileInfo);
-    void LoadAllScenes(const String& path);
+
+    /** Scans the scene and layer files in the folder and its sub folders for their dependencies. */
+    void ScanAllScenes(const String& path);
+
+    /**
+     * Adds the file and the files that it references to the paths to pack. Xml files are parsed for the resource
+     * references, binary meshes for their materials and skeletons. Other files have no dependencies.
+     */
+    void ScanDependencies(const String& file);
+
+    /** Scans the node and its children for the resource references. */
+    void ScanXmlNode(XmlNode* node);
+
     void GetAllUsedResourcePaths();
 
-    bool ZipPack(const String& zipName);
-    bool AddFileToZip(ZipFile zfile, const char* filename);
+    /** Creates the zip file from the collected paths. Unchanged entries of the previous pak are copied if it exists. */
+    bool ZipPack(const String& zipName, const String& previousZipName);
 
-    void GetAllPaths(const String& path);
-    void GetExtraFilePaths();
+    /**
+     * Creates the entries of a file and writes the ones that are not in the previous pak to the part zip.
+     * @param path is the file to pack.
+     * @param previousEntries are the entries of the previous pak by their names.
+     * @param partZip is the zip that the new entries are written to.
+     * @param part is the index of the part zip.
+     * @param entries are the created entries.
+     */
+    void PackFile(const String& path,
+                  const std::unordered_map<String, PakEntry>& previousEntries,
+                  ZipFile partZip,
+                  int part,
+                  PakEntryArray& entries);
+
+    /** Adds the buffer to the zip as a file. Hash of the entry is stored as the entry's comment. */
+    bool AddBufferToZip(ZipFile zfile, const String& name, const void* data, uint64 size, uint64 hash);
 
-    XmlFilePtr ReadXmlFileFromZip(ZipFile zfile, const String& relativePath, const char* path);
-    uint8* ReadImageFileFromZip(ZipFile zfile, const String& relativePath, ImageFileInfo& fileInfo);
-    float* ReadHdriFileFromZip(ZipFile zfile, const String& relativePath, ImageFileInfo& fileInfo);
+    /** Copies the current entry of the unzip handle to the zip as it is, without decompressing it. */
+    bool CopyZipEntry(ZipFile unzipFile, ZipFile zfile);
 
-    /** Reads the file from the zip and returns it as buffer pointer and set the buffer size. */
-    ubyte* ReadFileBufferFromZip(ZipFile zfile, const String& relativePath, uint& bufferSize);
+    void GetAllPaths(const String& path);
+    void GetExtraFilePaths();
 
-    XmlFilePtr CreateXmlFileFromZip(ZipFile zfile, const String& filename, uint filesize);
-    uint8* CreateImageFileFromZip(ZipFile zfile, uint filesize, ImageFileInfo& fileInfo);
-    float* CreateHdriFileFromZip(ZipFile zfile, uint filesize, ImageFileInfo& fileInfo);
+    /** Opens the pak file if it is not already open. Returns true if the pak is open. */
+    bool OpenPakFile();
 
-    void GenerateOffsetTableForPakFiles();
-    bool IsFileInPak(const String& filename);
+    /** Reads the file from the pak. Returns null if there is no pak or the file is not in the pak. */
+    MappedFilePtr ReadFileFromPak(const String& filePath);
 
    private:
-    StringSet m_allPaths;
-    std::unordered_map<String, std::pair<uint64, uint>> m_zipFilesOffsetTable;
-    bool m_offsetTableCreated = false;
-    ZipFile m_zfile           = nullptr;
+    StringSet m_allPaths;                                               //!< Paths of the files to pack.
+    std::unordered_map<String, bool> m_texturePaths;                    //!< Textures to pack and if they are srgb.
+    TextureCompression m_textureCompression = TextureCompression::None; //!< Compression of the packed textures.
+    bool m_dropSourceImages                 = false;                    //!< Leaves out the etc2 source images.
+    PakFile m_pak;                                                      //!< Resources pak, opened on first access.
+    Mutex m_pakMutex;                                                   //!< Guards opening and closing the pak.
 
    public:
     bool m_ignorePakFile = false;
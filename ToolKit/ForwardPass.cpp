@@ -47,6 +47,7 @@ namespace ToolKit
 
     renderer->SetFramebuffer(m_params.FrameBuffer, m_params.clearBuffer);
     renderer->SetCamera(m_params.Cam, true);
+    renderer->SetClusteredLighting(m_params.clusteredLighting);
 
     // Adjust the depth test considering z-pre pass.
     if (m_params.hasForwardPrePass)
@@ -64,6 +65,7 @@ namespace ToolKit
     // Set the default depth test.
     Renderer* renderer = GetRenderer();
     renderer->SetDepthTestFunc(CompareFunctions::FuncLess);
+    renderer->SetClusteredLighting(nullptr);
   }
 
   void ForwardRenderPass::RenderOpaque(RenderData* renderData)
@@ -72,19 +74,14 @@ namespace ToolKit
     ConfigureProgram();
 
     // Render opaque.
-    ShaderPtr frag = m_programConfigMat->GetFragmentShaderVal();
-    frag->SetDefine("DrawAlphaMasked", "0");
-
-    ShaderPtr vert           = m_programConfigMat->GetVertexShaderVal();
-    GpuProgramPtr gpuProgram = GetGpuProgramManager()->CreateProgram(vert, frag);
+    GpuProgramPtr gpuProgram = CreateOpaqueProgram(false);
 
     RenderJobItr begin       = renderData->GetForwardOpaqueBegin();
     RenderJobItr end         = renderData->GetForwardAlphaMaskedBegin();
     RenderOpaqueHelper(renderData, begin, end, gpuProgram);
 
     // Render alpha masked.
-    frag->SetDefine("DrawAlphaMasked", "1");
-    gpuProgram = GetGpuProgramManager()->CreateProgram(vert, frag);
+    gpuProgram = CreateOpaqueProgram(true);
 
     begin      = renderData->GetForwardAlphaMaskedBegin();
     end        = renderData->GetForwardTranslucentBegin();
@@ -152,17 +149,20 @@ namespace ToolKit
     Renderer* renderer = GetRenderer();
     renderer->SetAmbientOcclusionTexture(m_params.SsaoTexture);
 
-    for (RenderJobItr job = begin; job != end; job++)
+    for (RenderJobItr job = begin; job != end;)
     {
       if (job->Material->IsShaderMaterial())
       {
         renderer->RenderWithProgramFromMaterial(*job);
+        job++;
+        continue;
       }
-      else
-      {
-        renderer->BindProgram(defaultGpuProgram);
-        renderer->Render(*job);
-      }
+
+      renderer->BindProgram(defaultGpuProgram);
+
+      RenderJobItr batchEnd = m_instancing ? RenderJobProcessor::FindInstanceBatchEnd(job, end) : job + 1;
+      RenderJobs(job, batchEnd, m_instancing);
+      job = batchEnd;
     }
   }
 
@@ -188,6 +188,24 @@ namespace ToolKit
 
     int shadowSample = shadows->GetShadowSamples();
     frag->SetDefine("ShadowSampleCount", std::to_string(shadowSample));
+
+    frag->SetDefine("ClusteredLighting", m_params.clusteredLighting != nullptr ? "1" : "0");
+
+    m_instancing = GetEngineSettings().m_graphics->GetGpuInstancingVal();
+  }
+
+  GpuProgramPtr ForwardRenderPass::CreateOpaqueProgram(bool alphaMasked)
+  {
+    ShaderPtr frag = m_programConfigMat->GetFragmentShaderVal();
+    frag->SetDefine("DrawAlphaMasked", alphaMasked ? "1" : "0");
+
+    // Vertex shader is shared with other materials, instanced variant is only selected while creating the program.
+    ShaderPtr vert = m_programConfigMat->GetVertexShaderVal();
+    vert->SetDefine("Instanced", m_instancing ? "1" : "0");
+    GpuProgramPtr program = GetGpuProgramManager()->CreateProgram(vert, frag);
+    vert->SetDefine("Instanced", "0");
+
+    return program;
   }
 
 } // namespace ToolKit
\ No newline at end of file
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include "ClusteredLighting.h"
 #include "Pass.h"
 
 namespace ToolKit
@@ -14,13 +15,16 @@ namespace ToolKit
 
   struct ForwardRenderPassParams
   {
-    RenderData* renderData           = nullptr;
-    CameraPtr Cam                    = nullptr;
-    FramebufferPtr FrameBuffer       = nullptr;
-    RenderTargetPtr SsaoTexture      = nullptr;
-    GraphicBitFields clearBuffer     = GraphicBitFields::AllBits;
-    bool hasForwardPrePass           = false;
-    uint activeDirectionalLightCount = 0;
+    RenderData* renderData                 = nullptr;
+    CameraPtr Cam                          = nullptr;
+    FramebufferPtr FrameBuffer             = nullptr;
+    RenderTargetPtr SsaoTexture            = nullptr;
+    GraphicBitFields clearBuffer           = GraphicBitFields::AllBits;
+    bool hasForwardPrePass                 = false;
+    uint activeDirectionalLightCount       = 0;
+
+    /** When set, point and spot lights are read from the clusters instead of the render jobs. */
+    ClusteredLightingPtr clusteredLighting = nullptr;
   };
 
   /**
@@ -46,12 +50,16 @@ namespace ToolKit
 
     void ConfigureProgram();
 
+    /** Creates the program for the opaque or alpha masked jobs, instanced if the instancing is enabled. */
+    GpuProgramPtr CreateOpaqueProgram(bool alphaMasked);
+
    public:
     ForwardRenderPassParams m_params;
 
    private:
     bool m_SMFormat16Bit = false;
     bool m_EVSM4         = false;
+    bool m_instancing    = false;
 
     MaterialPtr m_programConfigMat;
   };
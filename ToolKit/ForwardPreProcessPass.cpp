@@ -9,7 +9,9 @@
 
 #include "ForwardPreProcessPass.h"
 
+#include "EngineSettings.h"
 #include "Shader.h"
+#include "ToolKit.h"
 
 #include "DebugNew.h"
 
@@ -74,17 +76,18 @@ namespace ToolKit
     ShaderPtr frag     = m_linearMaterial->GetFragmentShaderVal();
     frag->SetDefine("DrawAlphaMasked", "0");
 
-    ShaderPtr vert                       = m_linearMaterial->GetVertexShaderVal();
+    // Jobs are expected to be sorted by material, so that the ones that can be instanced are consecutive.
+    bool instancing = GetEngineSettings().m_graphics->GetGpuInstancingVal();
+    ShaderPtr vert  = m_linearMaterial->GetVertexShaderVal();
+    vert->SetDefine("Instanced", instancing ? "1" : "0");
+
     GpuProgramManager* gpuProgramManager = GetGpuProgramManager();
     m_program                            = gpuProgramManager->CreateProgram(vert, frag);
 
     Renderer* renderer                   = GetRenderer();
     renderer->BindProgram(m_program);
 
-    for (RenderJobItr job = begin; job != end; job++)
-    {
-      renderer->Render(*job);
-    }
+    RenderJobs(begin, end, instancing);
 
     begin = m_params.renderData->GetForwardAlphaMaskedBegin();
     end   = m_params.renderData->GetForwardTranslucentBegin();
@@ -93,10 +96,9 @@ namespace ToolKit
     m_program = gpuProgramManager->CreateProgram(vert, frag);
     renderer->BindProgram(m_program);
 
-    for (RenderJobItr job = begin; job != end; job++)
-    {
-      renderer->Render(*job);
-    }
+    RenderJobs(begin, end, instancing);
+
+    vert->SetDefine("Instanced", "0");
   }
 
   void ForwardPreProcessPass::PreRender()
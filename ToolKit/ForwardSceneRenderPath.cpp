@@ -9,6 +9,7 @@
 
 #include "Material.h"
 #include "MathUtil.h"
+#include "RenderProxyStore.h"
 #include "Scene.h"
 #include "Shader.h"
 #include "Stats.h"
@@ -28,6 +29,7 @@ namespace ToolKit
     m_bloomPass             = MakeNewPtr<BloomPass>();
     m_dofPass               = MakeNewPtr<DoFPass>();
     m_gammaTonemapFxaaPass  = MakeNewPtr<GammaTonemapFxaaPass>();
+    m_clusteredLighting     = std::make_shared<ClusteredLighting>();
   }
 
   ForwardSceneRenderPath::~ForwardSceneRenderPath()
@@ -40,6 +42,7 @@ namespace ToolKit
     m_bloomPass             = nullptr;
     m_dofPass               = nullptr;
     m_gammaTonemapFxaaPass  = nullptr;
+    m_clusteredLighting     = nullptr;
   }
 
   void ForwardSceneRenderPath::Render(Renderer* renderer)
@@ -119,8 +122,9 @@ namespace ToolKit
 
   void ForwardSceneRenderPath::SetPassParams(Renderer* renderer)
   {
-    Frustum frustum            = ExtractFrustum(m_params.Cam->GetProjectViewMatrix(), false);
-    EntityRawPtrArray entities = m_params.Scene->m_aabbTree.VolumeQuery(frustum);
+    Frustum frustum = ExtractFrustum(m_params.Cam->GetProjectViewMatrix(), false);
+    m_params.Scene->m_aabbTree.VolumeQuery(frustum, m_visibleEntities);
+    EntityRawPtrArray& entities = m_visibleEntities;
 
     if (m_params.grid != nullptr)
     {
@@ -166,7 +170,25 @@ namespace ToolKit
 
     int dirEndIndx                                   = RenderJobProcessor::PreSortLights(lights);
     const EnvironmentComponentPtrArray& environments = m_params.Scene->GetEnvironmentVolumes();
-    RenderJobProcessor::CreateRenderJobs(m_renderData.jobs, entities, false, dirEndIndx, lights, environments);
+
+    // Jobs of the scene entities are retained between frames, only the changed entities are processed.
+    RenderProxyStore* renderProxies                  = m_params.Scene->GetRenderProxyStore();
+
+    bool clustered                                   = GetEngineSettings().m_graphics->GetClusteredLightingVal();
+    if (clustered && ClusteredLighting::IsSupported(m_params.Cam))
+    {
+      // Point and spot lights are read from the clusters, jobs only get the directional lights.
+      m_clusteredLighting->Update(m_params.Cam, lights);
+      m_forwardRenderPass->m_params.clusteredLighting = m_clusteredLighting;
+
+      LightRawPtrArray directionalLights(lights.begin(), lights.begin() + dirEndIndx);
+      renderProxies->CollectRenderJobs(m_renderData.jobs, entities, dirEndIndx, directionalLights, environments);
+    }
+    else
+    {
+      m_forwardRenderPass->m_params.clusteredLighting = nullptr;
+      renderProxies->CollectRenderJobs(m_renderData.jobs, entities, dirEndIndx, lights, environments);
+    }
 
     m_shadowPass->m_params.scene      = m_params.Scene;
     m_shadowPass->m_params.viewCamera = m_params.Cam;
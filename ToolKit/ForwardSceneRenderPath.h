@@ -8,6 +8,7 @@
 #pragma once
 
 #include "BloomPass.h"
+#include "ClusteredLighting.h"
 #include "CubemapPass.h"
 #include "DofPass.h"
 #include "EngineSettings.h"
@@ -73,12 +74,16 @@ namespace ToolKit
     DoFPassPtr m_dofPass                             = nullptr;
     GammaTonemapFxaaPassPtr m_gammaTonemapFxaaPass   = nullptr;
 
+    /** Clusters of the camera, used when clustered lighting is enabled in the graphic settings. */
+    ClusteredLightingPtr m_clusteredLighting         = nullptr;
+
    protected:
     bool m_drawSky   = false;
     SkyBasePtr m_sky = nullptr;
 
     // Cached variables
     RenderData m_renderData;
+    EntityRawPtrArray m_visibleEntities;
   };
 
 } // namespace ToolKit
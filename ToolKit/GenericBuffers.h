@@ -50,12 +50,24 @@ namespace ToolKit
     virtual void InvalidateCacheItem()      = 0;
   };
 
-  /** LRU based generic cache. T must be a type derived from CacheItem. Size is in bytes. */
+  /**
+   * LRU based generic cache. T must be a type derived from CacheItem. Size is in bytes. Items are kept in a fixed
+   * array of slots linked in the LRU order, so the index of an item doesn't change while it stays in the cache. Only the
+   * slots that are changed since the last map are passed to gpu.
+   */
   template <typename T, uint64 ItemSize>
   class TK_API LRUCache
   {
    public:
-    LRUCache(uint64 byteSize) : m_cacheSize(byteSize) { m_data = new byte[m_cacheSize]; }
+    LRUCache(uint64 byteSize) : m_cacheSize(byteSize)
+    {
+      m_data     = new byte[m_cacheSize];
+      m_capacity = (int) (m_cacheSize / ItemSize);
+      m_items.resize(m_capacity);
+      m_links.resize(m_capacity);
+      m_dirty.resize(m_capacity);
+      Reset();
+    }
 
     virtual ~LRUCache() { SafeDelArray(m_data); }
 
@@ -65,44 +77,48 @@ namespace ToolKit
     /** Adds or updates a cache item, invalidates the cache if needed. Returns index of the item. */
     int AddOrUpdateItem(const T& item)
     {
+      int slot     = -1;
+
       // If item exist, check if update is needed.
       auto itemItr = m_cacheMap.find(item.id);
       if (itemItr != m_cacheMap.end())
       {
+        slot = itemItr->second;
+        Unlink(slot);
+        LinkFront(slot);
+
         // Check versions
-        T& CacheItem = *itemItr->second;
-        if (CacheItem.version != item.version)
+        if (m_items[slot].version == item.version)
         {
-          // Set the new item data.
-          m_lruCacheList.erase(itemItr->second);
-          m_lruCacheList.push_front(item);
-          m_cacheMap[item.id] = m_lruCacheList.begin();
-
-          m_isValid           = false;
-          return 0; // Material is the first item in the cache.
+          return slot;
         }
       }
       else
       {
-        // Check if there is enough space
-        uint64 usedSize = ConsumedSize();
-        if (usedSize + ItemSize > m_cacheSize)
+        if (m_count < m_capacity)
         {
-          // Not enough space, drop the last item
-          T& lastItem = m_lruCacheList.back();
-          m_cacheMap.erase(lastItem.id);
-          m_lruCacheList.pop_back();
+          // Slots are given in order until the cache is full.
+          slot = m_count++;
+        }
+        else
+        {
+          // Not enough space, reuse the slot of the least recently used item.
+          slot = m_tail;
+          Unlink(slot);
+          m_cacheMap.erase(m_items[slot].id);
         }
 
-        // Insert the new item.
-        m_lruCacheList.push_front(item);
-        m_cacheMap[item.id] = m_lruCacheList.begin();
-
-        m_isValid           = false;
-        return 0; // Material is the first item in the cache.
+        LinkFront(slot);
+        m_cacheMap[item.id] = slot;
       }
 
-      return (int) std::distance(m_lruCacheList.begin(), itemItr->second);
+      // Set the new item data.
+      m_items[slot] = item;
+      memcpy(m_data + slot * ItemSize, m_items[slot].GetData(), ItemSize);
+      m_dirty[slot] = true;
+      m_isValid     = false;
+
+      return slot;
     }
 
     /**
@@ -132,7 +148,7 @@ namespace ToolKit
         auto itemItr = m_cacheMap.find(id);
         if (itemItr != m_cacheMap.end())
         {
-          ids.push_back((int) std::distance(m_lruCacheList.begin(), itemItr->second));
+          ids.push_back(itemItr->second);
         }
       }
 
@@ -143,35 +159,53 @@ namespace ToolKit
     void Reset()
     {
       m_cacheMap.clear();
-      m_lruCacheList.clear();
+      m_head  = -1;
+      m_tail  = -1;
+      m_count = 0;
       memset(m_data, 0, m_cacheSize);
+      std::fill(m_dirty.begin(), m_dirty.end(), true);
       m_isValid = false;
     }
 
     /** Returns used size of the cache in bytes. */
-    uint64 ConsumedSize() const { return ItemSize * m_lruCacheList.size(); }
+    uint64 ConsumedSize() const { return ItemSize * m_count; }
 
     /**
-     * Maps the Items to cache data in LRU.
-     * Calls the update function with current cache and size if cache is invalidated.
+     * Passes the changed parts of the cache data to gpu.
+     * Calls the update function with each changed range of the cache data, its offset and size in bytes.
      * returns true if mapping is performed in case of invalidation.
      */
-    bool Map(std::function<void(const void* data, uint64 size)> updateFn = nullptr)
+    bool Map(std::function<void(const void* data, uint64 offset, uint64 size)> updateFn = nullptr)
     {
       bool mapped = false;
       if (!m_isValid)
       {
-        int i = 0;
-        for (auto& item : m_lruCacheList)
-        {
-          void* data = item.GetData();
-          memcpy(static_cast<byte*>(m_data) + i * ItemSize, data, ItemSize);
-          i++;
-        }
+        // Close ranges are merged to reduce the number of uploads.
+        constexpr int maxGap = 4;
 
-        if (updateFn != nullptr)
+        int begin            = -1;
+        int end              = -1;
+        for (int i = 0; i <= m_capacity; i++)
         {
-          updateFn(m_data, m_cacheSize);
+          bool dirty = i < m_capacity && m_dirty[i];
+          if (dirty)
+          {
+            if (begin == -1)
+            {
+              begin = i;
+            }
+            end        = i + 1;
+            m_dirty[i] = false;
+          }
+          else if (begin != -1 && (i == m_capacity || i - end >= maxGap))
+          {
+            if (updateFn != nullptr)
+            {
+              uint64 offset = begin * ItemSize;
+              updateFn(m_data + offset, offset, (end - begin) * ItemSize);
+            }
+            begin = -1;
+          }
         }
 
         m_isValid = true;
@@ -181,22 +215,77 @@ namespace ToolKit
       return mapped;
     }
 
+   private:
+    /** Removes the slot from the LRU list. */
+    void Unlink(int slot)
+    {
+      Link& link = m_links[slot];
+      if (link.prev != -1)
+      {
+        m_links[link.prev].next = link.next;
+      }
+      else
+      {
+        m_head = link.next;
+      }
+
+      if (link.next != -1)
+      {
+        m_links[link.next].prev = link.prev;
+      }
+      else
+      {
+        m_tail = link.prev;
+      }
+    }
+
+    /** Inserts the slot to the front of the LRU list as the most recently used. */
+    void LinkFront(int slot)
+    {
+      m_links[slot] = {-1, m_head};
+      if (m_head != -1)
+      {
+        m_links[m_head].prev = slot;
+      }
+      else
+      {
+        m_tail = slot;
+      }
+      m_head = slot;
+    }
+
    public:
     /** Size of the cache in bytes. */
     const uint64 m_cacheSize;
 
    private:
-    typedef std::list<T> CacheList;
-    typedef std::unordered_map<ObjectId, typename CacheList::iterator> CacheMap;
-
-    /** Storage of items by id and list iterator. This map is used to see if an get its iterator in m_cacheList. */
-    CacheMap m_cacheMap;
-    /** List of item in the cache stored from least recently used to last.  */
-    CacheList m_lruCacheList;
+    /** Neighbours of a slot in the LRU list. */
+    struct Link
+    {
+      int prev; //!< More recently used slot.
+      int next; //!< Less recently used slot.
+    };
+
+    /** Slot of the items by id. */
+    std::unordered_map<ObjectId, int> m_cacheMap;
+    /** Items by slot. */
+    std::vector<T> m_items;
+    /** LRU list over the slots. */
+    std::vector<Link> m_links;
+    /** States if the slot is changed since the last map. */
+    std::vector<bool> m_dirty;
+    /** Most recently used slot. */
+    int m_head     = -1;
+    /** Least recently used slot. */
+    int m_tail     = -1;
+    /** Number of the used slots. */
+    int m_count    = 0;
+    /** Number of the slots. */
+    int m_capacity = 0;
     /** States if a gpu map is needed. */
-    int m_isValid = false;
+    int m_isValid  = false;
     /** The full data that will be passed to gpu. */
-    void* m_data  = nullptr;
+    byte* m_data   = nullptr;
   };
 
   // StructBuffer
@@ -126,6 +126,42 @@ namespace ToolKit
     inline float GetDepth() const { return max.z - min.z; }
   };
 
+  /**
+   * 4 bounding boxes stored in structure of arrays layout to be tested at once with SIMD instructions.
+   * Empty lanes are kept inverted, min at TK_FLT_MAX and max at -TK_FLT_MAX, so that they never pass a test.
+   */
+  struct alignas(16) BoundingBox4
+  {
+    float minX[4]; //!< Minimum x values of the boxes.
+    float minY[4]; //!< Minimum y values of the boxes.
+    float minZ[4]; //!< Minimum z values of the boxes.
+    float maxX[4]; //!< Maximum x values of the boxes.
+    float maxY[4]; //!< Maximum y values of the boxes.
+    float maxZ[4]; //!< Maximum z values of the boxes.
+
+    BoundingBox4()
+    {
+      for (int i = 0; i < 4; i++)
+      {
+        SetEmpty(i);
+      }
+    }
+
+    /** Sets the box at the given lane. */
+    inline void Set(int lane, const BoundingBox& box)
+    {
+      minX[lane] = box.min.x;
+      minY[lane] = box.min.y;
+      minZ[lane] = box.min.z;
+      maxX[lane] = box.max.x;
+      maxY[lane] = box.max.y;
+      maxZ[lane] = box.max.z;
+    }
+
+    /** Marks the given lane as empty. */
+    inline void SetEmpty(int lane) { Set(lane, BoundingBox()); }
+  };
+
   static const BoundingBox infinitesimalBox(Vec3(-TK_FLT_MIN), Vec3(TK_FLT_MIN));
   static const BoundingBox unitBox({-0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, 0.5f});
 
@@ -138,6 +174,8 @@ namespace ToolKit
     Vec3 direction; //!< The direction of the ray.
   };
 
+  typedef std::vector<Ray> RayArray;
+
   /**
    * A struct representing a plane equation in 3D space.
    * Plane equation: ax+by+cz+(-d)=0
@@ -7,15 +7,38 @@
 
 #include "GpuProgram.h"
 
+#include "MappedFile.h"
 #include "Renderer.h"
 #include "Shader.h"
+#include "Stats.h"
 #include "TKOpenGL.h"
+#include "ToolKit.h"
+#include "Util.h"
 
 #include "DebugNew.h"
 
 namespace ToolKit
 {
 
+  /**
+   * Program binary cache file layout:
+   * ProgramCacheHeader followed by the program binary returned by the driver. Files are named after the hash of the
+   * shader variants and the driver, the header is checked against them on load to reject stale files.
+   */
+
+  static constexpr char g_programCacheMagic[4]  = {'T', 'K', 'P', 'B'};
+  static constexpr uint32 g_programCacheVersion = 1;
+
+  struct ProgramCacheHeader
+  {
+    char magic[4];                        //!< Always g_programCacheMagic.
+    uint32 version;                       //!< Version of the layout.
+    uint64 driverHash;                    //!< Hash of the driver that created the binary.
+    uint64 variants[TKGpuPipelineStages]; //!< Variant hashes of the shaders in the program.
+    uint32 format;                        //!< Binary format returned by the driver.
+    uint32 size;                          //!< Size of the binary following the header.
+  };
+
   // GpuProgram
   //////////////////////////////////////////
 
@@ -105,10 +128,31 @@ namespace ToolKit
 
   GpuProgramManager::~GpuProgramManager() { FlushPrograms(); }
 
-  void GpuProgramManager::LinkProgram(uint program, const ShaderPtr vertexShader, const ShaderPtr fragmentShader)
+  bool GpuProgramManager::LinkProgram(uint program, const ShaderPtr vertexShader, const ShaderPtr fragmentShader)
   {
-    glAttachShader(program, vertexShader->m_shaderHandle);
-    glAttachShader(program, fragmentShader->m_shaderHandle);
+    // Both stages are submitted before waiting for any, so that they compile together if the driver allows.
+    vertexShader->SubmitCompile();
+    fragmentShader->SubmitCompile();
+
+    uint vertexHandle   = vertexShader->GetCompiledHandle();
+    uint fragmentHandle = fragmentShader->GetCompiledHandle();
+    if (vertexHandle == 0 || fragmentHandle == 0)
+    {
+      TK_ERR("Program can't be linked, shader compilation failed.\nVertex shader: %s\nFragment shader: %s",
+             vertexShader->GetFile().c_str(),
+             fragmentShader->GetFile().c_str());
+      return false;
+    }
+
+    float beginTime = GetElapsedMilliSeconds();
+
+    if (m_programCacheEnabled)
+    {
+      glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    glAttachShader(program, vertexHandle);
+    glAttachShader(program, fragmentHandle);
 
     glLinkProgram(program);
 
@@ -132,6 +176,166 @@ namespace ToolKit
       }
 
       glDeleteProgram(program);
+      return false;
+    }
+
+    if (TKStats* stats = GetTKStats())
+    {
+      stats->m_programLinkCount++;
+      stats->m_programLinkTime += GetElapsedMilliSeconds() - beginTime;
+    }
+
+    return true;
+  }
+
+  void GpuProgramManager::InitProgramCache()
+  {
+    m_programCacheInitialized = true;
+
+    GLint formatCount         = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+    if (formatCount <= 0)
+    {
+      return;
+    }
+
+    // Binaries are only valid for the driver that created them.
+    String driver;
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+    {
+      if (const GLubyte* str = glGetString(name))
+      {
+        driver += (const char*) str;
+        driver += "|";
+      }
+    }
+    m_driverHash       = StringHash(driver);
+
+    m_programCachePath = ConcatPaths({ConfigPath(), "ProgramCache"});
+
+    std::error_code err;
+    std::filesystem::create_directories(m_programCachePath, err);
+    m_programCacheEnabled = !err;
+  }
+
+  String GpuProgramManager::GetProgramCacheFile(const ProgramKey& key) const
+  {
+    uint64 hash = m_driverHash;
+    for (uint64 variant : key)
+    {
+      hash = MurmurHash(hash ^ variant);
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long) hash);
+
+    return ConcatPaths({m_programCachePath, name});
+  }
+
+  bool GpuProgramManager::LoadProgramBinary(uint program, const ProgramKey& key)
+  {
+    if (!m_programCacheEnabled)
+    {
+      return false;
+    }
+
+    float beginTime = GetElapsedMilliSeconds();
+
+    MappedFile file;
+    if (!file.Open(GetProgramCacheFile(key)) || file.Size() < sizeof(ProgramCacheHeader))
+    {
+      return false;
+    }
+
+    ProgramCacheHeader header;
+    memcpy(&header, file.Data(), sizeof(ProgramCacheHeader));
+
+    bool valid = memcmp(header.magic, g_programCacheMagic, sizeof(g_programCacheMagic)) == 0;
+    valid      = valid && header.version == g_programCacheVersion && header.driverHash == m_driverHash;
+    valid      = valid && sizeof(ProgramCacheHeader) + header.size <= file.Size();
+    for (int i = 0; i < TKGpuPipelineStages; i++)
+    {
+      valid = valid && header.variants[i] == key[i];
+    }
+
+    if (!valid)
+    {
+      return false;
+    }
+
+    glProgramBinary(program, header.format, file.Data() + sizeof(ProgramCacheHeader), header.size);
+
+    // Drivers may reject their old binaries after an update, program is linked from the shaders in that case.
+    GLint linked = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+      return false;
+    }
+
+    if (TKStats* stats = GetTKStats())
+    {
+      stats->m_programCacheLoadCount++;
+      stats->m_programCacheLoadTime += GetElapsedMilliSeconds() - beginTime;
+    }
+
+    return true;
+  }
+
+  void GpuProgramManager::SaveProgramBinary(uint program, const ProgramKey& key)
+  {
+    if (!m_programCacheEnabled)
+    {
+      return;
+    }
+
+    GLint size = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0)
+    {
+      return;
+    }
+
+    std::vector<uint8> binary(size);
+    GLsizei length = 0;
+    GLenum format  = 0;
+    glGetProgramBinary(program, size, &length, &format, binary.data());
+    if (length <= 0)
+    {
+      return;
+    }
+
+    ProgramCacheHeader header;
+    memcpy(header.magic, g_programCacheMagic, sizeof(g_programCacheMagic));
+    header.version    = g_programCacheVersion;
+    header.driverHash = m_driverHash;
+    header.format     = (uint32) format;
+    header.size       = (uint32) length;
+    for (int i = 0; i < TKGpuPipelineStages; i++)
+    {
+      header.variants[i] = key[i];
+    }
+
+    // Written to a temporary file first, so that other instances never read a partial binary.
+    String file     = GetProgramCacheFile(key);
+    String tempFile = file + ".tmp";
+    {
+      std::ofstream stream(tempFile, std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!stream.is_open())
+      {
+        TK_WRN("Can't write program binary: %s", tempFile.c_str());
+        return;
+      }
+
+      stream.write((const char*) &header, sizeof(ProgramCacheHeader));
+      stream.write((const char*) binary.data(), (std::streamsize) length);
+    }
+
+    std::error_code err;
+    std::filesystem::rename(tempFile, file, err);
+    if (err)
+    {
+      std::filesystem::remove(tempFile, err);
     }
   }
 
@@ -144,13 +348,26 @@ namespace ToolKit
     vertexShader->Init();
     fragmentShader->Init();
 
-    const auto& progIter = m_programs.find({vertexShader->m_shaderHandle, fragmentShader->m_shaderHandle});
+    if (!m_programCacheInitialized)
+    {
+      InitProgramCache();
+    }
+
+    // Shaders are compiled only if the program is neither created nor cached before.
+    ProgramKey key       = {vertexShader->GetVariantHash(), fragmentShader->GetVariantHash()};
+    const auto& progIter = m_programs.find(key);
     if (progIter == m_programs.end())
     {
       GpuProgramPtr program = MakeNewPtr<GpuProgram>(vertexShader, fragmentShader);
       program->m_handle     = glCreateProgram();
 
-      LinkProgram(program->m_handle, vertexShader, fragmentShader);
+      if (!LoadProgramBinary(program->m_handle, key))
+      {
+        if (LinkProgram(program->m_handle, vertexShader, fragmentShader))
+        {
+          SaveProgramBinary(program->m_handle, key);
+        }
+      }
 
       GLint currentProgram = 0;
       glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
@@ -215,6 +432,13 @@ namespace ToolKit
         glBindBufferBase(GL_UNIFORM_BUFFER, SpotLightCache::BindingSlot, m_globalGpuBuffers->spotLightBufferId);
       }
 
+      loc = glGetUniformBlockIndex(program->m_handle, "ClusterData");
+      if (loc != GL_INVALID_INDEX)
+      {
+        glUniformBlockBinding(program->m_handle, loc, ClusterGpuBuffer::Binding());
+        glBindBufferBase(GL_UNIFORM_BUFFER, ClusterGpuBuffer::Binding(), m_globalGpuBuffers->clusterBufferId);
+      }
+
       // Register default uniform locations
       for (ShaderPtr shader : program->m_shaders)
       {
@@ -233,11 +457,11 @@ namespace ToolKit
         }
       }
 
-      m_programs[{vertexShader->m_shaderHandle, fragmentShader->m_shaderHandle}] = program;
+      m_programs[key] = program;
 
       glUseProgram(currentProgram); // Restore current program.
 
-      return m_programs[{vertexShader->m_shaderHandle, fragmentShader->m_shaderHandle}];
+      return m_programs[key];
     }
 
     return progIter->second;
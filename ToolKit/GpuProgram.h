@@ -63,20 +63,23 @@ namespace ToolKit
     void SetGpuBuffers(struct GlobalGpuBuffers* gpuBuffers) { m_globalGpuBuffers = gpuBuffers; }
 
    private:
+    /** Variant hashes of the shaders for each stage, identifies a program. */
+    typedef std::array<uint64, TKGpuPipelineStages> ProgramKey;
+
     /**
      * Utility class that hash an array of ULongIDs. Purpose of this class is to provide a hash generator from the
-     * shader ids that is used in the program. This hash value will be identifying the program.
+     * shader variant hashes that is used in the program. This hash value will be identifying the program.
      */
     struct IDArrayHash
     {
-      std::size_t operator()(const std::array<ObjectId, TKGpuPipelineStages>& data) const
+      std::size_t operator()(const ProgramKey& data) const
       {
         std::size_t hashValue = 0;
 
         for (const auto& element : data)
         {
           // Combine the hash value with the hash of each element
-          hashValue ^= std::hash<ObjectId>()(element) + 0x9e3779b9 + (hashValue << 6) + (hashValue >> 2);
+          hashValue ^= std::hash<uint64>()(element) + 0x9e3779b9 + (hashValue << 6) + (hashValue >> 2);
         }
 
         return hashValue;
@@ -85,7 +88,8 @@ namespace ToolKit
 
    public:
     /**
-     * Creates a gpu program that can be binded to renderer to render the objects with.
+     * Creates a gpu program that can be binded to renderer to render the objects with. Linked programs are saved to the
+     * program binary cache, following runs load them without compiling the shaders.
      * @param vertexShader - is the vertex shader to use in pipeline.
      * @param fragmentShader - is the fragment program to use in pipeline.
      */
@@ -99,15 +103,38 @@ namespace ToolKit
     void FlushPrograms();
 
    private:
-    /** Links the given shaders with the program. */
-    void LinkProgram(uint program, const ShaderPtr vertexShader, const ShaderPtr fragmentShader);
+    /**
+     * Compiles the shaders if needed and links them with the program.
+     * @return False if the shaders can't be compiled or linked.
+     */
+    bool LinkProgram(uint program, const ShaderPtr vertexShader, const ShaderPtr fragmentShader);
+
+    /** Enables the program binary cache if the driver supports it. Requires a current context. */
+    void InitProgramCache();
+
+    /** Returns the path of the cache file for the program. */
+    String GetProgramCacheFile(const ProgramKey& key) const;
+
+    /**
+     * Loads the program from the program binary cache.
+     * @return False if there is no binary for the program or the driver rejects it.
+     */
+    bool LoadProgramBinary(uint program, const ProgramKey& key);
+
+    /** Saves the binary of the linked program to the program binary cache. */
+    void SaveProgramBinary(uint program, const ProgramKey& key);
 
    private:
     /** Associative array that holds all the programs. */
-    std::unordered_map<std::array<ObjectId, TKGpuPipelineStages>, GpuProgramPtr, IDArrayHash> m_programs;
+    std::unordered_map<ProgramKey, GpuProgramPtr, IDArrayHash> m_programs;
 
     /** Global gpu buffers used to set uniforms / buffers for each created program. */
     struct GlobalGpuBuffers* m_globalGpuBuffers = nullptr;
+
+    bool m_programCacheInitialized              = false; //!< Whether the driver is queried for the program cache.
+    bool m_programCacheEnabled                  = false; //!< Whether the driver supports program binaries.
+    uint64 m_driverHash                         = 0;     //!< Hash of the driver strings. Binaries aren't portable.
+    String m_programCachePath;                           //!< Folder that the program binaries are saved to.
   };
 
 } // namespace ToolKit
@@ -103,6 +103,16 @@ namespace ToolKit
 
   float Light::AffectDistance() { return 1000.0f; }
 
+  float Light::GetShadowMapResolution() const
+  {
+    if (m_shadowAtlasResolution > 0.0f)
+    {
+      return m_shadowAtlasResolution;
+    }
+
+    return GetShadowResVal().GetValue<float>();
+  }
+
   void Light::InvalidateSpatialCaches()
   {
     Super::InvalidateSpatialCaches();
@@ -147,11 +157,11 @@ namespace ToolKit
     data->color             = GetColorVal();
     data->intensity         = GetIntensityVal();
     data->position          = m_node->GetTranslation(TransformationSpace::TS_WORLD);
-    data->castShadow        = GetCastShadowVal();
+    data->castShadow        = GetCastShadowVal() && m_shadowAtlasLayers[0] != -1;
     data->shadowBias        = GetShadowBiasVal() * RHIConstants::ShadowBiasMultiplier;
     data->bleedingReduction = GetBleedingReductionVal();
     data->pcfRadius         = GetPCFRadiusVal();
-    data->shadowResolution  = GetShadowResVal().GetValue<float>();
+    data->shadowResolution  = GetShadowMapResolution();
     data->shadowAtlasLayer  = m_shadowAtlasLayers[0];
     data->shadowAtlasCoord  = m_shadowAtlasCoords[0];
   }
@@ -397,7 +407,7 @@ namespace ToolKit
     // Allow camera to only make texel size movements.
     // To do this, find the camera origin in projection space and calculate the offset that
     // puts the camera origin on to a texel, prevent sub pixel movements and shimmering in shadow map.
-    float shadowMapRes                     = GetShadowResVal().GetValue<float>();
+    float shadowMapRes                     = GetShadowMapResolution();
     Mat4 shadowMatrix                      = lightCamera->GetProjectViewMatrix();
     Vec4 shadowOrigin                      = Vec4(0.0f, 0.0f, 0.0f, 1.0f);
     shadowOrigin                           = shadowMatrix * shadowOrigin;
@@ -430,7 +440,8 @@ namespace ToolKit
 
   bool PointLightCache::Map()
   {
-    return LRUCache::Map([this](const void* data, uint64 size) { m_gpuBuffer.Map(data, size); });
+    return LRUCache::Map([this](const void* data, uint64 offset, uint64 size)
+                         { m_gpuBuffer.MapRange(data, offset, size); });
   }
 
   // PointLight
@@ -528,7 +539,8 @@ namespace ToolKit
 
   bool SpotLightCache::Map()
   {
-    return LRUCache::Map([this](const void* data, uint64 size) { m_gpuBuffer.Map(data, size); });
+    return LRUCache::Map([this](const void* data, uint64 offset, uint64 size)
+                         { m_gpuBuffer.MapRange(data, offset, size); });
   }
 
   // SpotLight
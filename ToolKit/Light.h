@@ -62,6 +62,12 @@ namespace ToolKit
 
     virtual LightType GetLightType() const = 0;
 
+    /**
+     * Returns the resolution of the shadow maps in the shadow atlas. Same as the shadow resolution, unless the atlas
+     * is full and the shadow maps are placed with a lower resolution.
+     */
+    float GetShadowMapResolution() const;
+
    protected:
     void InvalidateSpatialCaches() override;
 
@@ -91,8 +97,9 @@ namespace ToolKit
     bool m_shadowResolutionUpdated = false;
     MeshPtr m_volumeMesh           = nullptr;
 
-    IntArray m_shadowAtlasLayers;  //!< Layer index in the shadow atlas for each cascade.
-    Vec2Array m_shadowAtlasCoords; //!< Coordinates for each cascade in the corresponding layer.
+    IntArray m_shadowAtlasLayers;         //!< Layer index in the shadow atlas for each cascade.
+    Vec2Array m_shadowAtlasCoords;        //!< Coordinates for each cascade in the corresponding layer.
+    float m_shadowAtlasResolution = 0.0f; //!< Resolution of the shadow maps in the atlas, zero if not placed.
   };
 
   // DirectionalLightCacheItem
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+  #define WIN32_LEAN_AND_MEAN
+  #include <Windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#include "DebugNew.h"
+
+namespace ToolKit
+{
+
+  MappedFile::MappedFile() {}
+
+  MappedFile::~MappedFile() { Close(); }
+
+  bool MappedFile::Open(const String& filePath)
+  {
+    Close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(filePath.c_str(),
+                              GENERIC_READ,
+                              FILE_SHARE_READ,
+                              nullptr,
+                              OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                              nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+      return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+      CloseHandle(file);
+      return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+      CloseHandle(file);
+      return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr)
+    {
+      CloseHandle(mapping);
+      CloseHandle(file);
+      return false;
+    }
+
+    m_fileHandle    = file;
+    m_mappingHandle = mapping;
+    m_data          = static_cast<const uint8*>(data);
+    m_size          = (uint64) size.QuadPart;
+#else
+    int file = open(filePath.c_str(), O_RDONLY);
+    if (file == -1)
+    {
+      return false;
+    }
+
+    struct stat info;
+    if (fstat(file, &info) != 0 || info.st_size == 0)
+    {
+      close(file);
+      return false;
+    }
+
+    void* data = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+    // Mapping keeps its own reference to the file.
+    close(file);
+
+    if (data == MAP_FAILED)
+    {
+      return false;
+    }
+
+    m_data = static_cast<const uint8*>(data);
+    m_size = (uint64) info.st_size;
+#endif
+
+    return true;
+  }
+
+  void MappedFile::Adopt(uint8* buffer, uint64 size)
+  {
+    Close();
+
+    m_buffer = buffer;
+    m_data   = buffer;
+    m_size   = size;
+  }
+
+  void MappedFile::View(const MappedFilePtr& source, uint64 offset, uint64 size)
+  {
+    Close();
+
+    assert(offset + size <= source->Size() && "View exceeds the source.");
+    m_source = source;
+    m_data   = source->Data() + offset;
+    m_size   = size;
+  }
+
+  void MappedFile::Close()
+  {
+    if (m_buffer != nullptr)
+    {
+      SafeDelArray(m_buffer);
+    }
+    else if (m_source != nullptr)
+    {
+      m_source = nullptr;
+    }
+    else if (m_data != nullptr)
+    {
+#ifdef _WIN32
+      UnmapViewOfFile(m_data);
+      CloseHandle(m_mappingHandle);
+      CloseHandle(m_fileHandle);
+
+      m_mappingHandle = nullptr;
+      m_fileHandle    = nullptr;
+#else
+      munmap(const_cast<uint8*>(m_data), (size_t) m_size);
+#endif
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+  }
+
+  const uint8* MappedFile::Data() const { return m_data; }
+
+  uint64 MappedFile::Size() const { return m_size; }
+
+} // namespace ToolKit
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#pragma once
+
+/**
+ * @file Read only view of a file's content. Files on disk are memory mapped, so that only the touched pages are read
+ * from the disk. Files that can't be mapped, such as compressed pak entries, are kept in a memory buffer instead.
+ */
+
+#include "Types.h"
+
+namespace ToolKit
+{
+
+  /** Read only content of a file, either memory mapped or buffered. Content stays valid until the file is closed. */
+  class TK_API MappedFile
+  {
+   public:
+    MappedFile();
+    ~MappedFile(); //!< Closes the file.
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Maps the whole file to the memory as read only.
+     * @return False if the file can't be opened or it is empty.
+     */
+    bool Open(const String& filePath);
+
+    /** Takes the ownership of a buffer that is allocated with new[] and serves it as the file content. */
+    void Adopt(uint8* buffer, uint64 size);
+
+    /** Serves a range of another file as the file content. Source is kept alive until this file is closed. */
+    void View(const MappedFilePtr& source, uint64 offset, uint64 size);
+
+    /** Unmaps the file, releases the buffer or the viewed file. */
+    void Close();
+
+    /** Returns the start of the file content. Mapped content is page aligned, buffers are aligned by new[]. */
+    const uint8* Data() const;
+
+    /** Returns the size of the file content in bytes. */
+    uint64 Size() const;
+
+   private:
+    const uint8* m_data = nullptr; //!< Start of the content.
+    uint64 m_size       = 0;       //!< Size of the content.
+    uint8* m_buffer     = nullptr; //!< Owned buffer, if the content is not mapped.
+    MappedFilePtr m_source;        //!< Viewed file, if the content is a range of another file.
+#ifdef _WIN32
+    void* m_fileHandle    = nullptr; //!< Handle of the opened file.
+    void* m_mappingHandle = nullptr; //!< Handle of the file mapping object.
+#endif
+  };
+
+} // namespace ToolKit
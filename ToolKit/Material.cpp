@@ -43,6 +43,9 @@ namespace ToolKit
 
   void Material::Save(bool onlyIfDirty)
   {
+    // Empty parameters of the loading textures must not be written.
+    SetPendingTextures(true);
+
     Resource::Save(onlyIfDirty);
 
     if (ShaderPtr shader = GetFragmentShaderVal())
@@ -58,6 +61,11 @@ namespace ToolKit
 
   void Material::Init(bool flushClientSideArray)
   {
+    if (!m_pendingTextures.empty())
+    {
+      SetPendingTextures(false);
+    }
+
     if (m_initiated)
     {
       return;
@@ -124,6 +132,8 @@ namespace ToolKit
 
   void Material::CopyTo(Resource* other)
   {
+    SetPendingTextures(true);
+
     Super::CopyTo(other);
     Material* cpy              = static_cast<Material*>(other);
     cpy->m_cubeMap             = m_cubeMap;
@@ -137,6 +147,7 @@ namespace ToolKit
   void Material::SetRenderState(RenderState* state)
   {
     m_renderState = *state; // Copy
+    m_materialCacheItem.Invalidate();
   }
 
   bool Material::IsTranslucent()
@@ -288,8 +299,12 @@ namespace ToolKit
 
   void Material::DeSerializeImpV049(const SerializationFileInfo& info, XmlNode* parent)
   {
-    parent            = Super::DeSerializeImp(info, parent);
-    XmlNode* rootNode = parent->first_node(StaticClass()->Name.c_str());
+    // Textures are streamed, material is usable with its colors until they are loaded.
+    SerializationFileInfo streamInfo = info;
+    streamInfo.StreamedTextures      = &m_pendingTextures;
+
+    parent                           = Super::DeSerializeImp(streamInfo, parent);
+    XmlNode* rootNode                = parent->first_node(StaticClass()->Name.c_str());
     for (XmlNode* node = rootNode->first_node(); node; node = node->next_sibling())
     {
       if (strcmp("renderState", node->name()) == 0)
@@ -484,6 +499,62 @@ namespace ToolKit
 
   void Material::InvalidateCacheItem() { m_materialCacheItem.Invalidate(); }
 
+  bool Material::HasPendingTextures() const { return !m_pendingTextures.empty(); }
+
+  void Material::UpdateStreamingPriority(float priority)
+  {
+    for (auto& [param, request] : m_pendingTextures)
+    {
+      if (priority < request->GetPriority())
+      {
+        request->SetPriority(priority);
+      }
+    }
+  }
+
+  void Material::SetPendingTextures(bool wait)
+  {
+    // Setting the textures doesn't modify the material file.
+    bool dirty = m_dirty;
+
+    for (size_t i = 0; i < m_pendingTextures.size();)
+    {
+      auto& [param, request] = m_pendingTextures[i];
+
+      TexturePtr texture;
+      if (request->IsReady())
+      {
+        texture = Cast<Texture>(request->GetResource());
+      }
+      else if (wait)
+      {
+        texture = GetTextureManager()->Create<Texture>(request->GetFile());
+      }
+      else
+      {
+        i++;
+        continue;
+      }
+
+      for (ParameterVariant& var : m_localData.m_variants)
+      {
+        if (var.m_name == param && var.GetVar<TexturePtr>() == nullptr)
+        {
+          var = texture;
+          break;
+        }
+      }
+
+      m_pendingTextures[i] = m_pendingTextures.back();
+      m_pendingTextures.pop_back();
+
+      // Textures get initialized with the material.
+      m_initiated = false;
+    }
+
+    m_dirty = dirty;
+  }
+
   MaterialManager::MaterialManager() { m_baseType = Material::StaticClass(); }
 
   MaterialManager::~MaterialManager() {}
@@ -502,17 +573,17 @@ namespace ToolKit
     TextureManager* texMan = GetTextureManager();
     material->SetDiffuseTextureVal(texMan->Create<Texture>(TexturePath(TKDefaultImage, true)));
     material->Init();
-    m_defaultMaterial                                 = material;
-    m_storage[MaterialPath("default.material", true)] = material;
+    m_defaultMaterial = material;
+    Store(MaterialPath("default.material", true), material);
 
     // Unlit material
-    material                                          = MakeNewPtr<Material>();
+    material = MakeNewPtr<Material>();
     material->SetVertexShaderVal(defVertex);
     material->SetFragmentShaderVal(shaderMan->Create<Shader>(ShaderPath("unlitFrag.shader", true)));
 
     material->SetDiffuseTextureVal(texMan->Create<Texture>(TexturePath(TKDefaultImage, true)));
     material->Init();
-    m_storage[MaterialPath("unlit.material", true)] = material;
+    Store(MaterialPath("unlit.material", true), material);
   }
 
   bool MaterialManager::CanStore(ClassMeta* Class) { return Class == Material::StaticClass(); }
@@ -523,7 +594,7 @@ namespace ToolKit
 
   MaterialPtr MaterialManager::GetCopyOfUnlitMaterial(bool storeInMaterialManager)
   {
-    ResourcePtr source = m_storage[MaterialPath("unlit.material", true)];
+    ResourcePtr source = Find(MaterialPath("unlit.material", true));
     return Copy<Material>(source, storeInMaterialManager);
   }
 
@@ -545,7 +616,7 @@ namespace ToolKit
 
   MaterialPtr MaterialManager::GetCopyOfDefaultMaterial(bool storeInMaterialManager)
   {
-    ResourcePtr source = m_storage[MaterialPath("default.material", true)];
+    ResourcePtr source = Find(MaterialPath("default.material", true));
     return Copy<Material>(source, storeInMaterialManager);
   }
 
@@ -95,6 +95,22 @@ namespace ToolKit
 
     void InvalidateCacheItem() override;
 
+    /** States if any of the textures is still loading in the background. */
+    bool HasPendingTextures() const;
+
+    /**
+     * Moves the loading textures forward in the background queue. Renderer passes the distance of the drawn object to
+     * the camera, so closer objects get their textures first.
+     */
+    void UpdateStreamingPriority(float priority);
+
+    /**
+     * Sets the textures that are loaded in the background to their parameters. Textures that are set to something
+     * else in the meantime are dropped.
+     * @param wait Waits for the textures that are still loading, otherwise only the ready ones are set.
+     */
+    void SetPendingTextures(bool wait);
+
    protected:
     XmlNode* SerializeImp(XmlDocument* doc, XmlNode* parent) const override;
     XmlNode* DeSerializeImp(const SerializationFileInfo& info, XmlNode* parent) override;
@@ -137,6 +153,9 @@ namespace ToolKit
 
     /** States if the material is using default shaders. */
     bool m_usingDefaultShaders;
+
+    /** Textures that are requested while loading the material and their parameters that are left empty until then. */
+    StreamedResourceArray m_pendingTextures;
   };
 
   // MaterialManager
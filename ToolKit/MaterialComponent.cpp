@@ -138,21 +138,32 @@ namespace ToolKit
     return matNode;
   }
 
-  void MaterialComponent::AddMaterial(MaterialPtr mat) { m_materialList.push_back(mat); }
+  void MaterialComponent::AddMaterial(MaterialPtr mat)
+  {
+    m_materialList.push_back(mat);
+    InvalidateRenderProxy();
+  }
 
   void MaterialComponent::RemoveMaterial(uint index)
   {
     assert(m_materialList.size() >= index && "Material List overflow");
     m_materialList.erase(m_materialList.begin() + index);
+    InvalidateRenderProxy();
   }
 
   const MaterialPtrArray& MaterialComponent::GetMaterialList() const { return m_materialList; }
 
-  MaterialPtrArray& MaterialComponent::GetMaterialList() { return m_materialList; }
+  MaterialPtrArray& MaterialComponent::GetMaterialList()
+  {
+    // List may be modified by the caller.
+    InvalidateRenderProxy();
+    return m_materialList;
+  }
 
   void MaterialComponent::UpdateMaterialList()
   {
     m_materialList.clear();
+    InvalidateRenderProxy();
 
     MeshComponentPtr meshComp;
     if (EntityPtr owner = OwnerEntity())
@@ -207,6 +218,8 @@ namespace ToolKit
     {
       m_materialList[0] = material;
     }
+
+    InvalidateRenderProxy();
   }
 
 } // namespace ToolKit
\ No newline at end of file
@@ -13,8 +13,11 @@
 #include "Mesh.h"
 #include "Node.h"
 #include "Pass.h"
+#include "SimdMath.h"
 #include "Skeleton.h"
 #include "Threads.h"
+#include "ToolKit.h"
+#include "TriangleBVH.h"
 
 #include "DebugNew.h"
 
@@ -301,6 +304,35 @@ namespace ToolKit
     return IntersectResult::Intersect;
   }
 
+  void BoxBoxIntersection(const BoundingBox& box1, const BoundingBox4& boxes, int& outsideMask, int& insideMask)
+  {
+    Float4 minX     = Load4(boxes.minX);
+    Float4 minY     = Load4(boxes.minY);
+    Float4 minZ     = Load4(boxes.minZ);
+    Float4 maxX     = Load4(boxes.maxX);
+    Float4 maxY     = Load4(boxes.maxY);
+    Float4 maxZ     = Load4(boxes.maxZ);
+
+    Float4 box1MinX = Splat4(box1.min.x);
+    Float4 box1MinY = Splat4(box1.min.y);
+    Float4 box1MinZ = Splat4(box1.min.z);
+    Float4 box1MaxX = Splat4(box1.max.x);
+    Float4 box1MaxY = Splat4(box1.max.y);
+    Float4 box1MaxZ = Splat4(box1.max.z);
+
+    // Same tests with the scalar version, evaluated for all lanes.
+    Mask4 outsideX  = (box1MaxX < minX) | (box1MinX > maxX);
+    Mask4 outsideY  = (box1MaxY < minY) | (box1MinY > maxY);
+    Mask4 outsideZ  = (box1MaxZ < minZ) | (box1MinZ > maxZ);
+
+    Mask4 containsX = (box1MinX <= minX) & (box1MaxX >= maxX);
+    Mask4 containsY = (box1MinY <= minY) & (box1MaxY >= maxY);
+    Mask4 containsZ = (box1MinZ <= minZ) & (box1MaxZ >= maxZ);
+
+    outsideMask     = MoveMask4(outsideX | outsideY | outsideZ);
+    insideMask      = MoveMask4(containsX & containsY & containsZ) & ~outsideMask;
+  }
+
   bool BoxPointIntersection(const BoundingBox& box, const Vec3& point)
   {
     // Not accept point on bounding box cases.
@@ -337,7 +369,38 @@ namespace ToolKit
     return true;
   }
 
-  bool RayEntityIntersection(const Ray& ray, const EntityPtr entity, float& dist)
+  int RayBoxIntersection(const Ray& ray, const BoundingBox4& boxes, float t[4])
+  {
+    Vec3 invDir  = 1.0f / ray.direction;
+    Float4 posX  = Splat4(ray.position.x);
+    Float4 posY  = Splat4(ray.position.y);
+    Float4 posZ  = Splat4(ray.position.z);
+    Float4 invX  = Splat4(invDir.x);
+    Float4 invY  = Splat4(invDir.y);
+    Float4 invZ  = Splat4(invDir.z);
+
+    Float4 minX  = Load4(boxes.minX);
+    Float4 maxX  = Load4(boxes.maxX);
+    Float4 vminX = (minX - posX) * invX;
+    Float4 vmaxX = (maxX - posX) * invX;
+
+    Float4 vminY = (Load4(boxes.minY) - posY) * invY;
+    Float4 vmaxY = (Load4(boxes.maxY) - posY) * invY;
+
+    Float4 vminZ = (Load4(boxes.minZ) - posZ) * invZ;
+    Float4 vmaxZ = (Load4(boxes.maxZ) - posZ) * invZ;
+
+    Float4 tmin  = Max4(Max4(Min4(vminX, vmaxX), Min4(vminY, vmaxY)), Min4(vminZ, vmaxZ));
+    Float4 tmax  = Min4(Min4(Max4(vminX, vmaxX), Max4(vminY, vmaxY)), Max4(vminZ, vmaxZ));
+
+    // Same as the scalar version, also rejects the empty lanes whose min is greater than max.
+    Mask4 hit    = (tmax >= Splat4(0.0f)) & (tmin <= tmax) & (minX <= maxX);
+    Store4(t, tmin);
+
+    return MoveMask4(hit);
+  }
+
+  bool RayEntityIntersection(const Ray& ray, const EntityPtr entity, float& dist, uint* submeshIndex)
   {
     bool hit                   = false;
     Ray rayInObjectSpace       = ray;
@@ -357,6 +420,11 @@ namespace ToolKit
       {
         hit = true;
       }
+
+      if (submeshIndex != nullptr)
+      {
+        *submeshIndex = submeshIndx;
+      }
     }
 
     return hit;
@@ -434,11 +502,122 @@ namespace ToolKit
     return transformedPos;
   }
 
+  void GetSkinningMatrices(const Skeleton* skel,
+                           DynamicBoneMapPtr dynamicBoneMap,
+                           bool isAnimated,
+                           Mat4Array& skinningMatrices)
+  {
+    skinningMatrices.resize(skel->m_bones.size());
+    for (size_t i = 0; i < skel->m_bones.size(); i++)
+    {
+      StaticBone* sBone = skel->m_bones[i];
+
+      Mat4 boneTransform;
+      if (isAnimated)
+      {
+        Node* boneNode = dynamicBoneMap->m_boneMap.find(sBone->m_name)->second.node;
+        boneTransform  = boneNode->GetTransform(TransformationSpace::TS_WORLD);
+      }
+      else
+      {
+        Node* boneNode = skel->m_Tpose.m_boneMap.find(sBone->m_name)->second.node;
+        boneTransform  = boneNode->GetTransform();
+      }
+
+      skinningMatrices[i] = boneTransform * sBone->m_inverseWorldMatrix;
+    }
+  }
+
+  /**
+   * Skins the position of the vertex. Matrices of the 4 bones are blended by their weights column by column and the
+   * position is transformed with the blended matrix. Returned w is the sum of the weights.
+   */
+  static inline Float4 SkinPosition(const SkinVertex& vertex, const Mat4* skinningMatrices)
+  {
+    Float4 col0 = Splat4(0.0f);
+    Float4 col1 = col0;
+    Float4 col2 = col0;
+    Float4 col3 = col0;
+
+    for (int boneIndx = 0; boneIndx < 4; boneIndx++)
+    {
+      const float* matrix = &skinningMatrices[(uint) vertex.bones[boneIndx]][0][0];
+      Float4 weight       = Splat4(vertex.weights[boneIndx]);
+
+      col0                = col0 + LoadUnaligned4(matrix) * weight;
+      col1                = col1 + LoadUnaligned4(matrix + 4) * weight;
+      col2                = col2 + LoadUnaligned4(matrix + 8) * weight;
+      col3                = col3 + LoadUnaligned4(matrix + 12) * weight;
+    }
+
+    return col0 * Splat4(vertex.pos.x) + col1 * Splat4(vertex.pos.y) + col2 * Splat4(vertex.pos.z) + col3;
+  }
+
+  void SkinVertices(const SkinVertex* vertices, size_t count, const Mat4Array& skinningMatrices, Vec3* positions)
+  {
+    const Mat4* matrices = skinningMatrices.data();
+    GetWorkerManager()->ParallelFor(count,
+                                    1024,
+                                    [=](size_t beginIndex, size_t endIndex) -> void
+                                    {
+                                      alignas(16) float skinned[4];
+                                      for (size_t i = beginIndex; i < endIndex; i++)
+                                      {
+                                        Store4(skinned, SkinPosition(vertices[i], matrices));
+                                        positions[i] = Vec3(skinned[0], skinned[1], skinned[2]);
+                                      }
+                                    });
+  }
+
+  BoundingBox SkinnedBoundingBox(const SkinVertex* vertices, size_t count, const Mat4Array& skinningMatrices)
+  {
+    const size_t chunkSize  = 1024;
+    const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    const Mat4* matrices    = skinningMatrices.data();
+
+    // Each chunk reduces in to its own bounds, so the workers don't share any writes.
+    std::vector<Float4> chunkMins(chunkCount);
+    std::vector<Float4> chunkMaxs(chunkCount);
+
+    GetWorkerManager()->ParallelFor(chunkCount,
+                                    1,
+                                    [&](size_t beginChunk, size_t endChunk) -> void
+                                    {
+                                      for (size_t chunk = beginChunk; chunk < endChunk; chunk++)
+                                      {
+                                        size_t end    = glm::min((chunk + 1) * chunkSize, count);
+                                        Float4 minPos = Splat4(TK_FLT_MAX);
+                                        Float4 maxPos = Splat4(-TK_FLT_MAX);
+                                        for (size_t i = chunk * chunkSize; i < end; i++)
+                                        {
+                                          Float4 skinned = SkinPosition(vertices[i], matrices);
+                                          minPos         = Min4(minPos, skinned);
+                                          maxPos         = Max4(maxPos, skinned);
+                                        }
+
+                                        chunkMins[chunk] = minPos;
+                                        chunkMaxs[chunk] = maxPos;
+                                      }
+                                    });
+
+    BoundingBox bounds;
+    alignas(16) float minPos[4];
+    alignas(16) float maxPos[4];
+    for (size_t i = 0; i < chunkCount; i++)
+    {
+      Store4(minPos, chunkMins[i]);
+      Store4(maxPos, chunkMaxs[i]);
+      bounds.UpdateBoundary(Vec3(minPos[0], minPos[1], minPos[2]));
+      bounds.UpdateBoundary(Vec3(maxPos[0], maxPos[1], maxPos[2]));
+    }
+
+    return bounds;
+  }
+
   bool RayMeshIntersection(const Mesh* const mesh, const Ray& ray, float& t, const SkeletonComponentPtr skelComp)
   {
-    float closestPickedDistance = TK_FLT_MAX;
-    bool hit                    = false;
-    bool isAnimated             = true;
+    bool hit        = false;
+    bool isAnimated = true;
 
     // Sanitize.
     if (mesh->IsSkinned())
@@ -477,36 +656,37 @@ namespace ToolKit
       }
     }
 
-    std::mutex updateHit;
-    std::for_each(TKExecByConditional(mesh->m_faces.size() > 100, WorkerManager::FramePool),
-                  mesh->m_faces.begin(),
-                  mesh->m_faces.end(),
-                  [&updateHit, &t, &closestPickedDistance, &ray, &hit, skelComp, mesh, &isAnimated](const Face& face)
-                  {
-                    Vec3 positions[3] = {face.vertices[0]->pos, face.vertices[1]->pos, face.vertices[2]->pos};
-                    if (skelComp != nullptr && mesh->IsSkinned())
-                    {
-                      SkinMesh* skinMesh = (SkinMesh*) mesh;
-                      for (uint vertexIndx = 0; vertexIndx < 3; vertexIndx++)
-                      {
-                        positions[vertexIndx] = CPUSkinning((SkinVertex*) face.vertices[vertexIndx],
-                                                            skinMesh->m_skeleton.get(),
-                                                            skelComp->m_map,
-                                                            isAnimated);
-                      }
-                    }
-                    float dist = TK_FLT_MAX;
-                    if (RayTriangleIntersection(ray, positions[0], positions[1], positions[2], dist))
-                    {
-                      std::lock_guard<std::mutex> guard(updateHit);
-                      if (dist < closestPickedDistance && t >= 0.0f)
-                      {
-                        t                     = dist;
-                        closestPickedDistance = dist;
-                        hit                   = true;
-                      }
-                    }
-                  });
+    TriangleBVHPtr bvh = mesh->GetTriangleBVH();
+    float dist         = TK_FLT_MAX;
+
+    if (skelComp != nullptr && mesh->IsSkinned())
+    {
+      // Hierarchy is built in the bind pose and shared by all the entities using the mesh. Only its bounds are
+      // refitted to the pose of this entity, in to the scratch pose of the thread.
+      static thread_local TriangleBVH::Pose skinnedPose;
+      static thread_local Mat4Array skinningMatrices;
+
+      const SkinMesh* skinMesh = static_cast<const SkinMesh*>(mesh);
+      GetSkinningMatrices(skinMesh->m_skeleton.get(), skelComp->m_map, isAnimated, skinningMatrices);
+
+      skinnedPose.positions.resize(skinMesh->m_clientSideVertices.size());
+      SkinVertices(skinMesh->m_clientSideVertices.data(),
+                   skinnedPose.positions.size(),
+                   skinningMatrices,
+                   skinnedPose.positions.data());
+
+      bvh->Refit(skinnedPose);
+      hit = bvh->RayIntersection(ray, skinnedPose, dist);
+    }
+    else
+    {
+      hit = bvh->RayIntersection(ray, dist);
+    }
+
+    if (hit)
+    {
+      t = dist;
+    }
 
     return hit;
   }
@@ -665,6 +845,42 @@ namespace ToolKit
     return FrustumSphereIntersection(frustum, sphere.pos, sphere.radius);
   }
 
+  void FrustumBoxIntersection(const Frustum& frustum, const BoundingBox4& boxes, int& outsideMask, int& insideMask)
+  {
+    Float4 zero     = Splat4(0.0f);
+    Mask4 outside   = zero < zero;
+    Mask4 intersect = outside;
+
+    for (int i = 0; i < 6; i++)
+    {
+      const PlaneEquation& plane = frustum.planes[i];
+
+      // Normal signs are the same for all lanes, so the positive and negative vertices are picked once per plane.
+      bool posX                  = plane.normal.x >= 0;
+      bool posY                  = plane.normal.y >= 0;
+      bool posZ                  = plane.normal.z >= 0;
+
+      Float4 px                  = Load4(posX ? boxes.maxX : boxes.minX);
+      Float4 py                  = Load4(posY ? boxes.maxY : boxes.minY);
+      Float4 pz                  = Load4(posZ ? boxes.maxZ : boxes.minZ);
+
+      Float4 nx                  = Load4(posX ? boxes.minX : boxes.maxX);
+      Float4 ny                  = Load4(posY ? boxes.minY : boxes.maxY);
+      Float4 nz                  = Load4(posZ ? boxes.minZ : boxes.maxZ);
+
+      Float4 a                   = Splat4(plane.normal.x);
+      Float4 b                   = Splat4(plane.normal.y);
+      Float4 c                   = Splat4(plane.normal.z);
+      Float4 d                   = Splat4(plane.d);
+
+      outside                    = outside | (a * px + b * py + c * pz + d < zero);
+      intersect                  = intersect | (a * nx + b * ny + c * nz + d < zero);
+    }
+
+    outsideMask = MoveMask4(outside);
+    insideMask  = ~(outsideMask | MoveMask4(intersect)) & 0xF;
+  }
+
   bool ConePointIntersection(Vec3 conePos, Vec3 coneDir, float coneHeight, float coneAngle, Vec3 point)
   {
     // move cone to backwards
@@ -61,11 +61,34 @@ namespace ToolKit
 
   TK_API IntersectResult BoxBoxIntersection(const BoundingBox& box1, const BoundingBox& box2);
 
+  /**
+   * Tests box1 against 4 boxes at once. Bit i of the masks corresponds to the i'th box in boxes.
+   * @param outsideMask Bits are set for the boxes that are outside of box1.
+   * @param insideMask Bits are set for the boxes that are fully contained by box1.
+   */
+  TK_API void BoxBoxIntersection(const BoundingBox& box1, const BoundingBox4& boxes, int& outsideMask, int& insideMask);
+
   TK_API bool BoxPointIntersection(const BoundingBox& box, const Vec3& point);
 
   TK_API bool RayBoxIntersection(const Ray& ray, const BoundingBox& box, float& t);
 
-  TK_API bool RayEntityIntersection(const Ray& ray, const EntityPtr entity, float& dist);
+  /**
+   * Tests the ray against 4 boxes at once.
+   * @param t Entry distances for each box. Only valid for the boxes that are hit.
+   * @return Mask whose bit i is set if the ray hits the i'th box.
+   */
+  TK_API int RayBoxIntersection(const Ray& ray, const BoundingBox4& boxes, float t[4]);
+
+  /**
+   * Tests the ray against the meshes of the entity.
+   * @param dist Distance to the nearest mesh hit.
+   * @param submeshIndex If given, index of the hit sub mesh is written to it.
+   * @return True if any of the meshes is hit.
+   */
+  TK_API bool RayEntityIntersection(const Ray& ray,
+                                    const EntityPtr entity,
+                                    float& dist,
+                                    uint* submeshIndex = nullptr);
 
   TK_API bool RectPointIntersection(Vec2 rectMin, Vec2 rectMax, Vec2 point);
 
@@ -76,6 +99,37 @@ namespace ToolKit
                           DynamicBoneMapPtr dynamicBoneMap,
                           bool isAnimated);
 
+  /**
+   * Calculates the skinning matrix of each bone of the skeleton, which is the bone transform multiplied with the
+   * inverse bind matrix of the bone. Bone transforms are taken from the dynamic bone map if animated, bind pose
+   * otherwise.
+   */
+  TK_API void GetSkinningMatrices(const Skeleton* skel,
+                                  DynamicBoneMapPtr dynamicBoneMap,
+                                  bool isAnimated,
+                                  Mat4Array& skinningMatrices);
+
+  /**
+   * Skins the positions of the vertices with 4 bones per vertex. Weighted bone matrices are blended with SIMD
+   * instructions, vertices are processed in parallel on the frame workers.
+   * @param vertices are the vertices to skin.
+   * @param count is the number of vertices.
+   * @param skinningMatrices are the matrices calculated by the GetSkinningMatrices.
+   * @param positions is the array of skinned positions, must have room for count positions.
+   */
+  TK_API void SkinVertices(const class SkinVertex* vertices,
+                           size_t count,
+                           const Mat4Array& skinningMatrices,
+                           Vec3* positions);
+
+  /**
+   * Returns the bounding box of the skinned positions of the vertices without storing them. Each chunk of the vertices
+   * reduces its own bounds in parallel, chunk bounds are merged afterwards, so no locks are taken.
+   */
+  TK_API BoundingBox SkinnedBoundingBox(const class SkinVertex* vertices,
+                                        size_t count,
+                                        const Mat4Array& skinningMatrices);
+
   TK_API bool RayMeshIntersection(const class Mesh* const mesh,
                                   const Ray& rayInWorldSpace,
                                   float& t,
@@ -90,6 +144,16 @@ namespace ToolKit
 
   TK_API IntersectResult FrustumBoxIntersection(const Frustum& frustum, const BoundingBox& box);
 
+  /**
+   * Tests the frustum against 4 boxes at once. Bit i of the masks corresponds to the i'th box in boxes.
+   * @param outsideMask Bits are set for the boxes that are outside of the frustum.
+   * @param insideMask Bits are set for the boxes that are fully inside the frustum.
+   */
+  TK_API void FrustumBoxIntersection(const Frustum& frustum,
+                                     const BoundingBox4& boxes,
+                                     int& outsideMask,
+                                     int& insideMask);
+
   TK_API bool ConePointIntersection(Vec3 conePos, Vec3 coneDir, float coneHeight, float coneAngle, Vec3 point);
 
   TK_API bool FrustumConeIntersect(const Frustum& frustum,
@@ -9,6 +9,7 @@
 
 #include "Common/base64.h"
 #include "FileManager.h"
+#include "MappedFile.h"
 #include "Material.h"
 #include "MathUtil.h"
 #include "RHI.h"
@@ -18,8 +19,8 @@
 #include "TKAssert.h"
 #include "TKOpenGL.h"
 #include "Texture.h"
-#include "Threads.h"
 #include "ToolKit.h"
+#include "TriangleBVH.h"
 #include "Util.h"
 
 #include "DebugNew.h"
@@ -93,6 +94,9 @@ namespace ToolKit
 
   TKDefineClass(Mesh, Resource);
 
+  /** Last version given to the data of a mesh. */
+  static std::atomic<uint64> g_meshDataVersion {0};
+
   Mesh::Mesh()
   {
     m_material     = GetMaterialManager()->GetCopyOfDefaultMaterial(false);
@@ -112,6 +116,9 @@ namespace ToolKit
 
     TK_ASSERT_ONCE(!m_clientSideVertices.empty() || m_vertexLayout == VertexLayout::SkinMesh);
 
+    InvalidateTriangleBVH();
+    m_version = ++g_meshDataVersion;
+
     InitVertices(flushClientSideArray);
     SetVertexLayout(m_vertexLayout);
     InitIndices(flushClientSideArray);
@@ -168,14 +175,29 @@ namespace ToolKit
   {
     if (!m_loaded)
     {
-      ParseDocument("meshContainer");
+      LoadFile();
       m_loaded = true;
     }
   }
 
   void Mesh::Save(bool onlyIfDirty)
   {
-    if (onlyIfDirty)
+    if (m_binaryFormat)
+    {
+      if (!onlyIfDirty || m_dirty || m_material->m_dirty)
+      {
+        if (GetFile().empty())
+        {
+          SetFile(CreatePathFromResourceType(m_name + GetExtFromType(Class()), Class()));
+        }
+
+        if (SerializeBinary(GetFile()))
+        {
+          m_dirty = false;
+        }
+      }
+    }
+    else if (onlyIfDirty)
     {
       // if the mesh is dirty, false needs to be send to save always.
       Resource::Save(!m_dirty && !m_material->m_dirty);
@@ -380,6 +402,49 @@ namespace ToolKit
       v.norm = glm::normalize(its * Vec4(v.norm, 1.0f));
       v.btan = glm::normalize(its * Vec4(v.btan, 1.0f));
     }
+
+    InvalidateTriangleBVH();
+    m_version = ++g_meshDataVersion;
+  }
+
+  template <typename T>
+  void BuildTriangleBVHT(const T* mesh, TriangleBVH* bvh)
+  {
+    Vec3Array positions(mesh->m_clientSideVertices.size());
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+      positions[i] = mesh->m_clientSideVertices[i].pos;
+    }
+
+    bvh->Build(positions, mesh->m_clientSideIndices);
+  }
+
+  TriangleBVHPtr Mesh::GetTriangleBVH() const
+  {
+    // Deep ray queries may run on the workers. Each mesh is built once, queries on the other meshes don't wait.
+    LockGuard lock(m_triangleBVHMutex);
+    if (m_triangleBVH == nullptr)
+    {
+      m_triangleBVH = std::make_shared<TriangleBVH>();
+      if (IsSkinned())
+      {
+        BuildTriangleBVHT(static_cast<const SkinMesh*>(this), m_triangleBVH.get());
+      }
+      else
+      {
+        BuildTriangleBVHT(this, m_triangleBVH.get());
+      }
+    }
+
+    return m_triangleBVH;
+  }
+
+  uint64 Mesh::GetVersion() const { return m_version; }
+
+  void Mesh::InvalidateTriangleBVH()
+  {
+    LockGuard lock(m_triangleBVHMutex);
+    m_triangleBVH = nullptr;
   }
 
   void Mesh::SetMaterial(MaterialPtr material)
@@ -584,9 +649,381 @@ namespace ToolKit
       mesh                = nullptr;
     }
 
+    // Sub meshes have their own bounds, main mesh's covers all meshes.
+    for (MeshPtr subMesh : mainMesh->m_subMeshes)
+    {
+      subMesh->CalculateAABB();
+    }
     mainMesh->CalculateAABB();
   }
 
+  // Binary mesh format
+  //////////////////////////////////////////
+
+  /**
+   * Layout of the binary mesh file:
+   * MeshFileHeader, MeshFileEntry for each mesh, resource paths, vertex and index arrays each aligned to
+   * g_meshFileAlignment. Arrays are stored as they are in the memory, little endian.
+   */
+
+  static constexpr char g_meshFileMagic[4]    = {'T', 'K', 'M', 'B'};
+  static constexpr uint32 g_meshFileVersion   = 1;
+  static constexpr uint64 g_meshFileAlignment = 16;
+
+  struct MeshFileHeader
+  {
+    char magic[4];       //!< Always g_meshFileMagic. Xml files can't start with it.
+    uint32 version;      //!< Version of the layout.
+    uint32 vertexLayout; //!< VertexLayout of all the meshes in the file.
+    uint32 meshCount;    //!< Number of the entries that follow the header. First one is the main mesh.
+    float aabbMin[3];    //!< Bounding box of all the meshes.
+    float aabbMax[3];    //!< Bounding box of all the meshes.
+  };
+
+  struct MeshFileEntry
+  {
+    uint64 vertexOffset;   //!< Offset of the vertex array from the start of the file.
+    uint64 indexOffset;    //!< Offset of the index array from the start of the file.
+    uint64 materialOffset; //!< Offset of the material path, not null terminated.
+    uint64 skeletonOffset; //!< Offset of the skeleton path for the skin meshes, not null terminated.
+    uint32 vertexCount;    //!< Number of the vertices.
+    uint32 indexCount;     //!< Number of the indices.
+    uint32 vertexSize;     //!< Size of a vertex in bytes, must match the vertex layout.
+    uint32 materialLength; //!< Length of the material path.
+    uint32 skeletonLength; //!< Length of the skeleton path.
+    uint32 padding;        //!< Keeps the entries 8 byte aligned.
+  };
+
+  static_assert(sizeof(MeshFileHeader) == 40, "Binary mesh header layout changed.");
+  static_assert(sizeof(MeshFileEntry) == 56, "Binary mesh entry layout changed.");
+
+  static inline uint64 AlignMeshFileOffset(uint64 offset)
+  {
+    return (offset + g_meshFileAlignment - 1) & ~(g_meshFileAlignment - 1);
+  }
+
+  template <typename T>
+  bool WriteMeshBinary(const String& file, const T* mainMesh)
+  {
+    typedef std::conditional_t<std::is_same<T, SkinMesh>::value, SkinVertex, Vertex> VertexType;
+
+    MeshRawPtrArray meshes;
+    mainMesh->GetAllMeshes(meshes, true);
+
+    MeshFileHeader header;
+    memcpy(header.magic, g_meshFileMagic, sizeof(g_meshFileMagic));
+    header.version      = g_meshFileVersion;
+    header.vertexLayout = (uint32) mainMesh->m_vertexLayout;
+    header.meshCount    = (uint32) meshes.size();
+
+    // Resource paths are placed right after the table, arrays after the paths.
+    std::vector<MeshFileEntry> entries(meshes.size());
+    StringArray materialPaths(meshes.size());
+    StringArray skeletonPaths(meshes.size());
+
+    BoundingBox aabb;
+    uint64 offset = sizeof(MeshFileHeader) + sizeof(MeshFileEntry) * entries.size();
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+      const T* mesh        = static_cast<const T*>(meshes[i]);
+      MeshFileEntry& entry = entries[i];
+      entry                = {};
+
+      String& materialPath = materialPaths[i];
+      if (mesh->m_material)
+      {
+        materialPath = GetRelativeResourcePath(mesh->m_material->GetSerializeFile());
+      }
+
+      if (materialPath.empty())
+      {
+        materialPath = MaterialPath("default.material", true);
+      }
+      UnixifyPath(materialPath);
+
+      entry.materialOffset  = offset;
+      entry.materialLength  = (uint32) materialPath.size();
+      offset               += materialPath.size();
+
+      if constexpr (std::is_same<T, SkinMesh>::value)
+      {
+        String& skeletonPath = skeletonPaths[i];
+        if (mesh->m_skeleton)
+        {
+          skeletonPath = GetRelativeResourcePath(mesh->m_skeleton->GetSerializeFile());
+          UnixifyPath(skeletonPath);
+        }
+
+        entry.skeletonOffset  = offset;
+        entry.skeletonLength  = (uint32) skeletonPath.size();
+        offset               += skeletonPath.size();
+      }
+
+      for (const VertexType& v : mesh->m_clientSideVertices)
+      {
+        aabb.UpdateBoundary(v.pos);
+      }
+    }
+
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+      const T* mesh        = static_cast<const T*>(meshes[i]);
+      MeshFileEntry& entry = entries[i];
+
+      entry.vertexCount    = (uint32) mesh->m_clientSideVertices.size();
+      entry.vertexSize     = (uint32) sizeof(VertexType);
+      entry.vertexOffset   = AlignMeshFileOffset(offset);
+      offset               = entry.vertexOffset + (uint64) entry.vertexCount * entry.vertexSize;
+
+      entry.indexCount     = (uint32) mesh->m_clientSideIndices.size();
+      entry.indexOffset    = AlignMeshFileOffset(offset);
+      offset               = entry.indexOffset + (uint64) entry.indexCount * sizeof(uint);
+    }
+
+    for (int i = 0; i < 3; i++)
+    {
+      header.aabbMin[i] = aabb.min[i];
+      header.aabbMax[i] = aabb.max[i];
+    }
+
+    std::ofstream stream(file, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open())
+    {
+      TK_ERR("Can't write binary mesh file: %s", file.c_str());
+      return false;
+    }
+
+    // Pads the stream up to the given offset.
+    uint64 written = 0;
+    auto writeFn   = [&](const void* data, uint64 size, uint64 at) -> void
+    {
+      static const char zeros[g_meshFileAlignment] = {};
+      assert(at >= written && at - written < g_meshFileAlignment && "Invalid binary mesh layout.");
+
+      stream.write(zeros, (std::streamsize) (at - written));
+      stream.write(static_cast<const char*>(data), (std::streamsize) size);
+      written = at + size;
+    };
+
+    writeFn(&header, sizeof(MeshFileHeader), 0);
+    writeFn(entries.data(), sizeof(MeshFileEntry) * entries.size(), written);
+
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+      writeFn(materialPaths[i].data(), materialPaths[i].size(), entries[i].materialOffset);
+      writeFn(skeletonPaths[i].data(), skeletonPaths[i].size(), written);
+    }
+
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+      const T* mesh = static_cast<const T*>(meshes[i]);
+      writeFn(mesh->m_clientSideVertices.data(),
+              (uint64) entries[i].vertexCount * entries[i].vertexSize,
+              entries[i].vertexOffset);
+
+      writeFn(mesh->m_clientSideIndices.data(), (uint64) entries[i].indexCount * sizeof(uint), entries[i].indexOffset);
+    }
+
+    return stream.good();
+  }
+
+  template <typename T>
+  bool LoadMeshBinary(const MappedFile& file, T* mainMesh)
+  {
+    typedef std::conditional_t<std::is_same<T, SkinMesh>::value, SkinVertex, Vertex> VertexType;
+
+    const uint8* data = file.Data();
+    const uint64 size = file.Size();
+
+    MeshFileHeader header;
+    memcpy(&header, data, sizeof(MeshFileHeader));
+
+    auto inFileFn = [size](uint64 offset, uint64 length) -> bool { return offset <= size && length <= size - offset; };
+
+    if (header.version != g_meshFileVersion || header.vertexLayout != (uint32) mainMesh->m_vertexLayout ||
+        header.meshCount == 0 || !inFileFn(sizeof(MeshFileHeader), (uint64) header.meshCount * sizeof(MeshFileEntry)))
+    {
+      TK_ERR("Unsupported binary mesh file: %s", mainMesh->GetFile().c_str());
+      return false;
+    }
+
+    const MeshFileEntry* entries = reinterpret_cast<const MeshFileEntry*>(data + sizeof(MeshFileHeader));
+    for (uint32 i = 0; i < header.meshCount; i++)
+    {
+      const MeshFileEntry& entry = entries[i];
+      if (entry.vertexSize != sizeof(VertexType) ||
+          !inFileFn(entry.vertexOffset, (uint64) entry.vertexCount * entry.vertexSize) ||
+          !inFileFn(entry.indexOffset, (uint64) entry.indexCount * sizeof(uint)) ||
+          !inFileFn(entry.materialOffset, entry.materialLength) ||
+          !inFileFn(entry.skeletonOffset, entry.skeletonLength))
+      {
+        TK_ERR("Corrupted binary mesh file: %s", mainMesh->GetFile().c_str());
+        return false;
+      }
+    }
+
+    for (uint32 i = 0; i < header.meshCount; i++)
+    {
+      const MeshFileEntry& entry = entries[i];
+
+      T* mesh = mainMesh;
+      if (i > 0)
+      {
+        std::shared_ptr<T> meshPtr = MakeNewPtr<T>();
+        mesh                       = meshPtr.get();
+        mainMesh->m_subMeshes.push_back(meshPtr);
+      }
+
+      String materialPath((const char*) data + entry.materialOffset, entry.materialLength);
+      NormalizePathInplace(materialPath);
+      mesh->m_material = GetMaterialManager()->Create<Material>(MaterialPath(materialPath));
+
+      if constexpr (std::is_same<T, SkinMesh>())
+      {
+        String skeletonPath((const char*) data + entry.skeletonOffset, entry.skeletonLength);
+        if (skeletonPath.empty())
+        {
+          assert(0 && "SkinMesh has no skeleton!");
+        }
+
+        NormalizePathInplace(skeletonPath);
+        mesh->m_skeleton = GetSkeletonManager()->Create<Skeleton>(SkeletonPath(skeletonPath));
+      }
+
+      // Arrays are aligned in the file, they are copied directly from the mapped memory.
+      const VertexType* vertices = reinterpret_cast<const VertexType*>(data + entry.vertexOffset);
+      mesh->m_clientSideVertices.assign(vertices, vertices + entry.vertexCount);
+
+      const uint* indices = reinterpret_cast<const uint*>(data + entry.indexOffset);
+      mesh->m_clientSideIndices.assign(indices, indices + entry.indexCount);
+
+      mesh->m_loaded      = true;
+      mesh->m_vertexCount = entry.vertexCount;
+      mesh->m_indexCount  = entry.indexCount;
+
+      // Bounds of the sub meshes are their own, bounds of the main mesh covers all meshes and is in the header.
+      if (i > 0)
+      {
+        mesh->m_boundingBox = BoundingBox();
+        for (const VertexType& v : mesh->m_clientSideVertices)
+        {
+          mesh->m_boundingBox.UpdateBoundary(v.pos);
+        }
+      }
+    }
+
+    mainMesh->m_boundingBox = BoundingBox(Vec3(header.aabbMin[0], header.aabbMin[1], header.aabbMin[2]),
+                                          Vec3(header.aabbMax[0], header.aabbMax[1], header.aabbMax[2]));
+
+    // Update the cache of all meshes, which is done by CalculateAABB for the xml files.
+    MeshRawPtrArray meshes;
+    mainMesh->GetAllMeshes(meshes, true);
+
+    return true;
+  }
+
+  void Mesh::LoadFile()
+  {
+    MappedFilePtr file = GetFileManager()->GetMappedFile(GetFile());
+    if (file == nullptr)
+    {
+      // Let the xml loader report the missing file.
+      ParseDocument("meshContainer");
+      return;
+    }
+
+    if (file->Size() >= sizeof(MeshFileHeader) && memcmp(file->Data(), g_meshFileMagic, sizeof(g_meshFileMagic)) == 0)
+    {
+      m_boundingBox  = BoundingBox();
+      m_binaryFormat = true;
+
+      bool loaded    = false;
+      if (IsSkinned())
+      {
+        loaded = LoadMeshBinary(*file, static_cast<SkinMesh*>(this));
+      }
+      else
+      {
+        loaded = LoadMeshBinary(*file, this);
+      }
+
+      // There is no xml to fall back, partially read data is dropped and the mesh is left empty.
+      if (!loaded)
+      {
+        TK_ERR("Mesh is left empty, binary mesh file can't be read: %s", GetFile().c_str());
+
+        m_subMeshes.clear();
+        m_clientSideVertices.clear();
+        m_clientSideIndices.clear();
+        m_vertexCount = 0;
+        m_indexCount  = 0;
+        m_boundingBox = BoundingBox();
+
+        MeshRawPtrArray meshes;
+        GetAllMeshes(meshes, true);
+      }
+
+      return;
+    }
+
+    // Xml is parsed from the already read content.
+    XmlFilePtr xmlFile = MakeNewPtr<XmlFile>((const char*) file->Data(), (uint) file->Size());
+    ParseDocument("meshContainer", false, xmlFile);
+  }
+
+  bool Mesh::SerializeBinary(const String& file) const
+  {
+    if (IsSkinned())
+    {
+      return WriteMeshBinary(file, static_cast<const SkinMesh*>(this));
+    }
+
+    return WriteMeshBinary(file, this);
+  }
+
+  bool Mesh::ReadBinaryReferences(const MappedFile& file, StringArray& references)
+  {
+    const uint8* data = file.Data();
+    const uint64 size = file.Size();
+    if (size < sizeof(MeshFileHeader) || memcmp(data, g_meshFileMagic, sizeof(g_meshFileMagic)) != 0)
+    {
+      return false;
+    }
+
+    MeshFileHeader header;
+    memcpy(&header, data, sizeof(MeshFileHeader));
+
+    auto inFileFn = [size](uint64 offset, uint64 length) -> bool { return offset <= size && length <= size - offset; };
+    if (!inFileFn(sizeof(MeshFileHeader), (uint64) header.meshCount * sizeof(MeshFileEntry)))
+    {
+      return false;
+    }
+
+    const MeshFileEntry* entries = reinterpret_cast<const MeshFileEntry*>(data + sizeof(MeshFileHeader));
+    for (uint32 i = 0; i < header.meshCount; i++)
+    {
+      const MeshFileEntry& entry = entries[i];
+      if (!inFileFn(entry.materialOffset, entry.materialLength) ||
+          !inFileFn(entry.skeletonOffset, entry.skeletonLength))
+      {
+        return false;
+      }
+
+      String materialPath((const char*) data + entry.materialOffset, entry.materialLength);
+      NormalizePathInplace(materialPath);
+      references.push_back(MaterialPath(materialPath));
+
+      if (entry.skeletonLength > 0)
+      {
+        String skeletonPath((const char*) data + entry.skeletonOffset, entry.skeletonLength);
+        NormalizePathInplace(skeletonPath);
+        references.push_back(SkeletonPath(skeletonPath));
+      }
+    }
+
+    return true;
+  }
+
   XmlNode* Mesh::SerializeImp(XmlDocument* doc, XmlNode* parent) const
   {
     XmlNode* container = CreateXmlNode(doc, "meshContainer", parent);
@@ -737,7 +1174,7 @@ namespace ToolKit
       }
     }
 
-    ParseDocument("meshContainer");
+    LoadFile();
     m_loaded = true;
   }
 
@@ -754,43 +1191,25 @@ namespace ToolKit
       return m_bindPoseAABB;
     }
 
+    // Skinning matrices are shared by all the sub meshes.
+    Mat4Array skinningMatrices;
+    GetSkinningMatrices(skel, boneMap, false, skinningMatrices);
+
     BoundingBox finalAABB;
     MeshRawPtrArray meshes;
     GetAllMeshes(meshes);
 
-    std::vector<BoundingBox> AABBs(meshes.size());
-    UIntArray indexes(meshes.size());
-    for (uint i = 0; i < meshes.size(); i++)
+    for (Mesh* mesh : meshes)
     {
-      indexes[i] = i;
-    }
-
-    std::for_each(indexes.begin(),
-                  indexes.end(),
-                  [skel, boneMap, &AABBs, &meshes](uint index)
-                  {
-                    SkinMesh* m = (SkinMesh*) meshes[index];
-                    if (m->m_clientSideVertices.empty())
-                    {
-                      return;
-                    }
-
-                    BoundingBox& meshAABB = AABBs[index];
-                    Spinlock aabbWriteLock;
-
-                    std::for_each(TKExecBy(WorkerManager::FramePool),
-                                  m->m_clientSideVertices.begin(),
-                                  m->m_clientSideVertices.end(),
-                                  [skel, boneMap, &aabbWriteLock, &meshAABB](SkinVertex& v)
-                                  {
-                                    Vec3 skinnedPos = CPUSkinning(&v, skel, boneMap, false);
-                                    SpinlockGuard lock(aabbWriteLock);
-                                    meshAABB.UpdateBoundary(skinnedPos);
-                                  });
-                  });
+      SkinMesh* m = static_cast<SkinMesh*>(mesh);
+      if (m->m_clientSideVertices.empty())
+      {
+        continue;
+      }
 
-    for (BoundingBox& aabb : AABBs)
-    {
+      BoundingBox aabb = SkinnedBoundingBox(m->m_clientSideVertices.data(),
+                                            m->m_clientSideVertices.size(),
+                                            skinningMatrices);
       finalAABB.UpdateBoundary(aabb.max);
       finalAABB.UpdateBoundary(aabb.min);
     }
@@ -212,10 +212,61 @@ namespace ToolKit
      */
     void SetMaterial(MaterialPtr material);
 
+    /**
+     * @brief Returns the triangle hierarchy of the mesh for ray intersection tests.
+     *
+     * Hierarchy is built from the client side arrays at the first call and cached until the mesh is initialized or
+     * transformed again. Skinned meshes are built in the bind pose, refit a TriangleBVH::Pose to the current pose
+     * before use. It is safe to call from multiple threads, the returned hierarchy stays valid after invalidation.
+     *
+     * @return The triangle hierarchy of this mesh, excluding the submeshes.
+     */
+    TriangleBVHPtr GetTriangleBVH() const;
+
+    /**
+     * @brief Returns the version of the mesh data.
+     *
+     * Version changes each time the mesh is initialized or transformed and it is unique across the meshes. Caches that
+     * depend on the vertex data of the mesh compare it to detect the changes.
+     *
+     * @return The version of the vertex and index data, excluding the submeshes.
+     */
+    uint64 GetVersion() const;
+
+    /**
+     * @brief Writes the mesh and its submeshes to a file in the binary mesh format.
+     *
+     * Binary mesh files keep the vertex and index arrays as they are in the memory, so loading them only requires a
+     * copy from the memory mapped file. Material of the mesh is not saved.
+     *
+     * @param file The path of the file to write.
+     * @return True if the file is written.
+     */
+    bool SerializeBinary(const String& file) const;
+
+    /**
+     * @brief Reads the paths of the materials and the skeletons that a binary mesh file references.
+     *
+     * Only the header and the entries are read, the mesh is not loaded. Used for collecting the dependencies of the
+     * resources without loading them.
+     *
+     * @param file The content of the mesh file.
+     * @param references The full paths of the referenced files are appended to it.
+     * @return False if the file is not a binary mesh file.
+     */
+    static bool ReadBinaryReferences(const MappedFile& file, StringArray& references);
+
    protected:
     XmlNode* SerializeImp(XmlDocument* doc, XmlNode* parent) const override;
     XmlNode* DeSerializeImp(const SerializationFileInfo& info, XmlNode* parent) override;
 
+    /**
+     * @brief Reads the mesh file either in the binary or the xml format.
+     *
+     * Binary files are recognized from their header, any other file is parsed as xml.
+     */
+    void LoadFile();
+
     /**
      * @brief Initializes the vertex data.
      * @param flush If true, existing client-side vertex data is flushed.
@@ -234,6 +285,9 @@ namespace ToolKit
      */
     void CopyTo(Resource* other) override;
 
+    /** Drops the cached triangle hierarchy, so that it is built again for the current vertices. */
+    void InvalidateTriangleBVH();
+
    public:
     VertexArray m_clientSideVertices; //!< Array of vertices stored on the client side.
     UIntArray m_clientSideIndices;    //!< Array of indices stored on the client side.
@@ -247,9 +301,13 @@ namespace ToolKit
     BoundingBox m_boundingBox;        //!< Bounding box of the mesh.
     FaceArray m_faces;                //!< Array of faces that make up the mesh.
     VertexLayout m_vertexLayout;      //!< Layout of the vertices.
+    bool m_binaryFormat = false;      //!< Saves the mesh in the binary format. Set when loaded from a binary file.
 
    protected:
-    mutable MeshRawPtrArray m_allMeshes; //!< Cached array of all meshes including submeshes.
+    mutable MeshRawPtrArray m_allMeshes;  //!< Cached array of all meshes including submeshes.
+    mutable TriangleBVHPtr m_triangleBVH; //!< Lazily built triangle hierarchy for ray intersection tests.
+    mutable Mutex m_triangleBVHMutex;     //!< Guards the construction and the reset of the triangle hierarchy.
+    uint64 m_version = 0;                 //!< Version of the vertex and index data.
   };
 
   /**
@@ -72,4 +72,15 @@ namespace ToolKit
     CastShadow_Define(true, MeshComponentCategory.Name, MeshComponentCategory.Priority, true, true);
   }
 
+  void MeshComponent::ParameterEventConstructor()
+  {
+    Super::ParameterEventConstructor();
+
+    // Retained render jobs refer to the mesh and the shadow casting state.
+    auto invalidateFn = [this](Value& oldVal, Value& newVal) -> void { InvalidateRenderProxy(); };
+
+    ParamMesh().m_onValueChangedFn.push_back(invalidateFn);
+    ParamCastShadow().m_onValueChangedFn.push_back(invalidateFn);
+  }
+
 } // namespace ToolKit
\ No newline at end of file
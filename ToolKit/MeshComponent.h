@@ -56,6 +56,7 @@ namespace ToolKit
    protected:
     XmlNode* SerializeImp(XmlDocument* doc, XmlNode* parent) const override;
     void ParameterConstructor() override;
+    void ParameterEventConstructor() override;
 
    public:
     TKDeclareParam(MeshPtr, Mesh); //!< Component's Mesh resource.
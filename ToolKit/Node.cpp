@@ -10,6 +10,7 @@
 #include "MathUtil.h"
 #include "Scene.h"
 #include "ToolKit.h"
+#include "TransformSystem.h"
 #include "Util.h"
 
 #include "DebugNew.h"
@@ -27,6 +28,11 @@ namespace ToolKit
 
   Node::~Node()
   {
+    if (m_transformSystem != nullptr)
+    {
+      m_transformSystem->Remove(this);
+    }
+
     OrphanSelf(true);
     for (int i = (int) m_children.size() - 1; i >= 0; i--)
     {
@@ -185,6 +191,7 @@ namespace ToolKit
     child->m_parent = this;
     child->m_dirty  = true;
     child->SetChildrenDirty();
+    SetHierarchyDirty(child);
 
     if (preserveTransform)
     {
@@ -221,6 +228,7 @@ namespace ToolKit
     child->m_dirty  = true;
     child->SetChildrenDirty();
     m_children.erase(m_children.begin() + index);
+    SetHierarchyDirty(child);
 
     if (preserveTransform)
     {
@@ -334,7 +342,39 @@ namespace ToolKit
 
   XmlNode* Node::DeSerializeImp(const SerializationFileInfo& info, XmlNode* parent)
   {
-    XmlNode* node = parent;
+    XmlNode* node       = parent;
+
+    uint64 binaryOffset = 0;
+    if (info.Binary != nullptr)
+    {
+      ReadAttr(node, XmlBinaryOffsetAttr.data(), binaryOffset);
+    }
+
+    if (binaryOffset != 0)
+    {
+      BinaryReader reader(*info.Binary, binaryOffset);
+
+      uint8 inheritScale = 0;
+      reader.Read(inheritScale);
+      reader.Read(m_translation);
+      reader.Read(m_orientation);
+      reader.Read(m_scale);
+
+      if (reader.Failed())
+      {
+        TK_ERR("Corrupt binary transform in %s", info.File.c_str());
+        if (info.Corrupt != nullptr)
+        {
+          *info.Corrupt = true;
+        }
+      }
+
+      m_inheritScale = inheritScale != 0;
+      UpdateTransformCaches();
+
+      return nullptr;
+    }
+
     if (XmlAttribute* attr = node->first_attribute(XmlNodeInheritScaleAttr.c_str()))
     {
       String val     = attr->value();
@@ -361,10 +401,23 @@ namespace ToolKit
     return nullptr;
   }
 
+  void Node::SerializeBinary(BinaryWriter& writer) const
+  {
+    writer.Write((uint8) m_inheritScale);
+    writer.Write(m_translation);
+    writer.Write(m_orientation);
+    writer.Write(m_scale);
+  }
+
   void Node::SetInheritScaleDeep(bool val)
   {
     m_inheritScale = val;
     m_dirty        = true;
+    if (m_transformSystem != nullptr)
+    {
+      m_transformSystem->MarkDirty(m_transformIndex);
+    }
+
     for (Node* n : m_children)
     {
       n->SetInheritScaleDeep(val);
@@ -425,7 +478,7 @@ namespace ToolKit
                              Quaternion* orientation,
                              Vec3* scale)
   {
-    if (m_dirty)
+    if (m_transformSystem == nullptr && m_dirty)
     {
       // This will recursively climb up in the hierarchy until it finds a clear node or clears all the tree.
       UpdateTransformCaches();
@@ -434,7 +487,12 @@ namespace ToolKit
     switch (space)
     {
     case TransformationSpace::TS_WORLD:
-      if (m_parent != nullptr)
+      if (m_parent != nullptr && m_transformSystem != nullptr)
+      {
+        m_transformSystem->GetWorldTransform(this, transform, translation, orientation);
+        break;
+      }
+      else if (m_parent != nullptr)
       {
         if (transform != nullptr)
         {
@@ -481,6 +539,14 @@ namespace ToolKit
     Mat4 ts      = glm::translate(m_translation);
     m_localCache = ts * rt * scl;
 
+    // World and spatial caches are updated in batch by the transform system. Queries that read the spatial caches
+    // update the system first.
+    if (m_transformSystem != nullptr)
+    {
+      m_transformSystem->SetLocalTransform(m_transformIndex, m_localCache);
+      return;
+    }
+
     // Let all children know they need to update their parent caches.
     SetChildrenDirty();
 
@@ -499,7 +565,7 @@ namespace ToolKit
     Mat4 ps;
     if (m_parent != nullptr)
     {
-      if (!m_dirty)
+      if (!m_dirty && m_transformSystem == nullptr)
       {
         return m_parentCache;
       }
@@ -509,11 +575,7 @@ namespace ToolKit
 
       if (!m_inheritScale)
       {
-        for (int i = 0; i < 3; i++)
-        {
-          Vec3 v = ps[i];
-          ps[i]  = Vec4(glm::normalize(v), ps[i].w);
-        }
+        RemoveScale(ps);
       }
 
       m_parentCache = ps;
@@ -523,10 +585,39 @@ namespace ToolKit
     return ps;
   }
 
+  void Node::RemoveScale(Mat4& transform)
+  {
+    for (int i = 0; i < 3; i++)
+    {
+      Vec3 v       = transform[i];
+      transform[i] = Vec4(glm::normalize(v), transform[i].w);
+    }
+  }
+
+  void Node::SetHierarchyDirty(Node* child)
+  {
+    if (m_transformSystem != nullptr)
+    {
+      m_transformSystem->MarkHierarchyDirty();
+    }
+
+    if (child->m_transformSystem != nullptr && child->m_transformSystem != m_transformSystem)
+    {
+      child->m_transformSystem->MarkHierarchyDirty();
+    }
+  }
+
   void Node::SetChildrenDirty()
   {
     for (Node* c : m_children)
     {
+      // Registered children pass the change to their descendants in the transform system's update.
+      if (c->m_transformSystem != nullptr)
+      {
+        c->m_transformSystem->MarkDirty(c->m_transformIndex);
+        continue;
+      }
+
       c->m_dirty = true;
       c->SetChildrenDirty();
     }
@@ -540,13 +631,23 @@ namespace ToolKit
 
       for (Node* node : m_children)
       {
-        node->InvalitadeSpatialCaches();
+        if (node->m_transformSystem == nullptr)
+        {
+          node->InvalitadeSpatialCaches();
+        }
       }
     }
   }
 
   Quaternion Node::GetWorldOrientationCache()
   {
+    if (m_transformSystem != nullptr)
+    {
+      Quaternion orientation;
+      m_transformSystem->GetWorldTransform(this, nullptr, nullptr, &orientation);
+      return orientation;
+    }
+
     if (m_dirty)
     {
       UpdateTransformCaches();
@@ -557,6 +658,13 @@ namespace ToolKit
 
   Mat4 Node::GetWorldCache()
   {
+    if (m_transformSystem != nullptr)
+    {
+      Mat4 transform;
+      m_transformSystem->GetWorldTransform(this, &transform, nullptr, nullptr);
+      return transform;
+    }
+
     if (m_dirty)
     {
       UpdateTransformCaches();
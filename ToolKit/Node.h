@@ -15,6 +15,8 @@
 
 namespace ToolKit
 {
+  class TransformSystem;
+
   /**
    * Transformation space.
    */
@@ -30,6 +32,8 @@ namespace ToolKit
    */
   class TK_API Node : public Serializable
   {
+    friend class TransformSystem;
+
    public:
     Node();
     ~Node();
@@ -211,9 +215,15 @@ namespace ToolKit
     /** Odd number of negative values in scale requires back / front culling to be flipped for proper winding order. */
     bool RequireCullFlip();
 
+    /** Returns the transform system that updates the world transform of the node, or null if node updates itself. */
+    TransformSystem* GetTransformSystem() const { return m_transformSystem; }
+
     XmlNode* SerializeImp(XmlDocument* doc, XmlNode* parent) const;
     XmlNode* DeSerializeImp(const SerializationFileInfo& info, XmlNode* parent);
 
+    /** Writes the local transform in binary, which is read back by DeSerializeImp if the element refers to it. */
+    void SerializeBinary(BinaryWriter& writer) const;
+
    private:
     void TransformImp(const Mat4& val,
                       TransformationSpace space,
@@ -235,6 +245,8 @@ namespace ToolKit
 
     void UpdateTransformCaches();
     Mat4 GetParentTransform();
+    static void RemoveScale(Mat4& transform);
+    void SetHierarchyDirty(Node* child);
     void SetChildrenDirty();
     void InvalitadeSpatialCaches();
     Quaternion GetWorldOrientationCache();
@@ -263,7 +275,9 @@ namespace ToolKit
     /** World orientation cache. Never access directly. It may be dirty. */
     Quaternion m_worldOrientationCache;
 
-    bool m_dirty; //!< Hint for child to update its parent cache.
+    bool m_dirty;                                 //!< Hint for child to update its parent cache.
+    TransformSystem* m_transformSystem = nullptr; //!< System that updates the world caches, if registered.
+    int m_transformIndex               = -1;      //!< Index of the node in the transform system.
   };
 
   /**
@@ -67,7 +67,12 @@ namespace ToolKit
     GetHandleManager()->ReleaseHandle(id);
     m_localData.m_version = m_version;
     m_localData.DeSerialize(info, parent);
-    PreventIdCollision();
+
+    // Objects that are read in parallel claim their ids afterwards, in file order.
+    if (!info.DeferIdCollision)
+    {
+      PreventIdCollision();
+    }
 
     // Construction progress from bottom up.
     return parent;
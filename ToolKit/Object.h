@@ -187,14 +187,14 @@ namespace ToolKit
     void PreDeserializeImp(const SerializationFileInfo& info, XmlNode* parent) override;
     void PostDeSerializeImp(const SerializationFileInfo& info, XmlNode* parent) override;
 
+   public:
     /**
      * Utility function that checks if the current id is colliding with anything currently in the handle manager.
      * If a collision happens, it sets _idBeforeCollision with the colliding id to resolve parent - child relations
-     * and assigns a new non colliding id.
+     * and assigns a new non colliding id. Called by the deserialization unless the collisions are deferred.
      */
     void PreventIdCollision();
 
-   public:
     TKDeclareParam(ObjectId, Id);
 
     /**
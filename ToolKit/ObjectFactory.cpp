@@ -78,6 +78,33 @@ namespace ToolKit
     }
   }
 
+  void ObjectFactory::AssignComponentIndex(ClassMeta* Class)
+  {
+    // Overridden classes are registered again, they keep their index.
+    if (Class->ComponentIndex != -1 || !Class->IsSublcassOf(Component::StaticClass()))
+    {
+      return;
+    }
+
+    // Hash is derived from the class name, a reloaded class has the same hash with a new class meta.
+    auto indexItr = m_componentIndices.find(Class->HashId);
+    if (indexItr != m_componentIndices.end())
+    {
+      Class->ComponentIndex = indexItr->second;
+      return;
+    }
+
+    if ((int) m_componentIndices.size() >= TKMaxComponentClasses)
+    {
+      TK_ERR("Maximum number of component classes is exceeded by %s.", Class->Name.c_str());
+      assert(false && "Maximum number of component classes is exceeded.");
+      return;
+    }
+
+    Class->ComponentIndex = (int) m_componentIndices.size();
+    m_componentIndices.insert({Class->HashId, Class->ComponentIndex});
+  }
+
   ObjectFactory::ObjectConstructorCallback& ObjectFactory::GetConstructorFn(const StringView Class)
   {
     auto constructorFnIt = m_constructorFnMap.find(Class);
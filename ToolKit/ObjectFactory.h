@@ -94,6 +94,7 @@ namespace ToolKit
 
       objectClass->SuperClassLookUp.clear();
       ClassLookUpBuilder(objectClass, objectClass);
+      AssignComponentIndex(objectClass);
 
       CallMetaProcessors(objectClass->MetaKeys, m_metaProcessorRegisterMap);
     }
@@ -105,6 +106,8 @@ namespace ToolKit
       m_constructorFnMap.erase(objectClass->Name);
       m_allRegisteredClasses.erase(objectClass->HashId);
 
+      // Component index stays reserved for the class, bits of the entity and archetype masks keep their meaning.
+
       CallMetaProcessors(objectClass->MetaKeys, m_metaProcessorUnRegisterMap);
     }
 
@@ -174,6 +177,12 @@ namespace ToolKit
      */
     void ClassLookUpBuilder(ClassMeta* Class, ClassMeta* FirstClass);
 
+    /**
+     * Assigns a component index to the class if it is a component class that doesn't have one. A class that is
+     * registered before, such as the ones of a reloaded plugin, gets its previous index. Others get the next index.
+     */
+    void AssignComponentIndex(ClassMeta* Class);
+
    public:
     /**
      * Each MetaKey has a corresponding meta processor. When a class registered and it has a MetaKey that corresponds to
@@ -191,6 +200,7 @@ namespace ToolKit
     std::unordered_map<StringView, ObjectConstructorCallback> m_constructorFnMap;
     ObjectConstructorCallback m_nullFn = nullptr;
     std::unordered_map<ObjectId, ClassMeta*> m_allRegisteredClasses;
+    std::unordered_map<ObjectId, int> m_componentIndices; //!< Index of each component class, keyed by the class hash.
   };
 
   template <typename T, typename... Args>
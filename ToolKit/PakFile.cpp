@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#include "PakFile.h"
+
+#include "Logger.h"
+#include "MappedFile.h"
+#include "Util.h"
+
+#include <unzip.h>
+
+#include "DebugNew.h"
+
+namespace ToolKit
+{
+
+  // Zip record signatures and sizes.
+  constexpr uint32 g_zipEndOfDirSignature      = 0x06054b50;
+  constexpr uint32 g_zip64EndOfDirSignature    = 0x06064b50;
+  constexpr uint32 g_zip64EndOfDirLocSignature = 0x07064b50;
+  constexpr uint32 g_zipDirRecordSignature     = 0x02014b50;
+  constexpr uint32 g_zipLocalHeaderSignature   = 0x04034b50;
+  constexpr uint64 g_zipEndOfDirSize           = 22;
+  constexpr uint64 g_zip64EndOfDirSize         = 56;
+  constexpr uint64 g_zip64EndOfDirLocSize      = 20;
+  constexpr uint64 g_zipDirRecordSize          = 46;
+  constexpr uint64 g_zipLocalHeaderSize        = 30;
+  constexpr uint64 g_zipMaxCommentSize         = 0xFFFF;
+  constexpr uint16 g_zip64ExtraFieldId         = 0x0001;
+
+  /** Reads a little endian value from an unaligned position. */
+  template <typename T>
+  static inline T ReadZipValue(const uint8* data)
+  {
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return value;
+  }
+
+  PakFile::PakFile() {}
+
+  PakFile::~PakFile() { Close(); }
+
+  bool PakFile::Open(const String& path)
+  {
+    Close();
+
+    m_file = std::make_shared<MappedFile>();
+    if (!m_file->Open(path))
+    {
+      m_file = nullptr;
+      return false;
+    }
+
+    m_path = path;
+    if (!ReadDirectory())
+    {
+      TK_ERR("Pak file is not a valid zip archive: %s", path.c_str());
+      Close();
+      return false;
+    }
+
+    return true;
+  }
+
+  void PakFile::Close()
+  {
+    LockGuard lock(m_handleMutex);
+    for (ZipFile handle : m_handles)
+    {
+      unzClose(handle);
+    }
+    m_handles.clear();
+
+    m_entries.clear();
+    m_file = nullptr;
+    m_path.clear();
+  }
+
+  bool PakFile::IsOpen() const { return m_file != nullptr; }
+
+  bool PakFile::Contains(const String& name) const { return m_entries.find(name) != m_entries.end(); }
+
+  MappedFilePtr PakFile::Read(const String& name)
+  {
+    auto entryItr = m_entries.find(name);
+    if (entryItr == m_entries.end())
+    {
+      return nullptr;
+    }
+
+    const Entry& entry = entryItr->second;
+    if (entry.method == 0)
+    {
+      // Stored entries are the views of the mapped pak.
+      MappedFilePtr file = std::make_shared<MappedFile>();
+      file->View(m_file, entry.dataOffset, entry.size);
+      return file;
+    }
+
+    return Decompress(entry);
+  }
+
+  bool PakFile::ReadDirectory()
+  {
+    const uint8* data = m_file->Data();
+    const uint64 size = m_file->Size();
+    if (size < g_zipEndOfDirSize)
+    {
+      return false;
+    }
+
+    // End of central directory record is at the end of the file, followed by a comment of variable length.
+    uint64 endOfDir  = size - g_zipEndOfDirSize;
+    uint64 searchEnd = endOfDir > g_zipMaxCommentSize ? endOfDir - g_zipMaxCommentSize : 0;
+    while (ReadZipValue<uint32>(data + endOfDir) != g_zipEndOfDirSignature)
+    {
+      if (endOfDir == searchEnd)
+      {
+        return false;
+      }
+      endOfDir--;
+    }
+
+    uint64 entryCount = ReadZipValue<uint16>(data + endOfDir + 10);
+    uint64 dirSize    = ReadZipValue<uint32>(data + endOfDir + 12);
+    uint64 dirOffset  = ReadZipValue<uint32>(data + endOfDir + 16);
+
+    // Large archives store the directory location in the zip64 record.
+    if (endOfDir >= g_zip64EndOfDirLocSize &&
+        ReadZipValue<uint32>(data + endOfDir - g_zip64EndOfDirLocSize) == g_zip64EndOfDirLocSignature)
+    {
+      uint64 zip64EndOfDir = ReadZipValue<uint64>(data + endOfDir - g_zip64EndOfDirLocSize + 8);
+      if (zip64EndOfDir + g_zip64EndOfDirSize > size ||
+          ReadZipValue<uint32>(data + zip64EndOfDir) != g_zip64EndOfDirSignature)
+      {
+        return false;
+      }
+
+      entryCount = ReadZipValue<uint64>(data + zip64EndOfDir + 32);
+      dirSize    = ReadZipValue<uint64>(data + zip64EndOfDir + 40);
+      dirOffset  = ReadZipValue<uint64>(data + zip64EndOfDir + 48);
+    }
+
+    if (dirOffset + dirSize > size)
+    {
+      return false;
+    }
+
+    m_entries.reserve(entryCount);
+
+    uint64 record = dirOffset;
+    for (uint64 i = 0; i < entryCount; i++)
+    {
+      if (record + g_zipDirRecordSize > dirOffset + dirSize ||
+          ReadZipValue<uint32>(data + record) != g_zipDirRecordSignature)
+      {
+        return false;
+      }
+
+      Entry entry;
+      entry.recordOffset   = record;
+      entry.method         = ReadZipValue<uint16>(data + record + 10);
+      entry.compressedSize = ReadZipValue<uint32>(data + record + 20);
+      entry.size           = ReadZipValue<uint32>(data + record + 24);
+      uint16 nameLength    = ReadZipValue<uint16>(data + record + 28);
+      uint16 extraLength   = ReadZipValue<uint16>(data + record + 30);
+      uint16 commentLength = ReadZipValue<uint16>(data + record + 32);
+      uint64 localHeader   = ReadZipValue<uint32>(data + record + 42);
+
+      const uint8* name    = data + record + g_zipDirRecordSize;
+      const uint8* extra   = name + nameLength;
+      uint64 next          = record + g_zipDirRecordSize + nameLength + extraLength + commentLength;
+      if (next > dirOffset + dirSize)
+      {
+        return false;
+      }
+
+      // Sizes that don't fit in 32 bits are in the zip64 extra field, in the order of size, compressed size, offset.
+      for (uint32 field = 0; field + 4 <= extraLength;)
+      {
+        uint16 fieldId     = ReadZipValue<uint16>(extra + field);
+        uint16 fieldLength = ReadZipValue<uint16>(extra + field + 2);
+        if (fieldId == g_zip64ExtraFieldId)
+        {
+          const uint8* value    = extra + field + 4;
+          const uint8* valueEnd = value + fieldLength;
+          if (entry.size == 0xFFFFFFFF && value + 8 <= valueEnd)
+          {
+            entry.size  = ReadZipValue<uint64>(value);
+            value      += 8;
+          }
+          if (entry.compressedSize == 0xFFFFFFFF && value + 8 <= valueEnd)
+          {
+            entry.compressedSize  = ReadZipValue<uint64>(value);
+            value                += 8;
+          }
+          if (localHeader == 0xFFFFFFFF && value + 8 <= valueEnd)
+          {
+            localHeader = ReadZipValue<uint64>(value);
+          }
+          break;
+        }
+
+        field += 4 + fieldLength;
+      }
+
+      // Data follows the local header, whose extra field may differ from the directory record's.
+      if (localHeader + g_zipLocalHeaderSize > size ||
+          ReadZipValue<uint32>(data + localHeader) != g_zipLocalHeaderSignature)
+      {
+        return false;
+      }
+
+      uint16 localNameLength  = ReadZipValue<uint16>(data + localHeader + 26);
+      uint16 localExtraLength = ReadZipValue<uint16>(data + localHeader + 28);
+      entry.dataOffset        = localHeader + g_zipLocalHeaderSize + localNameLength + localExtraLength;
+      if (entry.dataOffset + entry.compressedSize > size || (entry.method == 0 && entry.compressedSize != entry.size))
+      {
+        return false;
+      }
+
+      String entryName((const char*) name, nameLength);
+      UnixifyPath(entryName);
+      m_entries[entryName] = entry;
+
+      record               = next;
+    }
+
+    return true;
+  }
+
+  MappedFilePtr PakFile::Decompress(const Entry& entry)
+  {
+    ZipFile handle = AcquireHandle();
+    if (handle == nullptr)
+    {
+      return nullptr;
+    }
+
+    MappedFilePtr file = nullptr;
+
+    // Unzip addresses the entries with the positions of their central directory records.
+    if (unzSetOffset64(handle, entry.recordOffset) == UNZ_OK && unzOpenCurrentFile(handle) == UNZ_OK)
+    {
+      uint8* buffer = new uint8[entry.size];
+      int readBytes = unzReadCurrentFile(handle, buffer, (uint) entry.size);
+      unzCloseCurrentFile(handle);
+
+      if (readBytes >= 0 && (uint64) readBytes == entry.size)
+      {
+        file = std::make_shared<MappedFile>();
+        file->Adopt(buffer, entry.size);
+      }
+      else
+      {
+        SafeDelArray(buffer);
+      }
+    }
+
+    ReleaseHandle(handle);
+
+    if (file == nullptr)
+    {
+      GetLogger()->Log("Error reading compressed file at: " + std::to_string(entry.recordOffset));
+    }
+
+    return file;
+  }
+
+  ZipFile PakFile::AcquireHandle()
+  {
+    {
+      LockGuard lock(m_handleMutex);
+      if (!m_handles.empty())
+      {
+        ZipFile handle = m_handles.back();
+        m_handles.pop_back();
+        return handle;
+      }
+    }
+
+    // Each concurrent reader opens its own handle, they are pooled afterwards.
+    return unzOpen64(m_path.c_str());
+  }
+
+  void PakFile::ReleaseHandle(ZipFile handle)
+  {
+    LockGuard lock(m_handleMutex);
+    m_handles.push_back(handle);
+  }
+
+} // namespace ToolKit
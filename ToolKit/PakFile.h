@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#pragma once
+
+/**
+ * @file Reader for the pak files. Pak is memory mapped and its zip directory is parsed once, entries can be read from
+ * multiple threads at the same time.
+ */
+
+#include "Types.h"
+
+namespace ToolKit
+{
+
+  /**
+   * Read only access to the entries of a zip archive. Stored entries are served directly from the mapped pak without
+   * copying. Compressed entries are decompressed by a pool of unzip handles, so each concurrent reader has its own
+   * decompression state.
+   */
+  class TK_API PakFile
+  {
+   public:
+    PakFile();
+    ~PakFile(); //!< Closes the pak.
+
+    PakFile(const PakFile&)            = delete;
+    PakFile& operator=(const PakFile&) = delete;
+
+    /**
+     * Maps the pak and reads its directory.
+     * @return False if the file can't be opened or it is not a valid zip archive.
+     */
+    bool Open(const String& path);
+
+    /** Closes the pak and all the unzip handles. Files that are read from the pak stay valid. */
+    void Close();
+
+    /** Returns true if a pak is opened. */
+    bool IsOpen() const;
+
+    /** Returns true if the pak contains the entry. Entry names are relative to the Resources folder. */
+    bool Contains(const String& name) const;
+
+    /**
+     * Reads an entry. Thread safe.
+     * @return Content of the entry or null if the entry is not found or can't be decompressed.
+     */
+    MappedFilePtr Read(const String& name);
+
+   private:
+    /** Location of an entry in the pak. */
+    struct Entry
+    {
+      uint64 recordOffset;   //!< Position of the entry's central directory record. Used as the unzip offset.
+      uint64 dataOffset;     //!< Position of the entry's data.
+      uint64 compressedSize; //!< Size of the entry's data in the pak.
+      uint64 size;           //!< Size of the entry's content.
+      uint16 method;         //!< Compression method, 0 for stored entries.
+    };
+
+    bool ReadDirectory();
+    MappedFilePtr Decompress(const Entry& entry);
+
+    ZipFile AcquireHandle();
+    void ReleaseHandle(ZipFile handle);
+
+   private:
+    String m_path;                               //!< Path of the opened pak.
+    MappedFilePtr m_file;                        //!< Mapped content of the pak.
+    std::unordered_map<String, Entry> m_entries; //!< Entries by their unixified names.
+    std::vector<ZipFile> m_handles;              //!< Unzip handles that are not in use.
+    Mutex m_handleMutex;                         //!< Guards the handle pool.
+  };
+
+} // namespace ToolKit
@@ -18,6 +18,90 @@
 namespace ToolKit
 {
 
+  /** Creates the resource that the variant refers to from its file. Empty file creates an empty resource. */
+  static void SetResourceVal(ParameterVariant& var, const String& file)
+  {
+    switch (var.GetType())
+    {
+    case ParameterVariant::VariantType::MeshPtr:
+    {
+      if (file.empty())
+      {
+        var = MakeNewPtr<Mesh>();
+      }
+      else
+      {
+        String path = MeshPath(file);
+        String ext;
+        DecomposePath(path, nullptr, nullptr, &ext);
+        if (ext == SKINMESH)
+        {
+          var = GetMeshManager()->Create<SkinMesh>(path);
+        }
+        else
+        {
+          var = GetMeshManager()->Create<Mesh>(path);
+        }
+      }
+    }
+    break;
+    case ParameterVariant::VariantType::TexturePtr:
+      var = file.empty() ? TexturePtr() : GetTextureManager()->Create<Texture>(TexturePath(file));
+      break;
+    case ParameterVariant::VariantType::ShaderPtr:
+      var = file.empty() ? ShaderPtr() : GetShaderManager()->Create<Shader>(ShaderPath(file));
+      break;
+    case ParameterVariant::VariantType::MaterialPtr:
+      var = file.empty() ? MakeNewPtr<Material>() : GetMaterialManager()->Create<Material>(MaterialPath(file));
+      break;
+    case ParameterVariant::VariantType::HdriPtr:
+      var = file.empty() ? MakeNewPtr<Hdri>() : GetTextureManager()->Create<Hdri>(TexturePath(file));
+      break;
+    case ParameterVariant::VariantType::SkeletonPtr:
+      var = file.empty() ? MakeNewPtr<Skeleton>() : GetSkeletonManager()->Create<Skeleton>(SkeletonPath(file));
+      break;
+    default:
+      assert(false && "Variant is not a resource.");
+      break;
+    }
+  }
+
+  /**
+   * Sets the texture that the variant refers to if it is loaded already. Otherwise requests it on the background and
+   * leaves the variant empty until the owner sets it from the appended request.
+   */
+  static void StreamTextureVal(ParameterVariant& var, const String& file, StreamedResourceArray& requests)
+  {
+    var = TexturePtr();
+    if (file.empty())
+    {
+      return;
+    }
+
+    // Priority is lowered by the renderer once the distance to the camera is known.
+    ResourceHandle<Texture> handle = GetTextureManager()->CreateAsync<Texture>(TexturePath(file), TK_FLT_MAX);
+    if (handle.IsReady())
+    {
+      var = handle.Get();
+    }
+    else
+    {
+      requests.push_back({var.m_name, handle.GetRequest()});
+    }
+  }
+
+  /** Adds a record to the list that plays the animation file on the signal. */
+  static void AddAnimRecord(AnimRecordPtrMap& list, const String& signalName, const String& file)
+  {
+    AnimRecordPtr record = MakeNewPtr<AnimRecord>();
+    if (!file.empty())
+    {
+      record->m_animation = GetAnimationManager()->Create<Animation>(AnimationPath(file));
+    }
+
+    list.insert(std::make_pair(signalName, record));
+  }
+
   ParameterVariant::ParameterVariant() { *this = 0; }
 
   ParameterVariant::~ParameterVariant() {}
@@ -501,7 +585,7 @@ namespace ToolKit
     ReadAttr(parent, XmlNodeName.data(), m_name);
 
     std::function<void(XmlNode*, ParameterVariant*)> deserializeDataFn;
-    deserializeDataFn = [&deserializeDataFn](XmlNode* parent, ParameterVariant* pVar)
+    deserializeDataFn = [&deserializeDataFn, &info](XmlNode* parent, ParameterVariant* pVar)
     {
       switch (pVar->GetType())
       {
@@ -610,85 +694,23 @@ namespace ToolKit
         pVar->m_var = val;
       }
       break;
-      case VariantType::MeshPtr:
-      {
-        String file = Resource::DeserializeRef(parent);
-        if (file.empty())
-        {
-          pVar->m_var = MakeNewPtr<Mesh>();
-        }
-        else
-        {
-          file = MeshPath(file);
-          String ext;
-          DecomposePath(file, nullptr, nullptr, &ext);
-          if (ext == SKINMESH)
-          {
-            pVar->m_var = GetMeshManager()->Create<SkinMesh>(file);
-          }
-          else
-          {
-            pVar->m_var = GetMeshManager()->Create<Mesh>(file);
-          }
-        }
-      }
-      break;
       case VariantType::TexturePtr:
-      {
-        String file = Resource::DeserializeRef(parent);
-        if (file.empty())
+        if (info.StreamedTextures != nullptr)
         {
-          pVar->m_var = TexturePtr();
+          StreamTextureVal(*pVar, Resource::DeserializeRef(parent), *info.StreamedTextures);
         }
         else
         {
-          file        = TexturePath(file);
-          pVar->m_var = GetTextureManager()->Create<Texture>(file);
+          SetResourceVal(*pVar, Resource::DeserializeRef(parent));
         }
-      }
-      break;
+        break;
+      case VariantType::MeshPtr:
       case VariantType::ShaderPtr:
-      {
-        String file = Resource::DeserializeRef(parent);
-        if (file.empty())
-        {
-          pVar->m_var = ShaderPtr();
-        }
-        else
-        {
-          file        = ShaderPath(file);
-          pVar->m_var = GetShaderManager()->Create<Shader>(file);
-        }
-      }
-      break;
       case VariantType::MaterialPtr:
-      {
-        String file = Resource::DeserializeRef(parent);
-        if (file.empty())
-        {
-          pVar->m_var = MakeNewPtr<Material>();
-        }
-        else
-        {
-          file        = MaterialPath(file);
-          pVar->m_var = GetMaterialManager()->Create<Material>(file);
-        }
-      }
-      break;
       case VariantType::HdriPtr:
-      {
-        String file = Resource::DeserializeRef(parent);
-        if (file.empty())
-        {
-          pVar->m_var = MakeNewPtr<Hdri>();
-        }
-        else
-        {
-          file        = TexturePath(file);
-          pVar->m_var = GetTextureManager()->Create<Hdri>(file);
-        }
-      }
-      break;
+      case VariantType::SkeletonPtr:
+        SetResourceVal(*pVar, Resource::DeserializeRef(parent));
+        break;
       case VariantType::AnimRecordPtrMap:
       {
         XmlNode* listNode = parent->first_node("List");
@@ -697,36 +719,15 @@ namespace ToolKit
         AnimRecordPtrMap list;
         for (uint stateIndx = 0; stateIndx < listSize; stateIndx++)
         {
-          AnimRecordPtr record = MakeNewPtr<AnimRecord>();
           XmlNode* elementNode = listNode->first_node(std::to_string(stateIndx).c_str());
 
           String signalName;
           ReadAttr(elementNode, "SignalName", signalName);
-          String file = Resource::DeserializeRef(elementNode);
-          if (!file.empty())
-          {
-            file                = AnimationPath(file);
-            record->m_animation = GetAnimationManager()->Create<Animation>(file);
-          }
-          list.insert(std::make_pair(signalName, record));
+          AddAnimRecord(list, signalName, Resource::DeserializeRef(elementNode));
         }
         pVar->m_var = list;
       }
       break;
-      case VariantType::SkeletonPtr:
-      {
-        String file = Resource::DeserializeRef(parent);
-        if (file.empty())
-        {
-          pVar->m_var = MakeNewPtr<Skeleton>();
-        }
-        else
-        {
-          file        = SkeletonPath(file);
-          pVar->m_var = GetSkeletonManager()->Create<Skeleton>(file);
-        }
-      }
-      break;
       case VariantType::VariantCallback:
         break;
       case VariantType::MultiChoice:
@@ -769,6 +770,238 @@ namespace ToolKit
     return nullptr;
   }
 
+  void ParameterVariant::SerializeBinary(BinaryWriter& writer) const
+  {
+    writer.Write((uint8) m_type);
+    writer.WriteString(m_name);
+
+    // Resources are referred by their file, same as Resource::SerializeRef.
+    auto writeRefFn = [&writer](Resource* res, bool referDynamic) -> void
+    {
+      String file;
+      if (res != nullptr && (referDynamic || !res->IsDynamic()))
+      {
+        file = GetRelativeResourcePath(res->GetSerializeFile());
+        UnixifyPath(file);
+      }
+
+      writer.WriteString(file);
+    };
+
+    switch (m_type)
+    {
+    case VariantType::Bool:
+      writer.Write((uint8) GetCVar<bool>());
+      break;
+    case VariantType::Byte:
+      writer.Write(GetCVar<byte>());
+      break;
+    case VariantType::Ubyte:
+      writer.Write(GetCVar<ubyte>());
+      break;
+    case VariantType::Float:
+      writer.Write(GetCVar<float>());
+      break;
+    case VariantType::Int:
+      writer.Write(GetCVar<int>());
+      break;
+    case VariantType::UInt:
+      writer.Write(GetCVar<uint>());
+      break;
+    case VariantType::Vec2:
+      writer.Write(GetCVar<Vec2>());
+      break;
+    case VariantType::Vec3:
+      writer.Write(GetCVar<Vec3>());
+      break;
+    case VariantType::Vec4:
+      writer.Write(GetCVar<Vec4>());
+      break;
+    case VariantType::Mat3:
+      writer.Write(GetCVar<Mat3>());
+      break;
+    case VariantType::Mat4:
+      writer.Write(GetCVar<Mat4>());
+      break;
+    case VariantType::String:
+      writer.WriteString(GetCVar<String>());
+      break;
+    case VariantType::ObjectId:
+      writer.Write(GetCVar<ObjectId>());
+      break;
+    case VariantType::MeshPtr:
+      writeRefFn(GetCVar<MeshPtr>().get(), false);
+      break;
+    case VariantType::TexturePtr:
+      writeRefFn(GetCVar<TexturePtr>().get(), false);
+      break;
+    case VariantType::ShaderPtr:
+      writeRefFn(GetCVar<ShaderPtr>().get(), false);
+      break;
+    case VariantType::MaterialPtr:
+      writeRefFn(GetCVar<MaterialPtr>().get(), false);
+      break;
+    case VariantType::HdriPtr:
+      writeRefFn(GetCVar<HdriPtr>().get(), false);
+      break;
+    case VariantType::SkeletonPtr:
+      writeRefFn(GetCVar<SkeletonPtr>().get(), true);
+      break;
+    case VariantType::AnimRecordPtrMap:
+    {
+      const AnimRecordPtrMap& list = GetCVar<AnimRecordPtrMap>();
+      writer.Write((uint32) list.size());
+      for (auto& [signalName, record] : list)
+      {
+        writer.WriteString(signalName);
+        writeRefFn(record->m_animation.get(), true);
+      }
+    }
+    break;
+    case VariantType::VariantCallback:
+      break;
+    case VariantType::MultiChoice:
+    {
+      const MultiChoiceVariant& mcv = GetCVar<MultiChoiceVariant>();
+      writer.Write((uint32) mcv.CurrentVal.Index);
+      writer.Write((uint32) mcv.Choices.size());
+      for (const ParameterVariant& choice : mcv.Choices)
+      {
+        choice.SerializeBinary(writer);
+      }
+    }
+    break;
+    default:
+      assert(false && "Invalid type.");
+      break;
+    }
+  }
+
+  bool ParameterVariant::DeSerializeBinary(BinaryReader& reader)
+  {
+    uint8 type = 0;
+    reader.Read(type);
+    reader.ReadString(m_name);
+    m_type         = (VariantType) type;
+
+    auto readValFn = [&](auto val) -> void
+    {
+      reader.Read(val);
+      m_var = val;
+    };
+
+    auto readFileFn = [&reader]() -> String
+    {
+      String file;
+      reader.ReadString(file);
+      NormalizePathInplace(file);
+      return file;
+    };
+
+    switch (m_type)
+    {
+    case VariantType::Bool:
+    {
+      uint8 val = 0;
+      reader.Read(val);
+      m_var = val != 0;
+    }
+    break;
+    case VariantType::Byte:
+      readValFn(byte(0));
+      break;
+    case VariantType::Ubyte:
+      readValFn(ubyte(0));
+      break;
+    case VariantType::Float:
+      readValFn(0.0f);
+      break;
+    case VariantType::Int:
+      readValFn(0);
+      break;
+    case VariantType::UInt:
+      readValFn(0u);
+      break;
+    case VariantType::Vec2:
+      readValFn(Vec2());
+      break;
+    case VariantType::Vec3:
+      readValFn(Vec3());
+      break;
+    case VariantType::Vec4:
+      readValFn(Vec4());
+      break;
+    case VariantType::Mat3:
+      readValFn(Mat3());
+      break;
+    case VariantType::Mat4:
+      readValFn(Mat4());
+      break;
+    case VariantType::String:
+    {
+      String val;
+      reader.ReadString(val);
+      m_var = val;
+    }
+    break;
+    case VariantType::ObjectId:
+      readValFn(ObjectId(0));
+      break;
+    case VariantType::MeshPtr:
+    case VariantType::TexturePtr:
+    case VariantType::ShaderPtr:
+    case VariantType::MaterialPtr:
+    case VariantType::HdriPtr:
+    case VariantType::SkeletonPtr:
+      SetResourceVal(*this, readFileFn());
+      break;
+    case VariantType::AnimRecordPtrMap:
+    {
+      uint32 listSize = 0;
+      reader.Read(listSize);
+
+      AnimRecordPtrMap list;
+      for (uint32 i = 0; i < listSize && !reader.Failed(); i++)
+      {
+        String signalName;
+        reader.ReadString(signalName);
+        AddAnimRecord(list, signalName, readFileFn());
+      }
+      m_var = list;
+    }
+    break;
+    case VariantType::VariantCallback:
+      break;
+    case VariantType::MultiChoice:
+    {
+      uint32 currentValIndex = 0;
+      uint32 choiceCount     = 0;
+      reader.Read(currentValIndex);
+      reader.Read(choiceCount);
+
+      MultiChoiceVariant mcv;
+      mcv.CurrentVal = currentValIndex;
+      for (uint32 i = 0; i < choiceCount && !reader.Failed(); i++)
+      {
+        ParameterVariant choice;
+        if (!choice.DeSerializeBinary(reader))
+        {
+          return false;
+        }
+
+        mcv.Choices.push_back(std::move(choice));
+      }
+      m_var = std::move(mcv);
+    }
+    break;
+    default:
+      // Unknown type, rest of the data can't be read.
+      return false;
+    }
+
+    return !reader.Failed();
+  }
+
   XmlNode* ParameterBlock::SerializeImp(XmlDocument* doc, XmlNode* parent) const
   {
     XmlNode* blockNode = CreateXmlNode(doc, XmlParamBlockElement, parent);
@@ -780,10 +1013,63 @@ namespace ToolKit
     return blockNode;
   }
 
+  void ParameterBlock::SerializeBinary(BinaryWriter& writer) const
+  {
+    // Functions can't be serialized, they are kept from the ParameterConstructor.
+    uint32 count = 0;
+    for (const ParameterVariant& var : m_variants)
+    {
+      count += var.GetType() != ParameterVariant::VariantType::VariantCallback;
+    }
+
+    writer.Write(count);
+    for (const ParameterVariant& var : m_variants)
+    {
+      if (var.GetType() != ParameterVariant::VariantType::VariantCallback)
+      {
+        var.SerializeBinary(writer);
+      }
+    }
+  }
+
   XmlNode* ParameterBlock::DeSerializeImp(const SerializationFileInfo& info, XmlNode* parent)
   {
     if (XmlNode* block = parent->first_node(XmlParamBlockElement.c_str()))
     {
+      uint64 binaryOffset = 0;
+      if (info.Binary != nullptr)
+      {
+        ReadAttr(block, XmlBinaryOffsetAttr.data(), binaryOffset);
+      }
+
+      if (binaryOffset != 0)
+      {
+        BinaryReader reader(*info.Binary, binaryOffset);
+
+        uint32 count = 0;
+        bool valid   = reader.Read(count);
+        for (uint32 i = 0; i < count && valid; i++)
+        {
+          ParameterVariant var;
+          valid = var.DeSerializeBinary(reader);
+          if (valid)
+          {
+            MergeVariant(var);
+          }
+        }
+
+        if (!valid)
+        {
+          TK_ERR("Corrupt binary parameter block in %s", info.File.c_str());
+          if (info.Corrupt != nullptr)
+          {
+            *info.Corrupt = true;
+          }
+        }
+
+        return nullptr;
+      }
+
       XmlNode* param = block->first_node(XmlParamterElement.c_str());
       while (param != nullptr)
       {
@@ -796,31 +1082,7 @@ namespace ToolKit
         // Because functions can't be serialized.
         if (var.GetType() != ParameterVariant::VariantType::VariantCallback)
         {
-          // Override the existing variant constructed by the
-          // ParameterConstrcutor with deserialized one.
-          bool isFound = false;
-          for (ParameterVariant& memberVar : m_variants)
-          {
-            if (var.m_name == memberVar.m_name)
-            {
-              if (var.GetType() != memberVar.GetType())
-              {
-                // Skip due to type mismatch and let the constructed one stay.
-                isFound = true;
-                break;
-              }
-
-              memberVar.m_var = var.m_var;
-              isFound         = true;
-              break;
-            }
-          }
-
-          if (!isFound)
-          {
-            var.m_category = CustomDataCategory;
-            Add(var);
-          }
+          MergeVariant(var);
         }
 
         param = param->next_sibling();
@@ -830,6 +1092,28 @@ namespace ToolKit
     return nullptr;
   }
 
+  void ParameterBlock::MergeVariant(ParameterVariant& var)
+  {
+    // Override the existing variant constructed by the
+    // ParameterConstrcutor with deserialized one.
+    for (ParameterVariant& memberVar : m_variants)
+    {
+      if (var.m_name == memberVar.m_name)
+      {
+        // Skip due to type mismatch and let the constructed one stay.
+        if (var.GetType() == memberVar.GetType())
+        {
+          memberVar.m_var = var.m_var;
+        }
+
+        return;
+      }
+    }
+
+    var.m_category = CustomDataCategory;
+    Add(var);
+  }
+
   ParameterVariant& ParameterBlock::operator[](size_t index) { return m_variants[index]; }
 
   const ParameterVariant& ParameterBlock::operator[](size_t index) const { return m_variants[index]; }
@@ -554,6 +554,19 @@ namespace ToolKit
      */
     XmlNode* DeSerializeImp(const SerializationFileInfo& info, XmlNode* parent) override;
 
+    /**
+     * Writes the type, name and value of the variant in compact binary. Resources are written as their files.
+     * @param writer The writer to append to.
+     */
+    void SerializeBinary(BinaryWriter& writer) const;
+
+    /**
+     * Reads a variant written by SerializeBinary and creates the resources that it refers to.
+     * @param reader The reader to read from.
+     * @return False if the data is corrupt.
+     */
+    bool DeSerializeBinary(BinaryReader& reader);
+
    public:
     /**
      * States if this variant exposed to framework / editor.
@@ -675,6 +688,12 @@ namespace ToolKit
      */
     void ExposeByCategory(bool exposed, const VariantCategory& category);
 
+    /**
+     * Writes the variants in compact binary. DeSerializeImp reads them back if the block element refers to the data.
+     * @param writer The writer to append to.
+     */
+    void SerializeBinary(BinaryWriter& writer) const;
+
    protected:
     /**
      * Serializes the ParameterBlock to the xml document.
@@ -690,6 +709,13 @@ namespace ToolKit
      */
     XmlNode* DeSerializeImp(const SerializationFileInfo& info, XmlNode* parent) override;
 
+   private:
+    /**
+     * Overrides the value of the constructed variant with the same name and type. Adds the variant as custom data if
+     * there isn't one with the same name.
+     */
+    void MergeVariant(ParameterVariant& var);
+
    public:
     /**
      * Container vector for ParameterVariants.
@@ -53,6 +53,27 @@ namespace ToolKit
     }
   }
 
+  void Pass::RenderJobs(RenderJobArray::iterator begin, RenderJobArray::iterator end, bool instanced)
+  {
+    Renderer* renderer = GetRenderer();
+    if (!instanced)
+    {
+      for (RenderJobItr job = begin; job != end; job++)
+      {
+        renderer->Render(*job);
+      }
+
+      return;
+    }
+
+    while (begin != end)
+    {
+      RenderJobItr batchEnd = RenderJobProcessor::FindInstanceBatchEnd(begin, end);
+      renderer->RenderInstanced(&(*begin), (int) std::distance(begin, batchEnd));
+      begin = batchEnd;
+    }
+  }
+
   void RenderJobProcessor::CreateRenderJobs(RenderJobArray& jobArray,
                                             EntityRawPtrArray& entities,
                                             bool ignoreVisibility,
@@ -95,82 +116,24 @@ namespace ToolKit
     }
 
     // Construct jobs.
-    using poolstl::iota_iter;
-    std::for_each(TKExecByConditional(entities.size() > 1000, WorkerManager::FramePool),
-                  iota_iter<size_t>(0),
-                  iota_iter<size_t>(entities.size()),
-                  [&](size_t nttIndex)
-                  {
-                    Entity* ntt                    = entities[nttIndex];
-                    MaterialPtrArray* materialList = nullptr;
-                    if (MaterialComponent* matComp = ntt->GetComponentFast<MaterialComponent>())
-                    {
-                      materialList = &matComp->GetMaterialList();
-                    }
-
-                    MeshComponent* meshComp   = ntt->GetComponentFast<MeshComponent>();
-                    const MeshPtr& parentMesh = meshComp->GetMeshVal();
-
-                    MeshRawPtrArray allMeshes;
-                    parentMesh->GetAllMeshes(allMeshes);
-
-                    bool cullFlip  = ntt->m_node->RequireCullFlip();
-                    Mat4 transform = ntt->m_node->GetTransform();
-                    for (int subMeshIndx = 0; subMeshIndx < (int) allMeshes.size(); subMeshIndx++)
-                    {
-                      Mesh* mesh           = allMeshes[subMeshIndx];
-                      MaterialPtr material = nullptr;
-
-                      // Pick the material for submesh.
-                      if (materialList != nullptr)
-                      {
-                        if (subMeshIndx < materialList->size())
-                        {
-                          material = (*materialList)[subMeshIndx];
-                        }
-                      }
-
-                      // if material is still null, pick from mesh.
-                      if (material == nullptr)
-                      {
-                        if (mesh->m_material)
-                        {
-                          material = mesh->m_material;
-                        }
-                      }
-
-                      // Worst case, no material found pick a copy of default.
-                      if (material == nullptr)
-                      {
-                        material = GetMaterialManager()->GetDefaultMaterial();
-                        TK_WRN("Material component for entity: \"%s\" has less material than mesh count. Default "
-                               "material used for meshes with missing material.",
-                               ntt->GetNameVal().c_str());
-                      }
-
-                      // Translate nttIndex to corresponding job index.
-                      int jobIndex        = submeshIndexLookup[nttIndex] + subMeshIndx;
-
-                      RenderJob& job      = jobArray[jobIndex];
-                      job.Entity          = ntt;
-                      job.Mesh            = mesh;
-                      job.Material        = material.get();
-                      job.requireCullFlip = cullFlip;
-                      job.ShadowCaster    = meshComp->GetCastShadowVal();
-                      job.WorldTransform  = ntt->m_node->GetTransform();
-                      job.BoundingBox     = ntt->GetBoundingBox(true);
-
-                      // Assign skeletal animations.
-                      if (SkeletonComponent* skComp = ntt->GetComponentFast<SkeletonComponent>())
-                      {
-                        job.animData = skComp->GetAnimData(); // copy
-                      }
-
-                      // push directional lights.
-                      AssignLight(job, lights, dirLightEndIndex);
-                      AssignEnvironment(job, environments);
-                    }
-                  });
+    auto createJobsFn = [&](size_t beginIndex, size_t endIndex) -> void
+    {
+      for (size_t nttIndex = beginIndex; nttIndex < endIndex; nttIndex++)
+      {
+        // Translate nttIndex to corresponding job index.
+        Entity* ntt     = entities[nttIndex];
+        RenderJob* jobs = jobArray.data() + submeshIndexLookup[nttIndex];
+        InitRenderJobs(ntt, jobs);
+
+        int jobCount = ntt->GetComponentFast<MeshComponent>()->GetMeshVal()->GetMeshCount();
+        for (int i = 0; i < jobCount; i++)
+        {
+          UpdateRenderJob(jobs[i], dirLightEndIndex, lights, environments);
+        }
+      }
+    };
+
+    GetWorkerManager()->ParallelFor(entities.size(), 256, createJobsFn);
   }
 
   void RenderJobProcessor::CreateRenderJobs(RenderJobArray& jobArray, EntityPtr entity)
@@ -179,6 +142,84 @@ namespace ToolKit
     CreateRenderJobs(jobArray, singleNtt, true);
   }
 
+  void RenderJobProcessor::InitRenderJobs(Entity* entity, RenderJob* jobs)
+  {
+    const MaterialPtrArray* materialList = nullptr;
+    if (const MaterialComponent* matComp = entity->GetComponentFast<MaterialComponent>())
+    {
+      materialList = &matComp->GetMaterialList();
+    }
+
+    MeshComponent* meshComp   = entity->GetComponentFast<MeshComponent>();
+    const MeshPtr& parentMesh = meshComp->GetMeshVal();
+
+    MeshRawPtrArray allMeshes;
+    parentMesh->GetAllMeshes(allMeshes);
+
+    bool cullFlip        = entity->m_node->RequireCullFlip();
+    bool shadowCaster    = meshComp->GetCastShadowVal();
+    Mat4 transform       = entity->m_node->GetTransform();
+    BoundingBox worldBox = entity->GetBoundingBox(true);
+    for (int subMeshIndx = 0; subMeshIndx < (int) allMeshes.size(); subMeshIndx++)
+    {
+      Mesh* mesh           = allMeshes[subMeshIndx];
+      MaterialPtr material = nullptr;
+
+      // Pick the material for submesh.
+      if (materialList != nullptr)
+      {
+        if (subMeshIndx < materialList->size())
+        {
+          material = (*materialList)[subMeshIndx];
+        }
+      }
+
+      // if material is still null, pick from mesh.
+      if (material == nullptr)
+      {
+        if (mesh->m_material)
+        {
+          material = mesh->m_material;
+        }
+      }
+
+      // Worst case, no material found pick a copy of default.
+      if (material == nullptr)
+      {
+        material = GetMaterialManager()->GetDefaultMaterial();
+        TK_WRN("Material component for entity: \"%s\" has less material than mesh count. Default "
+               "material used for meshes with missing material.",
+               entity->GetNameVal().c_str());
+      }
+
+      RenderJob& job      = jobs[subMeshIndx];
+      job.Entity          = entity;
+      job.Mesh            = mesh;
+      job.Material        = material.get();
+      job.requireCullFlip = cullFlip;
+      job.ShadowCaster    = shadowCaster;
+      job.WorldTransform  = transform;
+      job.BoundingBox     = worldBox;
+    }
+  }
+
+  void RenderJobProcessor::UpdateRenderJob(RenderJob& job,
+                                           int dirLightEndIndex,
+                                           const LightRawPtrArray& lights,
+                                           const EnvironmentComponentPtrArray& environments)
+  {
+    // Assign skeletal animations.
+    if (SkeletonComponent* skComp = job.Entity->GetComponentFast<SkeletonComponent>())
+    {
+      job.animData = skComp->GetAnimData(); // copy
+    }
+
+    // push directional lights.
+    job.lights.clear();
+    AssignLight(job, lights, dirLightEndIndex);
+    AssignEnvironment(job, environments);
+  }
+
   void RenderJobProcessor::SeperateRenderData(RenderData& renderData, bool forwardOnly)
   {
     // Group culled.
@@ -320,7 +361,25 @@ namespace ToolKit
       std::sort(begin,
                 end,
                 [](const RenderJob& a, const RenderJob& b) -> bool
-                { return a.Material->GetIdVal() < b.Material->GetIdVal(); });
+                {
+                  if (a.Material != b.Material)
+                  {
+                    return a.Material->GetIdVal() < b.Material->GetIdVal();
+                  }
+
+                  // Jobs that can be instanced become consecutive.
+                  if (a.Mesh != b.Mesh)
+                  {
+                    return a.Mesh->GetIdVal() < b.Mesh->GetIdVal();
+                  }
+
+                  if (a.requireCullFlip != b.requireCullFlip)
+                  {
+                    return a.requireCullFlip < b.requireCullFlip;
+                  }
+
+                  return a.animData.currentAnimation < b.animData.currentAnimation;
+                });
     };
 
     RenderJobItr begin, end;
@@ -349,6 +408,42 @@ namespace ToolKit
     sortRangeFn(begin, end);
   }
 
+  bool RenderJobProcessor::CanInstance(const RenderJob& job1, const RenderJob& job2)
+  {
+    if (job1.Mesh != job2.Mesh || job1.Material != job2.Material)
+    {
+      return false;
+    }
+
+    if (job1.requireCullFlip != job2.requireCullFlip || job1.EnvironmentVolume != job2.EnvironmentVolume)
+    {
+      return false;
+    }
+
+    // Animation textures are bound per draw.
+    const AnimData& anim1 = job1.animData;
+    const AnimData& anim2 = job2.animData;
+    if (anim1.currentAnimation != anim2.currentAnimation || anim1.blendAnimation != anim2.blendAnimation)
+    {
+      return false;
+    }
+
+    // With clustered lighting jobs only have the directional lights, which are the same for all jobs.
+    return job1.lights == job2.lights;
+  }
+
+  RenderJobItr RenderJobProcessor::FindInstanceBatchEnd(RenderJobItr begin, RenderJobItr end)
+  {
+    RenderJobItr batchEnd = begin + 1;
+    RenderJobItr limit    = begin + glm::min((size_t) RHIConstants::MaxInstancesPerDraw, (size_t) (end - begin));
+    while (batchEnd != limit && CanInstance(*begin, *batchEnd))
+    {
+      batchEnd++;
+    }
+
+    return batchEnd;
+  }
+
   void RenderJobProcessor::AssignEnvironment(RenderJob& job, const EnvironmentComponentPtrArray& environments)
   {
     BoundingBox bestBox;
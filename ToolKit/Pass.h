@@ -34,6 +34,13 @@ namespace ToolKit
     /** This function is used to pass custom uniforms to this pass. */
     void UpdateUniform(const ShaderUniform& shaderUniform);
 
+   protected:
+    /**
+     * Renders the jobs with the bound program. If instanced is true, program must be created with the Instanced define
+     * set to 1 and consecutive jobs that can be instanced are drawn with a single draw call.
+     */
+    void RenderJobs(RenderJobArray::iterator begin, RenderJobArray::iterator end, bool instanced);
+
    protected:
     GpuProgramPtr m_program = nullptr; //!< Program used to draw objects with in the pass.
     StringView m_name; //!< Label that appears in the gpu profile / debug applications (RenderDoc etc...).
@@ -118,6 +125,20 @@ namespace ToolKit
 
     static void CreateRenderJobs(RenderJobArray& jobArray, EntityPtr entity);
 
+    /**
+     * Fills the jobs of the entity's meshes with the data that only changes with the entity, such as the mesh,
+     * material, transform and bounding box. Mesh component must be initialized.
+     * @param entity is the entity to fill the jobs for. It must have a mesh component.
+     * @param jobs must point to at least as many jobs as the mesh count of the entity.
+     */
+    static void InitRenderJobs(Entity* entity, RenderJob* jobs);
+
+    /** Assigns the data that changes each frame, animation data, lights and environment to the job. */
+    static void UpdateRenderJob(RenderJob& job,
+                                int dirLightEndIndex,
+                                const LightRawPtrArray& lights,
+                                const EnvironmentComponentPtrArray& environments);
+
     /**
      * Separate jobs such that job array starts with culled jobs, than deferred jobs, than forward opaque and
      * translucent jobs.
@@ -142,9 +163,21 @@ namespace ToolKit
     /** Sort entities by distance(from boundary center) in ascending order to camera. Accounts for isometric camera. */
     static void SortByDistanceToCamera(RenderJobItr begin, RenderJobItr end, const CameraPtr& cam);
 
-    /** Sort render jobs based on materials. */
+    /** Sort render jobs based on materials. Jobs with the same material are grouped by mesh to allow instancing. */
     static void SortByMaterial(RenderData& renderData);
 
+    /**
+     * Returns true if the jobs can be drawn with a single instanced draw call. Jobs must share the mesh, material,
+     * cull flip, lights and environment. Skinned jobs must also play the same animations, key frames are per instance.
+     */
+    static bool CanInstance(const RenderJob& job1, const RenderJob& job2);
+
+    /**
+     * Returns the end of the consecutive jobs that can be instanced with the first job. Range is limited to
+     * RHIConstants::MaxInstancesPerDraw jobs.
+     */
+    static RenderJobItr FindInstanceBatchEnd(RenderJobItr begin, RenderJobItr end);
+
     /**
      * Calculates the standard deviation and mean of the given RenderJobArray
      * based on world position of the RenderJobs.
@@ -29,6 +29,9 @@ namespace ToolKit
     /** Update shadow.shader SHADOW_ATLAS_SIZE accordingly. */
     static constexpr uint ShadowAtlasTextureSize         = 2048;
 
+    /** Lowest resolution that the shadow maps are reduced to when the shadow atlas is full. */
+    static constexpr uint MinShadowMapResolution         = 128;
+
     /** Update drawDataInc.shader DIRECTIONAL_LIGHT_CACHE_ITEM_COUNT accordingly. */
     static constexpr uint DirectionalLightCacheItemCount = 12;
 
@@ -46,6 +49,37 @@ namespace ToolKit
 
     /** Update drawDataInc.shader MAX_SPOT_LIGHT_PER_OBJECT accordingly. */
     static constexpr uint MaxSpotLightPerObject          = 24;
+
+    /** Update drawDataInc.shader CLUSTER_COUNT_X, CLUSTER_COUNT_Y and CLUSTER_COUNT_Z accordingly. */
+    static constexpr uint ClusterCountX                  = 16;
+    static constexpr uint ClusterCountY                  = 9;
+    static constexpr uint ClusterCountZ                  = 24;
+
+    /** Maximum number of point and spot lights that clustered lighting processes in a frame. */
+    static constexpr uint MaxClusteredLights             = 1024;
+
+    /** Maximum number of light indexes in all clusters. */
+    static constexpr uint MaxClusterLightIndices         = 65536;
+
+    /** Update drawDataInc.shader CLUSTER_INDEX_TEXTURE_WIDTH accordingly. */
+    static constexpr uint ClusterIndexTextureWidth       = 1024;
+
+    /** Texture slots of the cluster grid, clustered light data and cluster light indexes. */
+    static constexpr uint ClusterGridSlot                = 12;
+    static constexpr uint ClusterLightDataSlot           = 13;
+    static constexpr uint ClusterLightIndexSlot          = 14;
+
+    /** Update instancingInc.shader attribute locations accordingly. First location of the per instance attributes. */
+    static constexpr uint InstanceAttributeLocation      = 6;
+
+    /** Maximum number of render jobs that are drawn with a single instanced draw call. */
+    static constexpr uint MaxInstancesPerDraw            = 1024;
+
+    /**
+     * Maximum width and height of the animation data textures, the minimum that gles 3.0 supports. Key frames beyond
+     * the height wrap to the next block of bone columns.
+     */
+    static constexpr uint AnimationDataTextureSize       = 2048;
   };
 
   class TK_API RHI
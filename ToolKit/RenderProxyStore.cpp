@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#include "RenderProxyStore.h"
+
+#include "Entity.h"
+#include "Light.h"
+#include "Mesh.h"
+#include "MeshComponent.h"
+#include "Node.h"
+#include "SkeletonComponent.h"
+#include "Threads.h"
+#include "ToolKit.h"
+#include "Util.h"
+
+#include "DebugNew.h"
+
+namespace ToolKit
+{
+
+  RenderProxyStore::RenderProxyStore() {}
+
+  RenderProxyStore::~RenderProxyStore() { Clear(); }
+
+  void RenderProxyStore::Add(Entity* entity)
+  {
+    if (GetProxy(entity) != nullptr)
+    {
+      return;
+    }
+
+    entity->m_renderProxyIndex = (int) m_proxies.size();
+    m_dirtyProxies.push_back(entity->m_renderProxyIndex);
+
+    RenderProxy& proxy = m_proxies.emplace_back();
+    proxy.entity       = entity;
+  }
+
+  void RenderProxyStore::Remove(Entity* entity)
+  {
+    // Index is overwritten if the entity is added to another scene, proxy is searched in that case.
+    int index  = entity->m_renderProxyIndex;
+    bool owned = GetProxy(entity) != nullptr;
+    if (!owned)
+    {
+      auto proxyItr = std::find_if(m_proxies.begin(),
+                                   m_proxies.end(),
+                                   [entity](const RenderProxy& proxy) -> bool { return proxy.entity == entity; });
+
+      if (proxyItr == m_proxies.end())
+      {
+        return;
+      }
+
+      index = (int) std::distance(m_proxies.begin(), proxyItr);
+    }
+
+    // Last proxy is moved in place of the removed one.
+    int last = (int) m_proxies.size() - 1;
+    if (index != last)
+    {
+      m_proxies[index] = std::move(m_proxies[last]);
+
+      Entity* moved    = m_proxies[index].entity;
+      if (moved->m_renderProxyIndex == last)
+      {
+        moved->m_renderProxyIndex = index;
+      }
+
+      // Index of the moved proxy in the dirty list is stale, it is skipped by the update.
+      if (m_proxies[index].dirty)
+      {
+        m_dirtyProxies.push_back(index);
+      }
+    }
+
+    m_proxies.pop_back();
+    if (owned)
+    {
+      entity->m_renderProxyIndex = -1;
+    }
+  }
+
+  void RenderProxyStore::Clear()
+  {
+    for (int i = 0; i < (int) m_proxies.size(); i++)
+    {
+      if (m_proxies[i].entity->m_renderProxyIndex == i)
+      {
+        m_proxies[i].entity->m_renderProxyIndex = -1;
+      }
+    }
+
+    m_proxies.clear();
+    m_dirtyProxies.clear();
+  }
+
+  void RenderProxyStore::Invalidate(Entity* entity)
+  {
+    if (RenderProxy* proxy = GetProxy(entity))
+    {
+      if (!proxy->dirty)
+      {
+        proxy->dirty = true;
+        m_dirtyProxies.push_back(entity->m_renderProxyIndex);
+      }
+    }
+  }
+
+  void RenderProxyStore::Update()
+  {
+    m_updatedProxyCount = 0;
+    if (m_dirtyProxies.empty())
+    {
+      return;
+    }
+
+    // Stale and duplicate indexes are dropped. Meshes are initialized here, since it is not thread safe. Reading the
+    // transform updates the pending transforms of the scene, which invalidates the moved proxies. That is done here
+    // as well, the indexes that are added meanwhile are processed by this loop.
+    IntArray dirtyProxies;
+    dirtyProxies.reserve(m_dirtyProxies.size());
+    for (size_t i = 0; i < m_dirtyProxies.size(); i++)
+    {
+      int index = m_dirtyProxies[i];
+      if (index < (int) m_proxies.size() && m_proxies[index].dirty)
+      {
+        m_proxies[index].entity->m_node->GetTransform();
+
+        RenderProxy& proxy = m_proxies[index];
+        proxy.dirty        = false;
+
+        if (MeshComponent* meshComp = proxy.entity->GetComponentFast<MeshComponent>())
+        {
+          meshComp->Init(false);
+        }
+
+        dirtyProxies.push_back(index);
+      }
+    }
+    m_dirtyProxies.clear();
+
+    GetWorkerManager()->ParallelFor(dirtyProxies.size(),
+                                    64,
+                                    [&](size_t beginIndex, size_t endIndex) -> void
+                                    {
+                                      for (size_t i = beginIndex; i < endIndex; i++)
+                                      {
+                                        UpdateProxy(m_proxies[dirtyProxies[i]]);
+                                      }
+                                    });
+
+    m_updatedProxyCount = (int) dirtyProxies.size();
+  }
+
+  void RenderProxyStore::CollectRenderJobs(RenderJobArray& jobArray,
+                                           EntityRawPtrArray& entities,
+                                           int dirLightEndIndex,
+                                           const LightRawPtrArray& lights,
+                                           const EnvironmentComponentPtrArray& environments)
+  {
+    Update();
+
+    // Index of the first job of each entity, followed by the total job count.
+    IntArray jobOffsets;
+    int size = 0;
+
+    erase_if(entities,
+             [&](Entity* ntt) -> bool
+             {
+               if (ntt->IsVisible())
+               {
+                 if (MeshComponent* meshComp = ntt->GetComponentFast<MeshComponent>())
+                 {
+                   meshComp->Init(false);
+                   jobOffsets.push_back(size);
+                   size += meshComp->GetMeshVal()->GetMeshCount();
+                   return false;
+                 }
+               }
+
+               return true;
+             });
+    jobOffsets.push_back(size);
+
+    // Jobs of the previous call are overwritten, so that their light arrays are reused.
+    jobArray.resize(size);
+
+    if (entities.empty())
+    {
+      return;
+    }
+
+    // Calls without lights, such as the shadow passes, leave the lights of the proxies as they are.
+    bool lighting      = !lights.empty() || !environments.empty();
+    uint64 lightingKey = lighting ? GetLightingKey(dirLightEndIndex, lights, environments) : 0;
+
+    auto collectJobsFn = [&](size_t beginIndex, size_t endIndex) -> void
+    {
+      for (size_t nttIndex = beginIndex; nttIndex < endIndex; nttIndex++)
+      {
+        Entity* ntt        = entities[nttIndex];
+        RenderJob* jobs    = jobArray.data() + jobOffsets[nttIndex];
+        int jobCount       = jobOffsets[nttIndex + 1] - jobOffsets[nttIndex];
+
+        // Entities of other scenes and the proxies that are out of sync with their mesh are created on the fly.
+        RenderProxy* proxy = GetProxy(ntt);
+        if (proxy == nullptr || (int) proxy->jobs.size() != jobCount)
+        {
+          std::fill(jobs, jobs + jobCount, RenderJob());
+          RenderJobProcessor::InitRenderJobs(ntt, jobs);
+          for (int i = 0; i < jobCount; i++)
+          {
+            RenderJobProcessor::UpdateRenderJob(jobs[i], dirLightEndIndex, lights, environments);
+          }
+
+          continue;
+        }
+
+        if (lighting && proxy->lightingKey != lightingKey)
+        {
+          for (RenderJob& job : proxy->jobs)
+          {
+            job.lights.clear();
+            RenderJobProcessor::AssignLight(job, lights, dirLightEndIndex);
+            RenderJobProcessor::AssignEnvironment(job, environments);
+          }
+
+          proxy->lightingKey = lightingKey;
+        }
+
+        SkeletonComponent* skComp = ntt->GetComponentFast<SkeletonComponent>();
+        for (int i = 0; i < jobCount; i++)
+        {
+          RenderJob& job = jobs[i];
+          job            = proxy->jobs[i];
+          if (!lighting)
+          {
+            job.lights.clear();
+            job.EnvironmentVolume = nullptr;
+          }
+
+          if (skComp != nullptr)
+          {
+            job.animData = skComp->GetAnimData();
+          }
+        }
+      }
+    };
+
+    GetWorkerManager()->ParallelFor(entities.size(), 256, collectJobsFn);
+  }
+
+  int RenderProxyStore::GetProxyCount() const { return (int) m_proxies.size(); }
+
+  int RenderProxyStore::GetUpdatedProxyCount() const { return m_updatedProxyCount; }
+
+  RenderProxyStore::RenderProxy* RenderProxyStore::GetProxy(Entity* entity)
+  {
+    int index = entity->m_renderProxyIndex;
+    if (index < 0 || index >= (int) m_proxies.size() || m_proxies[index].entity != entity)
+    {
+      return nullptr;
+    }
+
+    return &m_proxies[index];
+  }
+
+  uint64 RenderProxyStore::GetLightingKey(int dirLightEndIndex,
+                                          const LightRawPtrArray& lights,
+                                          const EnvironmentComponentPtrArray& environments)
+  {
+    // Lights are hashed with the volumes that the jobs are tested against.
+    uint64 key = MurmurHash((uint64) dirLightEndIndex);
+    for (Light* light : lights)
+    {
+      key = MurmurHash(key ^ (uint64) light);
+      if (light->GetLightType() == Light::LightType::Spot)
+      {
+        const Frustum& frustum = static_cast<SpotLight*>(light)->m_frustumCache;
+        key                    = MurmurHash64A(&frustum, sizeof(Frustum), key);
+      }
+      else if (light->GetLightType() == Light::LightType::Point)
+      {
+        const BoundingSphere& sphere = static_cast<PointLight*>(light)->m_boundingSphereCache;
+        key                          = MurmurHash64A(&sphere, sizeof(BoundingSphere), key);
+      }
+    }
+
+    for (const EnvironmentComponentPtr& volume : environments)
+    {
+      const BoundingBox& box = volume->GetBoundingBox();
+      key                    = MurmurHash(key ^ (uint64) volume.get());
+      key                    = MurmurHash(key ^ (uint64) volume->GetIlluminateVal());
+      key                    = MurmurHash64A(&box, sizeof(BoundingBox), key);
+    }
+
+    return key != 0 ? key : 1;
+  }
+
+  void RenderProxyStore::UpdateProxy(RenderProxy& proxy)
+  {
+    proxy.jobs.clear();
+    proxy.lightingKey = 0;
+
+    if (MeshComponent* meshComp = proxy.entity->GetComponentFast<MeshComponent>())
+    {
+      proxy.jobs.resize(meshComp->GetMeshVal()->GetMeshCount());
+      RenderJobProcessor::InitRenderJobs(proxy.entity, proxy.jobs.data());
+    }
+  }
+
+} // namespace ToolKit
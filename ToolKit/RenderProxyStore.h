@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#pragma once
+
+/**
+ * @file Retained render jobs of the scene entities.
+ */
+
+#include "Pass.h"
+
+namespace ToolKit
+{
+
+  /**
+   * Keeps the render jobs of the scene entities between frames. Each entity has a proxy that holds the jobs of its
+   * meshes. Entities notify the store when their transform, components, mesh or materials change and only the proxies
+   * of those entities are recreated. Lights and environments are assigned to the jobs of the proxies and kept until
+   * the proxy or the lights change. Animations are assigned to the collected jobs of the visible entities.
+   */
+  class TK_API RenderProxyStore
+  {
+   public:
+    RenderProxyStore();
+    ~RenderProxyStore(); //!< Removes all the proxies.
+
+    RenderProxyStore(const RenderProxyStore&)            = delete;
+    RenderProxyStore& operator=(const RenderProxyStore&) = delete;
+
+    /** Creates a proxy for the entity. Jobs of the proxy are created with the next update. */
+    void Add(Entity* entity);
+
+    /** Removes the proxy of the entity. */
+    void Remove(Entity* entity);
+
+    /** Removes all the proxies. */
+    void Clear();
+
+    /** Marks the proxy of the entity dirty, so that its jobs are created again with the next update. */
+    void Invalidate(Entity* entity);
+
+    /** Recreates the jobs of the dirty proxies in parallel. Does nothing if nothing is changed. */
+    void Update();
+
+    /**
+     * Same as RenderJobProcessor::CreateRenderJobs, except that the jobs of the entities which have a proxy in this
+     * store are copied from their proxies instead of being created. Store is updated before collecting the jobs.
+     * @param jobArray is the array of collected jobs.
+     * @param entities are the entities to collect render jobs for. Invisible entities and the ones without a mesh
+     * component are removed.
+     * @param lights are the list of lights to consider. Lights must be presorted before sending them to this function.
+     * @param environments are the environment volumes to consider.
+     */
+    void CollectRenderJobs(RenderJobArray& jobArray,
+                           EntityRawPtrArray& entities,
+                           int dirLightEndIndex                             = 0,
+                           const LightRawPtrArray& lights                   = {},
+                           const EnvironmentComponentPtrArray& environments = {});
+
+    /** Returns the number of the proxies. */
+    int GetProxyCount() const;
+
+    /** Returns the number of the proxies that are recreated by the last update. */
+    int GetUpdatedProxyCount() const;
+
+   private:
+    /** Render jobs of an entity's meshes. */
+    struct RenderProxy
+    {
+      Entity* entity     = nullptr; //!< Entity that the jobs are created from.
+      RenderJobArray jobs;          //!< Jobs of the meshes of the entity, empty if the entity doesn't have a mesh.
+      uint64 lightingKey = 0;       //!< Key of the lights that are assigned to the jobs, 0 if they aren't assigned.
+      bool dirty         = true;    //!< States if the jobs need to be created again.
+    };
+
+    /** Returns the proxy of the entity, null if the entity doesn't have a proxy in this store. */
+    RenderProxy* GetProxy(Entity* entity);
+
+    /**
+     * Returns a key that changes if any of the lights or the environments is added, removed or moved. Jobs are
+     * assigned to the lights again only if the key is different than the one of their proxy. Never returns 0.
+     */
+    static uint64 GetLightingKey(int dirLightEndIndex,
+                                 const LightRawPtrArray& lights,
+                                 const EnvironmentComponentPtrArray& environments);
+
+    /** Recreates the jobs of the proxy. Mesh component of the entity must be initialized. */
+    void UpdateProxy(RenderProxy& proxy);
+
+   private:
+    std::vector<RenderProxy> m_proxies; //!< Proxies of the entities, entities hold the index of their proxy.
+    IntArray m_dirtyProxies;            //!< Indexes of the dirty proxies, may contain stale indexes.
+    int m_updatedProxyCount = 0;        //!< Number of the proxies that are recreated by the last update.
+  };
+
+} // namespace ToolKit
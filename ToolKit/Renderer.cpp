@@ -115,6 +115,12 @@ namespace ToolKit
 
     m_framebuffer                   = nullptr;
     m_shadowAtlas                   = nullptr;
+    m_clusteredLighting             = nullptr;
+
+    if (m_instanceBuffer != 0)
+    {
+      glDeleteBuffers(1, &m_instanceBuffer);
+    }
   }
 
   int Renderer::GetMaxArrayTextureLayers()
@@ -178,6 +184,66 @@ namespace ToolKit
   }
 
   void Renderer::Render(const RenderJob& job)
+  {
+    SetRenderJob(job);
+    DrawRenderJob(job, 0);
+  }
+
+  void Renderer::RenderInstanced(const RenderJob* jobs, int count)
+  {
+    const RenderJob& job = jobs[0];
+    SetRenderJob(job);
+
+    m_instanceData.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+      const AnimData& anim    = jobs[i].animData;
+      InstanceData& instance  = m_instanceData[i];
+      instance.model          = jobs[i].WorldTransform;
+      instance.keyFrames      = Vec4(anim.firstKeyFrame,
+                                     anim.secondKeyFrame,
+                                     anim.keyFrameInterpolationTime,
+                                     anim.animationBlendFactor);
+      instance.blendKeyFrames = Vec4(anim.blendFirstKeyFrame,
+                                     anim.blendSecondKeyFrame,
+                                     anim.blendKeyFrameInterpolationTime,
+                                     0.0f);
+    }
+
+    if (m_instanceBuffer == 0)
+    {
+      glGenBuffers(1, &m_instanceBuffer);
+    }
+
+    // Respecifying the storage orphans the previous data, draws that still use it are not waited for.
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(InstanceData), m_instanceData.data(), GL_STREAM_DRAW);
+
+    // Instance attributes are set on the vertex array of the mesh, which is bound by SetRenderJob.
+    const GLuint location = RHIConstants::InstanceAttributeLocation;
+    for (GLuint i = 0; i < 6; i++)
+    {
+      glEnableVertexAttribArray(location + i);
+      glVertexAttribPointer(location + i,
+                            4,
+                            GL_FLOAT,
+                            GL_FALSE,
+                            sizeof(InstanceData),
+                            reinterpret_cast<void*>((size_t) i * sizeof(Vec4)));
+      glVertexAttribDivisor(location + i, 1);
+    }
+
+    DrawRenderJob(job, count);
+
+    // Non instanced draws of the mesh must not read the instance attributes.
+    for (GLuint i = 0; i < 6; i++)
+    {
+      glVertexAttribDivisor(location + i, 0);
+      glDisableVertexAttribArray(location + i);
+    }
+  }
+
+  void Renderer::SetRenderJob(const RenderJob& job)
   {
     // Skeleton Component is used by all meshes of an entity.
     const auto& updateAndBindSkinningTextures = [&]()
@@ -200,16 +266,28 @@ namespace ToolKit
         DataTexturePtr animTexture =
             animPlayer->GetAnimationDataTexture(skel->GetIdVal(), job.animData.currentAnimation->GetIdVal());
 
+        // Bind pose is used until the animation data texture is baked.
         if (animTexture != nullptr)
         {
           SetTexture(3, animTexture->m_textureId);
         }
+        else
+        {
+          SetTexture(3, skel->m_bindPoseTexture->m_textureId);
+        }
 
         // animation to blend.
         if (job.animData.blendAnimation != nullptr)
         {
           animTexture = animPlayer->GetAnimationDataTexture(skel->GetIdVal(), job.animData.blendAnimation->GetIdVal());
-          SetTexture(2, animTexture->m_textureId);
+          if (animTexture != nullptr)
+          {
+            SetTexture(2, animTexture->m_textureId);
+          }
+          else
+          {
+            SetTexture(2, skel->m_bindPoseTexture->m_textureId);
+          }
         }
       }
       else
@@ -220,6 +298,14 @@ namespace ToolKit
 
     updateAndBindSkinningTextures();
 
+    // Textures that are still loading are queued by the distance of the closest object that uses them.
+    if (job.Material->HasPendingTextures())
+    {
+      Vec3 camPos  = m_cameraCacheItem.data.position;
+      Vec3 closest = glm::clamp(camPos, job.BoundingBox.min, job.BoundingBox.max);
+      job.Material->UpdateStreamingPriority(glm::distance(camPos, closest));
+    }
+
     // Make sure render data is initialized.
     job.Mesh->Init();
     job.Material->Init();
@@ -264,14 +350,33 @@ namespace ToolKit
     FeedUniforms(m_currentProgram, job);
 
     RHI::BindVertexArray(mesh->m_vaoId);
+  }
+
+  void Renderer::DrawRenderJob(const RenderJob& job, int instanceCount)
+  {
+    const Mesh* mesh = job.Mesh;
+    GLenum drawType  = (GLenum) job.Material->GetRenderState()->drawType;
+
+    if (instanceCount > 0)
+    {
+      if (mesh->m_indexCount != 0)
+      {
+        glDrawElementsInstanced(drawType, mesh->m_indexCount, GL_UNSIGNED_INT, nullptr, instanceCount);
+      }
+      else
+      {
+        glDrawArraysInstanced(drawType, 0, mesh->m_vertexCount, instanceCount);
+      }
 
-    if (mesh->m_indexCount != 0)
+      Stats::AddInstancedDrawCall(instanceCount);
+    }
+    else if (mesh->m_indexCount != 0)
     {
-      glDrawElements((GLenum) renderState->drawType, mesh->m_indexCount, GL_UNSIGNED_INT, nullptr);
+      glDrawElements(drawType, mesh->m_indexCount, GL_UNSIGNED_INT, nullptr);
     }
     else
     {
-      glDrawArrays((GLenum) renderState->drawType, 0, mesh->m_vertexCount);
+      glDrawArrays(drawType, 0, mesh->m_vertexCount);
     }
 
     if (m_framebuffer)
@@ -514,6 +619,17 @@ namespace ToolKit
     glClear((GLbitfield) fields);
   }
 
+  void Renderer::ClearBufferRegion(GraphicBitFields fields, const Vec4& value, uint x, uint y, uint width, uint height)
+  {
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(x, y, width, height);
+
+    glClearColor(value.x, value.y, value.z, value.w);
+    glClear((GLbitfield) fields);
+
+    glDisable(GL_SCISSOR_TEST);
+  }
+
   void Renderer::ColorMask(bool r, bool g, bool b, bool a) { glColorMask(r, g, b, a); }
 
   void Renderer::CopyFrameBuffer(FramebufferPtr src, FramebufferPtr dest, GraphicBitFields fields)
@@ -1021,6 +1137,14 @@ namespace ToolKit
     {
       SetTexture(8, m_shadowAtlas->m_textureId);
     }
+
+    // Bind cluster data if clustered lighting is active.
+    if (m_clusteredLighting != nullptr)
+    {
+      SetTexture(RHIConstants::ClusterGridSlot, m_clusteredLighting->m_clusterGridTexture->m_textureId);
+      SetTexture(RHIConstants::ClusterLightDataSlot, m_clusteredLighting->m_lightDataTexture->m_textureId);
+      SetTexture(RHIConstants::ClusterLightIndexSlot, m_clusteredLighting->m_lightIndexTexture->m_textureId);
+    }
   }
 
   void Renderer::SetTransforms(const Mat4& model)
@@ -1279,9 +1403,9 @@ namespace ToolKit
         GL_TEXTURE_2D,       // 9 -> Normal map, gbuffer position
         GL_TEXTURE_2D,       // 10 -> gBuffer normal texture
         GL_TEXTURE_2D,       // 11 -> gBuffer color texture
-        GL_TEXTURE_2D,       // 12 -> gBuffer emissive texture
-        GL_TEXTURE_2D,       // 13 -> EMPTY
-        GL_TEXTURE_2D,       // 14 -> gBuffer metallic roughness texture
+        GL_TEXTURE_2D,       // 12 -> gBuffer emissive texture, cluster grid
+        GL_TEXTURE_2D,       // 13 -> Clustered light data
+        GL_TEXTURE_2D,       // 14 -> gBuffer metallic roughness texture, cluster light indexes
         GL_TEXTURE_CUBE_MAP, // 15 -> IBL Specular Pre-Filtered Map
         GL_TEXTURE_2D        // 16 -> IBL BRDF Lut
     };
@@ -1291,6 +1415,18 @@ namespace ToolKit
 
   void Renderer::SetShadowAtlas(TexturePtr shadowAtlas) { m_shadowAtlas = shadowAtlas; }
 
+  void Renderer::SetClusteredLighting(ClusteredLightingPtr clusteredLighting)
+  {
+    m_clusteredLighting = clusteredLighting;
+    if (clusteredLighting != nullptr)
+    {
+      ClusterGpuBuffer& clusterBuffer = m_globalGpuBuffers->clusterGpuBuffer;
+      clusterBuffer.m_data            = clusteredLighting->m_clusterData;
+      clusterBuffer.Invalidate();
+      clusterBuffer.Map();
+    }
+  }
+
   CubeMapPtr Renderer::GenerateCubemapFrom2DTexture(TexturePtr texture,
                                                     uint size,
                                                     float exposure,
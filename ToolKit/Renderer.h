@@ -8,6 +8,7 @@
 #pragma once
 
 #include "Camera.h"
+#include "ClusteredLighting.h"
 #include "GenericBuffers.h"
 #include "GpuProgram.h"
 #include "Material.h"
@@ -45,6 +46,17 @@ namespace ToolKit
     void SetActiveDirectionalLightCount(int count) { data2.z = (float) count; }
   };
 
+  // InstanceData
+  //////////////////////////////////////////
+
+  /** Per instance attributes of an instanced draw. Layout must match the attributes in instancingInc.shader. */
+  struct InstanceData
+  {
+    Mat4 model;          //!< World transform of the instance.
+    Vec4 keyFrames;      //!< x: keyFrame1, y: keyFrame2, z: interpolation time, w: animation blend factor.
+    Vec4 blendKeyFrames; //!< x: blendKeyFrame1, y: blendKeyFrame2, z: interpolation time, w: unused.
+  };
+
   // GraphicConstantsGpuBuffer
   //////////////////////////////////////////
 
@@ -85,6 +97,10 @@ namespace ToolKit
     SpotLightCache spotLightBuffer;
     int spotLightBufferId = 0;
 
+    /** Slice parameters of the active clustered lighting. */
+    ClusterGpuBuffer clusterGpuBuffer;
+    int clusterBufferId = 0;
+
     void InitGlobalGpuBuffers()
     {
       graphicConstantBuffer.Init();
@@ -102,6 +118,9 @@ namespace ToolKit
 
       spotLightBuffer.Init();
       spotLightBufferId = spotLightBuffer.m_gpuBuffer.m_id;
+
+      clusterGpuBuffer.Init();
+      clusterBufferId = clusterGpuBuffer.Id();
     }
   };
 
@@ -136,6 +155,10 @@ namespace ToolKit
 
     void ClearColorBuffer(const Vec4& color);
     void ClearBuffer(GraphicBitFields fields, const Vec4& value = Vec4(0.0f));
+
+    /** Clears the given rectangle of the buffers, rest of the buffers are preserved. */
+    void ClearBufferRegion(GraphicBitFields fields, const Vec4& value, uint x, uint y, uint width, uint height);
+
     void ColorMask(bool r, bool g, bool b, bool a);
 
     // FrameBuffer Operations
@@ -213,9 +236,19 @@ namespace ToolKit
     // Giving nullptr as argument means no shadows
     void SetShadowAtlas(TexturePtr shadowAtlas);
 
+    /** Clustered lighting whose lights are used by the subsequent renders. Giving nullptr disables it. */
+    void SetClusteredLighting(ClusteredLightingPtr clusteredLighting);
+
     void Render(const struct RenderJob& job);
     void Render(const RenderJobArray& jobs);
 
+    /**
+     * Draws the jobs with a single instanced draw call. Jobs must be compatible, see RenderJobProcessor::CanInstance.
+     * Bound program must be created with the Instanced define set to 1. States and uniforms are set from the first job,
+     * transforms and animation key frames are set per instance.
+     */
+    void RenderInstanced(const struct RenderJob* jobs, int count);
+
     void RenderWithProgramFromMaterial(const RenderJobArray& jobs);
     void RenderWithProgramFromMaterial(const RenderJob& job);
 
@@ -262,6 +295,12 @@ namespace ToolKit
     /** Sets the current model and derived transforms to be used in shader. */
     void SetTransforms(const Mat4& model);
 
+    /** Sets the mesh, material, lights, textures, states and uniforms of the job for a draw call. */
+    void SetRenderJob(const RenderJob& job);
+
+    /** Issues the draw call for the mesh of the job. Non instanced draw if instance count is 0. */
+    void DrawRenderJob(const RenderJob& job, int instanceCount);
+
     void FeedUniforms(const GpuProgramPtr& program, const RenderJob& job);
     void FeedAnimationUniforms(const GpuProgramPtr& program, const RenderJob& job);
 
@@ -295,15 +334,20 @@ namespace ToolKit
     std::array<int, RHIConstants::MaxSpotLightPerObject> m_activeSpotLightIndices;
     DrawCommand m_drawCommand;
 
-    int m_activePointLightCount   = 0;
-    int m_activeSpotLightCount    = 0;
-    bool m_ambientOcculusionInUse = false;
-    bool m_normalMapInUse         = false;
+    // Instancing
+    std::vector<InstanceData> m_instanceData;     //!< Per instance data of the last instanced draw.
+    uint m_instanceBuffer                    = 0; //!< Vertex buffer that holds the per instance data.
+
+    int m_activePointLightCount              = 0;
+    int m_activeSpotLightCount               = 0;
+    bool m_ambientOcculusionInUse            = false;
+    bool m_normalMapInUse                    = false;
 
-    FramebufferPtr m_framebuffer  = nullptr;
-    TexturePtr m_shadowAtlas      = nullptr;
-    RenderTargetPtr m_brdfLut     = nullptr;
-    TexturePtr m_aoTexture        = nullptr;
+    FramebufferPtr m_framebuffer             = nullptr;
+    TexturePtr m_shadowAtlas                 = nullptr;
+    ClusteredLightingPtr m_clusteredLighting = nullptr;
+    RenderTargetPtr m_brdfLut                = nullptr;
+    TexturePtr m_aoTexture                   = nullptr;
 
     std::array<int, RHIConstants::TextureSlotCount> m_textureSlots;
 
@@ -104,12 +104,16 @@ namespace ToolKit
     other->m_initiated = m_initiated;
   }
 
-  void Resource::ParseDocument(StringView firstNode, bool fullParse)
+  void Resource::ParseDocument(StringView firstNode, bool fullParse, XmlFilePtr file)
   {
     SerializationFileInfo info;
-    info.File          = GetFile();
+    info.File = GetFile();
+
+    if (file == nullptr)
+    {
+      file = GetFileManager()->GetXmlFile(info.File);
+    }
 
-    XmlFilePtr file    = GetFileManager()->GetXmlFile(info.File);
     XmlDocumentPtr doc = MakeNewPtr<XmlDocument>();
 
     if (fullParse)
@@ -77,8 +77,9 @@ namespace ToolKit
      * Create SerializationFileInfo structure and pass it to DeSerializeImp.
      * @param firstNode is the name of root node of the xml file of this resource.
      * @param full - parse all the xml file along with comments.
+     * @param file - already read content of the resource file. If null, the file is read through the FileManager.
      */
-    void ParseDocument(StringView firstNode, bool fullParse = false);
+    void ParseDocument(StringView firstNode, bool fullParse = false, XmlFilePtr file = nullptr);
 
    public:
     String m_name;
@@ -15,6 +15,7 @@
 #include "Shader.h"
 #include "SpriteSheet.h"
 #include "Texture.h"
+#include "Threads.h"
 #include "ToolKit.h"
 #include "Util.h"
 
@@ -22,6 +23,35 @@
 
 namespace ToolKit
 {
+
+  // ResourceRequest
+  //////////////////////////////////////////
+
+  ResourceRequest::ResourceRequest() { m_loaded = m_loadedPromise.get_future().share(); }
+
+  ResourceRequest::State ResourceRequest::GetState() const { return m_state.load(std::memory_order_acquire); }
+
+  bool ResourceRequest::IsReady() const { return GetState() == State::Ready; }
+
+  ResourcePtr ResourceRequest::Get() const { return IsReady() ? m_resource : m_placeholder; }
+
+  ResourcePtr ResourceRequest::GetResource() const { return m_resource; }
+
+  const String& ResourceRequest::GetFile() const { return m_file; }
+
+  void ResourceRequest::SetPriority(float priority) { m_priority.store(priority, std::memory_order_relaxed); }
+
+  float ResourceRequest::GetPriority() const { return m_priority.load(std::memory_order_relaxed); }
+
+  bool ResourceRequest::TryBeginLoad()
+  {
+    State expected = State::Queued;
+    return m_state.compare_exchange_strong(expected, State::Loading, std::memory_order_acq_rel);
+  }
+
+  // ResourceManager
+  //////////////////////////////////////////
+
   ResourceManager::ResourceManager() {}
 
   ResourceManager::~ResourceManager()
@@ -34,6 +64,27 @@ namespace ToolKit
   void ResourceManager::Uninit()
   {
     GetLogger()->Log("Uninitiating manager " + m_baseType->Name);
+
+    // Queued requests are dropped. Scheduled background tasks must complete before the manager gets destroyed.
+    {
+      LockGuard lock(m_storageMutex);
+      for (const ResourceRequestPtr& request : m_queuedRequests)
+      {
+        if (request->TryBeginLoad())
+        {
+          m_requests.erase(request->m_file);
+          request->m_loadedPromise.set_value();
+        }
+      }
+      m_queuedRequests.clear();
+    }
+
+    while (m_scheduledTasks.load(std::memory_order_acquire) > 0)
+    {
+      std::this_thread::yield();
+    }
+
+    LockGuard lock(m_storageMutex);
     m_storage.clear();
   }
 
@@ -46,16 +97,23 @@ namespace ToolKit
 
     if (sane)
     {
+      LockGuard lock(m_storageMutex);
       m_storage[file] = resource;
     }
   }
 
   String ResourceManager::GetDefaultResource(ClassMeta* Class) { return String(); }
 
-  bool ResourceManager::Exist(const String& file) { return m_storage.find(file) != m_storage.end(); }
+  bool ResourceManager::Exist(const String& file)
+  {
+    LockGuard lock(m_storageMutex);
+    return m_storage.find(file) != m_storage.end();
+  }
 
   ResourcePtr ResourceManager::Remove(const String& file)
   {
+    LockGuard lock(m_storageMutex);
+
     ResourcePtr resource = nullptr;
     auto mapItr          = m_storage.find(file);
     if (mapItr != m_storage.end())
@@ -67,4 +125,261 @@ namespace ToolKit
     return resource;
   }
 
+  ResourcePtr ResourceManager::Find(const String& file)
+  {
+    LockGuard lock(m_storageMutex);
+
+    auto mapItr = m_storage.find(file);
+    if (mapItr != m_storage.end())
+    {
+      return mapItr->second;
+    }
+
+    return nullptr;
+  }
+
+  void ResourceManager::Store(const String& file, ResourcePtr resource)
+  {
+    LockGuard lock(m_storageMutex);
+    m_storage[file] = resource;
+  }
+
+  std::vector<ResourcePtr> ResourceManager::GetStoredResources()
+  {
+    LockGuard lock(m_storageMutex);
+
+    std::vector<ResourcePtr> resources;
+    resources.reserve(m_storage.size());
+    for (const auto& [file, resource] : m_storage)
+    {
+      resources.push_back(resource);
+    }
+
+    return resources;
+  }
+
+  ResourcePtr ResourceManager::CreateImp(const String& file, ClassMeta* Class, ProgressCallback progressCallback)
+  {
+    ResourcePtr stored;
+    ResourceRequestPtr request = AcquireRequest(file, Class, nullptr, false, stored);
+    if (request == nullptr)
+    {
+      return stored;
+    }
+
+    // Either load it here or wait for the thread that is already loading it.
+    if (request->TryBeginLoad())
+    {
+      LoadRequest(request, progressCallback);
+    }
+    else
+    {
+      request->m_loaded.wait();
+    }
+
+    return request->m_resource;
+  }
+
+  ResourceRequestPtr ResourceManager::CreateAsyncImp(const String& file, ClassMeta* Class, float priority)
+  {
+    // Default resources are small and mostly loaded already, they are served while the requested one is loading.
+    ResourcePtr placeholder;
+    String def = GetDefaultResource(Class);
+    if (!def.empty() && def != file && CheckFile(def))
+    {
+      placeholder = CreateImp(def, Class, nullptr);
+    }
+
+    ResourcePtr stored;
+    ResourceRequestPtr request = AcquireRequest(file, Class, placeholder, true, stored);
+    if (request == nullptr)
+    {
+      request             = std::make_shared<ResourceRequest>();
+      request->m_file     = file;
+      request->m_resource = stored;
+      request->m_state    = ResourceRequest::State::Ready;
+      request->m_loadedPromise.set_value();
+
+      return request;
+    }
+
+    if (priority < request->GetPriority())
+    {
+      request->SetPriority(priority);
+    }
+
+    // Without threads, the resource is loaded right away and only the initialization is deferred.
+    if (!Main::GetInstance()->m_threaded && request->TryBeginLoad())
+    {
+      LoadRequest(request, nullptr);
+    }
+
+    return request;
+  }
+
+  ResourceRequestPtr ResourceManager::AcquireRequest(const String& file,
+                                                     ClassMeta* Class,
+                                                     ResourcePtr placeholder,
+                                                     bool async,
+                                                     ResourcePtr& stored)
+  {
+    // Resource is constructed outside of the lock, because constructors may use the managers.
+    ResourcePtr resource;
+    while (true)
+    {
+      {
+        LockGuard lock(m_storageMutex);
+
+        auto storageItr = m_storage.find(file);
+        if (storageItr != m_storage.end())
+        {
+          stored = storageItr->second;
+          return nullptr;
+        }
+
+        ResourceRequestPtr request;
+        auto requestItr = m_requests.find(file);
+        if (requestItr != m_requests.end())
+        {
+          request = requestItr->second;
+        }
+        else if (resource != nullptr)
+        {
+          request                = std::make_shared<ResourceRequest>();
+          request->m_file        = file;
+          request->m_resource    = resource;
+          request->m_placeholder = placeholder;
+          m_requests[file]       = request;
+
+          if (async && Main::GetInstance()->m_threaded)
+          {
+            m_queuedRequests.push_back(request);
+            m_scheduledTasks.fetch_add(1, std::memory_order_relaxed);
+            TKAsyncTask(WorkerManager::BackgroundPool, [this]() -> void { LoadNextRequest(); });
+          }
+        }
+
+        if (request != nullptr)
+        {
+          request->m_async |= async;
+          return request;
+        }
+      }
+
+      resource = MakeNewPtrCasted<Resource>(Class->Name);
+      if (resource == nullptr)
+      {
+        return nullptr;
+      }
+    }
+  }
+
+  void ResourceManager::LoadRequest(const ResourceRequestPtr& request, ProgressCallback progressCallback)
+  {
+    ResourcePtr resource = request->m_resource;
+    const String& file   = request->m_file;
+
+    bool loadable        = true;
+    if (CheckFile(file))
+    {
+      resource->SetFile(file);
+    }
+    else
+    {
+      String def = GetDefaultResource(resource->Class());
+      if (CheckFile(def))
+      {
+        String rel = GetRelativeResourcePath(file);
+        TK_WRN("File: %s is missing. Using default resource.", rel.c_str());
+        resource->SetFile(def);
+        resource->_missingFile = file;
+      }
+      else
+      {
+        TK_ERR("No default for Class %s", resource->Class()->Name.c_str());
+        assert(0 && "No default resource!");
+        loadable = false;
+      }
+    }
+
+    if (loadable)
+    {
+      resource->SetProgressCallback(progressCallback);
+      resource->Load();
+    }
+    else
+    {
+      request->m_resource = nullptr;
+    }
+
+    bool async = false;
+    {
+      LockGuard lock(m_storageMutex);
+      if (loadable)
+      {
+        m_storage[file] = resource;
+      }
+
+      m_requests.erase(file);
+      async = request->m_async;
+    }
+
+    request->m_loadedPromise.set_value();
+
+    if (!async || !loadable)
+    {
+      request->m_state = ResourceRequest::State::Ready;
+      return;
+    }
+
+    // Gpu resources are created on the main thread.
+    request->m_state = ResourceRequest::State::Uploading;
+    TKAsyncTask(WorkerManager::MainThread,
+                [request]() -> void
+                {
+                  if (Main::GetInstance()->m_initiated)
+                  {
+                    request->m_resource->Init();
+                  }
+
+                  request->m_state = ResourceRequest::State::Ready;
+                });
+  }
+
+  void ResourceManager::LoadNextRequest()
+  {
+    ResourceRequestPtr request;
+    {
+      LockGuard lock(m_storageMutex);
+      while (request == nullptr && !m_queuedRequests.empty())
+      {
+        size_t next = 0;
+        for (size_t i = 1; i < m_queuedRequests.size(); i++)
+        {
+          if (m_queuedRequests[i]->GetPriority() < m_queuedRequests[next]->GetPriority())
+          {
+            next = i;
+          }
+        }
+
+        ResourceRequestPtr nextRequest = m_queuedRequests[next];
+        m_queuedRequests[next]         = m_queuedRequests.back();
+        m_queuedRequests.pop_back();
+
+        // Requests that are taken over by synchronous loads are skipped.
+        if (nextRequest->TryBeginLoad())
+        {
+          request = nextRequest;
+        }
+      }
+    }
+
+    if (request != nullptr)
+    {
+      LoadRequest(request, nullptr);
+    }
+
+    m_scheduledTasks.fetch_sub(1, std::memory_order_release);
+  }
+
 } // namespace ToolKit
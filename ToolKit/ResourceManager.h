@@ -19,6 +19,87 @@ namespace ToolKit
 
   TK_API extern class ResourceManager* GetResourceManager(ClassMeta* Class);
 
+  /**
+   * Tracks a resource that is requested with ResourceManager::CreateAsync. Resource is loaded on the background pool,
+   * initialized on the main thread and becomes ready after that. Until then, the default resource of the manager is
+   * served as placeholder.
+   */
+  class TK_API ResourceRequest
+  {
+    friend class ResourceManager;
+
+   public:
+    /** Load states of the request in the order they are passed. */
+    enum class State
+    {
+      Queued,    //!< Waiting for a background thread.
+      Loading,   //!< Being loaded on the CPU side.
+      Uploading, //!< Loaded, waiting for the initialization on the main thread.
+      Ready      //!< Loaded and initialized.
+    };
+
+    ResourceRequest();
+
+    /** Returns the current state of the request. */
+    State GetState() const;
+
+    /** States if the requested resource is loaded and initialized. */
+    bool IsReady() const;
+
+    /** Returns the requested resource if it is ready, the placeholder otherwise. Placeholder can be null. */
+    ResourcePtr Get() const;
+
+    /** Returns the requested resource regardless of its state. */
+    ResourcePtr GetResource() const;
+
+    /** Returns the requested file. */
+    const String& GetFile() const;
+
+    /** Sets the load order of the queued request. Requests with smaller values, such as closer ones, load first. */
+    void SetPriority(float priority);
+
+    /** Returns the load priority of the request. */
+    float GetPriority() const;
+
+   private:
+    /** Changes the state from Queued to Loading. Returns true for the only caller that should load the resource. */
+    bool TryBeginLoad();
+
+   private:
+    String m_file;                              //!< Requested file.
+    ResourcePtr m_resource;                     //!< Resource that is being loaded.
+    ResourcePtr m_placeholder;                  //!< Default resource served until the requested one is ready.
+    std::atomic<State> m_state {State::Queued}; //!< Current state.
+    std::atomic<float> m_priority {TK_FLT_MAX}; //!< Load order of the queued request.
+    bool m_async = false;                       //!< Initialization is requested. Guarded by the storage lock.
+    std::promise<void> m_loadedPromise;         //!< Set after the resource is loaded.
+    std::shared_future<void> m_loaded;          //!< Waited by the threads that need the resource being loaded.
+  };
+
+  typedef std::shared_ptr<ResourceRequest> ResourceRequestPtr;
+
+  /** Typed access to a resource request, returned from ResourceManager::CreateAsync. */
+  template <typename T>
+  class ResourceHandle
+  {
+   public:
+    ResourceHandle() {}
+
+    explicit ResourceHandle(ResourceRequestPtr request) : m_request(request) {}
+
+    /** Returns the requested resource if it is ready, the placeholder otherwise. */
+    std::shared_ptr<T> Get() const { return tk_reinterpret_pointer_cast<T>(m_request->Get()); }
+
+    /** States if the requested resource is loaded and initialized. */
+    bool IsReady() const { return m_request->IsReady(); }
+
+    /** Returns the underlying request. */
+    const ResourceRequestPtr& GetRequest() const { return m_request; }
+
+   private:
+    ResourceRequestPtr m_request;
+  };
+
   class TK_API ResourceManager
   {
    public:
@@ -33,37 +114,27 @@ namespace ToolKit
     ResourceManager(const ResourceManager&) = delete;
     void operator=(const ResourceManager&)  = delete;
 
+    /**
+     * Returns the resource for the file, loads it on the calling thread if it is not loaded yet. If the file is being
+     * loaded by another thread, waits for it. Queued asynchronous requests for the file are loaded on the calling
+     * thread instead of waiting for them. It is safe to call from multiple threads.
+     */
     template <typename T>
     std::shared_ptr<T> Create(const String& file, ProgressCallback progressCallback = nullptr)
     {
-      if (!Exist(file))
-      {
-        ResourcePtr resource = MakeNewPtr<T>();
-        if (!CheckFile(file))
-        {
-          String def = GetDefaultResource(T::StaticClass());
-          if (!CheckFile(def))
-          {
-            TK_ERR("No default for Class %s", T::StaticClass()->Name.c_str());
-            assert(0 && "No default resource!");
-            return nullptr;
-          }
-
-          String rel = GetRelativeResourcePath(file);
-          TK_WRN("File: %s is missing. Using default resource.", rel.c_str());
-          resource->SetFile(def);
-          resource->_missingFile = file;
-        }
-        else
-        {
-          resource->SetFile(file);
-        }
-
-        resource->SetProgressCallback(progressCallback);
-        resource->Load();
-        m_storage[file] = resource;
-      }
-      return tk_reinterpret_pointer_cast<T>(m_storage[file]);
+      return tk_reinterpret_pointer_cast<T>(CreateImp(file, T::StaticClass(), progressCallback));
+    }
+
+    /**
+     * Requests the resource to be loaded on the background pool and initialized on the main thread. Returns
+     * immediately with a handle that serves the default resource until the requested one is ready. Requests for the
+     * same file are merged.
+     * @param priority Queued requests are loaded in ascending priority order, such as the distance to the camera.
+     */
+    template <typename T>
+    ResourceHandle<T> CreateAsync(const String& file, float priority = 0.0f)
+    {
+      return ResourceHandle<T>(CreateAsyncImp(file, T::StaticClass(), priority));
     }
 
     template <typename T>
@@ -82,9 +153,47 @@ namespace ToolKit
     bool Exist(const String& file);
     ResourcePtr Remove(const String& file);
 
+    /** Returns the stored resource for the file. Returns null if the resource is not loaded. */
+    ResourcePtr Find(const String& file);
+
+    /** Stores the resource under the given file, replacing the existing one. Used for the resources created in code. */
+    void Store(const String& file, ResourcePtr resource);
+
+    /**
+     * Returns a snapshot of the stored resources. Storage is modified by the background loads, the snapshot can be
+     * iterated and the resources can be saved without holding the storage lock.
+     */
+    std::vector<ResourcePtr> GetStoredResources();
+
+   private:
+    ResourcePtr CreateImp(const String& file, ClassMeta* Class, ProgressCallback progressCallback);
+    ResourceRequestPtr CreateAsyncImp(const String& file, ClassMeta* Class, float priority);
+
+    /**
+     * Returns the in flight request for the file or creates a new one. Returns null and sets the stored if the resource
+     * is already loaded. Asynchronous requests are marked for initialization and new ones are queued.
+     */
+    ResourceRequestPtr AcquireRequest(const String& file,
+                                      ClassMeta* Class,
+                                      ResourcePtr placeholder,
+                                      bool async,
+                                      ResourcePtr& stored);
+
+    /** Loads the resource of the request, moves it to the storage and wakes up the waiting threads. */
+    void LoadRequest(const ResourceRequestPtr& request, ProgressCallback progressCallback);
+
+    /** Background task that loads the queued request with the smallest priority value. */
+    void LoadNextRequest();
+
    public:
-    std::unordered_map<String, ResourcePtr> m_storage;
     ClassMeta* m_baseType = nullptr;
+
+   private:
+    std::unordered_map<String, ResourcePtr> m_storage;         //!< Loaded resources by their files.
+    Mutex m_storageMutex;                                      //!< Guards the storage and the requests.
+    std::unordered_map<String, ResourceRequestPtr> m_requests; //!< Requests that are being loaded.
+    std::vector<ResourceRequestPtr> m_queuedRequests;          //!< Requests waiting for a background thread.
+    std::atomic_int m_scheduledTasks {0};                      //!< Background tasks that are not completed yet.
   };
 
 } // namespace ToolKit
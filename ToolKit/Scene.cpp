@@ -13,10 +13,13 @@
 #include "EnvironmentComponent.h"
 #include "FileManager.h"
 #include "Logger.h"
+#include "MappedFile.h"
 #include "MathUtil.h"
 #include "Mesh.h"
 #include "Prefab.h"
+#include "RenderProxyStore.h"
 #include "ToolKit.h"
+#include "TransformSystem.h"
 #include "Util.h"
 
 #include "DebugNew.h"
@@ -25,14 +28,56 @@ namespace ToolKit
 {
   TKDefineClass(Scene, Resource);
 
+  /**
+   * Layout of the binary scene file:
+   * SceneFileHeader, parameter blocks and transforms of the entities, entity records, post processing settings,
+   * SceneFileEntry for each entity and the string table. Records are the null terminated xml of the entities, whose
+   * parameter block and transform elements refer to their binary data with XmlBinaryOffsetAttr. Strings are stored
+   * as their length followed by their characters.
+   */
+
+  static constexpr char g_sceneFileMagic[4]  = {'T', 'K', 'S', 'B'};
+  static constexpr uint32 g_sceneFileVersion = 1;
+
+  struct SceneFileEntry
+  {
+    uint64 offset; //!< Offset of the record from the start of the file.
+    uint64 length; //!< Length of the record, including the null terminator.
+  };
+
+  struct SceneFileHeader
+  {
+    char magic[4];            //!< Always g_sceneFileMagic.
+    uint32 version;           //!< Version of the layout.
+    uint64 sourceHash;        //!< Hash of the xml file that the binary file is produced from.
+    uint64 indexOffset;       //!< Offset of the SceneFileEntry array.
+    uint64 stringTableOffset; //!< Offset of the string table.
+    SceneFileEntry settings;  //!< Post processing settings record, zero length if there isn't any.
+    uint32 entityCount;       //!< Number of the entries in the entity index.
+    uint32 stringCount;       //!< Number of the strings in the string table.
+    uint32 versionString;     //!< String index of the version that the scene is serialized with.
+    uint32 padding;           //!< Keeps the header 8 byte aligned.
+  };
+
+  static_assert(sizeof(SceneFileEntry) == 16, "Binary scene entry layout changed.");
+  static_assert(sizeof(SceneFileHeader) == 64, "Binary scene header layout changed.");
+
   Scene::Scene()
   {
-    m_name     = "NewScene";
-    m_isLayer  = false;
-    m_isPrefab = false;
+    m_name             = "NewScene";
+    m_isLayer          = false;
+    m_isPrefab         = false;
+
+    m_renderProxyStore = new RenderProxyStore();
   }
 
-  Scene::~Scene() { Destroy(false); }
+  Scene::~Scene()
+  {
+    Destroy(false);
+    m_aabbTree.SetTransformSystem(nullptr);
+    SafeDel(m_transformSystem);
+    SafeDel(m_renderProxyStore);
+  }
 
   void Scene::NativeConstruct()
   {
@@ -54,7 +99,24 @@ namespace ToolKit
       m_isPrefab  = path.find("Prefabs") != String::npos;
       m_isLayer   = EndsWith(path, LAYER);
 
-      ParseDocument(XmlSceneElement);
+      // Inserting entities one by one is slow and results in a poor tree, build it at once after loading.
+      m_aabbTree.SetDeferredInsertion(true);
+
+      // Binary form is preferred if it is up to date, otherwise xml is parsed from the already read content.
+      MappedFilePtr file = GetFileManager()->GetMappedFile(path);
+      if (file == nullptr)
+      {
+        // Let the xml loader report the missing file.
+        ParseDocument(XmlSceneElement);
+      }
+      else if (!LoadBinary(*file))
+      {
+        // Mapped content has no terminator, it is added to the copy that the xml file owns.
+        XmlFilePtr xmlFile = MakeNewPtr<XmlFile>((const char*) file->Data(), (uint) file->Size());
+        ParseDocument(XmlSceneElement, false, xmlFile);
+      }
+
+      m_aabbTree.SetDeferredInsertion(false);
 
       m_loaded = true;
     }
@@ -102,6 +164,8 @@ namespace ToolKit
 
       file << xml;
       file.close();
+
+      SaveBinary(fullPath, &doc);
       doc.clear();
     }
     else
@@ -175,18 +239,21 @@ namespace ToolKit
 
   void Scene::Update(float deltaTime)
   {
+    if (m_transformSystem != nullptr)
+    {
+      m_transformSystem->Update();
+    }
+
     m_environmentVolumeCache.clear();
 
-    for (const EntityPtr& ntt : m_entities)
+    // Update volume caches.
+    for (Entity* ntt : GetEntitiesWith<EnvironmentComponent>())
     {
-      // Update volume caches.
-      if (const EnvironmentComponentPtr& envComp = ntt->GetComponent<EnvironmentComponent>())
+      EnvironmentComponentPtr envComp = ntt->GetComponent<EnvironmentComponent>();
+      if (envComp->GetHdriVal() != nullptr && envComp->GetIlluminateVal())
       {
-        if (envComp->GetHdriVal() != nullptr && envComp->GetIlluminateVal())
-        {
-          envComp->Init(true);
-          m_environmentVolumeCache.push_back(envComp);
-        }
+        envComp->Init(true);
+        m_environmentVolumeCache.push_back(envComp);
       }
     }
 
@@ -209,41 +276,45 @@ namespace ToolKit
     GetSceneManager()->Remove(other->GetFile());
   }
 
-  Scene::PickData Scene::PickObject(const Ray& ray, const IDArray& ignoreList, const EntityPtrArray& extraList)
+  /** Picks the closest entity that is hit by the ray before the closestPickedDistance and updates the pick data. */
+  static void PickEntities(const Ray& ray,
+                           const EntityPtrArray& entities,
+                           const IDArray& ignoreList,
+                           Scene::PickData& pd,
+                           float& closestPickedDistance)
   {
-    PickData pd;
-    pd.pickPos                  = ray.position + ray.direction * 5.0f;
-
-    float closestPickedDistance = TK_FLT_MAX;
-
-    auto pickFn                 = [&](const EntityPtrArray& entities) -> void
+    for (EntityPtr ntt : entities)
     {
-      for (EntityPtr ntt : entities)
+      if (!ntt->IsDrawable())
       {
-        if (!ntt->IsDrawable())
-        {
-          continue;
-        }
+        continue;
+      }
 
-        if (contains(ignoreList, ntt->GetIdVal()))
-        {
-          continue;
-        }
+      if (contains(ignoreList, ntt->GetIdVal()))
+      {
+        continue;
+      }
 
-        float dist = TK_FLT_MAX;
-        if (RayEntityIntersection(ray, ntt, dist))
+      float dist = TK_FLT_MAX;
+      if (RayEntityIntersection(ray, ntt, dist))
+      {
+        if (dist < closestPickedDistance && dist > 0.0f)
         {
-          if (dist < closestPickedDistance && dist > 0.0f)
-          {
-            pd.entity             = ntt;
-            pd.pickPos            = ray.position + ray.direction * dist;
-            closestPickedDistance = dist;
-          }
+          pd.entity             = ntt;
+          pd.pickPos            = ray.position + ray.direction * dist;
+          closestPickedDistance = dist;
         }
       }
-    };
+    }
+  }
+
+  Scene::PickData Scene::PickObject(const Ray& ray, const IDArray& ignoreList, const EntityPtrArray& extraList)
+  {
+    PickData pd;
+    pd.pickPos                  = ray.position + ray.direction * 5.0f;
 
-    pickFn(extraList);
+    float closestPickedDistance = TK_FLT_MAX;
+    PickEntities(ray, extraList, ignoreList, pd, closestPickedDistance);
 
     float dist          = TK_FLT_MAX;
     EntityPtr pickedNtt = m_aabbTree.RayQuery(ray, true, &dist, ignoreList);
@@ -257,6 +328,33 @@ namespace ToolKit
     return pd;
   }
 
+  void Scene::PickObjects(const RayArray& rays,
+                          PickDataArray& pickedObjects,
+                          const IDArray& ignoreList,
+                          const EntityPtrArray& extraList)
+  {
+    AABBTree::RayHitArray hits;
+    m_aabbTree.RayQueryBatch(rays, true, hits, ignoreList);
+
+    pickedObjects.resize(rays.size());
+    for (size_t i = 0; i < rays.size(); i++)
+    {
+      const Ray& ray              = rays[i];
+      PickData& pd                = pickedObjects[i];
+      pd.entity                   = nullptr;
+      pd.pickPos                  = ray.position + ray.direction * 5.0f;
+
+      float closestPickedDistance = TK_FLT_MAX;
+      PickEntities(ray, extraList, ignoreList, pd, closestPickedDistance);
+
+      if (hits[i].t < closestPickedDistance)
+      {
+        pd.entity  = hits[i].entity;
+        pd.pickPos = PointOnRay(ray, hits[i].t);
+      }
+    }
+  }
+
   void Scene::PickObject(const Frustum& frustum,
                          PickDataArray& pickedObjects,
                          const IDArray& ignoreList,
@@ -307,18 +405,15 @@ namespace ToolKit
 
   EntityPtr Scene::GetEntity(ObjectId id, int* index) const
   {
-    for (int i = 0; i < (int) m_entities.size(); i++)
+    auto indexItr = m_entityIndices.find(id);
+    if (indexItr != m_entityIndices.end())
     {
-      EntityPtr ntt = m_entities[i];
-      if (ntt->GetIdVal() == id)
+      if (index != nullptr)
       {
-        if (index != nullptr)
-        {
-          *index = i;
-        }
-
-        return ntt;
+        *index = indexItr->second;
       }
+
+      return m_entities[indexItr->second];
     }
 
     if (index != nullptr)
@@ -352,15 +447,31 @@ namespace ToolKit
 
         if (index < 0 || index >= (int) m_entities.size())
         {
+          m_entityIndices[entity->GetIdVal()] = (int) m_entities.size();
           m_entities.push_back(entity);
         }
         else
         {
+          // Entities after the inserted one are shifted.
           m_entities.insert(m_entities.begin() + index, entity);
+          for (int i = index; i < (int) m_entities.size(); i++)
+          {
+            m_entityIndices[m_entities[i]->GetIdVal()] = i;
+          }
         }
 
+        UpdateNameAndTagIndices(entity.get(), true);
+
         entity->m_scene = Self<Scene>();
 
+        if (m_transformSystem != nullptr)
+        {
+          m_transformSystem->Add(entity->m_node);
+        }
+
+        m_renderProxyStore->Add(entity.get());
+        AddToArchetype(entity.get());
+
         if (entity->m_partOfAABBTree)
         {
           m_aabbTree.CreateNode(entity, entity->GetBoundingBox(true));
@@ -377,6 +488,38 @@ namespace ToolKit
     }
   }
 
+  void Scene::MoveEntities(const EntityPtrArray& entities, int index)
+  {
+    EntityPtrArray movedEntities;
+    std::unordered_set<ObjectId> movedIds;
+    for (const EntityPtr& ntt : entities)
+    {
+      if (GetEntity(ntt->GetIdVal()) == ntt && movedIds.insert(ntt->GetIdVal()).second)
+      {
+        movedEntities.push_back(ntt);
+      }
+    }
+
+    if (movedEntities.empty())
+    {
+      return;
+    }
+
+    erase_if(m_entities,
+             [&movedIds](const EntityPtr& ntt) -> bool { return movedIds.find(ntt->GetIdVal()) != movedIds.end(); });
+
+    if (index < 0 || index > (int) m_entities.size())
+    {
+      index = (int) m_entities.size();
+    }
+    m_entities.insert(m_entities.begin() + index, movedEntities.begin(), movedEntities.end());
+
+    for (int i = 0; i < (int) m_entities.size(); i++)
+    {
+      m_entityIndices[m_entities[i]->GetIdVal()] = i;
+    }
+  }
+
   void Scene::_RemoveChildren(EntityPtr removed)
   {
     NodeRawPtrArray& children = removed->m_node->m_children;
@@ -390,6 +533,214 @@ namespace ToolKit
     }
   }
 
+  void Scene::UpdateIndex(std::unordered_map<String, IDArray>& index, const StringArray& keys, ObjectId id, bool add)
+  {
+    for (const String& key : keys)
+    {
+      IDArray& ids = index[key];
+      if (add)
+      {
+        if (!contains(ids, id))
+        {
+          ids.push_back(id);
+        }
+        continue;
+      }
+
+      auto idItr = std::find(ids.begin(), ids.end(), id);
+      if (idItr != ids.end())
+      {
+        *idItr = ids.back();
+        ids.pop_back();
+      }
+
+      if (ids.empty())
+      {
+        index.erase(key);
+      }
+    }
+  }
+
+  void Scene::UpdateNameAndTagIndices(Entity* ntt, bool add)
+  {
+    ObjectId id = ntt->GetIdVal();
+    UpdateIndex(m_nameIndex, {ntt->GetNameVal()}, id, add);
+
+    StringArray tags;
+    Split(ntt->GetTagVal(), ".", tags);
+    UpdateIndex(m_tagIndex, tags, id, add);
+  }
+
+  void Scene::RebuildEntityIndices()
+  {
+    m_entityIndices.clear();
+    m_nameIndex.clear();
+    m_tagIndex.clear();
+    ClearArchetypes();
+
+    for (int i = 0; i < (int) m_entities.size(); i++)
+    {
+      m_entityIndices[m_entities[i]->GetIdVal()] = i;
+      UpdateNameAndTagIndices(m_entities[i].get(), true);
+      AddToArchetype(m_entities[i].get());
+    }
+  }
+
+  void Scene::AddToArchetype(Entity* ntt)
+  {
+    const ComponentMask& mask = ntt->GetComponentMask();
+
+    auto archetypeItr         = m_archetypeIndices.find(mask);
+    if (archetypeItr == m_archetypeIndices.end())
+    {
+      Archetype& archetype = m_archetypes.emplace_back();
+      archetype.mask       = mask;
+      archetypeItr         = m_archetypeIndices.insert({mask, (int) m_archetypes.size() - 1}).first;
+    }
+
+    EntityRawPtrArray& entities = m_archetypes[archetypeItr->second].entities;
+    ntt->m_archetypeIndex       = archetypeItr->second;
+    ntt->m_archetypeSlot        = (int) entities.size();
+    entities.push_back(ntt);
+  }
+
+  void Scene::RemoveFromArchetype(Entity* ntt)
+  {
+    // Indices are overwritten if the entity is added to another scene, entity is searched in that case.
+    int index = ntt->m_archetypeIndex;
+    int slot  = ntt->m_archetypeSlot;
+    if (index < 0 || index >= (int) m_archetypes.size() || slot < 0 ||
+        slot >= (int) m_archetypes[index].entities.size() || m_archetypes[index].entities[slot] != ntt)
+    {
+      index = -1;
+      for (int i = 0; i < (int) m_archetypes.size() && index == -1; i++)
+      {
+        const EntityRawPtrArray& entities = m_archetypes[i].entities;
+        auto nttItr                       = std::find(entities.begin(), entities.end(), ntt);
+        if (nttItr != entities.end())
+        {
+          index = i;
+          slot  = (int) std::distance(entities.begin(), nttItr);
+        }
+      }
+
+      if (index == -1)
+      {
+        return;
+      }
+    }
+
+    // Last entity is moved in place of the removed one.
+    EntityRawPtrArray& entities = m_archetypes[index].entities;
+    int last                    = (int) entities.size() - 1;
+    if (slot != last)
+    {
+      entities[slot] = entities[last];
+      if (entities[slot]->m_archetypeIndex == index && entities[slot]->m_archetypeSlot == last)
+      {
+        entities[slot]->m_archetypeSlot = slot;
+      }
+    }
+    entities.pop_back();
+
+    if (ntt->m_archetypeIndex == index && ntt->m_archetypeSlot == slot)
+    {
+      ntt->m_archetypeIndex = -1;
+      ntt->m_archetypeSlot  = -1;
+    }
+  }
+
+  void Scene::ClearArchetypes()
+  {
+    // Entities may already be destroyed, only the entities of the scene are reset.
+    for (const EntityPtr& ntt : m_entities)
+    {
+      ntt->m_archetypeIndex = -1;
+      ntt->m_archetypeSlot  = -1;
+    }
+
+    m_archetypes.clear();
+    m_archetypeIndices.clear();
+  }
+
+  void Scene::OnEntityComponentsChanged(Entity* ntt)
+  {
+    if (GetEntity(ntt->GetIdVal()).get() != ntt)
+    {
+      return;
+    }
+
+    const ComponentMask& mask = ntt->GetComponentMask();
+    int index                 = ntt->m_archetypeIndex;
+    if (index >= 0 && index < (int) m_archetypes.size() && m_archetypes[index].mask == mask)
+    {
+      return;
+    }
+
+    RemoveFromArchetype(ntt);
+    AddToArchetype(ntt);
+  }
+
+  void Scene::GetEntitiesWith(const ComponentMask& mask, EntityRawPtrArray& entities) const
+  {
+    for (const Archetype& archetype : m_archetypes)
+    {
+      if ((archetype.mask & mask) == mask)
+      {
+        entities.insert(entities.end(), archetype.entities.begin(), archetype.entities.end());
+      }
+    }
+  }
+
+  void Scene::OnEntityIdChanged(Entity* ntt, ObjectId oldId)
+  {
+    auto indexItr = m_entityIndices.find(oldId);
+    if (indexItr == m_entityIndices.end() || m_entities[indexItr->second].get() != ntt)
+    {
+      return;
+    }
+
+    int index = indexItr->second;
+    m_entityIndices.erase(indexItr);
+    m_entityIndices[ntt->GetIdVal()] = index;
+
+    // Name and tag indices hold the ids.
+    UpdateIndex(m_nameIndex, {ntt->GetNameVal()}, oldId, false);
+    UpdateIndex(m_nameIndex, {ntt->GetNameVal()}, ntt->GetIdVal(), true);
+
+    StringArray tags;
+    Split(ntt->GetTagVal(), ".", tags);
+    UpdateIndex(m_tagIndex, tags, oldId, false);
+    UpdateIndex(m_tagIndex, tags, ntt->GetIdVal(), true);
+  }
+
+  void Scene::OnEntityNameChanged(Entity* ntt, const String& oldName)
+  {
+    if (GetEntity(ntt->GetIdVal()).get() != ntt)
+    {
+      return;
+    }
+
+    UpdateIndex(m_nameIndex, {oldName}, ntt->GetIdVal(), false);
+    UpdateIndex(m_nameIndex, {ntt->GetNameVal()}, ntt->GetIdVal(), true);
+  }
+
+  void Scene::OnEntityTagChanged(Entity* ntt, const String& oldTag)
+  {
+    if (GetEntity(ntt->GetIdVal()).get() != ntt)
+    {
+      return;
+    }
+
+    StringArray tags;
+    Split(oldTag, ".", tags);
+    UpdateIndex(m_tagIndex, tags, ntt->GetIdVal(), false);
+
+    tags.clear();
+    Split(ntt->GetTagVal(), ".", tags);
+    UpdateIndex(m_tagIndex, tags, ntt->GetIdVal(), true);
+  }
+
   EntityPtr Scene::RemoveEntity(ObjectId id, bool deep)
   {
     if (m_entities.empty())
@@ -407,12 +758,29 @@ namespace ToolKit
     if (Prefab* prefab = removed->As<Prefab>())
     {
       prefab->Unlink(); // This operation may alter the removed index.
-      indx              = -1;
-      EntityPtr removed = GetEntity(id, &indx);
+      GetEntity(id, &indx);
     }
 
     UpdateEntityCaches(removed, false);
-    m_entities.erase(m_entities.begin() + indx);
+    UpdateNameAndTagIndices(removed.get(), false);
+
+    // Last entity is moved in place of the removed one.
+    int last = (int) m_entities.size() - 1;
+    if (indx != last)
+    {
+      m_entities[indx]                              = std::move(m_entities[last]);
+      m_entityIndices[m_entities[indx]->GetIdVal()] = indx;
+    }
+    m_entities.pop_back();
+    m_entityIndices.erase(id);
+
+    if (m_transformSystem != nullptr)
+    {
+      m_transformSystem->Remove(removed->m_node);
+    }
+
+    m_renderProxyStore->Remove(removed.get());
+    RemoveFromArchetype(removed.get());
 
     if (deep)
     {
@@ -442,7 +810,18 @@ namespace ToolKit
     }
   }
 
-  void Scene::RemoveAllEntities() { m_entities.clear(); }
+  void Scene::RemoveAllEntities()
+  {
+    if (m_transformSystem != nullptr)
+    {
+      m_transformSystem->Clear();
+    }
+
+    m_renderProxyStore->Clear();
+
+    m_entities.clear();
+    RebuildEntityIndices();
+  }
 
   const EntityPtrArray& Scene::GetEntities() const { return m_entities; }
 
@@ -456,31 +835,49 @@ namespace ToolKit
 
   EntityPtr Scene::GetFirstByName(const String& name)
   {
-    for (EntityPtr ntt : m_entities)
+    auto nameItr = m_nameIndex.find(name);
+    if (nameItr == m_nameIndex.end())
+    {
+      return nullptr;
+    }
+
+    // The one that comes first in the entity list.
+    int firstIndex = -1;
+    for (ObjectId id : nameItr->second)
     {
-      if (ntt->GetNameVal() == name)
+      int index = m_entityIndices[id];
+      if (firstIndex == -1 || index < firstIndex)
       {
-        return ntt;
+        firstIndex = index;
       }
     }
-    return nullptr;
+
+    return firstIndex == -1 ? nullptr : m_entities[firstIndex];
   }
 
   EntityPtrArray Scene::GetByTag(const String& tag)
   {
     EntityPtrArray arrayByTag;
-    for (EntityPtr ntt : m_entities)
+
+    auto tagItr = m_tagIndex.find(tag);
+    if (tagItr == m_tagIndex.end())
     {
-      StringArray tokens;
-      Split(ntt->GetTagVal(), ".", tokens);
+      return arrayByTag;
+    }
 
-      for (const String& token : tokens)
-      {
-        if (token == tag)
-        {
-          arrayByTag.push_back(ntt);
-        }
-      }
+    // Entities are returned in the order of the entity list.
+    IntArray indices;
+    indices.reserve(tagItr->second.size());
+    for (ObjectId id : tagItr->second)
+    {
+      indices.push_back(m_entityIndices[id]);
+    }
+    std::sort(indices.begin(), indices.end());
+
+    arrayByTag.reserve(indices.size());
+    for (int index : indices)
+    {
+      arrayByTag.push_back(m_entities[index]);
     }
 
     return arrayByTag;
@@ -555,7 +952,15 @@ namespace ToolKit
       }
     }
 
+    if (m_transformSystem != nullptr)
+    {
+      m_transformSystem->Clear();
+    }
+
+    m_renderProxyStore->Clear();
+
     m_entities.clear();
+    RebuildEntityIndices();
     m_aabbTree.Reset();
 
     m_lightCache.clear();
@@ -575,6 +980,7 @@ namespace ToolKit
     entity->m_node->m_children = prevNode->m_children;
 
     // Construct prefab.
+    SceneWeakPtr prevScene     = entity->m_scene;
     ScenePtr prefab            = MakeNewPtr<Scene>();
     prefab->AddEntity(entity);
     GetChildren(entity, prefab->m_entities);
@@ -585,6 +991,8 @@ namespace ToolKit
     prefab->m_name = name;
     prefab->Save(false);
     prefab->m_entities.clear();
+    prefab->RebuildEntityIndices();
+    entity->m_scene = prevScene;
 
     // Restore the old node.
     entity->m_node->m_children.clear();
@@ -594,12 +1002,46 @@ namespace ToolKit
 
   void Scene::ClearEntities()
   {
+    if (m_transformSystem != nullptr)
+    {
+      m_transformSystem->Clear();
+    }
+
+    m_renderProxyStore->Clear();
+
     m_aabbTree.Reset();
     m_entities.clear();
+    RebuildEntityIndices();
   }
 
   const BoundingBox& Scene::GetSceneBoundary() { return m_aabbTree.GetRootBoundingBox(); }
 
+  void Scene::SetTransformSystemEnabled(bool enable)
+  {
+    if (!enable)
+    {
+      // Nodes are detached by the system and update their transforms by themselves.
+      m_aabbTree.SetTransformSystem(nullptr);
+      SafeDel(m_transformSystem);
+      return;
+    }
+
+    if (m_transformSystem == nullptr)
+    {
+      m_transformSystem = new TransformSystem();
+      for (const EntityPtr& ntt : m_entities)
+      {
+        m_transformSystem->Add(ntt->m_node);
+      }
+
+      m_aabbTree.SetTransformSystem(m_transformSystem);
+    }
+  }
+
+  TransformSystem* Scene::GetTransformSystem() const { return m_transformSystem; }
+
+  RenderProxyStore* Scene::GetRenderProxyStore() const { return m_renderProxyStore; }
+
   void Scene::CopyTo(Resource* other)
   {
     Super::CopyTo(other);
@@ -614,6 +1056,7 @@ namespace ToolKit
     {
       DeepCopy(ntt, cpy->m_entities);
     }
+    cpy->RebuildEntityIndices();
   }
 
   void Scene::UpdateEntityCaches(const EntityPtr& ntt, bool add)
@@ -675,16 +1118,10 @@ namespace ToolKit
     WriteAttr(scene, doc, "name", name.c_str());
     WriteAttr(scene, doc, XmlVersion, TKVersionStr);
 
-    for (size_t listIndx = 0; listIndx < m_entities.size(); listIndx++)
+    EntityPtrArray entities;
+    GetSerializedEntities(entities);
+    for (const EntityPtr& ntt : entities)
     {
-      EntityPtr ntt = m_entities[listIndx];
-
-      // If entity isn't a prefab type but from a prefab, don't serialize it
-      if (!ntt->IsA<Prefab>() && Prefab::GetPrefabRoot(ntt))
-      {
-        continue;
-      }
-
       ntt->Serialize(doc, scene);
     }
 
@@ -870,6 +1307,364 @@ namespace ToolKit
     }
   }
 
+  void Scene::SaveBinary(const String& xmlPath, XmlDocument* doc) const
+  {
+    // Hash of the file as it is written, line endings may be converted by the stream.
+    MappedFile xmlFile;
+    if (!xmlFile.Open(xmlPath))
+    {
+      return;
+    }
+
+    SceneFileHeader header = {};
+    memcpy(header.magic, g_sceneFileMagic, sizeof(g_sceneFileMagic));
+    header.version    = g_sceneFileVersion;
+    header.sourceHash = StringHash(StringView((const char*) xmlFile.Data(), xmlFile.Size()));
+    xmlFile.Close();
+
+    BinaryWriter writer;
+    header.versionString = writer.AddString(TKVersionStr);
+    writer.Write(header); // Rewritten once the offsets are known.
+
+    // Elements that are stored in binary lose their content and refer to their data.
+    auto referBinaryFn = [&](XmlNode* element) -> void
+    {
+      element->remove_all_nodes();
+      element->remove_all_attributes();
+      WriteAttr(element, doc, XmlBinaryOffsetAttr, std::to_string(writer.Tell()));
+    };
+
+    EntityPtrArray entities;
+    GetSerializedEntities(entities);
+
+    const char* objectElement = Object::StaticClass()->Name.c_str();
+    XmlNode* root             = doc->first_node(XmlSceneElement.c_str());
+    XmlNode* objectNode       = root->first_node(objectElement);
+
+    std::vector<SceneFileEntry> index;
+    index.reserve(entities.size());
+
+    String record;
+    for (const EntityPtr& ntt : entities)
+    {
+      if (objectNode == nullptr)
+      {
+        TK_ERR("Binary scene isn't saved. Document doesn't match the entities of %s", xmlPath.c_str());
+        return;
+      }
+
+      if (XmlNode* blockNode = objectNode->first_node(XmlParamBlockElement.c_str()))
+      {
+        referBinaryFn(blockNode);
+        ntt->m_localData.SerializeBinary(writer);
+      }
+
+      if (XmlNode* nttNode = objectNode->first_node(Entity::StaticClass()->Name.c_str()))
+      {
+        if (XmlNode* transformNode = nttNode->first_node(XmlNodeElement.c_str()))
+        {
+          referBinaryFn(transformNode);
+          ntt->m_node->SerializeBinary(writer);
+        }
+
+        // Components are serialized in order, each one with its parameter block.
+        if (XmlNode* componentArray = nttNode->first_node(XmlComponentArrayElement.data()))
+        {
+          XmlNode* componentNode = componentArray->first_node(objectElement);
+          for (const ComponentPtr& component : ntt->GetComponentPtrArray())
+          {
+            // Components that aren't serialized have no element.
+            if (!component->IsSerializable())
+            {
+              continue;
+            }
+
+            if (componentNode == nullptr)
+            {
+              break;
+            }
+
+            if (XmlNode* blockNode = componentNode->first_node(XmlParamBlockElement.c_str()))
+            {
+              referBinaryFn(blockNode);
+              component->m_localData.SerializeBinary(writer);
+            }
+
+            componentNode = componentNode->next_sibling(objectElement);
+          }
+        }
+      }
+
+      record.clear();
+      rapidxml::print(std::back_inserter(record), *objectNode, rapidxml::print_no_indenting);
+      index.push_back({writer.Tell(), record.size() + 1});
+      writer.WriteBytes(record.c_str(), record.size() + 1);
+
+      objectNode = objectNode->next_sibling(objectElement);
+    }
+
+    if (XmlNode* postProcessNode = root->first_node(PostProcessingSettings::StaticClass()->Name.c_str()))
+    {
+      record.clear();
+      rapidxml::print(std::back_inserter(record), *postProcessNode, rapidxml::print_no_indenting);
+      header.settings = {writer.Tell(), record.size() + 1};
+      writer.WriteBytes(record.c_str(), record.size() + 1);
+    }
+
+    writer.Align(sizeof(uint64));
+    header.indexOffset = writer.Tell();
+    header.entityCount = (uint32) index.size();
+    writer.WriteBytes(index.data(), index.size() * sizeof(SceneFileEntry));
+
+    header.stringTableOffset = writer.Tell();
+    header.stringCount       = (uint32) writer.m_strings.size();
+    for (const String& str : writer.m_strings)
+    {
+      writer.Write((uint32) str.size());
+      writer.WriteBytes(str.data(), str.size());
+    }
+
+    memcpy(writer.m_data.data(), &header, sizeof(SceneFileHeader));
+
+    String binaryPath = xmlPath + SCENE_BINARY;
+    std::ofstream stream(binaryPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open())
+    {
+      TK_ERR("Can't write binary scene file: %s", binaryPath.c_str());
+      return;
+    }
+
+    stream.write((const char*) writer.m_data.data(), (std::streamsize) writer.m_data.size());
+  }
+
+  bool Scene::LoadBinary(const MappedFile& xmlFile)
+  {
+    String path        = GetFile();
+    MappedFilePtr file = GetFileManager()->GetMappedFile(path + SCENE_BINARY);
+    if (file == nullptr || file->Size() < sizeof(SceneFileHeader))
+    {
+      return false;
+    }
+
+    const uint8* data = file->Data();
+    const uint64 size = file->Size();
+
+    SceneFileHeader header;
+    memcpy(&header, data, sizeof(SceneFileHeader));
+
+    auto inFileFn = [size](uint64 offset, uint64 length) -> bool { return offset <= size && length <= size - offset; };
+
+    if (memcmp(header.magic, g_sceneFileMagic, sizeof(g_sceneFileMagic)) != 0 ||
+        header.version != g_sceneFileVersion ||
+        !inFileFn(header.indexOffset, (uint64) header.entityCount * sizeof(SceneFileEntry)) ||
+        !inFileFn(header.stringTableOffset, (uint64) header.stringCount * sizeof(uint32)) ||
+        !inFileFn(header.settings.offset, header.settings.length))
+    {
+      TK_WRN("Unsupported binary scene file, loading the xml: %s", path.c_str());
+      return false;
+    }
+
+    // Xml is edited or replaced after the binary file is produced.
+    if (header.sourceHash != StringHash(StringView((const char*) xmlFile.Data(), xmlFile.Size())))
+    {
+      TK_LOG("Binary scene file is out of date, loading the xml: %s", path.c_str());
+      return false;
+    }
+
+    BinaryData binary;
+    binary.Data = data;
+    binary.Size = size;
+    binary.Strings.resize(header.stringCount);
+
+    uint64 offset = header.stringTableOffset;
+    for (String& str : binary.Strings)
+    {
+      uint32 length = 0;
+      if (!inFileFn(offset, sizeof(uint32)))
+      {
+        return false;
+      }
+
+      memcpy(&length, data + offset, sizeof(uint32));
+      offset += sizeof(uint32);
+
+      if (!inFileFn(offset, length))
+      {
+        return false;
+      }
+
+      str.assign((const char*) data + offset, length);
+      offset += length;
+    }
+
+    auto recordFn = [&](const SceneFileEntry& entry) -> bool
+    { return entry.length != 0 && inFileFn(entry.offset, entry.length) && data[entry.offset + entry.length - 1] == 0; };
+
+    if (header.versionString >= header.stringCount || (header.settings.length != 0 && !recordFn(header.settings)))
+    {
+      return false;
+    }
+
+    std::vector<SceneFileEntry> index(header.entityCount);
+    memcpy(index.data(), data + header.indexOffset, index.size() * sizeof(SceneFileEntry));
+
+    // Match scene name with file name.
+    String serializeFile = GetSerializeFile();
+    DecomposePath(serializeFile, nullptr, &m_name, nullptr);
+    TK_SYSLOG("Loading binary scene %s", serializeFile.c_str());
+
+    // Parameter blocks and transforms that can't be read mark the file corrupt.
+    std::atomic_bool corrupt = false;
+
+    SerializationFileInfo info;
+    info.File    = path;
+    info.Version = binary.Strings[header.versionString];
+    info.Binary  = &binary;
+    info.Corrupt = &corrupt;
+    m_version    = info.Version;
+
+    Super::PreDeserializeImp(info, nullptr);
+    m_numberOfThingsToLoad = glm::max(1u, header.entityCount);
+
+    // Records are independent, each worker parses its records to its own document. Entities don't claim their ids
+    // here, since the collisions would be resolved in a different order on each load.
+    EntityPtrArray entities(index.size());
+
+    auto deserializeFn = [&](size_t beginIndex, size_t endIndex) -> void
+    {
+      XmlDocument doc;
+      std::vector<char> record;
+
+      SerializationFileInfo workerInfo = info;
+      workerInfo.Document              = &doc;
+      workerInfo.DeferIdCollision      = true;
+      const char* objectElement        = Object::StaticClass()->Name.c_str();
+
+      for (size_t i = beginIndex; i < endIndex; i++)
+      {
+        const SceneFileEntry& entry = index[i];
+        if (!recordFn(entry))
+        {
+          corrupt = true;
+          continue;
+        }
+
+        // Parsing is in place, record is copied out of the read only file.
+        record.assign(data + entry.offset, data + entry.offset + entry.length);
+        doc.clear();
+        doc.parse<rapidxml::parse_default>(record.data());
+
+        XmlNode* objectNode = doc.first_node(objectElement);
+        XmlAttribute* attr  = objectNode ? objectNode->first_attribute(XmlObjectClassAttr.data()) : nullptr;
+        EntityPtr ntt       = attr ? SafeCast<Entity>(MakeNewPtrCasted<Object>(attr->value())) : nullptr;
+        if (ntt == nullptr)
+        {
+          corrupt = true;
+          continue;
+        }
+
+        ntt->m_version = m_version;
+        ntt->DeSerialize(workerInfo, objectNode);
+        entities[i] = ntt;
+      }
+    };
+
+    GetWorkerManager()->ParallelFor(entities.size(), 64, deserializeFn);
+
+    // Fix up in file order. Ids are claimed first, so that the entities that are dropped release their own ids.
+    for (const EntityPtr& ntt : entities)
+    {
+      if (ntt != nullptr)
+      {
+        ntt->PreventIdCollision();
+        for (const ComponentPtr& component : ntt->GetComponentPtrArray())
+        {
+          component->PreventIdCollision();
+        }
+      }
+    }
+
+    if (corrupt)
+    {
+      TK_ERR("Corrupt binary scene file, loading the xml: %s", path.c_str());
+      return false;
+    }
+
+    for (const EntityPtr& ntt : entities)
+    {
+      if (Prefab* prefab = ntt->As<Prefab>())
+      {
+        prefab->Load();
+      }
+
+      UpdateProgress(1);
+    }
+
+    // Parents are referred by their ids in the file.
+    std::unordered_map<ObjectId, Entity*> entitiesByFileId;
+    entitiesByFileId.reserve(entities.size());
+    for (const EntityPtr& ntt : entities)
+    {
+      ObjectId id = ntt->_idBeforeCollision;
+      if (id == NullHandle)
+      {
+        id = ntt->GetIdVal();
+      }
+
+      entitiesByFileId.insert({id, ntt.get()});
+    }
+
+    m_entities.reserve(entities.size());
+    for (const EntityPtr& ntt : entities)
+    {
+      if (ntt->_parentId != NullHandle)
+      {
+        auto parentItr = entitiesByFileId.find(ntt->_parentId);
+        if (parentItr != entitiesByFileId.end() && parentItr->second != ntt.get())
+        {
+          parentItr->second->m_node->AddChild(ntt->m_node);
+        }
+      }
+
+      AddEntity(ntt);
+    }
+
+    if (header.settings.length != 0)
+    {
+      std::vector<char> record(data + header.settings.offset, data + header.settings.offset + header.settings.length);
+
+      XmlDocument doc;
+      doc.parse<rapidxml::parse_default>(record.data());
+      info.Document            = &doc;
+
+      XmlNode* postProcessNode = doc.first_node(PostProcessingSettings::StaticClass()->Name.c_str());
+      if (postProcessNode != nullptr && postProcessNode->first_node() != nullptr)
+      {
+        m_postProcessSettings->DeSerialize(info, postProcessNode->first_node());
+      }
+    }
+
+    PostDeSerializeImp(info, nullptr);
+    return true;
+  }
+
+  void Scene::GetSerializedEntities(EntityPtrArray& entities) const
+  {
+    entities.clear();
+    entities.reserve(m_entities.size());
+
+    for (const EntityPtr& ntt : m_entities)
+    {
+      // If entity isn't a prefab type but from a prefab, don't serialize it
+      if (!ntt->IsA<Prefab>() && Prefab::GetPrefabRoot(ntt))
+      {
+        continue;
+      }
+
+      entities.push_back(ntt);
+    }
+  }
+
   ObjectId Scene::GetBiggestEntityId()
   {
     ObjectId lastId = 0;
@@ -20,6 +20,9 @@
 
 namespace ToolKit
 {
+  class RenderProxyStore;
+  class TransformSystem;
+
   /**
    * The Scene class represents a collection of entities in a 3D environment. It
    * provides functionality for loading and saving scenes, updating and querying
@@ -108,6 +111,20 @@ namespace ToolKit
      */
     virtual PickData PickObject(const Ray& ray, const IDArray& ignoreList = {}, const EntityPtrArray& extraList = {});
 
+    /**
+     * Picks the closest object for each of the rays at once. Rays are tested against the scene in parallel packets,
+     * which is much faster than picking them one by one.
+     *
+     * @param rays The rays to use for picking.
+     * @param pickedObjects An output vector that is filled with the pick result of each ray, in the order of the rays.
+     * @param ignoreList A list of entity IDs to ignore during the picking operation.
+     * @param extraList A list of extra entity pointers to include in the picking operation.
+     */
+    virtual void PickObjects(const RayArray& rays,
+                             PickDataArray& pickedObjects,
+                             const IDArray& ignoreList       = {},
+                             const EntityPtrArray& extraList = {});
+
     /**
      * Performs a frustum culling operation on the scene to find all objects
      * that are partially or fully contained within the frustum.
@@ -126,7 +143,7 @@ namespace ToolKit
                             const EntityPtrArray& extraList = {});
 
     /**
-     * Gets the entity with the given ID from the scene.
+     * Gets the entity with the given ID from the scene in constant time.
      * @param id The ID of the entity to get.
      * @param index is the index in to the entity list. If provided index of the entity is filled.
      * @returns The entity with the given ID, or nullptr if no entity with that
@@ -140,6 +157,14 @@ namespace ToolKit
     /** Adds an array of entities to the scene. */
     virtual void AddEntity(const EntityPtrArray& entities);
 
+    /**
+     * Moves the entities to the given index in the entity list. Order of the other entities is preserved. Removing
+     * entities doesn't preserve the order, entities are reordered with this function instead.
+     * @param entities are the entities to move, in the order that they will be placed.
+     * @param index is the position in the entity list without the moved entities. Negative values move to the end.
+     */
+    void MoveEntities(const EntityPtrArray& entities, int index);
+
     /**
      * Gets all the entities in the scene.
      * @returns An array containing pointers to all the entities in the scene.
@@ -165,7 +190,7 @@ namespace ToolKit
     EnvironmentComponentPtrArray& GetEnvironmentVolumes() const;
 
     /**
-     * Gets the first entity in the scene with the given name.
+     * Gets the first entity in the scene with the given name. Entities are looked up from the name index.
      * @param name The name of the entity to get.
      * @returns The first entity in the scene with the given name, or nullptr if
      * no entity with that name exists in the scene.
@@ -173,8 +198,8 @@ namespace ToolKit
     EntityPtr GetFirstByName(const String& name);
 
     /**
-     * Gets an array of all the entities in the scene with the given tag.
-     * @param tag The tag to search for.
+     * Gets an array of all the entities in the scene with the given tag. Entities are looked up from the tag index.
+     * @param tag The tag to search for. Tags of the entities are separated by dots, each part is a tag.
      * @returns An array containing pointers to all the entities in the scene
      * with the given tag.
      */
@@ -198,6 +223,37 @@ namespace ToolKit
      */
     EntityPtrArray Filter(std::function<bool(EntityPtr)> filter);
 
+    /**
+     * Appends the entities that have components of all the classes in the mask. Entities are grouped in to archetypes
+     * by their component masks, only the matching archetypes are visited. Order of the entities is not preserved.
+     * @param mask is the component classes to look for.
+     * @param entities is the array that the found entities are appended to.
+     */
+    void GetEntitiesWith(const ComponentMask& mask, EntityRawPtrArray& entities) const;
+
+    /**
+     * Returns the entities that have components of all the given types.
+     * Component types that are not registered to the ObjectFactory can't be queried, nothing is returned for them.
+     */
+    template <typename... T>
+    EntityRawPtrArray GetEntitiesWith() const
+    {
+      EntityRawPtrArray entities;
+
+      ComponentMask mask;
+      for (ClassMeta* Class : {T::StaticClass()...})
+      {
+        if (Class->ComponentIndex == -1)
+        {
+          return entities;
+        }
+        mask.set(Class->ComponentIndex);
+      }
+
+      GetEntitiesWith(mask, entities);
+      return entities;
+    }
+
     /**
      * Links a prefab to the scene.
      * @param fullPath The full path to the prefab file.
@@ -207,7 +263,8 @@ namespace ToolKit
     /**
      * Removes the entity with the given ID from the scene.
      *
-     * This function will remove the specified entity from the scene.
+     * This function will remove the specified entity from the scene. The last entity of the entity list is moved in
+     * place of the removed one.
      * If the `deep` parameter is set to true, it will also remove all
      * child entities associated with the specified entity.
      *
@@ -248,6 +305,18 @@ namespace ToolKit
     /** Returns scene boundary from the BVH. */
     const BoundingBox& GetSceneBoundary();
 
+    /**
+     * Enables or disables batched transform updates. When enabled, nodes of the entities are registered to a
+     * TransformSystem and their world transforms are updated together at the beginning of the scene update.
+     */
+    void SetTransformSystemEnabled(bool enable);
+
+    /** Returns the transform system of the scene, null if batched transform updates are disabled. */
+    TransformSystem* GetTransformSystem() const;
+
+    /** Returns the store that retains the render jobs of the scene entities between frames. */
+    RenderProxyStore* GetRenderProxyStore() const;
+
    protected:
     /**
      * Serializes the scene to an XML document.
@@ -269,6 +338,25 @@ namespace ToolKit
     /** Deserialize files with version v0.4.5 */
     void DeSerializeImpV045(const SerializationFileInfo& info, XmlNode* parent);
 
+    /**
+     * Writes the binary form of the scene next to its xml file. Parameter blocks and transforms of the entities are
+     * replaced with their binary data in the document, the rest of each entity is kept as a small xml record.
+     * @param xmlPath is the path of the saved xml file. Its hash is stored to detect changes to the xml.
+     * @param doc is the document that the scene is serialized to. Its entity elements are modified.
+     */
+    void SaveBinary(const String& xmlPath, XmlDocument* doc) const;
+
+    /**
+     * Loads the scene from its binary file if the file is produced from the current xml. Entities are deserialized in
+     * parallel, their ids, prefabs and parents are resolved afterwards in file order.
+     * @param xmlFile is the content of the xml file of the scene.
+     * @return False if the binary file is missing, out of date or corrupt. Nothing is added to the scene in that case.
+     */
+    bool LoadBinary(const MappedFile& xmlFile);
+
+    /** Returns the entities that are written to the scene file, in order. Prefab children are created by prefabs. */
+    void GetSerializedEntities(EntityPtrArray& entities) const;
+
     /**
      * Returns the biggest number generated during the current runtime. This
      * function is used to avoid ID collision during scene merges.
@@ -299,6 +387,37 @@ namespace ToolKit
      */
     void _RemoveChildren(EntityPtr removed);
 
+    /** Adds or removes the id of the entity to the index under each of the keys. */
+    void UpdateIndex(std::unordered_map<String, IDArray>& index, const StringArray& keys, ObjectId id, bool add);
+
+    /** Adds or removes the entity to the name and tag indices. */
+    void UpdateNameAndTagIndices(Entity* ntt, bool add);
+
+    /**
+     * Rebuilds the id, name and tag indices and the archetypes from the entity list. Used after the list is altered
+     * directly.
+     */
+    void RebuildEntityIndices();
+
+    /** Adds the entity to the archetype of its component mask. Archetype is created if it doesn't exist. */
+    void AddToArchetype(Entity* ntt);
+
+    /** Removes the entity from its archetype. Last entity of the archetype is moved in place of the removed one. */
+    void RemoveFromArchetype(Entity* ntt);
+
+    /** Removes all entities from the archetypes. */
+    void ClearArchetypes();
+
+    /** Moves the entity to the archetype of its new component mask. Called by the entity. */
+    void OnEntityComponentsChanged(Entity* ntt);
+
+    /** Updates the indices of the entity, after its id, name or tag changes. Called by the entity. */
+    void OnEntityIdChanged(Entity* ntt, ObjectId oldId);
+    void OnEntityNameChanged(Entity* ntt, const String& oldName);
+    void OnEntityTagChanged(Entity* ntt, const String& oldTag);
+
+    friend class Entity;
+
    public:
     PostProcessingSettingsPtr m_postProcessSettings; //!< Post process settings that this scene uses
 
@@ -314,6 +433,22 @@ namespace ToolKit
     mutable LightRawPtrArray m_directionalLightCache;              //!< Cached directional lights in the scene.
     mutable EnvironmentComponentPtrArray m_environmentVolumeCache; //!< Environment volumes in the scene.
     mutable SkyBasePtr m_skyCache;                                 //!< Last added sky.
+    TransformSystem* m_transformSystem   = nullptr;                //!< Batched transform updates, null if disabled.
+    RenderProxyStore* m_renderProxyStore = nullptr;                //!< Retained render jobs of the entities.
+
+    std::unordered_map<ObjectId, int> m_entityIndices; //!< Index of each entity in the entity list by id.
+    std::unordered_map<String, IDArray> m_nameIndex;   //!< Ids of the entities by name.
+    std::unordered_map<String, IDArray> m_tagIndex;    //!< Ids of the entities by each tag.
+
+    /** Entities that have components of the same classes. */
+    struct Archetype
+    {
+      ComponentMask mask;         //!< Component classes of the entities.
+      EntityRawPtrArray entities; //!< Entities of the archetype. Entities hold their index in this array.
+    };
+
+    std::vector<Archetype> m_archetypes;                       //!< Archetypes, kept until the indices are rebuilt.
+    std::unordered_map<ComponentMask, int> m_archetypeIndices; //!< Index of the archetype of each component mask.
   };
 
   /**
@@ -16,12 +16,131 @@ namespace ToolKit
   /** Progress callback for loading. */
   typedef std::function<void(float)> ProgressCallback;
 
+  class ResourceRequest;
+
+  /** Resource requests that are loading in the background, paired with the name of the variant that waits for them. */
+  typedef std::vector<std::pair<String, std::shared_ptr<ResourceRequest>>> StreamedResourceArray;
+
+  /**
+   * Content and string table of a binary file that xml elements refer to. Elements that are stored in binary carry
+   * the offset of their data in XmlBinaryOffsetAttr instead of their children.
+   */
+  struct BinaryData
+  {
+    const uint8* Data = nullptr; //!< Start of the file content.
+    uint64 Size       = 0;       //!< Size of the file content in bytes.
+    StringArray Strings;         //!< Strings that the data refers to by index.
+  };
+
+  /** Appends values to a byte array. Strings are written once to a string table and referred by their index. */
+  class BinaryWriter
+  {
+   public:
+    /** Appends the bytes of a plain value, such as numbers and math types. */
+    template <typename T>
+    void Write(const T& val)
+    {
+      static_assert(std::is_trivially_destructible_v<T> && !std::is_pointer_v<T>, "Only plain values can be written.");
+      WriteBytes(&val, sizeof(T));
+    }
+
+    /** Appends raw bytes. */
+    void WriteBytes(const void* data, uint64 size)
+    {
+      const uint8* bytes = static_cast<const uint8*>(data);
+      m_data.insert(m_data.end(), bytes, bytes + size);
+    }
+
+    /** Returns the index of the string in the string table, adds the string to the table if it is not there. */
+    uint32 AddString(const String& str)
+    {
+      auto itr = m_stringIndexes.find(str);
+      if (itr == m_stringIndexes.end())
+      {
+        itr = m_stringIndexes.insert({str, (uint32) m_strings.size()}).first;
+        m_strings.push_back(str);
+      }
+
+      return itr->second;
+    }
+
+    /** Appends the index of the string in the string table. */
+    void WriteString(const String& str) { Write(AddString(str)); }
+
+    /** Appends zeros until the size is a multiple of the alignment, which must be a power of two. */
+    void Align(uint64 alignment) { m_data.resize((m_data.size() + alignment - 1) & ~(alignment - 1), 0); }
+
+    /** Returns the offset that the next value is written to. */
+    uint64 Tell() const { return m_data.size(); }
+
+   public:
+    std::vector<uint8> m_data; //!< Written bytes.
+    StringArray m_strings;     //!< String table, in the order that the strings are first written.
+
+   private:
+    std::unordered_map<String, uint32> m_stringIndexes; //!< Index of each string in the table.
+  };
+
+  /** Reads values written by BinaryWriter. Reads are bounds checked, reader fails instead of reading out of data. */
+  class BinaryReader
+  {
+   public:
+    BinaryReader(const BinaryData& data, uint64 offset) : m_data(data), m_offset(offset) {}
+
+    /** Reads a plain value. Returns false and leaves the value unchanged if the data is exhausted. */
+    template <typename T>
+    bool Read(T& val)
+    {
+      static_assert(std::is_trivially_destructible_v<T> && !std::is_pointer_v<T>, "Only plain values can be read.");
+      if (m_failed || m_offset > m_data.Size || sizeof(T) > m_data.Size - m_offset)
+      {
+        m_failed = true;
+        return false;
+      }
+
+      memcpy(&val, m_data.Data + m_offset, sizeof(T));
+      m_offset += sizeof(T);
+      return true;
+    }
+
+    /** Reads a string table index and returns the string. Returns false if the index is out of the table. */
+    bool ReadString(String& str)
+    {
+      uint32 index = 0;
+      if (!Read(index) || index >= m_data.Strings.size())
+      {
+        m_failed = true;
+        return false;
+      }
+
+      str = m_data.Strings[index];
+      return true;
+    }
+
+    /** Returns true if any read failed. */
+    bool Failed() const { return m_failed; }
+
+   private:
+    const BinaryData& m_data; //!< Data that is read.
+    uint64 m_offset;          //!< Offset of the next value.
+    bool m_failed = false;    //!< States if a read ran out of the data.
+  };
+
   /** Serializaiton info for loading. */
   struct TK_API SerializationFileInfo
   {
+    /**
+     * If set, textures that are not loaded yet are requested with ResourceManager::CreateAsync. Their variants are
+     * left empty and the requests are appended here for the owner to set them once they are ready.
+     */
+    StreamedResourceArray* StreamedTextures = nullptr;
+
     String File;
     String Version;
-    XmlDocument* Document = nullptr;
+    XmlDocument* Document     = nullptr;
+    const BinaryData* Binary  = nullptr; //!< Binary data that the elements refer to, if the file is binary.
+    std::atomic_bool* Corrupt = nullptr; //!< Set if the binary data is corrupt, so the caller loads the xml instead.
+    bool DeferIdCollision     = false;   //!< Objects don't claim their ids, caller resolves the collisions in order.
   };
 
   /** Serializable object base class. */
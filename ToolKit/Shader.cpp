@@ -10,6 +10,7 @@
 #include "FileManager.h"
 #include "GpuProgram.h"
 #include "Logger.h"
+#include "Stats.h"
 #include "TKAssert.h"
 #include "TKOpenGL.h"
 #include "ToolKit.h"
@@ -117,28 +118,45 @@ namespace ToolKit
       return;
     }
 
-    if (!m_defineArray.empty())
-    {
-      ShaderDefineCombinaton defineCombo;
-      ComplieShaderCombinations(m_defineArray, 0, defineCombo);
-    }
-    else
+    m_sourceHash = StringHash(m_source);
+
+    // Start with the first value of each define.
+    m_currentDefineValues.clear();
+    for (int i = 0; i < (int) m_defineArray.size(); i++)
     {
-      Compile(m_source);
+      m_currentDefineValues.push_back({i, 0});
     }
 
     if (flushClientSideArray)
     {
+      // Variants can't be compiled once the source is gone, so all of them are submitted before the flush.
+      SubmitAllVariants(0);
+
+      for (ShaderDefineIndex& defineValue : m_currentDefineValues)
+      {
+        defineValue.variant = 0;
+      }
+
       m_source.clear();
+      m_source.shrink_to_fit();
     }
 
+    SelectVariant(GetCurrentVariantKey());
+
     m_initiated = true;
   }
 
   void Shader::UnInit()
   {
-    glDeleteShader(m_shaderHandle);
-    m_initiated = false;
+    for (auto& [key, variant] : m_shaderVariantMap)
+    {
+      glDeleteShader(variant.handle);
+    }
+
+    m_shaderVariantMap.clear();
+    m_currentVariant = nullptr;
+    m_shaderHandle   = 0;
+    m_initiated      = false;
   }
 
   void Shader::Save(bool onlyIfDirty)
@@ -193,17 +211,127 @@ namespace ToolKit
     key.pop_back();
 
     // Set the shader variant.
-    auto handle = m_shaderVariantMap.find(key);
-    if (handle != m_shaderVariantMap.end())
+    SelectVariant(key);
+  }
+
+  uint64 Shader::GetVariantHash() const { return m_currentVariant != nullptr ? m_currentVariant->hash : 0; }
+
+  void Shader::SubmitCompile()
+  {
+    if (m_currentVariant == nullptr || m_currentVariant->handle != 0 || m_currentVariant->checked)
     {
-      m_shaderHandle = m_shaderVariantMap[key];
+      return;
+    }
+
+    if (m_source.empty())
+    {
+      TK_ERR("Shader source is flushed, variant can't be compiled: %s", GetFile().c_str());
+      m_currentVariant->checked = true;
+      return;
+    }
+
+    float beginTime = GetElapsedMilliSeconds();
+
+    uint handle     = 0;
+    if (m_defineArray.empty())
+    {
+      handle = Compile(m_source);
     }
     else
     {
-      TK_ERR("Unknown shader combination %s", key.c_str());
+      handle = CompileWithDefines(m_source, m_currentDefineValues);
+    }
+
+    // Shader object couldn't be created, there is nothing to wait for.
+    m_currentVariant->handle  = handle;
+    m_currentVariant->checked = handle == 0;
+
+    if (TKStats* stats = GetTKStats())
+    {
+      stats->m_shaderCompileCount++;
+      stats->m_shaderCompileTime += GetElapsedMilliSeconds() - beginTime;
     }
   }
 
+  uint Shader::GetCompiledHandle()
+  {
+    SubmitCompile();
+
+    if (m_currentVariant == nullptr)
+    {
+      return 0;
+    }
+
+    if (!m_currentVariant->checked)
+    {
+      float beginTime = GetElapsedMilliSeconds();
+
+      if (!CheckCompileStatus(m_currentVariant->handle))
+      {
+        glDeleteShader(m_currentVariant->handle);
+        m_currentVariant->handle = 0;
+      }
+      m_currentVariant->checked = true;
+
+      if (TKStats* stats = GetTKStats())
+      {
+        stats->m_shaderCompileTime += GetElapsedMilliSeconds() - beginTime;
+      }
+    }
+
+    m_shaderHandle = m_currentVariant->handle;
+    return m_shaderHandle;
+  }
+
+  String Shader::GetCurrentVariantKey() const
+  {
+    String key;
+    for (const ShaderDefineIndex& defineValue : m_currentDefineValues)
+    {
+      const ShaderDefine& define  = m_defineArray[defineValue.define];
+      key                        += define.define + ":" + define.variants[defineValue.variant] + "|";
+    }
+
+    if (!key.empty())
+    {
+      key.pop_back();
+    }
+
+    return key;
+  }
+
+  void Shader::SubmitAllVariants(int defineIndex)
+  {
+    if (defineIndex == (int) m_currentDefineValues.size())
+    {
+      SelectVariant(GetCurrentVariantKey());
+      SubmitCompile();
+      return;
+    }
+
+    int variantCount = (int) m_defineArray[m_currentDefineValues[defineIndex].define].variants.size();
+    for (int i = 0; i < variantCount; i++)
+    {
+      m_currentDefineValues[defineIndex].variant = i;
+      SubmitAllVariants(defineIndex + 1);
+    }
+  }
+
+  void Shader::SelectVariant(const String& key)
+  {
+    auto variant = m_shaderVariantMap.find(key);
+    if (variant == m_shaderVariantMap.end())
+    {
+      ShaderVariant newVariant;
+      newVariant.hash = MurmurHash(m_sourceHash ^ StringHash(key));
+      variant         = m_shaderVariantMap.emplace(key, newVariant).first;
+    }
+
+    // Map items keep their addresses when new items are inserted.
+    m_currentVariant = &variant->second;
+    m_shaderHandle   = m_currentVariant->checked ? m_currentVariant->handle : 0;
+  }
+
   XmlNode* Shader::SerializeImp(XmlDocument* doc, XmlNode* parent) const { return nullptr; }
 
   XmlNode* Shader::DeSerializeImp(const SerializationFileInfo& info, XmlNode* parent)
@@ -390,8 +518,8 @@ namespace ToolKit
       return 0;
     }
 
-    m_shaderHandle = glCreateShader(type);
-    if (m_shaderHandle == 0)
+    uint handle = glCreateShader(type);
+    if (handle == 0)
     {
       return 0;
     }
@@ -409,32 +537,37 @@ namespace ToolKit
       str = source.c_str();
     }
 
-    glShaderSource(m_shaderHandle, 1, &str, nullptr);
-    glCompileShader(m_shaderHandle);
+    // Status is queried when the shader is needed, so that the drivers supporting it can compile in background.
+    glShaderSource(handle, 1, &str, nullptr);
+    glCompileShader(handle);
 
+    return handle;
+  }
+
+  bool Shader::CheckCompileStatus(uint handle)
+  {
     GLint compiled;
-    glGetShaderiv(m_shaderHandle, GL_COMPILE_STATUS, &compiled);
+    glGetShaderiv(handle, GL_COMPILE_STATUS, &compiled);
     if (!compiled)
     {
       GLint infoLen = 0;
-      glGetShaderiv(m_shaderHandle, GL_INFO_LOG_LENGTH, &infoLen);
+      glGetShaderiv(handle, GL_INFO_LOG_LENGTH, &infoLen);
       if (infoLen > 1)
       {
         char* log = new char[infoLen];
-        glGetShaderInfoLog(m_shaderHandle, infoLen, nullptr, log);
+        glGetShaderInfoLog(handle, infoLen, nullptr, log);
 
-        TK_ERR(log);
+        TK_ERR("Shader compilation failed: %s\n%s", GetFile().c_str(), log);
         SafeDelArray(log);
       }
 
-      glDeleteShader(m_shaderHandle);
-      return 0;
+      return false;
     }
 
-    return m_shaderHandle;
+    return true;
   }
 
-  void Shader::CompileWithDefines(String source, const ShaderDefineCombinaton& defineCombo)
+  uint Shader::CompileWithDefines(String source, const ShaderDefineCombinaton& defineCombo)
   {
     String key; // Hash key for the shader variant.
     String defineText;
@@ -455,33 +588,7 @@ namespace ToolKit
 
     TK_LOG("Compiling shader with defines: %s", key.c_str());
 
-    if (Compile(source) != 0)
-    {
-      m_currentDefineValues   = defineCombo;
-      m_shaderVariantMap[key] = m_shaderHandle;
-    }
-  }
-
-  void Shader::ComplieShaderCombinations(const ShaderDefineArray& defineArray,
-                                         int index,
-                                         ShaderDefineCombinaton& currentCombinaiton)
-  {
-    if (index == defineArray.size())
-    {
-      // Compile the final combo.
-      CompileWithDefines(m_source, currentCombinaiton);
-      return;
-    }
-
-    const ShaderDefine& currentDefine = defineArray[index];
-    for (int vi = (int) currentDefine.variants.size() - 1; vi >= 0; vi--)
-    {
-      currentCombinaiton.push_back({index, vi});
-
-      // Recursively generate combinations
-      ComplieShaderCombinations(defineArray, index + 1, currentCombinaiton);
-      currentCombinaiton.pop_back();
-    }
+    return Compile(source);
   }
 
   // ShaderManager
@@ -504,9 +611,9 @@ namespace ToolKit
 
   bool ShaderManager::CanStore(ClassMeta* Class) { return Class == Shader::StaticClass(); }
 
-  ShaderPtr ShaderManager::GetDefaultVertexShader() { return Cast<Shader>(m_storage[m_defaultVertexShaderFile]); }
+  ShaderPtr ShaderManager::GetDefaultVertexShader() { return Cast<Shader>(Find(m_defaultVertexShaderFile)); }
 
-  ShaderPtr ShaderManager::GetPbrForwardShader() { return Cast<Shader>(m_storage[m_pbrForwardShaderFile]); }
+  ShaderPtr ShaderManager::GetPbrForwardShader() { return Cast<Shader>(Find(m_pbrForwardShaderFile)); }
 
   const String& ShaderManager::PbrForwardShaderFile() { return m_pbrForwardShaderFile; }
 
@@ -65,9 +65,25 @@ namespace ToolKit
      * There must be a value declared in the shader file matching with new val.
      * To set the define values, the shader must be initialized.
      * This function won't add new defines or variants, only sets the existing shader variant.
+     * Variants are compiled when they are first needed by a program.
      */
     void SetDefine(const StringView name, const StringView val);
 
+    /**
+     * Returns the hash of the current variant, calculated from the shader source and the define values. It is stable
+     * between runs and identifies the variant in the program binary cache.
+     */
+    uint64 GetVariantHash() const;
+
+    /** Starts compiling the current variant if it is not compiled yet. Capable drivers compile it in background. */
+    void SubmitCompile();
+
+    /**
+     * Compiles the current variant if it is not compiled yet and waits for the compilation to complete.
+     * @return Shader handle of the current variant, 0 if the compilation fails.
+     */
+    uint GetCompiledHandle();
+
     XmlNode* SerializeImp(XmlDocument* doc, XmlNode* parent) const override;
     XmlNode* DeSerializeImp(const SerializationFileInfo& info, XmlNode* parent) override;
 
@@ -82,11 +98,17 @@ namespace ToolKit
     uint FindShaderMergeLocation(const String& file);
 
     /**
-     * Compiles the given source string.
-     * @return shader handle for compiled shader.
+     * Submits the given source string for compilation. Compile status is not waited for.
+     * @return shader handle for the shader being compiled.
      */
     uint Compile(String source);
 
+    /**
+     * Waits for the compilation of the shader and reports the errors.
+     * @return True if the shader is compiled successfully.
+     */
+    bool CheckCompileStatus(uint handle);
+
     /** Internally used structure to point to a define variant. */
     struct ShaderDefineIndex
     {
@@ -96,13 +118,25 @@ namespace ToolKit
 
     typedef std::vector<ShaderDefineIndex> ShaderDefineCombinaton;
 
-    /** Update the source file with the given define combinations and compile the shader. */
-    void CompileWithDefines(String source, const ShaderDefineCombinaton& defineArray);
+    /** Update the source file with the given define combinations and submit it for compilation. */
+    uint CompileWithDefines(String source, const ShaderDefineCombinaton& defineArray);
+
+    /** Sets the variant for the given key as the current variant. Variant is created if it doesn't exist. */
+    void SelectVariant(const String& key);
+
+    /** Constructs the variant key from the current define values. Key format is described in variant map. */
+    String GetCurrentVariantKey() const;
+
+    /** Submits every define combination starting from the given define for compilation. */
+    void SubmitAllVariants(int defineIndex);
 
-    /** Constructs shader define combinations and compiles each combination. */
-    void ComplieShaderCombinations(const ShaderDefineArray& defineArray,
-                                   int index,
-                                   ShaderDefineCombinaton& currentCombination);
+    /** Internally used structure that holds a variant of the shader. */
+    struct ShaderVariant
+    {
+      uint handle  = 0;     //!< Shader handle, 0 until the variant is submitted for compilation.
+      uint64 hash  = 0;     //!< Hash of the source and the define values.
+      bool checked = false; //!< Whether the compile status is checked. Failed variants aren't compiled again.
+    };
 
    public:
     struct ArrayUniform
@@ -124,7 +158,7 @@ namespace ToolKit
     /** Type of the shader. */
     ShaderType m_shaderType = ShaderType::VertexShader;
 
-    /** Internal Id that is being used by graphics API. */
+    /** Internal Id of the current variant that is being used by graphics API. 0 until the variant is compiled. */
     uint m_shaderHandle     = 0;
 
     /** Include files that this shader needs. */
@@ -138,16 +172,22 @@ namespace ToolKit
 
    private:
     /**
-     * The map holds the compiled shader resource id for given key.
+     * The map holds the shader variant for given key.
      * Shaders may hold multiple defines and multiple variants per define. Which leads to a combination of
      * Shaders based on defines and their values. The key string is constructed from the current define values and
-     * points to the version of the compiled shader for the given combination. The look up table is used to find the
-     * program for a given define combination in the string. Key format: DefineName:Value|DefineName:Value ...
+     * points to the version of the shader for the given combination. Variants are added to the map as they are
+     * selected and compiled when they are first used. Key format: DefineName:Value|DefineName:Value ...
      */
-    std::unordered_map<String, uint> m_shaderVariantMap;
+    std::unordered_map<String, ShaderVariant> m_shaderVariantMap;
 
     /** Current define value pairs in an array. */
     ShaderDefineCombinaton m_currentDefineValues;
+
+    /** Variant for the current define values. Points to an item in the variant map. */
+    ShaderVariant* m_currentVariant = nullptr;
+
+    /** Hash of the shader source including the included shaders. */
+    uint64 m_sourceHash             = 0;
   };
 
   class TK_API ShaderManager : public ResourceManager
@@ -15,10 +15,12 @@
 #include "MathUtil.h"
 #include "Mesh.h"
 #include "RHI.h"
+#include "RenderProxyStore.h"
 #include "RenderSystem.h"
 #include "Scene.h"
 #include "Stats.h"
 #include "ToolKit.h"
+#include "Util.h"
 
 #include "DebugNew.h"
 
@@ -76,13 +78,26 @@ namespace ToolKit
     Renderer* renderer        = GetRenderer();
     const Vec4 lastClearColor = renderer->m_clearColor;
 
-    // Clear shadow atlas before any draw call
-    renderer->SetFramebuffer(m_shadowFramebuffer, GraphicBitFields::AllBits);
-    for (int i = 0; i < m_layerCount; i++)
+    // Shadow maps are cleared one by one, cached ones must be preserved in the atlas.
+    renderer->SetFramebuffer(m_shadowFramebuffer, GraphicBitFields::None);
+
+    // Without caching, all shadow maps are rendered again.
+    if (!GetEngineSettings().m_graphics->m_shadows->GetCacheShadowMapsVal())
+    {
+      m_shadowMapSignatures.clear();
+    }
+
+    // Signatures of the removed lights are dropped.
+    std::unordered_map<ULongID, std::vector<uint64>> signatures;
+    for (Light* light : m_lights)
     {
-      m_shadowFramebuffer->SetColorAttachment(Framebuffer::Attachment::ColorAttachment0, m_shadowAtlas, 0, i);
-      renderer->ClearBuffer(GraphicBitFields::ColorBits, m_shadowClearColor);
+      auto signatureItr = m_shadowMapSignatures.find(light->GetIdVal());
+      if (signatureItr != m_shadowMapSignatures.end())
+      {
+        signatures[light->GetIdVal()] = std::move(signatureItr->second);
+      }
     }
+    m_shadowMapSignatures = std::move(signatures);
 
     // Update shadow maps.
     for (Light* light : m_lights)
@@ -164,83 +179,135 @@ namespace ToolKit
 
   void ShadowPass::RenderShadowMaps(Light* light)
   {
-    Renderer* renderer        = GetRenderer();
-    ShadowSettingsPtr shadows = GetEngineSettings().m_graphics->m_shadows;
-
     if (light->GetLightType() == Light::LightType::Directional)
     {
-      int cascadeCount         = shadows->GetCascadeCountVal();
-      DirectionalLight* dLight = static_cast<DirectionalLight*>(light);
+      ShadowSettingsPtr shadows = GetEngineSettings().m_graphics->m_shadows;
+      int cascadeCount          = shadows->GetCascadeCountVal();
+      DirectionalLight* dLight  = static_cast<DirectionalLight*>(light);
       for (int i = 0; i < cascadeCount; i++)
       {
-        int layer = dLight->m_shadowAtlasLayers[i];
-        m_shadowFramebuffer->SetColorAttachment(Framebuffer::Attachment::ColorAttachment0, m_shadowAtlas, 0, layer);
-
-        renderer->ClearBuffer(GraphicBitFields::DepthBits, m_shadowClearColor);
-
-        UVec2 coord     = dLight->m_shadowAtlasCoords[i];
-        uint resolution = (uint) light->GetShadowResVal().GetValue<float>();
-        renderer->SetViewportSize(coord.x, coord.y, resolution, resolution);
-
-        RenderShadowMap(light, dLight->m_cascadeShadowCameras[i], dLight->m_cascadeCullCameras[i]);
-
-        // Depth is invalidated because, atlas has the shadow map.
-        renderer->InvalidateFramebufferDepth(m_shadowFramebuffer);
+        RenderShadowMap(light, i, dLight->m_cascadeShadowCameras[i], dLight->m_cascadeCullCameras[i]);
       }
     }
     else if (light->GetLightType() == Light::LightType::Point)
     {
       for (int i = 0; i < 6; i++)
       {
-        int layer = light->m_shadowAtlasLayers[i];
-        m_shadowFramebuffer->SetColorAttachment(Framebuffer::Attachment::ColorAttachment0, m_shadowAtlas, 0, layer);
-
         light->m_shadowCamera->m_node->SetTranslation(light->m_node->GetTranslation());
         light->m_shadowCamera->m_node->SetOrientation(m_cubeMapRotations[i]);
 
-        renderer->ClearBuffer(GraphicBitFields::DepthBits, m_shadowClearColor);
-
-        UVec2 coord     = light->m_shadowAtlasCoords[i];
-        uint resolution = (uint) light->GetShadowResVal().GetValue<float>();
-        renderer->SetViewportSize(coord.x, coord.y, resolution, resolution);
-
-        RenderShadowMap(light, light->m_shadowCamera, light->m_shadowCamera);
-
-        // Depth is invalidated because, atlas has the shadow map.
-        renderer->InvalidateFramebufferDepth(m_shadowFramebuffer);
+        RenderShadowMap(light, i, light->m_shadowCamera, light->m_shadowCamera);
       }
     }
     else
     {
       assert(light->GetLightType() == Light::LightType::Spot);
+      RenderShadowMap(light, 0, light->m_shadowCamera, light->m_shadowCamera);
+    }
+  }
 
-      m_shadowFramebuffer->SetColorAttachment(Framebuffer::Attachment::ColorAttachment0,
-                                              m_shadowAtlas,
-                                              0,
-                                              light->m_shadowAtlasLayers[0]);
+  void ShadowPass::RenderShadowMap(Light* light, int mapIndex, CameraPtr shadowCamera, CameraPtr cullCamera)
+  {
+    // Shadow map couldn't be placed in the atlas.
+    if (light->m_shadowAtlasLayers[mapIndex] == -1)
+    {
+      return;
+    }
 
-      renderer->ClearBuffer(GraphicBitFields::DepthBits, m_shadowClearColor);
+    Renderer* renderer = GetRenderer();
 
-      UVec2 coord     = light->m_shadowAtlasCoords[0];
-      uint resolution = (uint) light->GetShadowResVal().GetValue<float>();
+    RenderData renderData;
+    CollectShadowCasters(light, cullCamera, renderData);
 
-      renderer->SetViewportSize(coord.x, coord.y, resolution, resolution);
-      RenderShadowMap(light, light->m_shadowCamera, light->m_shadowCamera);
+    int layer                       = light->m_shadowAtlasLayers[mapIndex];
+    UVec2 coord                     = light->m_shadowAtlasCoords[mapIndex];
+    uint resolution                 = (uint) light->GetShadowMapResolution();
 
-      // Depth is invalidated because, atlas has the shadow map.
-      renderer->InvalidateFramebufferDepth(m_shadowFramebuffer);
+    // Shadow map in the atlas is reused if nothing that it depends on is changed.
+    std::vector<uint64>& signatures = m_shadowMapSignatures[light->GetIdVal()];
+    if ((int) signatures.size() <= mapIndex)
+    {
+      signatures.resize(mapIndex + 1, 0);
     }
-  }
 
-  void ShadowPass::RenderShadowMap(Light* light, CameraPtr shadowCamera, CameraPtr cullCamera)
-  {
-    Renderer* renderer = GetRenderer();
+    uint64 signature = GetShadowMapSignature(shadowCamera, coord, layer, resolution, renderData);
+    if (signatures[mapIndex] == signature)
+    {
+      if (TKStats* stats = GetTKStats())
+      {
+        stats->m_shadowMapCacheHitPerFrame++;
+      }
+
+      return;
+    }
+
+    signatures[mapIndex] = signature;
+    if (TKStats* stats = GetTKStats())
+    {
+      stats->m_shadowMapCacheMissPerFrame++;
+    }
+
+    m_shadowFramebuffer->SetColorAttachment(Framebuffer::Attachment::ColorAttachment0, m_shadowAtlas, 0, layer);
+
+    // Only the region of the shadow map is cleared, other shadow maps in the layer may be cached.
+    renderer->ClearBufferRegion(GraphicBitFields::AllBits,
+                                m_shadowClearColor,
+                                coord.x,
+                                coord.y,
+                                resolution,
+                                resolution);
+    renderer->SetViewportSize(coord.x, coord.y, resolution, resolution);
 
     // Adjust light's camera.
     renderer->SetCamera(shadowCamera, false);
 
+    // Groups the jobs that can be instanced.
+    bool instancing = GetEngineSettings().m_graphics->GetGpuInstancingVal();
+    if (instancing)
+    {
+      RenderJobProcessor::SortByMaterial(renderData);
+    }
+
+    renderer->OverrideBlendState(true, BlendFunction::NONE); // Blending must be disabled for shadow map generation.
+
+    // Set material and program.
     Light::LightType lightType = light->GetLightType();
-    if (lightType == Light::LightType::Directional)
+    MaterialPtr shadowMaterial = lightType == Light::LightType::Directional ? m_shadowMatOrtho : m_shadowMatPersp;
+    ShaderPtr frag             = shadowMaterial->GetFragmentShaderVal();
+    frag->SetDefine("DrawAlphaMasked", "0");
+    ShaderPtr vert = shadowMaterial->GetVertexShaderVal();
+    vert->SetDefine("Instanced", instancing ? "1" : "0");
+
+    GpuProgramManager* gpuProgramManager = GetGpuProgramManager();
+    m_program                            = gpuProgramManager->CreateProgram(vert, frag);
+    renderer->BindProgram(m_program);
+
+    // Draw opaque.
+    RenderJobItr forwardBegin       = renderData.GetForwardOpaqueBegin();
+    RenderJobItr forwardMaskedBegin = renderData.GetForwardAlphaMaskedBegin();
+    RenderJobs(forwardBegin, forwardMaskedBegin, instancing);
+
+    // Draw alpha masked.
+    frag->SetDefine("DrawAlphaMasked", "1");
+    m_program = gpuProgramManager->CreateProgram(vert, frag);
+    renderer->BindProgram(m_program);
+
+    RenderJobItr translucentBegin = renderData.GetForwardTranslucentBegin();
+    RenderJobs(forwardMaskedBegin, translucentBegin, instancing);
+
+    vert->SetDefine("Instanced", "0");
+
+    // Translucent shadow is not supported.
+
+    renderer->OverrideBlendState(false, BlendFunction::NONE);
+
+    // Depth is invalidated because, atlas has the shadow map.
+    renderer->InvalidateFramebufferDepth(m_shadowFramebuffer);
+  }
+
+  void ShadowPass::CollectShadowCasters(Light* light, CameraPtr cullCamera, RenderData& renderData)
+  {
+    if (light->GetLightType() == Light::LightType::Directional)
     {
       // Here we will try to find a distance that covers all shadow casters.
       // Shadow camera placed at the outer bounds of the scene to find all shadow casters.
@@ -260,10 +327,6 @@ namespace ToolKit
       cullCamera->SetFarClipVal(glm::distance(outerPoint, pos) + cullCamera->Far());
     }
 
-    // Create render jobs for shadow map generation.
-    RenderJobArray jobs;
-    RenderData renderData;
-
     Frustum frustum            = ExtractFrustum(cullCamera->GetProjectViewMatrix(), false);
     EntityRawPtrArray entities = m_params.scene->m_aabbTree.VolumeQuery(frustum);
 
@@ -279,121 +342,190 @@ namespace ToolKit
                return false;
              });
 
-    RenderJobProcessor::CreateRenderJobs(renderData.jobs, entities);
+    m_params.scene->GetRenderProxyStore()->CollectRenderJobs(renderData.jobs, entities);
     RenderJobProcessor::SeperateRenderData(renderData, true);
+  }
 
-    renderer->OverrideBlendState(true, BlendFunction::NONE); // Blending must be disabled for shadow map generation.
-
-    // Set material and program.
-    MaterialPtr shadowMaterial = lightType == Light::LightType::Directional ? m_shadowMatOrtho : m_shadowMatPersp;
-    ShaderPtr frag             = shadowMaterial->GetFragmentShaderVal();
-    frag->SetDefine("DrawAlphaMasked", "0");
-    ShaderPtr vert                       = shadowMaterial->GetVertexShaderVal();
-
-    GpuProgramManager* gpuProgramManager = GetGpuProgramManager();
-    m_program                            = gpuProgramManager->CreateProgram(vert, frag);
-    renderer->BindProgram(m_program);
-
-    // Draw opaque.
-    RenderJobItr forwardBegin       = renderData.GetForwardOpaqueBegin();
-    RenderJobItr forwardMaskedBegin = renderData.GetForwardAlphaMaskedBegin();
-    for (RenderJobItr jobItr = forwardBegin; jobItr < forwardMaskedBegin; jobItr++)
+  uint64 ShadowPass::GetShadowMapSignature(CameraPtr shadowCamera,
+                                           UVec2 coord,
+                                           int layer,
+                                           uint resolution,
+                                           RenderData& data)
+  {
+    auto hashFloatsFn = [](uint64 hash, const float* values, int count) -> uint64
     {
-      renderer->Render(*jobItr);
-    }
+      for (int i = 0; i < count; i++)
+      {
+        uint bits = 0;
+        memcpy(&bits, &values[i], sizeof(uint));
+        hash = MurmurHash(hash ^ bits);
+      }
 
-    // Draw alpha masked.
-    frag->SetDefine("DrawAlphaMasked", "1");
-    m_program = gpuProgramManager->CreateProgram(vert, frag);
-    renderer->BindProgram(m_program);
+      return hash;
+    };
 
-    RenderJobItr translucentBegin = renderData.GetForwardTranslucentBegin();
-    for (RenderJobItr jobItr = forwardMaskedBegin; jobItr < translucentBegin; jobItr++)
+    Mat4 projectView   = shadowCamera->GetProjectViewMatrix();
+    uint64 signature   = hashFloatsFn(0, &projectView[0][0], 16);
+    signature          = MurmurHash(signature ^ coord.x);
+    signature          = MurmurHash(signature ^ coord.y);
+    signature          = MurmurHash(signature ^ (uint64) layer);
+    signature          = MurmurHash(signature ^ resolution);
+
+    // Casters are summed, so that the signature doesn't depend on the order of the jobs.
+    RenderJobItr begin = data.GetForwardOpaqueBegin();
+    RenderJobItr end   = data.GetForwardTranslucentBegin();
+    uint64 casters     = (uint64) std::distance(begin, end);
+    for (RenderJobItr job = begin; job != end; job++)
     {
-      renderer->Render(*jobItr);
+      const AnimData& anim  = job->animData;
+      float animValues[]    = {anim.firstKeyFrame,
+                               anim.secondKeyFrame,
+                               anim.keyFrameInterpolationTime,
+                               anim.animationBlendFactor,
+                               anim.blendFirstKeyFrame,
+                               anim.blendSecondKeyFrame,
+                               anim.blendKeyFrameInterpolationTime};
+
+      // Versions change with the mesh data and the material parameters, render state is written directly as well.
+      RenderState* state    = job->Material->GetRenderState();
+      uint64 jobHash        = MurmurHash((uint64) job->Mesh);
+      jobHash               = MurmurHash(jobHash ^ job->Mesh->GetVersion());
+      jobHash               = MurmurHash(jobHash ^ (uint64) job->Material);
+      jobHash               = MurmurHash(jobHash ^ (uint64) job->Material->GetCacheItem().version);
+      jobHash               = MurmurHash(jobHash ^ (uint64) state->blendFunction);
+      jobHash               = hashFloatsFn(jobHash, &state->alphaMaskTreshold, 1);
+      jobHash               = MurmurHash(jobHash ^ (uint64) anim.currentAnimation.get());
+      jobHash               = MurmurHash(jobHash ^ (uint64) anim.blendAnimation.get());
+      jobHash               = hashFloatsFn(jobHash, &job->WorldTransform[0][0], 16);
+      jobHash               = hashFloatsFn(jobHash, animValues, (int) ArraySize(animValues));
+      casters              += jobHash;
     }
 
-    // Translucent shadow is not supported.
-
-    renderer->OverrideBlendState(false, BlendFunction::NONE);
+    return MurmurHash(signature ^ casters);
   }
 
-  int ShadowPass::PlaceShadowMapsToShadowAtlas(const LightRawPtrArray& lights)
+  void ShadowPass::PlaceShadowMapsToShadowAtlas(int maxLayers)
   {
-    LightRawPtrArray lightArray = lights;
-
-    // Sort all lights based on resolution.
-    std::sort(lightArray.begin(),
-              lightArray.end(),
-              [](Light* l1, Light* l2) -> bool
-              { return l1->GetShadowResVal().GetValue<float>() < l2->GetShadowResVal().GetValue<float>(); });
+    if (m_maxShadowAtlasLayers != maxLayers)
+    {
+      m_maxShadowAtlasLayers = maxLayers;
+      m_packer.Init(RHIConstants::ShadowAtlasTextureSize, maxLayers);
+      m_shadowAtlasAllocations.clear();
+    }
 
     ShadowSettingsPtr shadows = GetEngineSettings().m_graphics->m_shadows;
     const int cascadeCount    = shadows->GetCascadeCountVal();
 
-    IntArray resolutions;
-    for (size_t i = 0; i < lightArray.size(); i++)
+    auto mapCountFn           = [cascadeCount](Light* light) -> int
+    {
+      switch (light->GetLightType())
+      {
+      case Light::LightType::Directional:
+        return cascadeCount;
+      case Light::LightType::Point:
+        return 6;
+      default:
+        assert(light->GetLightType() == Light::LightType::Spot);
+        return 1;
+      }
+    };
+
+    std::unordered_map<ULongID, Light*> lightMap;
+    for (Light* light : m_lights)
     {
-      Light* light   = lightArray[i];
-      int resolution = (int) light->GetShadowResVal().GetValue<float>();
+      lightMap[light->GetIdVal()] = light;
+    }
 
-      if (light->GetLightType() == Light::Directional)
+    // Release the lights that are removed or whose shadow maps are changed.
+    bool released = false;
+    for (auto itr = m_shadowAtlasAllocations.begin(); itr != m_shadowAtlasAllocations.end();)
+    {
+      auto lightItr = lightMap.find(itr->first);
+      if (lightItr != lightMap.end())
       {
-        for (int ii = 0; ii < cascadeCount; ii++)
+        Light* light   = lightItr->second;
+        int resolution = (int) light->GetShadowResVal().GetValue<float>();
+        if (itr->second.resolution == resolution && itr->second.mapCount == mapCountFn(light))
         {
-          resolutions.push_back(resolution);
+          itr++;
+          continue;
         }
       }
-      else if (light->GetLightType() == Light::Point)
+
+      m_packer.Remove(itr->second.rect);
+      m_shadowMapSignatures.erase(itr->first);
+      itr      = m_shadowAtlasAllocations.erase(itr);
+      released = true;
+    }
+
+    // Lights that are placed with a lower resolution get a chance to be placed with their own resolution.
+    LightRawPtrArray newLights;
+    for (Light* light : m_lights)
+    {
+      auto itr = m_shadowAtlasAllocations.find(light->GetIdVal());
+      if (itr == m_shadowAtlasAllocations.end())
       {
-        for (int ii = 0; ii < 6; ii++)
-        {
-          resolutions.push_back(resolution);
-        }
+        newLights.push_back(light);
       }
-      else
+      else if (released && (!itr->second.rect.IsValid() || itr->second.rect.squareSize < itr->second.resolution))
       {
-        assert(light->GetLightType() == Light::LightType::Spot);
-        resolutions.push_back(resolution);
+        m_packer.Remove(itr->second.rect);
+        m_shadowMapSignatures.erase(itr->first);
+        m_shadowAtlasAllocations.erase(itr);
+        newLights.push_back(light);
       }
     }
 
-    int layerCount                   = 0;
-    BinPack2D::PackedRectArray rects = m_packer.Pack(resolutions, RHIConstants::ShadowAtlasTextureSize, &layerCount);
-
-    int rectIndex                    = 0;
-    for (int i = 0; i < lightArray.size(); i++)
+    // Largest groups are placed first for a tighter packing.
+    std::sort(newLights.begin(),
+              newLights.end(),
+              [&mapCountFn](Light* l1, Light* l2) -> bool
+              {
+                float area1 = l1->GetShadowResVal().GetValue<float>() * mapCountFn(l1);
+                float area2 = l2->GetShadowResVal().GetValue<float>() * mapCountFn(l2);
+                return area1 > area2;
+              });
+
+    for (Light* light : newLights)
     {
-      Light* light = lightArray[i];
-      if (light->GetLightType() == Light::LightType::Directional)
+      ShadowAtlasAllocation allocation;
+      allocation.resolution = (int) light->GetShadowResVal().GetValue<float>();
+      allocation.mapCount   = mapCountFn(light);
+
+      // Resolution is halved until the shadow maps fit in the layer limit.
+      for (int size = allocation.resolution; size >= (int) RHIConstants::MinShadowMapResolution; size /= 2)
       {
-        for (int ii = 0; ii < cascadeCount; ii++)
+        allocation.rect = m_packer.Insert(size, allocation.mapCount);
+        if (allocation.rect.IsValid())
         {
-          light->m_shadowAtlasCoords[ii] = rects[rectIndex].coordinate;
-          light->m_shadowAtlasLayers[ii] = rects[rectIndex].layer;
-          rectIndex++;
+          break;
         }
       }
-      else if (light->GetLightType() == Light::LightType::Point)
+
+      if (!allocation.rect.IsValid())
       {
-        for (int ii = 0; ii < 6; ii++)
-        {
-          light->m_shadowAtlasCoords[ii] = rects[rectIndex].coordinate;
-          light->m_shadowAtlasLayers[ii] = rects[rectIndex].layer;
-          rectIndex++;
-        }
+        TK_ERR("Shadow maps of the light %s can't fit into the shadow atlas.", light->GetNameVal().c_str());
       }
-      else
+      else if (allocation.rect.squareSize < allocation.resolution)
       {
-        assert(light->GetLightType() == Light::LightType::Spot);
+        TK_WRN("Shadow resolution of the light %s is reduced to %d to fit into the shadow atlas.",
+               light->GetNameVal().c_str(),
+               allocation.rect.squareSize);
+      }
 
-        light->m_shadowAtlasCoords[0] = rects[rectIndex].coordinate;
-        light->m_shadowAtlasLayers[0] = rects[rectIndex].layer;
-        rectIndex++;
+      // Lights that are not placed keep the layer -1, their shadows are neither rendered nor sampled.
+      for (int i = 0; i < allocation.mapCount; i++)
+      {
+        BinPack2D::PackedRect square  = m_packer.GetSquare(allocation.rect, i);
+        light->m_shadowAtlasCoords[i] = square.coordinate;
+        light->m_shadowAtlasLayers[i] = allocation.rect.IsValid() ? square.layer : -1;
       }
-    }
 
-    return layerCount;
+      light->m_shadowAtlasResolution = allocation.rect.IsValid() ? (float) allocation.rect.squareSize : 0.0f;
+      light->InvalidateCacheItem();
+
+      m_shadowAtlasAllocations[light->GetIdVal()] = allocation;
+    }
   }
 
   void ShadowPass::InitShadowAtlas()
@@ -419,32 +551,28 @@ namespace ToolKit
       needChange          = true;
     }
 
-    // After this loop m_previousShadowCasters is set with lights with shadows
-    int nextId = 0;
-    for (int i = 0; i < m_lights.size(); ++i)
+    for (Light* light : m_lights)
     {
-      Light* light = m_lights[i];
       if (light->m_shadowResolutionUpdated)
       {
         light->m_shadowResolutionUpdated = false;
         needChange                       = true;
       }
+    }
 
-      if (nextId >= m_previousShadowCasters.size())
-      {
-        needChange = true;
-        m_previousShadowCasters.push_back(light->GetIdVal());
-        nextId++;
-        continue;
-      }
+    // Place shadow textures to atlas. Layer limit of the settings can only lower the gpu limit.
+    int maxLayers = GetRenderer()->GetMaxArrayTextureLayers();
+    if (shadows->GetMaxShadowAtlasLayersVal() > 0)
+    {
+      maxLayers = glm::min(maxLayers, shadows->GetMaxShadowAtlasLayersVal());
+    }
 
-      if (m_previousShadowCasters[nextId] != light->GetIdVal())
-      {
-        needChange = true;
-      }
+    PlaceShadowMapsToShadowAtlas(maxLayers);
 
-      m_previousShadowCasters[nextId] = light->GetIdVal();
-      nextId++;
+    int layerCount = glm::max(1, m_packer.GetLayerCount());
+    if (m_layerCount != layerCount)
+    {
+      needChange = true;
     }
 
     if (needChange && !m_lights.empty())
@@ -458,18 +586,7 @@ namespace ToolKit
       frag->SetDefine("EVSM4", std::to_string(m_useEVSM4));
       frag->SetDefine("SMFormat16Bit", std::to_string(!m_use32BitShadowMap));
 
-      // Update layers.
-      m_previousShadowCasters.resize(nextId);
-
-      // Place shadow textures to atlas
-      m_layerCount        = PlaceShadowMapsToShadowAtlas(m_lights);
-
-      const int maxLayers = GetRenderer()->GetMaxArrayTextureLayers();
-      if (maxLayers < m_layerCount)
-      {
-        m_layerCount = maxLayers;
-        GetLogger()->Log("ERROR: Max array texture layer size is reached: " + std::to_string(maxLayers) + " !");
-      }
+      m_layerCount                  = layerCount;
 
       GraphicTypes bufferComponents = m_useEVSM4 ? GraphicTypes::FormatRGBA : GraphicTypes::FormatRG;
       GraphicTypes bufferFormat     = m_useEVSM4 ? GraphicTypes::FormatRGBA32F : GraphicTypes::FormatRG32F;
@@ -498,6 +615,9 @@ namespace ToolKit
                                    m_layerCount,
                                    false};
 
+      // Content of the atlas is lost.
+      m_shadowMapSignatures.clear();
+
       m_shadowFramebuffer->DetachColorAttachment(Framebuffer::Attachment::ColorAttachment0);
       m_shadowAtlas->Reconstruct(RHIConstants::ShadowAtlasTextureSize, RHIConstants::ShadowAtlasTextureSize, set);
 
@@ -38,15 +38,31 @@ namespace ToolKit
     /** Perform all renderings to generate all shadow maps for the given light. */
     void RenderShadowMaps(Light* light);
 
-    /** Performs a single render that generates a single shadow map of a cascade, or a face of a cube etc...*/
-    void RenderShadowMap(Light* light, CameraPtr shadowCamera, CameraPtr cullCamera);
+    /**
+     * Performs a single render that generates a single shadow map of a cascade, or a face of a cube etc...
+     * Render is skipped if the shadow map in the atlas is up to date.
+     * @param light is the light that the shadow map belongs to.
+     * @param mapIndex is the index of the cascade, the cube face or zero for spot lights.
+     * @param shadowCamera is the camera that the shadow map is rendered with.
+     * @param cullCamera is the camera that the shadow casters are queried with.
+     */
+    void RenderShadowMap(Light* light, int mapIndex, CameraPtr shadowCamera, CameraPtr cullCamera);
+
+    /** Collects the render jobs of the shadow casters that are in the frustum of the cull camera. */
+    void CollectShadowCasters(Light* light, CameraPtr cullCamera, RenderData& renderData);
 
     /**
-     * Sets layer and coordinates of the shadow maps in shadow atlas.
-     * @param lights Light array that have shadows.
-     * @return number of layers needed.
+     * Returns the hash of everything that the content of a shadow map depends on. Shadow camera, placement in the
+     * atlas and the meshes, materials, transforms and animations of the casters. Order of the casters doesn't matter.
      */
-    int PlaceShadowMapsToShadowAtlas(const LightRawPtrArray& lights);
+    uint64 GetShadowMapSignature(CameraPtr shadowCamera, UVec2 coord, int layer, uint resolution, RenderData& data);
+
+    /**
+     * Places the shadow maps of the new lights and the lights whose shadow maps changed in the shadow atlas. Shadow
+     * maps of the other lights keep their places. Resolution is halved for the lights that don't fit.
+     * @param maxLayers is the maximum number of layers that the atlas can have.
+     */
+    void PlaceShadowMapsToShadowAtlas(int maxLayers);
 
     /** Creates a shadow atlas for m_params.Lights */
     void InitShadowAtlas();
@@ -65,7 +81,21 @@ namespace ToolKit
     int m_activeCascadeCount           = 0;
     bool m_useEVSM4                    = false;
     bool m_use32BitShadowMap           = true;
-    IDArray m_previousShadowCasters;
+
+    /** Placement of the shadow maps of a light in the shadow atlas. */
+    struct ShadowAtlasAllocation
+    {
+      BinPack2D::PackedRect rect; //!< Rectangle that holds all shadow maps of the light, invalid if not placed.
+      int resolution = 0;         //!< Shadow resolution of the light when it was placed.
+      int mapCount   = 0;         //!< Number of the shadow maps of the light.
+    };
+
+    /** Placements of the lights in the shadow atlas. */
+    std::unordered_map<ULongID, ShadowAtlasAllocation> m_shadowAtlasAllocations;
+    int m_maxShadowAtlasLayers = 0; //!< Layer limit of the packer.
+
+    /** Signatures of the shadow maps in the atlas for each light, indexed by the shadow map index. */
+    std::unordered_map<ULongID, std::vector<uint64>> m_shadowMapSignatures;
 
     Quaternion m_cubeMapRotations[6];
     BinPack2D m_packer;
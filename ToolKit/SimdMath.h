@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#pragma once
+
+/**
+ * @file Thin 4 wide float vector abstraction over SSE and NEON registers, used by the SIMD math kernels.
+ * Platforms without SSE2 or NEON fall back to scalar code with the same interface.
+ */
+
+#include "Types.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define TK_SIMD_SSE
+  #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+  #define TK_SIMD_NEON
+  #include <arm_neon.h>
+#endif
+
+namespace ToolKit
+{
+
+  /** 4 wide float vector. */
+  struct Float4
+  {
+#if defined(TK_SIMD_SSE)
+    __m128 v;
+#elif defined(TK_SIMD_NEON)
+    float32x4_t v;
+#else
+    float v[4];
+#endif
+  };
+
+  /** 4 wide comparison result. Each lane is either all ones or all zeros. */
+  struct Mask4
+  {
+#if defined(TK_SIMD_SSE)
+    __m128 v;
+#elif defined(TK_SIMD_NEON)
+    uint32x4_t v;
+#else
+    bool v[4];
+#endif
+  };
+
+#if defined(TK_SIMD_SSE)
+
+  /** Loads 4 floats from a 16 byte aligned address. */
+  inline Float4 Load4(const float* ptr) { return {_mm_load_ps(ptr)}; }
+
+  /** Loads 4 floats from an address without alignment requirement. */
+  inline Float4 LoadUnaligned4(const float* ptr) { return {_mm_loadu_ps(ptr)}; }
+
+  /** Stores 4 floats to a 16 byte aligned address. */
+  inline void Store4(float* ptr, Float4 a) { _mm_store_ps(ptr, a.v); }
+
+  /** Broadcasts the value to all lanes. */
+  inline Float4 Splat4(float val) { return {_mm_set1_ps(val)}; }
+
+  inline Float4 operator+(Float4 a, Float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+
+  inline Float4 operator-(Float4 a, Float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+
+  inline Float4 operator*(Float4 a, Float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+
+  inline Float4 Min4(Float4 a, Float4 b) { return {_mm_min_ps(a.v, b.v)}; }
+
+  inline Float4 Max4(Float4 a, Float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+
+  inline Mask4 operator<(Float4 a, Float4 b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+
+  inline Mask4 operator<=(Float4 a, Float4 b) { return {_mm_cmple_ps(a.v, b.v)}; }
+
+  inline Mask4 operator>(Float4 a, Float4 b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+
+  inline Mask4 operator>=(Float4 a, Float4 b) { return {_mm_cmpge_ps(a.v, b.v)}; }
+
+  inline Mask4 operator&(Mask4 a, Mask4 b) { return {_mm_and_ps(a.v, b.v)}; }
+
+  inline Mask4 operator|(Mask4 a, Mask4 b) { return {_mm_or_ps(a.v, b.v)}; }
+
+  /** Returns a bit for each lane, bit i is set if lane i is set. */
+  inline int MoveMask4(Mask4 a) { return _mm_movemask_ps(a.v); }
+
+#elif defined(TK_SIMD_NEON)
+
+  /** Loads 4 floats from a 16 byte aligned address. */
+  inline Float4 Load4(const float* ptr) { return {vld1q_f32(ptr)}; }
+
+  /** Loads 4 floats from an address without alignment requirement. */
+  inline Float4 LoadUnaligned4(const float* ptr) { return {vld1q_f32(ptr)}; }
+
+  /** Stores 4 floats to a 16 byte aligned address. */
+  inline void Store4(float* ptr, Float4 a) { vst1q_f32(ptr, a.v); }
+
+  /** Broadcasts the value to all lanes. */
+  inline Float4 Splat4(float val) { return {vdupq_n_f32(val)}; }
+
+  inline Float4 operator+(Float4 a, Float4 b) { return {vaddq_f32(a.v, b.v)}; }
+
+  inline Float4 operator-(Float4 a, Float4 b) { return {vsubq_f32(a.v, b.v)}; }
+
+  inline Float4 operator*(Float4 a, Float4 b) { return {vmulq_f32(a.v, b.v)}; }
+
+  inline Float4 Min4(Float4 a, Float4 b) { return {vminq_f32(a.v, b.v)}; }
+
+  inline Float4 Max4(Float4 a, Float4 b) { return {vmaxq_f32(a.v, b.v)}; }
+
+  inline Mask4 operator<(Float4 a, Float4 b) { return {vcltq_f32(a.v, b.v)}; }
+
+  inline Mask4 operator<=(Float4 a, Float4 b) { return {vcleq_f32(a.v, b.v)}; }
+
+  inline Mask4 operator>(Float4 a, Float4 b) { return {vcgtq_f32(a.v, b.v)}; }
+
+  inline Mask4 operator>=(Float4 a, Float4 b) { return {vcgeq_f32(a.v, b.v)}; }
+
+  inline Mask4 operator&(Mask4 a, Mask4 b) { return {vandq_u32(a.v, b.v)}; }
+
+  inline Mask4 operator|(Mask4 a, Mask4 b) { return {vorrq_u32(a.v, b.v)}; }
+
+  /** Returns a bit for each lane, bit i is set if lane i is set. */
+  inline int MoveMask4(Mask4 a)
+  {
+    static const uint32_t laneBits[4] = {1, 2, 4, 8};
+    uint32x4_t bits                   = vandq_u32(a.v, vld1q_u32(laneBits));
+    uint32x2_t sum                    = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+    return (int) vget_lane_u32(vpadd_u32(sum, sum), 0);
+  }
+
+#else
+
+  /** Loads 4 floats from a 16 byte aligned address. */
+  inline Float4 Load4(const float* ptr) { return {{ptr[0], ptr[1], ptr[2], ptr[3]}}; }
+
+  /** Loads 4 floats from an address without alignment requirement. */
+  inline Float4 LoadUnaligned4(const float* ptr) { return Load4(ptr); }
+
+  /** Stores 4 floats to a 16 byte aligned address. */
+  inline void Store4(float* ptr, Float4 a)
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      ptr[i] = a.v[i];
+    }
+  }
+
+  /** Broadcasts the value to all lanes. */
+  inline Float4 Splat4(float val) { return {{val, val, val, val}}; }
+
+  #define TK_SIMD_SCALAR_OP(Ret, Expr)                                                                                 \
+    Ret r;                                                                                                             \
+    for (int i = 0; i < 4; i++)                                                                                        \
+    {                                                                                                                  \
+      r.v[i] = Expr;                                                                                                   \
+    }                                                                                                                  \
+    return r;
+
+  inline Float4 operator+(Float4 a, Float4 b) { TK_SIMD_SCALAR_OP(Float4, a.v[i] + b.v[i]) }
+
+  inline Float4 operator-(Float4 a, Float4 b) { TK_SIMD_SCALAR_OP(Float4, a.v[i] - b.v[i]) }
+
+  inline Float4 operator*(Float4 a, Float4 b) { TK_SIMD_SCALAR_OP(Float4, a.v[i] * b.v[i]) }
+
+  inline Float4 Min4(Float4 a, Float4 b) { TK_SIMD_SCALAR_OP(Float4, a.v[i] < b.v[i] ? a.v[i] : b.v[i]) }
+
+  inline Float4 Max4(Float4 a, Float4 b) { TK_SIMD_SCALAR_OP(Float4, a.v[i] > b.v[i] ? a.v[i] : b.v[i]) }
+
+  inline Mask4 operator<(Float4 a, Float4 b) { TK_SIMD_SCALAR_OP(Mask4, a.v[i] < b.v[i]) }
+
+  inline Mask4 operator<=(Float4 a, Float4 b) { TK_SIMD_SCALAR_OP(Mask4, a.v[i] <= b.v[i]) }
+
+  inline Mask4 operator>(Float4 a, Float4 b) { TK_SIMD_SCALAR_OP(Mask4, a.v[i] > b.v[i]) }
+
+  inline Mask4 operator>=(Float4 a, Float4 b) { TK_SIMD_SCALAR_OP(Mask4, a.v[i] >= b.v[i]) }
+
+  inline Mask4 operator&(Mask4 a, Mask4 b) { TK_SIMD_SCALAR_OP(Mask4, a.v[i] && b.v[i]) }
+
+  inline Mask4 operator|(Mask4 a, Mask4 b) { TK_SIMD_SCALAR_OP(Mask4, a.v[i] || b.v[i]) }
+
+  #undef TK_SIMD_SCALAR_OP
+
+  /** Returns a bit for each lane, bit i is set if lane i is set. */
+  inline int MoveMask4(Mask4 a) { return (int) a.v[0] | (int) a.v[1] << 1 | (int) a.v[2] << 2 | (int) a.v[3] << 3; }
+
+#endif
+
+} // namespace ToolKit
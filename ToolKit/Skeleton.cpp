@@ -26,12 +26,13 @@ namespace ToolKit
 
   StaticBone::~StaticBone() {}
 
-  // Create a texture such that there is mat4x4 per bone
+  // Create a texture such that there is 3 texels per bone, the first three rows of the bone matrix. Layout is the same
+  // with the animation data textures.
   TexturePtr CreateBoneTransformTexture(const Skeleton* skeleton)
   {
     TexturePtr ptr = MakeNewPtr<Texture>();
     ptr->m_height  = 1;
-    ptr->m_width   = (int) (skeleton->m_bones.size()) * 4;
+    ptr->m_width   = (int) (skeleton->m_bones.size()) * 3;
     TextureSettings set;
     set.GenerateMipMap = false;
     set.InternalFormat = GraphicTypes::FormatRGBA32F;
@@ -57,8 +58,10 @@ namespace ToolKit
 
   void uploadBoneMatrix(Mat4 mat, TexturePtr& ptr, uint boneIndx)
   {
+    // Columns of the transpose are the rows of the matrix, the last row is always (0, 0, 0, 1).
+    Mat4 rows = glm::transpose(mat);
     RHI::SetTexture(GL_TEXTURE_2D, ptr->m_textureId);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, boneIndx * 4, 0, 4, 1, GL_RGBA, GL_FLOAT, &mat);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, boneIndx * 3, 0, 3, 1, GL_RGBA, GL_FLOAT, &rows);
   };
 
   // DynamicBoneMap
@@ -72,6 +75,12 @@ namespace ToolKit
     }
 
     m_boneMap.insert({boneName, bone});
+
+    if (bone.boneIndx >= m_boneNodes.size())
+    {
+      m_boneNodes.resize(bone.boneIndx + 1, nullptr);
+    }
+    m_boneNodes[bone.boneIndx] = bone.node;
   }
 
   void DynamicBoneMap::Init(const Skeleton* skeleton)
@@ -112,6 +121,12 @@ namespace ToolKit
         }
       }
     }
+
+    m_boneNodes.assign(skeleton->m_bones.size(), nullptr);
+    for (const auto& dBoneIter : m_boneMap)
+    {
+      m_boneNodes[dBoneIter.second.boneIndx] = dBoneIter.second.node;
+    }
   }
 
   DynamicBoneMap::DynamicBoneMap() {}
@@ -128,6 +143,7 @@ namespace ToolKit
     }
 
     m_boneMap.clear();
+    m_boneNodes.clear();
   }
 
   // Find skeleton's each child bone from its child nodes
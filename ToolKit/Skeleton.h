@@ -48,6 +48,7 @@ namespace ToolKit
 
    public:
     std::map<String, DynamicBone> m_boneMap;
+    NodeRawPtrArray m_boneNodes; //!< Node of each bone, indexed by the bone index.
   };
 
   class TK_API Skeleton : public Resource
@@ -28,6 +28,14 @@ namespace ToolKit
     float blendKeyFrameCount             = 1.0f; // default value is 1 to prevent division with 0
   };
 
+  /** Bone index of each track of an animation for a skeleton. */
+  struct AnimationBoneBinding
+  {
+    uint64 clipVersion = 0; //!< Version of the compiled animation clip that the binding is resolved for.
+    ObjectId skeleton  = 0; //!< Id of the skeleton that the tracks are bound to.
+    IntArray trackBones;    //!< Bone index of each track, -1 for the tracks without a bone.
+  };
+
   static VariantCategory SkeletonComponentCategory {"Skeleton Component", 90};
 
   /**
@@ -64,6 +72,9 @@ namespace ToolKit
     DynamicBoneMapPtr m_map = nullptr;
     bool isDirty            = true;
 
+    /** Tracks of the last animation that is posed on the skeleton, bound to the bones. */
+    AnimationBoneBinding m_boneBinding;
+
    private:
     AnimData m_animData;
   };
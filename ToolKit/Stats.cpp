@@ -75,6 +75,13 @@ namespace ToolKit
     snprintf(buffer, sizeof(buffer), "Total Draw Call: %llu\n", Stats::GetDrawCallCount());
     stats += buffer;
 
+    snprintf(buffer,
+             sizeof(buffer),
+             "Instanced Draw Call: %llu, Instances: %llu\n",
+             Stats::GetInstancedDrawCallCount(),
+             Stats::GetInstanceCount());
+    stats += buffer;
+
     snprintf(buffer, sizeof(buffer), "Total Hardware Render Pass: %llu\n", Stats::GetRenderPassCount());
     stats += buffer;
 
@@ -99,6 +106,46 @@ namespace ToolKit
     snprintf(buffer, sizeof(buffer), "UBO updates Per Frame: %llu\n", Stats::GetUboUpdatesPerFrame());
     stats += buffer;
 
+    snprintf(buffer,
+             sizeof(buffer),
+             "AABB Tree Build (ms): %.2f, SAH Cost: %.2f\n",
+             m_aabbTreeBuildTime,
+             m_aabbTreeSAHCost);
+    stats += buffer;
+
+    snprintf(buffer,
+             sizeof(buffer),
+             "Shaders Compiled: %u (%.1f ms), Programs Linked: %u (%.1f ms), Cached: %u (%.1f ms)\n",
+             m_shaderCompileCount,
+             m_shaderCompileTime,
+             m_programLinkCount,
+             m_programLinkTime,
+             m_programCacheLoadCount,
+             m_programCacheLoadTime);
+    stats += buffer;
+
+    snprintf(buffer,
+             sizeof(buffer),
+             "Shadow Map Cache Hit: %u, Miss: %u\n",
+             m_shadowMapCacheHitPerFramePrev,
+             m_shadowMapCacheMissPerFramePrev);
+    stats += buffer;
+
+    if (m_clusterCount > 0)
+    {
+      float avgLights = m_occupiedClusterCount > 0 ? (float) m_clusterLightIndexCount / m_occupiedClusterCount : 0.0f;
+      snprintf(buffer,
+               sizeof(buffer),
+               "Clustered Lights: %u, Occupied Clusters: %u/%u, Max: %u, Avg: %.1f (%.2f ms)\n",
+               m_clusteredLightCount,
+               m_occupiedClusterCount,
+               m_clusterCount,
+               m_maxLightsPerCluster,
+               avgLights,
+               m_clusteredLightBuildTime);
+      stats += buffer;
+    }
+
     return stats;
   }
 
@@ -258,6 +305,38 @@ namespace ToolKit
       }
     }
 
+    void AddInstancedDrawCall(uint64 instanceCount)
+    {
+      if (TKStats* tkStats = GetTKStats())
+      {
+        tkStats->AddInstancedDrawCall(instanceCount);
+      }
+    }
+
+    uint64 GetInstancedDrawCallCount()
+    {
+      if (TKStats* tkStats = GetTKStats())
+      {
+        return tkStats->GetInstancedDrawCallCount();
+      }
+      else
+      {
+        return 0;
+      }
+    }
+
+    uint64 GetInstanceCount()
+    {
+      if (TKStats* tkStats = GetTKStats())
+      {
+        return tkStats->GetInstanceCount();
+      }
+      else
+      {
+        return 0;
+      }
+    }
+
     uint64 GetRenderPassCount()
     {
       if (TKStats* tkStats = GetTKStats())
@@ -58,6 +58,17 @@ namespace ToolKit
 
     inline uint64 GetDrawCallCount() { return m_drawCallCountPrev; }
 
+    /** Counts an instanced draw call and its instances. Draw call itself is also counted by AddDrawCall. */
+    inline void AddInstancedDrawCall(uint64 instanceCount)
+    {
+      m_instancedDrawCallCount++;
+      m_instanceCount += instanceCount;
+    }
+
+    inline uint64 GetInstancedDrawCallCount() { return m_instancedDrawCallCountPrev; }
+
+    inline uint64 GetInstanceCount() { return m_instanceCountPrev; }
+
     // Hardware Render Pass Counter
     //////////////////////////////////////////
 
@@ -95,10 +106,49 @@ namespace ToolKit
     uint64 m_drawCallCount                       = 0;
     uint64 m_drawCallCountPrev                   = 0;
 
+    /** Number of instanced draw calls and the number of instances drawn by them in a frame. */
+    uint64 m_instancedDrawCallCount              = 0;
+    uint64 m_instancedDrawCallCountPrev          = 0;
+    uint64 m_instanceCount                       = 0;
+    uint64 m_instanceCountPrev                   = 0;
+
     /** Number of hardware render passes in a frame. */
     uint64 m_renderPassCount                     = 0;
     uint64 m_renderPassCountPrev                 = 0;
 
+    /** Duration of the last aabb tree rebuild in milliseconds. */
+    float m_aabbTreeBuildTime                    = 0.0f;
+    /** Surface area heuristic cost of the last rebuilt aabb tree. */
+    float m_aabbTreeSAHCost                      = 0.0f;
+
+    /** Number of shader variants compiled since the start and the time spent compiling them in milliseconds. */
+    uint m_shaderCompileCount                    = 0;
+    float m_shaderCompileTime                    = 0.0f;
+    /** Number of programs linked from shaders since the start and the time spent linking them in milliseconds. */
+    uint m_programLinkCount                      = 0;
+    float m_programLinkTime                      = 0.0f;
+    /** Number of programs loaded from the program binary cache and the time spent loading them in milliseconds. */
+    uint m_programCacheLoadCount                 = 0;
+    float m_programCacheLoadTime                 = 0.0f;
+
+    /** Number of lights that are assigned to the clusters in the last clustered lighting update. */
+    uint m_clusteredLightCount                   = 0;
+    /** Number of clusters and the number of clusters with at least one light. */
+    uint m_clusterCount                          = 0;
+    uint m_occupiedClusterCount                  = 0;
+    /** Light count of the most crowded cluster and the sum of the light counts of all clusters. */
+    uint m_maxLightsPerCluster                   = 0;
+    uint m_clusterLightIndexCount                = 0;
+    /** Duration of the last clustered lighting update in milliseconds. */
+    float m_clusteredLightBuildTime              = 0.0f;
+
+    /** Number of shadow maps reused from the previous frames in a frame. */
+    uint m_shadowMapCacheHitPerFrame             = 0;
+    uint m_shadowMapCacheHitPerFramePrev         = 0;
+    /** Number of shadow maps rendered in a frame. */
+    uint m_shadowMapCacheMissPerFrame            = 0;
+    uint m_shadowMapCacheMissPerFramePrev        = 0;
+
     /** Timers added to the source. */
     std::unordered_map<String, TimeArgs> m_profileTimerMap;
 
@@ -124,6 +174,9 @@ namespace ToolKit
     TK_API void ResetVRAMUsage();
     TK_API void AddDrawCall();
     TK_API uint64 GetDrawCallCount();
+    TK_API void AddInstancedDrawCall(uint64 instanceCount);
+    TK_API uint64 GetInstancedDrawCallCount();
+    TK_API uint64 GetInstanceCount();
     TK_API uint64 GetRenderPassCount();
     TK_API void GetRenderTime(float& cpu, float& gpu);
     TK_API void GetRenderTimeAvg(float& cpu, float& gpu);
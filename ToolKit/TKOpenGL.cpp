@@ -38,6 +38,29 @@ namespace ToolKit
 
   int TK_GL_OES_texture_float_linear                                           = 0;
 
+  TKGL_MaxShaderCompilerThreads tk_glMaxShaderCompilerThreadsKHR               = nullptr;
+
+  int TK_GL_KHR_parallel_shader_compile                                        = 0;
+
+#if defined(TK_WIN) || defined(TK_ANDROID)
+  /** Searches the extension in the extension list of the current context. */
+  static bool HasGlExtension(StringView extension)
+  {
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    for (GLint i = 0; i < extensionCount; i++)
+    {
+      const GLubyte* name = glGetStringi(GL_EXTENSIONS, i);
+      if (name != nullptr && extension == (const char*) name)
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+#endif
+
   void LoadGlFunctions(void* glGetProcAddres)
   {
 #ifdef TK_WIN
@@ -74,6 +97,13 @@ namespace ToolKit
 
   #endif
 
+    // Not covered by glad.
+    if (HasGlExtension("GL_KHR_parallel_shader_compile"))
+    {
+      tk_glMaxShaderCompilerThreadsKHR =
+          (TKGL_MaxShaderCompilerThreads) ((GLADloadfunc) glGetProcAddres)("glMaxShaderCompilerThreadsKHR");
+    }
+
 #endif
 
 #ifdef TK_ANDROID
@@ -107,6 +137,11 @@ namespace ToolKit
       }
     }
 
+    if (HasGlExtension("GL_KHR_parallel_shader_compile"))
+    {
+      tk_glMaxShaderCompilerThreadsKHR = (TKGL_MaxShaderCompilerThreads) glLoader("glMaxShaderCompilerThreadsKHR");
+    }
+
 #endif
 
 #ifdef TK_WEB
@@ -132,7 +167,18 @@ namespace ToolKit
     TK_GL_OES_texture_float_linear       = extensionsStr.find("GL_OES_texture_float_linear") != std::string::npos;
     TK_GL_EXT_texture_filter_anisotropic = extensionsStr.find("GL_EXT_texture_filter_anisotropic") != std::string::npos;
 
+    // WebGL compiles in parallel by itself when the extension is enabled, there is no thread count to set.
+    TK_GL_KHR_parallel_shader_compile =
+        emscripten_webgl_enable_extension(emscripten_webgl_get_current_context(), "KHR_parallel_shader_compile");
+
 #endif
+
+    // Let the driver decide the number of threads compiling in the background.
+    if (tk_glMaxShaderCompilerThreadsKHR != nullptr)
+    {
+      glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+      TK_GL_KHR_parallel_shader_compile = 1;
+    }
   }
 
 } // namespace ToolKit
@@ -105,6 +105,18 @@ namespace ToolKit
 
   extern int TK_GL_OES_texture_float_linear;
 
+  // GL_KHR_parallel_shader_compile
+  //////////////////////////////////////////
+
+  typedef void(TK_STDCAL* TKGL_MaxShaderCompilerThreads)(GLuint count);
+
+  extern TKGL_MaxShaderCompilerThreads tk_glMaxShaderCompilerThreadsKHR;
+
+#undef glMaxShaderCompilerThreadsKHR
+#define glMaxShaderCompilerThreadsKHR tk_glMaxShaderCompilerThreadsKHR
+
+  extern int TK_GL_KHR_parallel_shader_compile;
+
   // GL Loader function
   //////////////////////////////////////////
 
@@ -13,6 +13,7 @@
 #include "FullQuadPass.h"
 #include "Image.h"
 #include "Logger.h"
+#include "MappedFile.h"
 #include "Material.h"
 #include "RHI.h"
 #include "RenderSystem.h"
@@ -89,6 +90,19 @@ namespace ToolKit
     }
     else
     {
+      // Compressed image is preferred, it is uploaded without decoding.
+      if (MappedFilePtr compressedFile = GetFileManager()->GetMappedFile(GetFile() + KTX2))
+      {
+        if (ReadKtx2(compressedFile, m_compressedImage))
+        {
+          m_width       = m_compressedImage.width;
+          m_height      = m_compressedImage.height;
+          m_numChannels = 4;
+          m_loaded      = true;
+          return;
+        }
+      }
+
       if ((m_image = GetFileManager()->GetImageFile(GetFile(), &m_width, &m_height, &m_numChannels, 4)))
       {
         m_loaded = true;
@@ -103,8 +117,18 @@ namespace ToolKit
       return;
     }
 
+    bool compressed = m_compressedImage.data != nullptr;
+    if (compressed && !IsCompressedFormatSupported(m_compressedImage.format))
+    {
+      TK_WRN("Compressed texture format is not supported by the gpu, using the original image: %s", GetFile().c_str());
+
+      m_compressedImage = CompressedImage();
+      m_image           = GetFileManager()->GetImageFile(GetFile(), &m_width, &m_height, &m_numChannels, 4);
+      compressed        = false;
+    }
+
     // Sanity checks
-    if ((m_image == nullptr && m_imagef == nullptr))
+    if ((m_image == nullptr && m_imagef == nullptr && !compressed))
     {
       assert(0 && "No texture data.");
       return;
@@ -121,7 +145,27 @@ namespace ToolKit
     RHI::SetTexture((GLenum) m_settings.Target, m_textureId);
 
     uint64 pixelCount = (uint64) m_width * (uint64) m_height;
-    if (m_settings.Type != GraphicTypes::TypeFloat)
+    if (compressed)
+    {
+      const std::vector<CompressedImage::Level>& levels = m_compressedImage.levels;
+      for (int level = 0; level < (int) levels.size(); level++)
+      {
+        glCompressedTexImage2D(GL_TEXTURE_2D,
+                               level,
+                               (GLenum) m_compressedImage.format,
+                               glm::max(m_width >> level, 1),
+                               glm::max(m_height >> level, 1),
+                               0,
+                               (GLsizei) levels[level].size,
+                               m_compressedImage.LevelData(level));
+      }
+
+      // Levels that are not in the file are not sampled, so that the texture stays complete.
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint) levels.size() - 1);
+
+      Stats::AddVRAMUsageInBytes(GetVRAMUsageInBytes());
+    }
+    else if (m_settings.Type != GraphicTypes::TypeFloat)
     {
       glTexImage2D(GL_TEXTURE_2D,
                    0,
@@ -150,7 +194,7 @@ namespace ToolKit
       Stats::AddVRAMUsageInBytes(pixelCount * BytesOfFormat(m_settings.InternalFormat));
     }
 
-    if (m_settings.GenerateMipMap)
+    if (m_settings.GenerateMipMap && !compressed)
     {
       glGenerateMipmap(GL_TEXTURE_2D);
     }
@@ -189,24 +233,7 @@ namespace ToolKit
       return;
     }
 
-    uint64 pixelCount = (uint64) m_width * (uint64) m_height;
-    if (m_settings.Target == GraphicTypes::Target2D)
-    {
-      Stats::RemoveVRAMUsageInBytes(pixelCount * BytesOfFormat(m_settings.InternalFormat));
-    }
-    else if (m_settings.Target == GraphicTypes::Target2DArray)
-    {
-      assert(m_settings.Layers > 0 && "Layer count must be greater than 0");
-      Stats::RemoveVRAMUsageInBytes(pixelCount * BytesOfFormat(m_settings.InternalFormat) * m_settings.Layers);
-    }
-    else if (m_settings.Target == GraphicTypes::TargetCubeMap)
-    {
-      Stats::RemoveVRAMUsageInBytes(pixelCount * BytesOfFormat(m_settings.InternalFormat) * 6);
-    }
-    else
-    {
-      assert(false);
-    }
+    Stats::RemoveVRAMUsageInBytes(GetVRAMUsageInBytes());
 
     RHI::DeleteTexture(m_textureId);
     m_textureId = 0;
@@ -227,6 +254,11 @@ namespace ToolKit
 
   void Texture::GenerateMipMaps()
   {
+    if (m_compressedImage.IsValid())
+    {
+      return;
+    }
+
     RHI::SetTexture((GLenum) m_settings.Target, m_textureId);
     glGenerateMipmap((GLenum) m_settings.Target);
   }
@@ -236,8 +268,37 @@ namespace ToolKit
     ImageFree(m_image);
     ImageFree(m_imagef);
 
-    m_image  = nullptr;
-    m_imagef = nullptr;
+    m_image                = nullptr;
+    m_imagef               = nullptr;
+
+    // Levels are kept for the vram accounting.
+    m_compressedImage.data = nullptr;
+  }
+
+  uint64 Texture::GetVRAMUsageInBytes() const
+  {
+    if (m_compressedImage.IsValid())
+    {
+      return m_compressedImage.DataSize();
+    }
+
+    uint64 pixelCount = (uint64) m_width * (uint64) m_height;
+    if (m_settings.Target == GraphicTypes::Target2D)
+    {
+      return pixelCount * BytesOfFormat(m_settings.InternalFormat);
+    }
+    else if (m_settings.Target == GraphicTypes::Target2DArray)
+    {
+      assert(m_settings.Layers > 0 && "Layer count must be greater than 0");
+      return pixelCount * BytesOfFormat(m_settings.InternalFormat) * m_settings.Layers;
+    }
+    else if (m_settings.Target == GraphicTypes::TargetCubeMap)
+    {
+      return pixelCount * BytesOfFormat(m_settings.InternalFormat) * 6;
+    }
+
+    assert(false);
+    return 0;
   }
 
   // DepthTexture
@@ -341,6 +402,9 @@ namespace ToolKit
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, (GLint) m_settings.WarpS);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, (GLint) m_settings.WarpT);
 
+    // Balances the removal in UnInit. Mapping reuses the same storage.
+    Stats::AddVRAMUsageInBytes((uint64) (m_width * m_height) * BytesOfFormat(m_settings.InternalFormat));
+
     m_loaded    = true;
     m_initiated = true;
   };
@@ -364,8 +428,33 @@ namespace ToolKit
                     (GLenum) m_settings.Format,
                     (GLenum) m_settings.Type,
                     data);
+  }
+
+  void DataTexture::MapRows(const void* data, int rowCount)
+  {
+    if (!m_initiated)
+    {
+      assert(false && "Texture must be initialized before mapping data.");
+      return;
+    }
+
+    rowCount = glm::min(rowCount, m_height);
+    if (rowCount <= 0)
+    {
+      return;
+    }
+
+    RHI::SetTexture((GLenum) m_settings.Target, m_textureId);
 
-    Stats::AddVRAMUsageInBytes(size);
+    glTexSubImage2D((GLenum) m_settings.Target,
+                    0,
+                    0,
+                    0,
+                    m_width,
+                    rowCount,
+                    (GLenum) m_settings.Format,
+                    (GLenum) m_settings.Type,
+                    data);
   }
 
   void DataTexture::UnInit()
@@ -9,6 +9,7 @@
 
 #include "Resource.h"
 #include "ResourceManager.h"
+#include "TextureCompression.h"
 #include "Types.h"
 
 namespace ToolKit
@@ -47,7 +48,16 @@ namespace ToolKit
     virtual void NativeConstruct(StringView label);
     virtual void NativeConstruct(int widht, int height, const TextureSettings& settings, StringView label = "");
 
+    /**
+     * Loads the image of the texture. If there is a KTX2 file next to the image, named by appending the ".ktx2"
+     * extension to the image file, block compressed image and its mip levels are loaded from it instead.
+     */
     void Load() override;
+
+    /**
+     * Uploads the image to the gpu. Compressed images are uploaded without decoding. If the gpu doesn't support the
+     * compressed format, the original image is loaded and uploaded instead.
+     */
     void Init(bool flushClientSideArray = false) override;
     void UnInit() override;
 
@@ -60,13 +70,16 @@ namespace ToolKit
     /** Calculates the required number of mip levels. Mip levels not necessarily exist. */
     int CalculateMipmapLevels();
 
-    /** Generate mip maps for the texture. */
+    /** Generate mip maps for the texture. Compressed textures come with their mip maps, they are not generated. */
     void GenerateMipMaps();
 
    protected:
     /** Removes image data. */
     virtual void Clear();
 
+    /** Returns the vram usage of the texture. */
+    uint64 GetVRAMUsageInBytes() const;
+
    public:
     uint m_textureId  = 0;
     int m_width       = 0;
@@ -76,6 +89,9 @@ namespace ToolKit
     float* m_imagef   = nullptr;
     StringView m_label; //!< Debug label which appears in the gpu debuggers.
 
+    /** Block compressed image, valid if the texture is loaded from a KTX2 file. Levels are kept after the upload. */
+    CompressedImage m_compressedImage;
+
    protected:
     TextureSettings m_settings;
   };
@@ -126,6 +142,10 @@ namespace ToolKit
     void Load() override;
     void Init(void* data);
     void Map(void* data, uint64 size);
+
+    /** Maps data to the first rows of the texture. Texture is not resized, so the vram usage stays the same. */
+    void MapRows(const void* data, int rowCount);
+
     void UnInit() override;
   };
 
@@ -0,0 +1,839 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#include "TextureCompression.h"
+
+#include "Image.h"
+#include "Logger.h"
+#include "MappedFile.h"
+#include "TKOpenGL.h"
+#include "Threads.h"
+#include "ToolKit.h"
+
+#include "DebugNew.h"
+
+namespace ToolKit
+{
+
+  // Block formats
+  //////////////////////////////////////////
+
+  /** A block compressed format that can be read from a KTX2 file. */
+  struct BlockFormat
+  {
+    uint vkFormat;         //!< Vulkan format, which is stored in the KTX2 files.
+    GraphicTypes glFormat; //!< Matching gl internal format.
+    int blockWidth;        //!< Width of a block in pixels.
+    int blockHeight;       //!< Height of a block in pixels.
+    int blockBytes;        //!< Size of a block in bytes.
+  };
+
+  static const BlockFormat BlockFormats[] = {
+      {131, (GraphicTypes) 0x83F0, 4, 4, 8 }, // BC1 rgb
+      {132, (GraphicTypes) 0x8C4C, 4, 4, 8 }, // BC1 rgb srgb
+      {133, (GraphicTypes) 0x83F1, 4, 4, 8 }, // BC1 rgba
+      {134, (GraphicTypes) 0x8C4D, 4, 4, 8 }, // BC1 rgba srgb
+      {137, (GraphicTypes) 0x83F3, 4, 4, 16}, // BC3
+      {138, (GraphicTypes) 0x8C4F, 4, 4, 16}, // BC3 srgb
+      {145, (GraphicTypes) 0x8E8C, 4, 4, 16}, // BC7
+      {146, (GraphicTypes) 0x8E8D, 4, 4, 16}, // BC7 srgb
+      {147, (GraphicTypes) 0x9274, 4, 4, 8 }, // ETC2 rgb
+      {148, (GraphicTypes) 0x9275, 4, 4, 8 }, // ETC2 rgb srgb
+      {151, (GraphicTypes) 0x9278, 4, 4, 16}, // ETC2 rgba
+      {152, (GraphicTypes) 0x9279, 4, 4, 16}, // ETC2 rgba srgb
+      {157, (GraphicTypes) 0x93B0, 4, 4, 16}, // ASTC 4x4
+      {158, (GraphicTypes) 0x93D0, 4, 4, 16}, // ASTC 4x4 srgb
+      {165, (GraphicTypes) 0x93B4, 6, 6, 16}, // ASTC 6x6
+      {166, (GraphicTypes) 0x93D4, 6, 6, 16}, // ASTC 6x6 srgb
+      {171, (GraphicTypes) 0x93B7, 8, 8, 16}, // ASTC 8x8
+      {172, (GraphicTypes) 0x93D7, 8, 8, 16}, // ASTC 8x8 srgb
+  };
+
+  static const BlockFormat* FindBlockFormat(uint vkFormat)
+  {
+    for (const BlockFormat& format : BlockFormats)
+    {
+      if (format.vkFormat == vkFormat)
+      {
+        return &format;
+      }
+    }
+
+    return nullptr;
+  }
+
+  static uint64 LevelSize(const BlockFormat& format, int width, int height)
+  {
+    uint64 blocksX = (uint64) (width + format.blockWidth - 1) / format.blockWidth;
+    uint64 blocksY = (uint64) (height + format.blockHeight - 1) / format.blockHeight;
+    return blocksX * blocksY * format.blockBytes;
+  }
+
+  // CompressedImage
+  //////////////////////////////////////////
+
+  uint64 CompressedImage::DataSize() const
+  {
+    uint64 size = 0;
+    for (const Level& level : levels)
+    {
+      size += level.size;
+    }
+
+    return size;
+  }
+
+  const uint8* CompressedImage::LevelData(int level) const { return data->Data() + levels[level].offset; }
+
+  // KTX2
+  //////////////////////////////////////////
+
+  static const uint8 Ktx2Identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+  constexpr uint64 Ktx2HeaderSize       = 80; //!< Identifier, image description and the index of the other data.
+  constexpr uint64 Ktx2LevelIndexSize   = 24; //!< Offset, size and uncompressed size of each level.
+
+  static uint ReadU32(const uint8* ptr)
+  {
+    return (uint) ptr[0] | (uint) ptr[1] << 8 | (uint) ptr[2] << 16 | (uint) ptr[3] << 24;
+  }
+
+  static uint64 ReadU64(const uint8* ptr) { return (uint64) ReadU32(ptr) | (uint64) ReadU32(ptr + 4) << 32; }
+
+  static void WriteU32(std::vector<uint8>& buffer, uint64 offset, uint val)
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      buffer[offset + i] = (uint8) (val >> (i * 8));
+    }
+  }
+
+  static void WriteU64(std::vector<uint8>& buffer, uint64 offset, uint64 val)
+  {
+    WriteU32(buffer, offset, (uint) val);
+    WriteU32(buffer, offset + 4, (uint) (val >> 32));
+  }
+
+  bool ReadKtx2(const MappedFilePtr& file, CompressedImage& image)
+  {
+    const uint8* data = file->Data();
+    uint64 size       = file->Size();
+    if (size < Ktx2HeaderSize || memcmp(data, Ktx2Identifier, sizeof(Ktx2Identifier)) != 0)
+    {
+      TK_ERR("Not a KTX2 file.");
+      return false;
+    }
+
+    uint vkFormat         = ReadU32(data + 12);
+    int width             = (int) ReadU32(data + 20);
+    int height            = (int) ReadU32(data + 24);
+    uint depth            = ReadU32(data + 28);
+    uint layerCount       = ReadU32(data + 32);
+    uint faceCount        = ReadU32(data + 36);
+    uint levelCount       = glm::max(ReadU32(data + 40), 1u);
+    uint supercompression = ReadU32(data + 44);
+
+    if (depth > 1 || layerCount > 1 || faceCount != 1 || supercompression != 0)
+    {
+      TK_ERR("Only 2D KTX2 images without super compression are supported.");
+      return false;
+    }
+
+    const BlockFormat* format = FindBlockFormat(vkFormat);
+    if (format == nullptr)
+    {
+      TK_ERR("Unsupported KTX2 format: %u", vkFormat);
+      return false;
+    }
+
+    if (width <= 0 || height <= 0 || Ktx2HeaderSize + levelCount * Ktx2LevelIndexSize > size)
+    {
+      TK_ERR("Corrupt KTX2 file.");
+      return false;
+    }
+
+    image.levels.resize(levelCount);
+    for (uint i = 0; i < levelCount; i++)
+    {
+      const uint8* levelIndex       = data + Ktx2HeaderSize + i * Ktx2LevelIndexSize;
+      CompressedImage::Level& level = image.levels[i];
+      level.offset                  = ReadU64(levelIndex);
+      level.size                    = ReadU64(levelIndex + 8);
+
+      int levelWidth                = glm::max(width >> i, 1);
+      int levelHeight               = glm::max(height >> i, 1);
+      if (level.offset + level.size > size || level.size < LevelSize(*format, levelWidth, levelHeight))
+      {
+        TK_ERR("Corrupt KTX2 level: %u", i);
+        image.levels.clear();
+        return false;
+      }
+    }
+
+    image.format = format->glFormat;
+    image.width  = width;
+    image.height = height;
+    image.data   = file;
+
+    return true;
+  }
+
+  /**
+   * Creates a KTX2 file from the compressed levels. A basic data format descriptor is written, which is required by
+   * the standard. Levels are stored from the smallest to the largest as the standard suggests.
+   */
+  static std::vector<uint8> WriteKtx2(const BlockFormat& format,
+                                      int width,
+                                      int height,
+                                      const std::vector<std::vector<uint8>>& levels,
+                                      bool srgb)
+  {
+    // Descriptor of the bc and etc2 formats that are compressed by the encoders.
+    bool isEtc2       = format.vkFormat >= 147 && format.vkFormat <= 152;
+    bool hasAlpha     = format.blockBytes == 16;
+    uint colorModel   = isEtc2 ? 161 : (hasAlpha ? 130 : 128);
+    uint colorChannel = isEtc2 ? 2 : 0;
+    uint alphaChannel = 15;
+    uint sampleCount  = hasAlpha ? 2 : 1;
+
+    uint64 levelCount = levels.size();
+    uint64 dfdOffset  = Ktx2HeaderSize + levelCount * Ktx2LevelIndexSize;
+    uint64 dfdSize    = 4 + 24 + 16 * sampleCount;
+
+    // Each level is aligned to the block size, which is a multiple of 4 as required.
+    uint64 alignment  = format.blockBytes;
+    uint64 dataOffset = (dfdOffset + dfdSize + alignment - 1) / alignment * alignment;
+
+    std::vector<uint64> levelOffsets(levelCount);
+    for (int64 i = (int64) levelCount - 1; i >= 0; i--)
+    {
+      levelOffsets[i]  = dataOffset;
+      dataOffset      += (levels[i].size() + alignment - 1) / alignment * alignment;
+    }
+
+    std::vector<uint8> file(dataOffset, 0);
+    memcpy(file.data(), Ktx2Identifier, sizeof(Ktx2Identifier));
+    WriteU32(file, 12, format.vkFormat);
+    WriteU32(file, 16, 1); // Type size.
+    WriteU32(file, 20, (uint) width);
+    WriteU32(file, 24, (uint) height);
+    WriteU32(file, 36, 1); // Face count.
+    WriteU32(file, 40, (uint) levelCount);
+    WriteU32(file, 48, (uint) dfdOffset);
+    WriteU32(file, 52, (uint) dfdSize);
+
+    for (uint64 i = 0; i < levelCount; i++)
+    {
+      uint64 levelIndex = Ktx2HeaderSize + i * Ktx2LevelIndexSize;
+      WriteU64(file, levelIndex, levelOffsets[i]);
+      WriteU64(file, levelIndex + 8, levels[i].size());
+      WriteU64(file, levelIndex + 16, levels[i].size());
+      memcpy(file.data() + levelOffsets[i], levels[i].data(), levels[i].size());
+    }
+
+    // Basic descriptor block: model, primaries (bt709), transfer function, texel block dimensions and block size.
+    uint64 dfd = dfdOffset;
+    WriteU32(file, dfd, (uint) dfdSize);
+    WriteU32(file, dfd + 4, 0);
+    WriteU32(file, dfd + 8, 2 | (uint) (24 + 16 * sampleCount) << 16);
+    WriteU32(file, dfd + 12, colorModel | 1 << 8 | (srgb ? 2 : 1) << 16);
+    WriteU32(file, dfd + 16, 3 | 3 << 8);
+    WriteU32(file, dfd + 20, (uint) format.blockBytes);
+
+    // Samples: bit offset, bit length - 1 and channel, then lower and upper values.
+    uint64 sample = dfd + 28;
+    if (hasAlpha)
+    {
+      WriteU32(file, sample, 0 | 63 << 16 | alphaChannel << 24);
+      WriteU32(file, sample + 12, 0xFFFFFFFF);
+      sample += 16;
+    }
+    WriteU32(file, sample, (hasAlpha ? 64 : 0) | 63 << 16 | colorChannel << 24);
+    WriteU32(file, sample + 12, 0xFFFFFFFF);
+
+    return file;
+  }
+
+  // Block encoders
+  //////////////////////////////////////////
+
+  /** Pixels of a 4x4 block in row major order, 4 channels each. */
+  typedef uint8 BlockPixels[64];
+
+  static int ColorDistance(const int* a, const uint8* b)
+  {
+    int dr = a[0] - b[0];
+    int dg = a[1] - b[1];
+    int db = a[2] - b[2];
+    return dr * dr + dg * dg + db * db;
+  }
+
+  /**
+   * Finds the end points of the line that fits the colors of the block. Colors are projected on the principal axis,
+   * found by power iteration over the covariance, and the extreme colors are inset slightly to reduce the error.
+   */
+  static void FitColorLine(const BlockPixels pixels, Vec3& minColor, Vec3& maxColor)
+  {
+    Vec3 mean(0.0f);
+    for (int i = 0; i < 16; i++)
+    {
+      mean += Vec3(pixels[i * 4], pixels[i * 4 + 1], pixels[i * 4 + 2]);
+    }
+    mean /= 16.0f;
+
+    Mat3 covariance(0.0f);
+    for (int i = 0; i < 16; i++)
+    {
+      Vec3 d      = Vec3(pixels[i * 4], pixels[i * 4 + 1], pixels[i * 4 + 2]) - mean;
+      covariance += glm::outerProduct(d, d);
+    }
+
+    Vec3 axis(1.0f);
+    for (int i = 0; i < 4; i++)
+    {
+      axis      = covariance * axis;
+      float len = glm::length(axis);
+      axis      = len > 0.0f ? axis / len : Vec3(0.0f);
+    }
+
+    float minProj = TK_FLT_MAX;
+    float maxProj = -TK_FLT_MAX;
+    for (int i = 0; i < 16; i++)
+    {
+      float proj = glm::dot(Vec3(pixels[i * 4], pixels[i * 4 + 1], pixels[i * 4 + 2]) - mean, axis);
+      minProj    = glm::min(minProj, proj);
+      maxProj    = glm::max(maxProj, proj);
+    }
+
+    float inset = (maxProj - minProj) / 16.0f;
+    minColor    = glm::clamp(mean + axis * (minProj + inset), Vec3(0.0f), Vec3(255.0f));
+    maxColor    = glm::clamp(mean + axis * (maxProj - inset), Vec3(0.0f), Vec3(255.0f));
+  }
+
+  static uint16 To565(const Vec3& color)
+  {
+    uint r = (uint) glm::round(color.r * 31.0f / 255.0f);
+    uint g = (uint) glm::round(color.g * 63.0f / 255.0f);
+    uint b = (uint) glm::round(color.b * 31.0f / 255.0f);
+    return (uint16) (r << 11 | g << 5 | b);
+  }
+
+  static void From565(uint16 color, int* rgb)
+  {
+    int r  = (color >> 11) & 31;
+    int g  = (color >> 5) & 63;
+    int b  = color & 31;
+    rgb[0] = r << 3 | r >> 2;
+    rgb[1] = g << 2 | g >> 4;
+    rgb[2] = b << 3 | b >> 2;
+  }
+
+  /** Encodes the colors of the block as a bc1 block in 4 color mode, which is also the color part of bc3. */
+  static void EncodeBC1Block(const BlockPixels pixels, uint8* out)
+  {
+    Vec3 minColor, maxColor;
+    FitColorLine(pixels, minColor, maxColor);
+
+    uint16 color0 = To565(maxColor);
+    uint16 color1 = To565(minColor);
+    if (color0 < color1)
+    {
+      std::swap(color0, color1);
+    }
+
+    int palette[4][3];
+    From565(color0, palette[0]);
+    From565(color1, palette[1]);
+    for (int c = 0; c < 3; c++)
+    {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    // Equal end points select the 3 color mode, where index 0 is still the end point.
+    uint indices = 0;
+    if (color0 != color1)
+    {
+      for (int i = 0; i < 16; i++)
+      {
+        int best     = 0;
+        int bestDist = ColorDistance(palette[0], pixels + i * 4);
+        for (int p = 1; p < 4; p++)
+        {
+          int dist = ColorDistance(palette[p], pixels + i * 4);
+          if (dist < bestDist)
+          {
+            best     = p;
+            bestDist = dist;
+          }
+        }
+        indices |= (uint) best << (i * 2);
+      }
+    }
+
+    out[0] = (uint8) color0;
+    out[1] = (uint8) (color0 >> 8);
+    out[2] = (uint8) color1;
+    out[3] = (uint8) (color1 >> 8);
+    for (int i = 0; i < 4; i++)
+    {
+      out[4 + i] = (uint8) (indices >> (i * 8));
+    }
+  }
+
+  /** Encodes the alpha of the block as a bc3 alpha block in 8 alpha mode. */
+  static void EncodeBC3AlphaBlock(const BlockPixels pixels, uint8* out)
+  {
+    int alpha0 = 0;
+    int alpha1 = 255;
+    for (int i = 0; i < 16; i++)
+    {
+      alpha0 = glm::max(alpha0, (int) pixels[i * 4 + 3]);
+      alpha1 = glm::min(alpha1, (int) pixels[i * 4 + 3]);
+    }
+
+    int palette[8] = {alpha0, alpha1};
+    for (int p = 1; p < 7; p++)
+    {
+      palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+    }
+
+    uint64 indices = 0;
+    if (alpha0 != alpha1)
+    {
+      for (int i = 0; i < 16; i++)
+      {
+        int best = 0;
+        for (int p = 1; p < 8; p++)
+        {
+          if (glm::abs(palette[p] - pixels[i * 4 + 3]) < glm::abs(palette[best] - pixels[i * 4 + 3]))
+          {
+            best = p;
+          }
+        }
+        indices |= (uint64) best << (i * 3);
+      }
+    }
+
+    out[0] = (uint8) alpha0;
+    out[1] = (uint8) alpha1;
+    for (int i = 0; i < 6; i++)
+    {
+      out[2 + i] = (uint8) (indices >> (i * 8));
+    }
+  }
+
+  /** Small and large modifiers of the etc1 tables. */
+  static const int Etc1Modifiers[8][2] = {
+      {2,  8  },
+      {5,  17 },
+      {9,  29 },
+      {13, 42 },
+      {18, 60 },
+      {24, 80 },
+      {33, 106},
+      {47, 183}
+  };
+
+  /** Modifiers of the eac alpha tables. */
+  static const int EacModifiers[16][8] = {
+      {-3, -6, -9,  -15, 2, 5, 8, 14},
+      {-3, -7, -10, -13, 2, 6, 9, 12},
+      {-2, -5, -8,  -13, 1, 4, 7, 12},
+      {-2, -4, -6,  -13, 1, 3, 5, 12},
+      {-3, -6, -8,  -12, 2, 5, 7, 11},
+      {-3, -7, -9,  -11, 2, 6, 8, 10},
+      {-4, -7, -8,  -11, 3, 6, 7, 10},
+      {-3, -5, -8,  -11, 2, 4, 7, 10},
+      {-2, -6, -8,  -10, 1, 5, 7, 9 },
+      {-2, -5, -8,  -10, 1, 4, 7, 9 },
+      {-2, -4, -8,  -10, 1, 3, 7, 9 },
+      {-2, -5, -7,  -10, 1, 4, 6, 9 },
+      {-3, -4, -7,  -10, 2, 3, 6, 9 },
+      {-1, -2, -3,  -10, 0, 1, 2, 9 },
+      {-4, -6, -8,  -9,  3, 5, 7, 8 },
+      {-3, -5, -7,  -9,  2, 4, 6, 8 }
+  };
+
+  /** Result of encoding a half block of etc1 with a base color. */
+  struct Etc1HalfBlock
+  {
+    int table      = 0;  //!< Index of the modifier table.
+    int indices[8] = {}; //!< Pixel index values of the pixels, in the order the pixels are given.
+    int error      = 0;  //!< Sum of squared errors.
+  };
+
+  /** Finds the modifier table and the pixel indices that fit the pixels best with the base color. */
+  static Etc1HalfBlock EncodeEtc1HalfBlock(const int* base, const uint8* const* pixels)
+  {
+    Etc1HalfBlock best;
+    best.error = TK_INT_MAX;
+
+    for (int table = 0; table < 8; table++)
+    {
+      // Pixel index values 0 to 3 select a, b, -a and -b.
+      int smallModifier = Etc1Modifiers[table][0];
+      int largeModifier = Etc1Modifiers[table][1];
+      int modifiers[4]  = {smallModifier, largeModifier, -smallModifier, -largeModifier};
+
+      Etc1HalfBlock half;
+      half.table = table;
+      for (int i = 0; i < 8 && half.error < best.error; i++)
+      {
+        int bestDist = TK_INT_MAX;
+        for (int m = 0; m < 4; m++)
+        {
+          int color[3];
+          for (int c = 0; c < 3; c++)
+          {
+            color[c] = glm::clamp(base[c] + modifiers[m], 0, 255);
+          }
+
+          int dist = ColorDistance(color, pixels[i]);
+          if (dist < bestDist)
+          {
+            bestDist        = dist;
+            half.indices[i] = m;
+          }
+        }
+        half.error += bestDist;
+      }
+
+      if (half.error < best.error)
+      {
+        best = half;
+      }
+    }
+
+    return best;
+  }
+
+  /**
+   * Encodes the colors of the block as an etc1 block, which is also a valid etc2 block. Both the individual and the
+   * differential modes are tried with both the vertical and the horizontal split. Base colors are the averages of the
+   * half blocks. Differential deltas are clamped, so the etc2 only modes are never triggered.
+   */
+  static void EncodeEtc1Block(const BlockPixels pixels, uint8* out)
+  {
+    int bestError = TK_INT_MAX;
+    uint high     = 0;
+    uint low      = 0;
+
+    for (int flip = 0; flip < 2; flip++)
+    {
+      // Half blocks are the left and right columns without flip, top and bottom rows with flip.
+      const uint8* halfPixels[2][8];
+      int pixelIndex[2][8];
+      int counts[2]   = {0, 0};
+      Vec3 average[2] = {Vec3(0.0f), Vec3(0.0f)};
+      for (int y = 0; y < 4; y++)
+      {
+        for (int x = 0; x < 4; x++)
+        {
+          const uint8* pixel                = pixels + (y * 4 + x) * 4;
+          int half                          = flip ? y / 2 : x / 2;
+          halfPixels[half][counts[half]]    = pixel;
+          pixelIndex[half][counts[half]++]  = x * 4 + y;
+          average[half]                    += Vec3(pixel[0], pixel[1], pixel[2]);
+        }
+      }
+
+      for (int diff = 0; diff < 2; diff++)
+      {
+        int quantized[2][3];
+        int base[2][3];
+        for (int c = 0; c < 3; c++)
+        {
+          if (diff)
+          {
+            quantized[0][c] = (int) glm::round(average[0][c] / 8.0f * 31.0f / 255.0f);
+            int second      = (int) glm::round(average[1][c] / 8.0f * 31.0f / 255.0f);
+            quantized[1][c] = quantized[0][c] + glm::clamp(second - quantized[0][c], -4, 3);
+
+            for (int h = 0; h < 2; h++)
+            {
+              base[h][c] = quantized[h][c] << 3 | quantized[h][c] >> 2;
+            }
+          }
+          else
+          {
+            for (int h = 0; h < 2; h++)
+            {
+              quantized[h][c] = (int) glm::round(average[h][c] / 8.0f / 17.0f);
+              base[h][c]      = quantized[h][c] * 17;
+            }
+          }
+        }
+
+        Etc1HalfBlock halves[2];
+        halves[0] = EncodeEtc1HalfBlock(base[0], halfPixels[0]);
+        halves[1] = EncodeEtc1HalfBlock(base[1], halfPixels[1]);
+
+        int error = halves[0].error + halves[1].error;
+        if (error >= bestError)
+        {
+          continue;
+        }
+        bestError = error;
+
+        // Differential mode stores the first base color in 5 bits and the 3 bit delta of the second for each channel,
+        // individual mode stores both in 4 bits.
+        high      = 0;
+        for (int c = 0; c < 3; c++)
+        {
+          int shift = 24 - c * 8;
+          if (diff)
+          {
+            high |= (uint) quantized[0][c] << (shift + 3) | (uint) ((quantized[1][c] - quantized[0][c]) & 7) << shift;
+          }
+          else
+          {
+            high |= (uint) quantized[0][c] << (shift + 4) | (uint) quantized[1][c] << shift;
+          }
+        }
+        high |= (uint) (halves[0].table << 5 | halves[1].table << 2 | diff << 1 | flip);
+
+        // Most significant bits of the pixel indices are in the upper half.
+        low   = 0;
+        for (int h = 0; h < 2; h++)
+        {
+          for (int i = 0; i < 8; i++)
+          {
+            int index  = halves[h].indices[i];
+            low       |= (uint) (index >> 1) << (pixelIndex[h][i] + 16) | (uint) (index & 1) << pixelIndex[h][i];
+          }
+        }
+      }
+    }
+
+    for (int i = 0; i < 4; i++)
+    {
+      out[i]     = (uint8) (high >> (24 - i * 8));
+      out[4 + i] = (uint8) (low >> (24 - i * 8));
+    }
+  }
+
+  /** Encodes the alpha of the block as an eac alpha block, the alpha part of etc2 rgba. */
+  static void EncodeEacAlphaBlock(const BlockPixels pixels, uint8* out)
+  {
+    int minAlpha = 255;
+    int maxAlpha = 0;
+    for (int i = 0; i < 16; i++)
+    {
+      minAlpha = glm::min(minAlpha, (int) pixels[i * 4 + 3]);
+      maxAlpha = glm::max(maxAlpha, (int) pixels[i * 4 + 3]);
+    }
+
+    // Table 13 has a zero modifier, which encodes a constant alpha exactly.
+    int bestBase       = minAlpha;
+    int bestMultiplier = 1;
+    int bestTable      = 13;
+    uint64 bestIndices = 0;
+    for (int i = 0; i < 16; i++)
+    {
+      bestIndices |= (uint64) 4 << ((15 - i) * 3);
+    }
+
+    if (minAlpha != maxAlpha)
+    {
+      int bestError = TK_INT_MAX;
+      for (int table = 0; table < 16; table++)
+      {
+        const int* modifiers = EacModifiers[table];
+        int span             = modifiers[7] - modifiers[3];
+        int estimate         = (int) glm::round((maxAlpha - minAlpha) / (float) span);
+
+        for (int multiplier = glm::max(estimate - 1, 1); multiplier <= glm::min(estimate + 1, 15); multiplier++)
+        {
+          float center   = (minAlpha + maxAlpha) * 0.5f - multiplier * (modifiers[7] + modifiers[3]) * 0.5f;
+          int base       = glm::clamp((int) glm::round(center), 0, 255);
+
+          int error      = 0;
+          uint64 indices = 0;
+          for (int y = 0; y < 4 && error < bestError; y++)
+          {
+            for (int x = 0; x < 4; x++)
+            {
+              int alpha    = pixels[(y * 4 + x) * 4 + 3];
+              int best     = 0;
+              int bestDist = TK_INT_MAX;
+              for (int m = 0; m < 8; m++)
+              {
+                int dist = glm::abs(glm::clamp(base + modifiers[m] * multiplier, 0, 255) - alpha);
+                if (dist < bestDist)
+                {
+                  best     = m;
+                  bestDist = dist;
+                }
+              }
+
+              // Pixels are in column major order, first pixel is in the most significant bits.
+              error   += bestDist * bestDist;
+              indices |= (uint64) best << ((15 - (x * 4 + y)) * 3);
+            }
+          }
+
+          if (error < bestError)
+          {
+            bestError      = error;
+            bestBase       = base;
+            bestMultiplier = multiplier;
+            bestTable      = table;
+            bestIndices    = indices;
+          }
+        }
+      }
+    }
+
+    out[0] = (uint8) bestBase;
+    out[1] = (uint8) (bestMultiplier << 4 | bestTable);
+    for (int i = 0; i < 6; i++)
+    {
+      out[2 + i] = (uint8) (bestIndices >> (40 - i * 8));
+    }
+  }
+
+  /** Compresses a level of an rgba8 image in to blocks. Rows of blocks are compressed in parallel. */
+  static std::vector<uint8> CompressLevel(const uint8* rgba,
+                                          int width,
+                                          int height,
+                                          TextureCompression compression,
+                                          bool hasAlpha)
+  {
+    int blocksX    = (width + 3) / 4;
+    int blocksY    = (height + 3) / 4;
+    int blockBytes = hasAlpha ? 16 : 8;
+
+    std::vector<uint8> blocks((size_t) blocksX * blocksY * blockBytes);
+
+    auto compressRowsFn = [&](size_t beginRow, size_t endRow) -> void
+    {
+      BlockPixels pixels;
+      for (int blockY = (int) beginRow; blockY < (int) endRow; blockY++)
+      {
+        for (int blockX = 0; blockX < blocksX; blockX++)
+        {
+          // Pixels out of the image are clamped to the edge.
+          for (int y = 0; y < 4; y++)
+          {
+            for (int x = 0; x < 4; x++)
+            {
+              int px = glm::min(blockX * 4 + x, width - 1);
+              int py = glm::min(blockY * 4 + y, height - 1);
+              memcpy(pixels + (y * 4 + x) * 4, rgba + ((size_t) py * width + px) * 4, 4);
+            }
+          }
+
+          uint8* out = blocks.data() + ((size_t) blockY * blocksX + blockX) * blockBytes;
+          if (compression == TextureCompression::ETC2)
+          {
+            if (hasAlpha)
+            {
+              EncodeEacAlphaBlock(pixels, out);
+              out += 8;
+            }
+            EncodeEtc1Block(pixels, out);
+          }
+          else
+          {
+            if (hasAlpha)
+            {
+              EncodeBC3AlphaBlock(pixels, out);
+              out += 8;
+            }
+            EncodeBC1Block(pixels, out);
+          }
+        }
+      }
+    };
+
+    GetWorkerManager()->ParallelFor(blocksY, 4, compressRowsFn);
+
+    return blocks;
+  }
+
+  std::vector<uint8> CompressToKtx2(const uint8* rgba,
+                                    int width,
+                                    int height,
+                                    TextureCompression compression,
+                                    bool srgb)
+  {
+    if (compression == TextureCompression::None || rgba == nullptr || width <= 0 || height <= 0)
+    {
+      return {};
+    }
+
+    bool hasAlpha = false;
+    for (size_t i = 0; i < (size_t) width * height && !hasAlpha; i++)
+    {
+      hasAlpha = rgba[i * 4 + 3] != 255;
+    }
+
+    uint vkFormat = 0;
+    if (compression == TextureCompression::ETC2)
+    {
+      vkFormat = hasAlpha ? 151 : 147;
+    }
+    else
+    {
+      vkFormat = hasAlpha ? 137 : 131;
+    }
+
+    // Srgb formats follow the linear ones.
+    const BlockFormat* format = FindBlockFormat(srgb ? vkFormat + 1 : vkFormat);
+
+    // Mip levels are down sampled from the previous level until 1x1.
+    std::vector<std::vector<uint8>> levels;
+    std::vector<uint8> mip;
+    const uint8* level = rgba;
+    int levelWidth     = width;
+    int levelHeight    = height;
+    while (true)
+    {
+      levels.push_back(CompressLevel(level, levelWidth, levelHeight, compression, hasAlpha));
+      if (levelWidth == 1 && levelHeight == 1)
+      {
+        break;
+      }
+
+      int mipWidth  = glm::max(levelWidth / 2, 1);
+      int mipHeight = glm::max(levelHeight / 2, 1);
+
+      std::vector<uint8> nextMip((size_t) mipWidth * mipHeight * 4);
+      ImageResize(level, levelWidth, levelHeight, 0, nextMip.data(), mipWidth, mipHeight, 0, 4);
+
+      mip         = std::move(nextMip);
+      level       = mip.data();
+      levelWidth  = mipWidth;
+      levelHeight = mipHeight;
+    }
+
+    return WriteKtx2(*format, width, height, levels, srgb);
+  }
+
+  bool IsCompressedFormatSupported(GraphicTypes format)
+  {
+    // Formats that the context supports are listed by the gl, including the ones enabled by the extensions.
+    static IntArray supportedFormats;
+    static bool queried = false;
+    if (!queried)
+    {
+      GLint count = 0;
+      glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+
+      supportedFormats.resize(count);
+      if (count > 0)
+      {
+        glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, supportedFormats.data());
+      }
+      queried = true;
+    }
+
+    return std::find(supportedFormats.begin(), supportedFormats.end(), (int) format) != supportedFormats.end();
+  }
+
+} // namespace ToolKit
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#pragma once
+
+/**
+ * @file Block compressed textures. Images are compressed with their mip levels offline and stored in KTX2 containers,
+ * which are uploaded to the gpu without decoding.
+ */
+
+#include "Types.h"
+
+namespace ToolKit
+{
+
+  /** Block compression formats that the textures can be packed with. Values are the choice indexes in the settings. */
+  enum class TextureCompression
+  {
+    None = 0, //!< Textures are packed as they are.
+    ETC2 = 1, //!< Etc2 rgb or rgba, core in Gles 3.0. Suitable for mobile.
+    BC   = 2  //!< Bc1 or bc3 (s3tc). Suitable for desktop gpus and browsers.
+  };
+
+  /** Block compressed image and its mip levels. */
+  struct TK_API CompressedImage
+  {
+    /** A mip level of the image. */
+    struct Level
+    {
+      uint64 offset = 0; //!< Offset of the level data in the image data.
+      uint64 size   = 0; //!< Size of the level data in bytes.
+    };
+
+    GraphicTypes format = GraphicTypes::FormatRGBA; //!< Gl internal format of the compressed blocks.
+    int width           = 0;                        //!< Width of the first level.
+    int height          = 0;                        //!< Height of the first level.
+    std::vector<Level> levels;                      //!< Mip levels, starting from the largest.
+    MappedFilePtr data;                             //!< Content of the file that the levels are read from.
+
+    /** Returns true if the image has any levels. */
+    bool IsValid() const { return !levels.empty(); }
+
+    /** Returns the total size of the levels, which is the vram usage of the image. */
+    uint64 DataSize() const;
+
+    /** Returns the data of the level. */
+    const uint8* LevelData(int level) const;
+  };
+
+  /**
+   * Reads a KTX2 file. Only 2D images without super compression are supported. Block compressed etc2, eac, bc and
+   * astc formats are recognized.
+   * @param file is the content of the file. Image keeps referencing it.
+   * @param image is the read image.
+   * @return False if the file is not a valid or supported KTX2 file.
+   */
+  TK_API bool ReadKtx2(const MappedFilePtr& file, CompressedImage& image);
+
+  /**
+   * Compresses an rgba8 image and its mip levels, mip levels are generated from the image. Images without any
+   * transparent pixels are compressed without alpha. Blocks are compressed in parallel.
+   * @param rgba is the image with 4 channels.
+   * @param width is the width of the image.
+   * @param height is the height of the image.
+   * @param compression is the format to compress with.
+   * @param srgb states if the image is in srgb color space.
+   * @return The content of the KTX2 file that holds the compressed image, empty if compression is none.
+   */
+  TK_API std::vector<uint8> CompressToKtx2(const uint8* rgba,
+                                           int width,
+                                           int height,
+                                           TextureCompression compression,
+                                           bool srgb = true);
+
+  /** Returns true if the gpu can sample the compressed format. Must be called from the thread that owns the context. */
+  TK_API bool IsCompressedFormatSupported(GraphicTypes format);
+
+} // namespace ToolKit
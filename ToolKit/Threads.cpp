@@ -15,32 +15,377 @@
 namespace ToolKit
 {
 
+  // JobSystem
+  //////////////////////////////////////////
+
+  /** Index of the worker's queue for the worker threads, -1 for any other thread. */
+  static thread_local int g_workerIndex        = -1;
+
+  /** The scheduler that the current worker thread belongs to. */
+  static thread_local JobSystem* g_workerOwner = nullptr;
+
+  JobSystem::JobSystem(uint workerCount)
+  {
+    workerCount = glm::max(workerCount, 1u);
+
+    m_queues.reserve(workerCount);
+    for (uint i = 0; i < workerCount; i++)
+    {
+      m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    m_workers.reserve(workerCount);
+    for (uint i = 0; i < workerCount; i++)
+    {
+      m_workers.emplace_back(&JobSystem::WorkerLoop, this, (int) i);
+    }
+  }
+
+  JobSystem::~JobSystem()
+  {
+    WaitIdle();
+
+    {
+      std::lock_guard<std::mutex> lock(m_sleepMutex);
+      m_running.store(false);
+    }
+    m_sleepSignal.notify_all();
+
+    for (std::thread& worker : m_workers)
+    {
+      worker.join();
+    }
+  }
+
+  JobPtr JobSystem::Schedule(Task task, const JobPtrArray& dependencies)
+  {
+    JobPtr job = std::make_shared<Job>();
+    job->task  = std::move(task);
+
+    // Extra dependency prevents the job from starting before all dependencies are registered.
+    job->dependencies.store(1);
+    m_pendingJobs.fetch_add(1);
+
+    for (const JobPtr& dependency : dependencies)
+    {
+      if (dependency == nullptr)
+      {
+        continue;
+      }
+
+      SpinlockGuard guard(dependency->continuationLock);
+      if (!dependency->IsFinished())
+      {
+        job->dependencies.fetch_add(1);
+        dependency->continuations.push_back(job);
+      }
+    }
+
+    if (job->dependencies.fetch_sub(1) == 1)
+    {
+      Enqueue(job);
+    }
+
+    return job;
+  }
+
+  void JobSystem::Wait(const JobPtr& job)
+  {
+    while (!job->IsFinished())
+    {
+      if (!ExecutePending())
+      {
+        HyperThreadPause();
+      }
+    }
+  }
+
+  void JobSystem::WaitIdle()
+  {
+    while (m_pendingJobs.load() > 0)
+    {
+      if (!ExecutePending())
+      {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  void JobSystem::ParallelFor(size_t count, size_t grainSize, const RangeTask& task)
+  {
+    if (count == 0)
+    {
+      return;
+    }
+
+    grainSize               = glm::max(grainSize, (size_t) 1);
+    const size_t chunkCount = (count + grainSize - 1) / grainSize;
+    if (chunkCount == 1)
+    {
+      task(0, count);
+      return;
+    }
+
+    // Chunks are claimed dynamically by the helpers and the caller. Fast threads take more chunks.
+    std::atomic_size_t nextChunk(0);
+
+    auto processChunksFn = [&]() -> void
+    {
+      for (size_t chunk = nextChunk.fetch_add(1); chunk < chunkCount; chunk = nextChunk.fetch_add(1))
+      {
+        size_t begin = chunk * grainSize;
+        size_t end   = glm::min(begin + grainSize, count);
+        task(begin, end);
+      }
+    };
+
+    // Caller also processes chunks, so one less helper is enough.
+    size_t helperCount  = glm::min(chunkCount - 1, (size_t) GetWorkerCount());
+    JobPtrArray helpers = AcquireRangeJobs();
+
+    // Single reference capture fits in the small buffer of the task, assigning it doesn't allocate.
+    auto helperFn       = [&processChunksFn]() -> void { processChunksFn(); };
+    for (size_t i = 0; i < helperCount; i++)
+    {
+      const JobPtr& helper = helpers[i];
+      helper->task         = helperFn;
+      helper->finished.store(false, std::memory_order_relaxed);
+
+      m_pendingJobs.fetch_add(1);
+      Enqueue(helper);
+    }
+
+    processChunksFn();
+
+    // Helpers reference the stack of this function, they all must be done before returning.
+    for (size_t i = 0; i < helperCount; i++)
+    {
+      Wait(helpers[i]);
+    }
+
+    ReleaseRangeJobs(std::move(helpers));
+  }
+
+  JobPtrArray JobSystem::AcquireRangeJobs()
+  {
+    JobPtrArray helpers;
+    {
+      SpinlockGuard guard(m_rangeJobLock);
+      if (!m_rangeJobPool.empty())
+      {
+        helpers = std::move(m_rangeJobPool.back());
+        m_rangeJobPool.pop_back();
+      }
+    }
+
+    // Only allocates while warming up or when more parallel loops than ever before are running at the same time.
+    if (helpers.empty())
+    {
+      helpers.resize(m_workers.size());
+      for (JobPtr& helper : helpers)
+      {
+        helper = std::make_shared<Job>();
+      }
+    }
+
+    return helpers;
+  }
+
+  void JobSystem::ReleaseRangeJobs(JobPtrArray&& helpers)
+  {
+    SpinlockGuard guard(m_rangeJobLock);
+    m_rangeJobPool.push_back(std::move(helpers));
+  }
+
+  uint JobSystem::GetWorkerCount() const { return (uint) m_workers.size(); }
+
+  void JobSystem::WorkerLoop(int workerIndex)
+  {
+    g_workerIndex = workerIndex;
+    g_workerOwner = this;
+
+    while (m_running.load())
+    {
+      if (JobPtr job = FindJob(workerIndex))
+      {
+        Execute(job);
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(m_sleepMutex);
+      m_sleepSignal.wait(lock, [this]() -> bool { return m_queuedJobs.load() > 0 || !m_running.load(); });
+    }
+  }
+
+  void JobSystem::Enqueue(const JobPtr& job)
+  {
+    // Workers push to their own queue to keep the data hot, others distribute in round robin fashion.
+    int queueIndex = g_workerIndex;
+    if (g_workerOwner != this || queueIndex < 0)
+    {
+      queueIndex = (int) (m_nextQueue.fetch_add(1) % (uint) m_queues.size());
+    }
+
+    WorkerQueue& queue = *m_queues[queueIndex];
+    {
+      SpinlockGuard guard(queue.lock);
+      queue.jobs.push_back(job);
+    }
+
+    m_queuedJobs.fetch_add(1);
+
+    // Taking the lock prevents the signal to be lost between a worker's predicate check and its wait.
+    {
+      std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_sleepSignal.notify_one();
+  }
+
+  JobPtr JobSystem::FindJob(int workerIndex)
+  {
+    if (m_queuedJobs.load(std::memory_order_relaxed) <= 0)
+    {
+      return nullptr;
+    }
+
+    const int queueCount = (int) m_queues.size();
+
+    // Pop the most recent job from own queue.
+    if (workerIndex >= 0)
+    {
+      WorkerQueue& queue = *m_queues[workerIndex];
+      SpinlockGuard guard(queue.lock);
+      if (!queue.jobs.empty())
+      {
+        JobPtr job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+        m_queuedJobs.fetch_sub(1);
+        return job;
+      }
+    }
+
+    // Steal the oldest job from the others.
+    int start = workerIndex >= 0 ? workerIndex + 1 : (int) (m_nextQueue.load(std::memory_order_relaxed) % queueCount);
+    for (int i = 0; i < queueCount; i++)
+    {
+      int victimIndex = (start + i) % queueCount;
+      if (victimIndex == workerIndex)
+      {
+        continue;
+      }
+
+      WorkerQueue& victim = *m_queues[victimIndex];
+      if (!victim.lock.TryLock())
+      {
+        continue;
+      }
+
+      JobPtr job;
+      if (!victim.jobs.empty())
+      {
+        job = std::move(victim.jobs.front());
+        victim.jobs.pop_front();
+        m_queuedJobs.fetch_sub(1);
+      }
+      victim.lock.Unlock();
+
+      if (job != nullptr)
+      {
+        return job;
+      }
+    }
+
+    return nullptr;
+  }
+
+  void JobSystem::Execute(const JobPtr& job)
+  {
+    job->task();
+    job->task = nullptr; // Release captures.
+
+    JobPtrArray continuations;
+    {
+      SpinlockGuard guard(job->continuationLock);
+      job->finished.store(true, std::memory_order_release);
+      continuations.swap(job->continuations);
+    }
+
+    for (const JobPtr& continuation : continuations)
+    {
+      if (continuation->dependencies.fetch_sub(1) == 1)
+      {
+        Enqueue(continuation);
+      }
+    }
+
+    m_pendingJobs.fetch_sub(1);
+  }
+
+  bool JobSystem::ExecutePending()
+  {
+    int workerIndex = g_workerOwner == this ? g_workerIndex : -1;
+    if (JobPtr job = FindJob(workerIndex))
+    {
+      Execute(job);
+      return true;
+    }
+
+    return false;
+  }
+
+  // WorkerManager
+  //////////////////////////////////////////
+
   WorkerManager::WorkerManager() {}
 
   WorkerManager::~WorkerManager() { UnInit(); }
 
   void WorkerManager::Init()
   {
-    uint coreCount = std::thread::hardware_concurrency();
+    if (m_initialized)
+    {
+      return;
+    }
+
+    // Main thread also executes jobs while waiting, so frame threads are one less than the cores. All frame work goes
+    // through the job system, the poolSTL frame pool only runs when work stealing is disabled, so both get all the
+    // frame threads without oversubscribing the cores. Background threads mostly wait for io, they are not counted.
+    uint coreCount    = glm::max(std::thread::hardware_concurrency(), 1u);
+    uint frameThreads = glm::max(coreCount - 1, 1u);
     if constexpr (TK_PLATFORM == PLATFORM::TKWeb)
     {
-      m_frameWorkers      = new ThreadPool(glm::min(coreCount, 2u));
-      m_backgroundWorkers = new ThreadPool(glm::min(coreCount, 2u));
+      frameThreads = glm::min(coreCount, 2u);
     }
-    else
+
+    m_jobSystem         = new JobSystem(frameThreads);
+    m_frameWorkers      = new ThreadPool(frameThreads);
+    m_backgroundWorkers = new ThreadPool(glm::min(coreCount, 2u));
+
+    // Registered once, the manager can be initialized again after UnInit.
+    if (!m_mainTasksRegistered)
     {
-      m_frameWorkers      = new ThreadPool(glm::min(coreCount, 4u));
-      m_backgroundWorkers = new ThreadPool(glm::min(coreCount, 2u));
+      Main::GetInstance()->RegisterPostUpdateFunction([this](float deltaTime) -> void
+                                                      { ExecuteTasks(m_mainThreadTasks, m_mainTaskMutex); });
+      m_mainTasksRegistered = true;
     }
 
-    Main::GetInstance()->RegisterPostUpdateFunction([this](float deltaTime) -> void
-                                                    { ExecuteTasks(m_mainThreadTasks, m_mainTaskMutex); });
+    m_initialized = true;
   }
 
   void WorkerManager::UnInit()
   {
+    if (!m_initialized)
+    {
+      return;
+    }
+
+    Flush();
+
+    SafeDel(m_jobSystem);
     SafeDel(m_frameWorkers);
     SafeDel(m_backgroundWorkers);
+
+    m_initialized = false;
   }
 
   ThreadPool& WorkerManager::GetPool(Executor executor)
@@ -56,9 +401,21 @@ namespace ToolKit
     }
   }
 
+  JobSystem* WorkerManager::GetJobSystem() { return m_jobSystem; }
+
   int WorkerManager::GetThreadCount(Executor executor)
   {
-    return Main::GetInstance()->m_threaded ? GetPool(executor).get_num_threads() : 0;
+    if (!Main::GetInstance()->m_threaded)
+    {
+      return 0;
+    }
+
+    if (executor == FramePool && m_workStealing)
+    {
+      return (int) m_jobSystem->GetWorkerCount();
+    }
+
+    return GetPool(executor).get_num_threads();
   }
 
   void WorkerManager::Flush()
@@ -70,12 +427,50 @@ namespace ToolKit
       pool->unpause();
     };
 
+    if (m_jobSystem != nullptr)
+    {
+      m_jobSystem->WaitIdle();
+    }
+
     flushPoolFn(m_frameWorkers);
     flushPoolFn(m_backgroundWorkers);
 
     ExecuteTasks(m_mainThreadTasks, m_mainTaskMutex);
   }
 
+  void WorkerManager::ParallelFor(size_t count, size_t grainSize, const RangeTask& task)
+  {
+    if (count == 0)
+    {
+      return;
+    }
+
+    if (!Main::GetInstance()->m_threaded || count <= grainSize)
+    {
+      task(0, count);
+      return;
+    }
+
+    if (m_workStealing)
+    {
+      m_jobSystem->ParallelFor(count, grainSize, task);
+      return;
+    }
+
+    grainSize         = glm::max(grainSize, (size_t) 1);
+    size_t chunkCount = (count + grainSize - 1) / grainSize;
+
+    using poolstl::iota_iter;
+    std::for_each(poolstl::par_if(true, GetPool(FramePool)),
+                  iota_iter<size_t>(0),
+                  iota_iter<size_t>(chunkCount),
+                  [&](size_t chunk) -> void
+                  {
+                    size_t begin = chunk * grainSize;
+                    task(begin, glm::min(begin + grainSize, count));
+                  });
+  }
+
   void WorkerManager::ExecuteTasks(TaskQueue& queue, std::mutex& mex)
   {
     for (int i = 0; i < (int) queue.size(); i++)
@@ -11,6 +11,9 @@
 
 #include <poolSTL/include/poolstl/poolstl.hpp>
 
+#include <condition_variable>
+#include <thread>
+
 #if defined(__EMSCRIPTEN__)
   // WebAssembly: no-op
   #define HyperThreadPause() ((void) 0)
@@ -92,6 +95,92 @@ namespace ToolKit
   typedef task_thread_pool::task_thread_pool ThreadPool;
   typedef std::queue<std::packaged_task<void()>> TaskQueue;
   typedef std::function<void()> Task;
+  typedef std::function<void(size_t, size_t)> RangeTask;
+
+  typedef std::shared_ptr<struct Job> JobPtr;
+  typedef std::vector<JobPtr> JobPtrArray;
+
+  /** Unit of work that runs on the JobSystem. A job may wait for other jobs and runs as their continuation. */
+  struct TK_API Job
+  {
+    Task task;                         //!< Work to perform.
+    std::atomic_int dependencies {0};  //!< Number of unfinished jobs that this job waits for.
+    std::atomic_bool finished {false}; //!< Set after the task is completed.
+    JobPtrArray continuations;         //!< Jobs that are waiting for this job to complete.
+    Spinlock continuationLock;         //!< Guards continuations against concurrent completion.
+
+    bool IsFinished() const { return finished.load(std::memory_order_acquire); }
+  };
+
+  /**
+   * Work stealing job scheduler. Each worker owns a deque, pushes and pops its own jobs from the back and steals from
+   * the front of the other workers' deques when it runs out of work. Threads that wait on a job execute pending jobs
+   * instead of blocking, so jobs can schedule and wait for other jobs without dead locking the workers.
+   */
+  class TK_API JobSystem
+  {
+   public:
+    /** Creates the scheduler with given number of worker threads. */
+    explicit JobSystem(uint workerCount);
+
+    /** Completes all pending jobs and joins the workers. */
+    ~JobSystem();
+
+    JobSystem(const JobSystem&)            = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /** Schedules the task. It starts when all of the given dependencies are completed. */
+    JobPtr Schedule(Task task, const JobPtrArray& dependencies = {});
+
+    /** Waits for the job to complete. The calling thread executes pending jobs while waiting. */
+    void Wait(const JobPtr& job);
+
+    /** Waits until all scheduled jobs are completed. */
+    void WaitIdle();
+
+    /**
+     * Splits [0, count) in to chunks of grainSize and calls task(begin, end) for each chunk. Chunks are distributed to
+     * the workers and the calling thread dynamically. Returns after all chunks are completed.
+     */
+    void ParallelFor(size_t count, size_t grainSize, const RangeTask& task);
+
+    /** Returns the number of worker threads. */
+    uint GetWorkerCount() const;
+
+   private:
+    struct WorkerQueue
+    {
+      std::deque<JobPtr> jobs;
+      Spinlock lock;
+    };
+
+    void WorkerLoop(int workerIndex);
+    void Enqueue(const JobPtr& job);
+    JobPtr FindJob(int workerIndex);
+    void Execute(const JobPtr& job);
+    bool ExecutePending();
+
+    /** Returns a job for each worker to run parallel loop chunks. Jobs are pooled to not allocate in each loop. */
+    JobPtrArray AcquireRangeJobs();
+
+    /** Returns the completed jobs to the pool. */
+    void ReleaseRangeJobs(JobPtrArray&& helpers);
+
+   private:
+    std::vector<std::thread> m_workers;
+    std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+
+    std::atomic_bool m_running {true};
+    std::atomic_int m_queuedJobs {0};  //!< Jobs that are waiting in the queues.
+    std::atomic_int m_pendingJobs {0}; //!< Jobs that are scheduled but not completed yet.
+    std::atomic_uint m_nextQueue {0};  //!< Round robin queue index for jobs scheduled by non worker threads.
+
+    std::mutex m_sleepMutex;
+    std::condition_variable m_sleepSignal;
+
+    std::vector<JobPtrArray> m_rangeJobPool; //!< Reusable helper jobs of the parallel loops.
+    Spinlock m_rangeJobLock;                 //!< Guards the range job pool.
+  };
 
   /** This is the class that keeps the thread pools and manages async tasks. */
   class TK_API WorkerManager
@@ -118,21 +207,43 @@ namespace ToolKit
     /** Flushes all the tasks in the pools, queues than terminates threads. */
     void UnInit();
 
-    /** Returns the thread pool corresponding to the executor. */
+    /**
+     * Returns the thread pool corresponding to the executor. Frame pool only runs tasks when work stealing is disabled,
+     * frame loops should use ParallelFor instead of TKExecBy to run on the JobSystem.
+     */
     ThreadPool& GetPool(Executor executor);
 
+    /** Returns the work stealing scheduler that runs frame tasks. */
+    JobSystem* GetJobSystem();
+
     /** Returns available threads for given executor. */
     int GetThreadCount(Executor executor);
 
     /** Stops waiting tasks and completes ongoing tasks on all pools and threads. */
     void Flush();
 
+    /**
+     * Calls task(begin, end) for chunks of [0, count) on the frame workers and the calling thread. Runs sequentially on
+     * the calling thread if threading is disabled or count does not exceed the grain size.
+     */
+    void ParallelFor(size_t count, size_t grainSize, const RangeTask& task);
+
     template <typename F, typename... A, typename R = std::invoke_result_t<std::decay_t<F>, std::decay_t<A>...>>
     std::future<R> AsyncTask(Executor exec, F&& func, A&&... args)
     {
       if (exec == FramePool)
       {
-        return m_frameWorkers->submit(func, std::forward<A>(args)...);
+        if (!m_workStealing)
+        {
+          return GetPool(FramePool).submit(func, std::forward<A>(args)...);
+        }
+
+        std::shared_ptr<std::packaged_task<R()>> ptask =
+            std::make_shared<std::packaged_task<R()>>(std::bind(std::forward<F>(func), std::forward<A>(args)...));
+
+        m_jobSystem->Schedule([ptask]() -> void { (*ptask)(); });
+
+        return ptask->get_future();
       }
       else if (exec == BackgroundPool)
       {
@@ -156,7 +267,14 @@ namespace ToolKit
     void ExecuteTasks(TaskQueue& queue, std::mutex& mex);
 
    public:
-    /** Task that suppose to complete in a frame should be using this pool. */
+    /**
+     * Frame tasks and parallel loops are executed by the work stealing JobSystem if true. If false, the fixed size
+     * poolSTL frame pool is used instead. It is here to compare the schedulers and as a fallback for problematic
+     * platforms.
+     */
+    bool m_workStealing             = true;
+
+    /** Fallback pool for frame tasks when work stealing is disabled. Idle otherwise. */
     ThreadPool* m_frameWorkers      = nullptr;
 
     /** Tasks that needs to be run in the background should be performed using this pool. */
@@ -168,6 +286,15 @@ namespace ToolKit
    private:
     /** Lock for main thread tasks. */
     std::mutex m_mainTaskMutex;
+
+    /** True between Init and UnInit. */
+    bool m_initialized         = false;
+
+    /** Main thread tasks are executed by a post update function, which is registered at the first Init. */
+    bool m_mainTasksRegistered = false;
+
+    /** Work stealing scheduler that executes frame tasks. */
+    JobSystem* m_jobSystem     = nullptr;
   };
 
 /**
@@ -254,6 +254,10 @@ namespace ToolKit
     {
       stats->m_drawCallCountPrev                     = stats->m_drawCallCount;
       stats->m_drawCallCount                         = 0;
+      stats->m_instancedDrawCallCountPrev            = stats->m_instancedDrawCallCount;
+      stats->m_instancedDrawCallCount                = 0;
+      stats->m_instanceCountPrev                     = stats->m_instanceCount;
+      stats->m_instanceCount                         = 0;
       stats->m_renderPassCountPrev                   = stats->m_renderPassCount;
       stats->m_renderPassCount                       = 0;
       stats->m_lightCacheInvalidationPerFramePrev    = stats->m_lightCacheInvalidationPerFrame;
@@ -266,6 +270,10 @@ namespace ToolKit
       stats->m_cameraUpdatePerFrame                  = 0;
       stats->m_directionalLightUpdatePerFramePrev    = stats->m_directionalLightUpdatePerFrame;
       stats->m_directionalLightUpdatePerFrame        = 0;
+      stats->m_shadowMapCacheHitPerFramePrev         = stats->m_shadowMapCacheHitPerFrame;
+      stats->m_shadowMapCacheHitPerFrame             = 0;
+      stats->m_shadowMapCacheMissPerFramePrev        = stats->m_shadowMapCacheMissPerFrame;
+      stats->m_shadowMapCacheMissPerFrame            = 0;
     }
 
     GetRenderSystem()->StartFrame();
@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#include "TransformSystem.h"
+
+#include "Entity.h"
+#include "MathUtil.h"
+#include "Node.h"
+#include "Threads.h"
+#include "ToolKit.h"
+
+#include "DebugNew.h"
+
+namespace ToolKit
+{
+
+  /** Levels are updated in chunks of this many nodes, smaller levels are updated on the calling thread. */
+  constexpr int g_transformSystemParallelThreshold = 512;
+
+  TransformSystem::TransformSystem() {}
+
+  TransformSystem::~TransformSystem() { Clear(); }
+
+  void TransformSystem::Add(Node* node)
+  {
+    if (node->m_transformSystem == this)
+    {
+      return;
+    }
+
+    if (node->m_transformSystem != nullptr)
+    {
+      node->m_transformSystem->Remove(node);
+    }
+
+    node->m_transformSystem = this;
+    node->m_transformIndex  = (int) m_nodes.size();
+
+    m_nodes.push_back(node);
+    m_parents.push_back(-1);
+    m_localTransforms.push_back(node->m_localCache);
+    m_worldTransforms.push_back(Mat4());
+    m_worldTranslations.push_back(Vec3());
+    m_worldOrientations.push_back(Quaternion());
+    m_dirty.push_back(true);
+    m_changed.push_back(false);
+    m_foreignChildren.push_back(false);
+
+    MarkHierarchyDirty();
+  }
+
+  void TransformSystem::Remove(Node* node)
+  {
+    if (node->m_transformSystem != this)
+    {
+      return;
+    }
+
+    Detach(node->m_transformIndex);
+    MarkHierarchyDirty();
+  }
+
+  void TransformSystem::Clear()
+  {
+    for (int i = 0; i < (int) m_nodes.size(); i++)
+    {
+      if (m_nodes[i] != nullptr)
+      {
+        Detach(i);
+      }
+    }
+
+    m_nodes.clear();
+    m_parents.clear();
+    m_localTransforms.clear();
+    m_worldTransforms.clear();
+    m_worldTranslations.clear();
+    m_worldOrientations.clear();
+    m_dirty.clear();
+    m_changed.clear();
+    m_foreignChildren.clear();
+    m_levels.clear();
+
+    m_hierarchyDirty = false;
+    m_foreignRoots   = false;
+    m_pending        = false;
+    m_firstDirty     = TK_INT_MAX;
+  }
+
+  void TransformSystem::Update()
+  {
+    // An update on another thread keeps the values invalid until it is completed, it is waited for.
+    if (!m_pending.load(std::memory_order_acquire) && !m_updating.load(std::memory_order_acquire))
+    {
+      return;
+    }
+
+    // Reading a foreign parent may end up here again on the updating thread, values are used as they are in that case.
+    if (m_updating.load(std::memory_order_acquire) && m_updateThread.load() == std::this_thread::get_id())
+    {
+      return;
+    }
+
+    LockGuard lock(m_updateMutex);
+    if (!m_pending)
+    {
+      return;
+    }
+
+    m_updateThread = std::this_thread::get_id();
+    m_updating     = true;
+    m_pending      = false;
+
+    if (m_hierarchyDirty)
+    {
+      SortHierarchy();
+    }
+
+    // Changed nodes are the dirty ones and their descendants, which are all after the first dirty node.
+    const int firstDirty = m_firstDirty.exchange(TK_INT_MAX);
+
+    // Parents are always in the previous levels, so each level only reads the results of the previous ones.
+    for (int level = 0; level < (int) m_levels.size() - 1; level++)
+    {
+      int begin = glm::max(m_levels[level], firstDirty);
+      int end   = m_levels[level + 1];
+      if (begin >= end)
+      {
+        continue;
+      }
+
+      // Foreign parents update themselves lazily, which is not thread safe.
+      if (level == 0 && m_foreignRoots)
+      {
+        for (int i = begin; i < end; i++)
+        {
+          UpdateWorldTransform(i);
+        }
+
+        continue;
+      }
+
+      GetWorkerManager()->ParallelFor(end - begin,
+                                      g_transformSystemParallelThreshold,
+                                      [this, begin](size_t beginIndex, size_t endIndex) -> void
+                                      {
+                                        for (size_t i = beginIndex; i < endIndex; i++)
+                                        {
+                                          UpdateWorldTransform(begin + (int) i);
+                                        }
+                                      });
+    }
+
+    // Spatial caches and the foreign children are not thread safe to update. Flags are cleared for the next update,
+    // which only visits the nodes after its first dirty one.
+    for (int i = firstDirty; i < (int) m_nodes.size(); i++)
+    {
+      if (!m_changed[i])
+      {
+        continue;
+      }
+
+      m_changed[i] = false;
+      Node* node   = m_nodes[i];
+      if (EntityPtr ntt = node->OwnerEntity())
+      {
+        ntt->InvalidateSpatialCaches();
+      }
+
+      if (m_foreignChildren[i])
+      {
+        for (Node* child : node->m_children)
+        {
+          if (child->m_transformSystem != this)
+          {
+            child->m_dirty = true;
+            child->SetChildrenDirty();
+            child->InvalitadeSpatialCaches();
+          }
+        }
+      }
+    }
+
+    m_updateThread = std::thread::id();
+    m_updating     = false;
+  }
+
+  int TransformSystem::GetNodeCount() const
+  {
+    int count = 0;
+    for (Node* node : m_nodes)
+    {
+      count += node != nullptr;
+    }
+
+    return count;
+  }
+
+  void TransformSystem::SetLocalTransform(int index, const Mat4& transform)
+  {
+    m_localTransforms[index] = transform;
+    MarkDirty(index);
+  }
+
+  void TransformSystem::MarkDirty(int index)
+  {
+    m_dirty[index] = true;
+
+    int firstDirty = m_firstDirty.load(std::memory_order_relaxed);
+    while (index < firstDirty && !m_firstDirty.compare_exchange_weak(firstDirty, index, std::memory_order_relaxed))
+    {
+    }
+
+    m_pending.store(true, std::memory_order_release);
+  }
+
+  void TransformSystem::MarkHierarchyDirty()
+  {
+    m_hierarchyDirty = true;
+    m_pending.store(true, std::memory_order_release);
+  }
+
+  void TransformSystem::GetWorldTransform(const Node* node, Mat4* transform, Vec3* translation, Quaternion* orientation)
+  {
+    // Sorting may move the node, index is read after the update.
+    Update();
+    int index = node->m_transformIndex;
+
+    if (transform != nullptr)
+    {
+      *transform = m_worldTransforms[index];
+    }
+
+    if (translation != nullptr)
+    {
+      *translation = m_worldTranslations[index];
+    }
+
+    if (orientation != nullptr)
+    {
+      *orientation = m_worldOrientations[index];
+    }
+  }
+
+  void TransformSystem::Detach(int index)
+  {
+    // Detached node updates its caches by itself. Index is left empty until the nodes are sorted again.
+    Node* node              = m_nodes[index];
+    node->m_transformSystem = nullptr;
+    node->m_transformIndex  = -1;
+    node->m_dirty           = true;
+    node->SetChildrenDirty();
+
+    m_nodes[index]          = nullptr;
+  }
+
+  void TransformSystem::SortHierarchy()
+  {
+    NodeRawPtrArray nodes;
+    nodes.reserve(m_nodes.size());
+
+    // Roots are the nodes without a registered parent.
+    m_foreignRoots = false;
+    for (Node* node : m_nodes)
+    {
+      if (node != nullptr && (node->m_parent == nullptr || node->m_parent->m_transformSystem != this))
+      {
+        nodes.push_back(node);
+        m_foreignRoots |= node->m_parent != nullptr;
+      }
+    }
+
+    // Breadth first traversal places each level after the previous one.
+    m_levels.clear();
+    size_t levelBegin = 0;
+    while (levelBegin < nodes.size())
+    {
+      m_levels.push_back((int) levelBegin);
+
+      size_t levelEnd = nodes.size();
+      for (size_t i = levelBegin; i < levelEnd; i++)
+      {
+        for (Node* child : nodes[i]->m_children)
+        {
+          if (child->m_transformSystem == this)
+          {
+            nodes.push_back(child);
+          }
+        }
+      }
+
+      levelBegin = levelEnd;
+    }
+    m_levels.push_back((int) nodes.size());
+
+    const int count = (int) nodes.size();
+    m_nodes.swap(nodes);
+    m_parents.resize(count);
+    m_localTransforms.resize(count);
+    m_worldTransforms.resize(count);
+    m_worldTranslations.resize(count);
+    m_worldOrientations.resize(count);
+    m_foreignChildren.assign(count, false);
+
+    // All world transforms are recalculated once, since the parents may have changed.
+    m_dirty.assign(count, true);
+    m_changed.assign(count, false);
+    m_firstDirty = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+      Node* node             = m_nodes[i];
+      node->m_transformIndex = i;
+      m_localTransforms[i]   = node->m_localCache;
+
+      Node* parent           = node->m_parent;
+      m_parents[i]           = parent != nullptr && parent->m_transformSystem == this ? parent->m_transformIndex : -1;
+
+      for (Node* child : node->m_children)
+      {
+        m_foreignChildren[i] |= child->m_transformSystem != this;
+      }
+    }
+
+    m_hierarchyDirty = false;
+  }
+
+  void TransformSystem::UpdateWorldTransform(int index)
+  {
+    int parent       = m_parents[index];
+    bool changed     = m_dirty[index] || (parent != -1 && m_changed[parent]);
+    m_changed[index] = changed;
+    m_dirty[index]   = false;
+
+    if (!changed)
+    {
+      return;
+    }
+
+    Node* node = m_nodes[index];
+    Mat4 parentTransform;
+    if (parent != -1)
+    {
+      parentTransform = m_worldTransforms[parent];
+      if (!node->m_inheritScale)
+      {
+        Node::RemoveScale(parentTransform);
+      }
+    }
+    else if (node->m_parent != nullptr)
+    {
+      parentTransform = node->GetParentTransform();
+    }
+
+    m_worldTransforms[index] = parentTransform * m_localTransforms[index];
+    DecomposeMatrix(m_worldTransforms[index], &m_worldTranslations[index], &m_worldOrientations[index], nullptr);
+  }
+
+} // namespace ToolKit
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#pragma once
+
+/**
+ * @file Batched world transform updates for node hierarchies.
+ */
+
+#include "Types.h"
+
+namespace ToolKit
+{
+
+  /**
+   * Stores the transforms of the registered nodes in contiguous arrays sorted by their depth in the hierarchy. Changing
+   * a registered node only marks it dirty. World transforms are updated in a single pass, level by level, where each
+   * level is processed in parallel. Nodes keep their api, they read and write their transforms through the system.
+   */
+  class TK_API TransformSystem
+  {
+    friend class Node;
+
+   public:
+    TransformSystem();
+    ~TransformSystem(); //!< Detaches all the nodes.
+
+    TransformSystem(const TransformSystem&)            = delete;
+    TransformSystem& operator=(const TransformSystem&) = delete;
+
+    /** Registers the node. A node that is registered to another system is moved to this one. */
+    void Add(Node* node);
+
+    /** Detaches the node from the system. Node updates its transforms by itself afterwards. */
+    void Remove(Node* node);
+
+    /** Detaches all the nodes. */
+    void Clear();
+
+    /**
+     * Updates the world transforms of the dirty nodes and their descendants and invalidates the spatial caches of the
+     * changed ones. Does nothing if nothing is changed.
+     */
+    void Update();
+
+    /** Returns the number of the registered nodes. */
+    int GetNodeCount() const;
+
+   private:
+    /** Sets the local transform of the node at the index and marks it dirty. */
+    void SetLocalTransform(int index, const Mat4& transform);
+
+    /** Marks the node at the index dirty, so that its world transform is updated with the next update. */
+    void MarkDirty(int index);
+
+    /** Marks the hierarchy as changed, so that the nodes are sorted again with the next update. */
+    void MarkHierarchyDirty();
+
+    /** Updates the system and retrieves the world transforms of the node. */
+    void GetWorldTransform(const Node* node, Mat4* transform, Vec3* translation, Quaternion* orientation);
+
+    void Detach(int index);
+    void SortHierarchy();
+    void UpdateWorldTransform(int index);
+
+   private:
+    NodeRawPtrArray m_nodes;                     //!< Registered nodes, sorted by depth if the hierarchy is not dirty.
+    IntArray m_parents;                          //!< Index of the parent of each node, -1 if it is not registered.
+    std::vector<Mat4> m_localTransforms;         //!< Local transform of each node.
+    std::vector<Mat4> m_worldTransforms;         //!< World transform of each node.
+    Vec3Array m_worldTranslations;               //!< World translation of each node.
+    std::vector<Quaternion> m_worldOrientations; //!< World orientation of each node.
+    std::vector<uint8> m_dirty;                  //!< States if the local transform of the node is changed.
+    std::vector<uint8> m_changed;                //!< States if the world transform is changed by the running update.
+    std::vector<uint8> m_foreignChildren;        //!< States if the node has children that are not registered.
+    IntArray m_levels;                           //!< Start index of each level and the node count at the end.
+    bool m_hierarchyDirty = false;               //!< States if the nodes need to be sorted again.
+    bool m_foreignRoots   = false;               //!< States if any root has a parent that is not registered.
+    std::atomic_int m_firstDirty {TK_INT_MAX};   //!< Lowest dirty index, nodes before it are not changed.
+    std::atomic_bool m_updating {false};         //!< States if an update is in progress.
+    std::atomic_bool m_pending {false};          //!< States if there are changes to update.
+    std::atomic<std::thread::id> m_updateThread; //!< Thread that runs the update in progress.
+    Mutex m_updateMutex;                         //!< Serializes the updates. Reads don't lock unless there is one.
+  };
+
+} // namespace ToolKit
@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#include "TriangleBVH.h"
+
+#include "MathUtil.h"
+
+#include "DebugNew.h"
+
+namespace ToolKit
+{
+
+  void TriangleBVH::Build(const Vec3Array& positions, const UIntArray& indices)
+  {
+    m_nodes.clear();
+    m_positions = positions;
+
+    if (indices.empty())
+    {
+      m_indices.resize(positions.size() / 3 * 3);
+      for (uint i = 0; i < (uint) m_indices.size(); i++)
+      {
+        m_indices[i] = i;
+      }
+    }
+    else
+    {
+      m_indices.assign(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+    }
+
+    const int32 triCount = GetTriangleCount();
+    if (triCount == 0)
+    {
+      return;
+    }
+
+    // Bounds and centers of the triangles. Order is partitioned while building, leafs point to ranges in it.
+    std::vector<BoundingBox> triBounds(triCount);
+    Vec3Array triCenters(triCount);
+    std::vector<int32> order(triCount);
+
+    BoundingBox rootBounds;
+    for (int32 i = 0; i < triCount; i++)
+    {
+      BoundingBox& box = triBounds[i];
+      for (int j = 0; j < 3; j++)
+      {
+        box.UpdateBoundary(m_positions[m_indices[i * 3 + j]]);
+      }
+
+      triCenters[i] = box.GetCenter();
+      order[i]      = i;
+      rootBounds    = BoundingBox::Union(rootBounds, box);
+    }
+
+    // A binary tree with n leafs has 2n - 1 nodes.
+    m_nodes.reserve(triCount * 2);
+    m_nodes.push_back({rootBounds, 0, triCount});
+
+    constexpr int32 maxLeafSize = 4;
+    constexpr int binCount      = 16;
+
+    std::vector<int32> stack;
+    stack.push_back(0);
+
+    while (!stack.empty())
+    {
+      int32 nodeIndex = stack.back();
+      stack.pop_back();
+
+      // Node array grows below, node is copied instead of referenced.
+      const Node node = m_nodes[nodeIndex];
+      if (node.count <= maxLeafSize)
+      {
+        continue;
+      }
+
+      const int32 begin = node.first;
+      const int32 end   = node.first + node.count;
+
+      BoundingBox centerBounds;
+      for (int32 i = begin; i < end; i++)
+      {
+        centerBounds.UpdateBoundary(triCenters[order[i]]);
+      }
+
+      const Vec3 extent = centerBounds.max - centerBounds.min;
+      int axis          = 0;
+      if (extent.y > extent[axis])
+      {
+        axis = 1;
+      }
+      if (extent.z > extent[axis])
+      {
+        axis = 2;
+      }
+
+      int32 mid = begin + node.count / 2;
+      BoundingBox leftBounds, rightBounds;
+      bool split = false;
+
+      if (extent[axis] > 0.0f)
+      {
+        struct Bin
+        {
+          BoundingBox bounds;
+          int32 count = 0;
+        };
+
+        Bin bins[binCount];
+        const float binScale = binCount / extent[axis];
+        auto binIndexFn      = [&](int32 tri) -> int
+        { return glm::min((int) ((triCenters[tri][axis] - centerBounds.min[axis]) * binScale), binCount - 1); };
+
+        for (int32 i = begin; i < end; i++)
+        {
+          Bin& bin    = bins[binIndexFn(order[i])];
+          bin.bounds  = BoundingBox::Union(bin.bounds, triBounds[order[i]]);
+          bin.count  += 1;
+        }
+
+        // Cost of the right side for the splits after each bin, accumulated from the right.
+        float rightCosts[binCount] = {};
+        BoundingBox rightAccum;
+        int32 rightCount = 0;
+        for (int i = binCount - 1; i > 0; i--)
+        {
+          rightAccum     = BoundingBox::Union(rightAccum, bins[i].bounds);
+          rightCount    += bins[i].count;
+          rightCosts[i]  = rightCount > 0 ? rightAccum.HalfSurfaceArea() * rightCount : 0.0f;
+        }
+
+        float bestCost = TK_FLT_MAX;
+        int bestSplit  = -1;
+        BoundingBox leftAccum;
+        int32 leftCount = 0;
+        for (int i = 0; i < binCount - 1; i++)
+        {
+          leftAccum  = BoundingBox::Union(leftAccum, bins[i].bounds);
+          leftCount += bins[i].count;
+          if (leftCount == 0 || leftCount == node.count)
+          {
+            continue;
+          }
+
+          float cost = leftAccum.HalfSurfaceArea() * leftCount + rightCosts[i + 1];
+          if (cost < bestCost)
+          {
+            bestCost  = cost;
+            bestSplit = i;
+          }
+        }
+
+        if (bestSplit != -1)
+        {
+          int32* midPtr = std::partition(order.data() + begin,
+                                         order.data() + end,
+                                         [&](int32 tri) -> bool { return binIndexFn(tri) <= bestSplit; });
+          mid           = (int32) (midPtr - order.data());
+
+          for (int i = 0; i < binCount; i++)
+          {
+            BoundingBox& bounds = i <= bestSplit ? leftBounds : rightBounds;
+            bounds              = BoundingBox::Union(bounds, bins[i].bounds);
+          }
+          split = true;
+        }
+      }
+
+      if (!split)
+      {
+        // Centers are too close to be binned, split from the median.
+        std::nth_element(order.begin() + begin,
+                         order.begin() + mid,
+                         order.begin() + end,
+                         [&](int32 a, int32 b) -> bool { return triCenters[a][axis] < triCenters[b][axis]; });
+
+        for (int32 i = begin; i < end; i++)
+        {
+          BoundingBox& bounds = i < mid ? leftBounds : rightBounds;
+          bounds              = BoundingBox::Union(bounds, triBounds[order[i]]);
+        }
+      }
+
+      int32 left = (int32) m_nodes.size();
+      m_nodes.push_back({leftBounds, begin, mid - begin});
+      m_nodes.push_back({rightBounds, mid, end - mid});
+
+      m_nodes[nodeIndex].first = left;
+      m_nodes[nodeIndex].count = 0;
+
+      stack.push_back(left + 1);
+      stack.push_back(left);
+    }
+
+    // Store the triangles in the leaf order, so that the triangles of a leaf are adjacent.
+    UIntArray indicesInOrder(m_indices.size());
+    for (int32 i = 0; i < triCount; i++)
+    {
+      for (int j = 0; j < 3; j++)
+      {
+        indicesInOrder[i * 3 + j] = m_indices[order[i] * 3 + j];
+      }
+    }
+    m_indices.swap(indicesInOrder);
+  }
+
+  void TriangleBVH::Refit(Pose& pose) const
+  {
+    assert(pose.positions.size() == m_positions.size() && "Refit requires the same vertices.");
+    pose.bounds.resize(m_nodes.size());
+
+    // Children are always created after their parents, iterating backwards updates the children first.
+    for (int32 i = (int32) m_nodes.size() - 1; i >= 0; i--)
+    {
+      const Node& node = m_nodes[i];
+      if (node.count == 0)
+      {
+        pose.bounds[i] = BoundingBox::Union(pose.bounds[node.first], pose.bounds[node.first + 1]);
+        continue;
+      }
+
+      BoundingBox aabb;
+      for (int32 j = node.first * 3; j < (node.first + node.count) * 3; j++)
+      {
+        aabb.UpdateBoundary(pose.positions[m_indices[j]]);
+      }
+      pose.bounds[i] = aabb;
+    }
+  }
+
+  /** Slab test with the precomputed reciprocal direction. Returns the entry distance or TK_FLT_MAX if missed. */
+  static inline float RayBoxDistance(const Vec3& origin, const Vec3& invDir, const BoundingBox& box)
+  {
+    Vec3 vmin  = (box.min - origin) * invDir;
+    Vec3 vmax  = (box.max - origin) * invDir;
+
+    float tmin = glm::compMax(glm::min(vmin, vmax));
+    float tmax = glm::compMin(glm::max(vmin, vmax));
+
+    return tmax >= 0.0f && tmin <= tmax ? tmin : TK_FLT_MAX;
+  }
+
+  /** Nodes postponed for the ray traversal with their entry distances. Grows to the tree depth once and gets reused. */
+  static thread_local std::vector<std::pair<int32, float>> g_triangleBVHStack;
+
+  template <typename BoundsFn>
+  bool TriangleBVH::Traverse(const Ray& ray, const Vec3Array& positions, BoundsFn boundsFn, float& t) const
+  {
+    t = TK_FLT_MAX;
+    if (m_nodes.empty())
+    {
+      return false;
+    }
+
+    const Vec3 invDir = 1.0f / ray.direction;
+    if (RayBoxDistance(ray.position, invDir, boundsFn(0)) == TK_FLT_MAX)
+    {
+      return false;
+    }
+
+    std::vector<std::pair<int32, float>>& stack = g_triangleBVHStack;
+    stack.clear();
+
+    int32 current = 0;
+    while (current != -1)
+    {
+      const Node& node = m_nodes[current];
+      if (node.count == 0)
+      {
+        // Visit the nearer child first, the farther one is visited later if it can still contain a closer hit.
+        int32 nearChild = node.first;
+        int32 farChild  = node.first + 1;
+        float nearDist  = RayBoxDistance(ray.position, invDir, boundsFn(nearChild));
+        float farDist   = RayBoxDistance(ray.position, invDir, boundsFn(farChild));
+        if (farDist < nearDist)
+        {
+          std::swap(nearChild, farChild);
+          std::swap(nearDist, farDist);
+        }
+
+        if (nearDist < t)
+        {
+          if (farDist < t)
+          {
+            stack.push_back({farChild, farDist});
+          }
+
+          current = nearChild;
+          continue;
+        }
+      }
+      else
+      {
+        for (int32 i = node.first * 3; i < (node.first + node.count) * 3; i += 3)
+        {
+          float dist;
+          const Vec3& v0 = positions[m_indices[i]];
+          const Vec3& v1 = positions[m_indices[i + 1]];
+          const Vec3& v2 = positions[m_indices[i + 2]];
+          if (RayTriangleIntersection(ray, v0, v1, v2, dist) && dist < t)
+          {
+            t = dist;
+          }
+        }
+      }
+
+      // Continue with the closest postponed node that can still contain a closer hit.
+      current = -1;
+      while (!stack.empty())
+      {
+        std::pair<int32, float> next = stack.back();
+        stack.pop_back();
+
+        if (next.second < t)
+        {
+          current = next.first;
+          break;
+        }
+      }
+    }
+
+    return t != TK_FLT_MAX;
+  }
+
+  bool TriangleBVH::RayIntersection(const Ray& ray, float& t) const
+  {
+    auto boundsFn = [this](int32 node) -> const BoundingBox& { return m_nodes[node].aabb; };
+    return Traverse(ray, m_positions, boundsFn, t);
+  }
+
+  bool TriangleBVH::RayIntersection(const Ray& ray, const Pose& pose, float& t) const
+  {
+    assert(pose.bounds.size() == m_nodes.size() && "Pose must be refitted before the ray test.");
+
+    auto boundsFn = [&pose](int32 node) -> const BoundingBox& { return pose.bounds[node]; };
+    return Traverse(ray, pose.positions, boundsFn, t);
+  }
+
+  int TriangleBVH::GetTriangleCount() const { return (int) m_indices.size() / 3; }
+
+} // namespace ToolKit
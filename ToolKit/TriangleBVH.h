@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2019-2025 OtSoftware
+ * This code is licensed under the GNU Lesser General Public License v3.0 (LGPL-3.0).
+ * For more information, including options for a more permissive commercial license,
+ * please visit [otyazilim.com] or contact us at [info@otyazilim.com].
+ */
+
+#pragma once
+
+/**
+ * @file Bounding volume hierarchy over the triangles of a mesh. Used for finding the ray mesh intersections without
+ * testing all the triangles.
+ */
+
+#include "GeometryTypes.h"
+
+namespace ToolKit
+{
+
+  /**
+   * Static bounding volume hierarchy over triangles, built top down with binned surface area heuristic. Hierarchy can
+   * be refitted to the new positions of the vertices, which is used for following the pose of skinned meshes.
+   */
+  class TK_API TriangleBVH
+  {
+   public:
+    /**
+     * Vertex positions and node bounds for a pose of the mesh. Hierarchy is shared with the bind pose, only the bounds
+     * are refitted. Reusing a pose avoids allocations once its arrays are grown.
+     */
+    struct Pose
+    {
+      Vec3Array positions;             //!< Vertex positions in the same order that the hierarchy is built with.
+      std::vector<BoundingBox> bounds; //!< Bounds of the nodes for the positions. Set by Refit.
+    };
+
+    /**
+     * Builds the hierarchy over the triangles. Every 3 consecutive indices form a triangle. If indices are empty,
+     * every 3 consecutive positions form a triangle.
+     */
+    void Build(const Vec3Array& positions, const UIntArray& indices);
+
+    /**
+     * Calculates the bounds of the nodes for the positions of the pose without changing the hierarchy. Positions must
+     * have the same vertex count and order that the hierarchy is built with.
+     */
+    void Refit(Pose& pose) const;
+
+    /**
+     * Tests the ray against the triangles.
+     * @param t Distance to the closest hit along the ray.
+     * @return True if any of the triangles is hit.
+     */
+    bool RayIntersection(const Ray& ray, float& t) const;
+
+    /** Same as RayIntersection, but tests the triangles in the given pose, which must be refitted. */
+    bool RayIntersection(const Ray& ray, const Pose& pose, float& t) const;
+
+    /** Returns the number of triangles in the hierarchy. */
+    int GetTriangleCount() const;
+
+   private:
+    /** Traverses the hierarchy with the node bounds returned by boundsFn and the given vertex positions. */
+    template <typename BoundsFn>
+    bool Traverse(const Ray& ray, const Vec3Array& positions, BoundsFn boundsFn, float& t) const;
+
+   private:
+    /** Node of the hierarchy. Children of a node are adjacent, right child is next to the left one. */
+    struct Node
+    {
+      BoundingBox aabb; //!< Bounds of the triangles under the node.
+      int32 first;      //!< Left child for the internal nodes, first triangle for the leafs.
+      int32 count;      //!< Triangle count for the leafs, 0 for the internal nodes.
+    };
+
+    std::vector<Node> m_nodes;
+    UIntArray m_indices;   //!< Vertex indices of the triangles in the leaf order.
+    Vec3Array m_positions; //!< Vertex positions.
+  };
+
+} // namespace ToolKit
@@ -35,6 +35,7 @@
 #include <assert.h>
 
 #include <array>
+#include <atomic>
 #include <deque>
 #include <filesystem>
 #include <functional>
@@ -48,6 +49,7 @@
 #include <set>
 #include <stack>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -153,6 +155,7 @@ namespace ToolKit
   typedef std::vector<ShaderPtr> ShaderPtrArray;
   typedef std::shared_ptr<class GpuProgram> GpuProgramPtr;
   typedef std::shared_ptr<class SkinMesh> SkinMeshPtr;
+  typedef std::shared_ptr<class TriangleBVH> TriangleBVHPtr;
   typedef std::shared_ptr<class Scene> ScenePtr;
   typedef std::weak_ptr<class Scene> SceneWeakPtr;
   typedef std::vector<MeshPtr> MeshPtrArray;
@@ -210,6 +213,7 @@ namespace ToolKit
   typedef std::shared_ptr<XmlDocument> XmlDocumentPtr;
   typedef rapidxml::file<char> XmlFile;
   typedef std::shared_ptr<XmlFile> XmlFilePtr;
+  typedef std::shared_ptr<class MappedFile> MappedFilePtr;
 
   struct XmlDocBundle
   {
@@ -252,6 +256,7 @@ namespace ToolKit
   static const String BMP(".bmp");
   static const String PSD(".psd");
   static const String HDR(".hdr");
+  static const String KTX2(".ktx2");
   static const String WAW(".waw");
   static const String MP3(".mp3");
 
@@ -265,6 +270,7 @@ namespace ToolKit
   static const String SHADER(".shader");
   static const String AUDIO(".wav");
   static const String LAYER(".layer");
+  static const String SCENE_BINARY(".bin"); //!< Appended to the scene files for their binary form.
 
   static const ObjectId NullHandle    = 0;  //!< Used for uninitialized handles.
   static const ObjectId InvalidHandle = -1; //!< Used for invalid handles.
@@ -303,6 +309,7 @@ namespace ToolKit
   static const StringView XmlObjectIdAttr("i");
   static const StringView XmlComponentArrayElement("Ca");
   static const StringView XmlVersion("version");
+  static const StringView XmlBinaryOffsetAttr("bo");
 
   enum class AxisLabel
   {
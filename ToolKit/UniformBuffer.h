@@ -32,6 +32,9 @@ namespace ToolKit
      */
     void Map(const void* data, uint64 size);
 
+    /** Maps the cpu data to a range of the gpu buffer starting from offset in bytes. */
+    void MapRange(const void* data, uint64 offset, uint64 size);
+
    public:
     /** Slot corresponds the buffer's binding location. */
     int m_slot;
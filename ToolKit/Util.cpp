@@ -1100,6 +1100,18 @@ namespace ToolKit
     return x ^ (x >> 31ULL);
   }
 
+  uint64 StringHash(StringView str)
+  {
+    uint64 hash = 14695981039346656037ULL;
+    for (char c : str)
+    {
+      hash ^= (uint8) c;
+      hash *= 1099511628211ULL;
+    }
+
+    return hash;
+  }
+
   void Xoroshiro128PlusSeed(uint64 s[2], uint64 seed)
   {
     s[0]  = MurmurHash(seed);
@@ -342,6 +342,9 @@ namespace ToolKit
 
   TK_API uint64 MurmurHash(uint64 x);
 
+  /** Returns the 64 bit FNV-1a hash of the string. Unlike std::hash, the result is stable between runs and builds. */
+  TK_API uint64 StringHash(StringView str);
+
   TK_API void Xoroshiro128PlusSeed(uint64 s[2], uint64 seed);
 
   TK_API uint64 Xoroshiro128Plus(uint64 s[2]);